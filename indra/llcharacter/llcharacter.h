@@ -155,6 +155,11 @@ public:
 	enum e_update_t { NORMAL_UPDATE, HIDDEN_UPDATE, FORCE_UPDATE };
 	void updateMotions(e_update_t update_type);
 
+	// updateMotions() split as in LLMotionController: beginMotionUpdate() on
+	// the main thread, then evaluateMotions() on any thread if it returned true
+	bool beginMotionUpdate(e_update_t update_type);
+	void evaluateMotions(e_update_t update_type);
+
 	LLAnimPauseRequest requestPause();
 	bool areAnimationsPaused() const { return mMotionController.isPaused(); }
 	void setAnimTimeFactor(F32 factor) { mMotionController.setTimeFactor(factor); }
@@ -35,8 +35,9 @@
 #include "llcallstack.h"
 #include <boost/algorithm/string.hpp>
 
-S32 LLJoint::sNumUpdates = 0;
-S32 LLJoint::sNumTouches = 0;
+thread_local S32 LLJoint::sNumUpdates = 0;
+thread_local S32 LLJoint::sNumTouches = 0;
+U32 LLJoint::sHierarchySerialNum = 0;
 
 template <class T> 
 bool attachment_map_iter_compare_key(const T& a, const T& b)
@@ -273,6 +274,7 @@ void LLJoint::addChild(LLJoint* joint)
 	joint->mXform.setParent(&mXform);
 	joint->mParent = this;	
 	joint->touch();
+	++sHierarchySerialNum;
 }
 
 
@@ -289,6 +291,7 @@ void LLJoint::removeChild(LLJoint* joint)
 		joint->mXform.setParent(nullptr);
 		joint->mParent = nullptr;
 		joint->touch();
+		++sHierarchySerialNum;
 	}
 }
 
@@ -309,6 +312,7 @@ void LLJoint::removeAllChildren()
         }
 	}
     mChildren.clear();
+	++sHierarchySerialNum;
 }
 
 
@@ -1002,6 +1006,58 @@ void LLJoint::updateWorldMatrix()
 	}
 }
 
+//-----------------------------------------------------------------------------
+// LLJointUpdateList
+//-----------------------------------------------------------------------------
+LLJointUpdateList::LLJointUpdateList()
+:	mRoot(nullptr),
+	mHierarchySerialNum(0)
+{
+}
+
+void LLJointUpdateList::updateWorldMatrices(LLJoint* root)
+{
+	if (root != mRoot || mHierarchySerialNum != LLJoint::sHierarchySerialNum)
+	{
+		rebuild(root);
+	}
+
+	const U32 count = (U32)mEntries.size();
+	for (U32 i = 0; i < count; )
+	{
+		const Entry& entry = mEntries[i];
+		if (!entry.mJoint->mUpdateXform)
+		{
+			i = entry.mSubtreeEnd;
+			continue;
+		}
+		entry.mJoint->updateWorldMatrix();
+		++i;
+	}
+}
+
+void LLJointUpdateList::rebuild(LLJoint* root)
+{
+	mEntries.clear();
+	mRoot = root;
+	mHierarchySerialNum = LLJoint::sHierarchySerialNum;
+	if (root)
+	{
+		append(root);
+	}
+}
+
+void LLJointUpdateList::append(LLJoint* joint)
+{
+	const U32 index = (U32)mEntries.size();
+	mEntries.push_back({ joint, 0 });
+	for (LLJoint* child : joint->mChildren)
+	{
+		append(child);
+	}
+	mEntries[index].mSubtreeEnd = (U32)mEntries.size();
+}
+
 //--------------------------------------------------------------------
 // getSkinOffset()
 //--------------------------------------------------------------------
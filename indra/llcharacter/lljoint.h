@@ -148,9 +148,13 @@ public:
 	typedef std::vector<LLJoint*> joints_t;
 	joints_t mChildren;
 
-	// debug statics
-	static S32		sNumTouches;
-	static S32		sNumUpdates;
+	// debug statics, per thread since avatars animate on worker threads
+	// (see LLAvatarAnimationUpdater, which hands the counts back)
+	static thread_local S32	sNumTouches;
+	static thread_local S32	sNumUpdates;
+
+	// bumped whenever any joint gains or loses a child, see LLJointUpdateList
+	static U32		sHierarchySerialNum;
     typedef std::set<std::string> debug_joint_name_t;
     static debug_joint_name_t s_debugJointNames;
     static void setDebugJointNames(const debug_joint_name_t& names);
@@ -303,5 +307,36 @@ public:
     bool aboveJointPosThreshold(const LLVector3& pos) const;
     bool aboveJointScaleThreshold(const LLVector3& scale) const;
 } LL_ALIGN_POSTFIX(16);
+
+//-----------------------------------------------------------------------------
+// class LLJointUpdateList
+// updateWorldMatrixChildren() without the recursion.  The hierarchy below a
+// root is flattened, parents before children, into an array that is rebuilt
+// only when LLJoint::sHierarchySerialNum moves, and walked in order;
+// a joint with mUpdateXform off skips its whole subtree as before.
+//-----------------------------------------------------------------------------
+class LLJointUpdateList
+{
+public:
+	LLJointUpdateList();
+
+	void updateWorldMatrices(LLJoint* root);
+
+	U32 getNumJoints() const { return (U32)mEntries.size(); }
+
+private:
+	void rebuild(LLJoint* root);
+	void append(LLJoint* joint);
+
+	struct Entry
+	{
+		LLJoint*	mJoint;
+		U32			mSubtreeEnd; // index of the first joint after this one's descendants
+	};
+
+	std::vector<Entry>	mEntries;
+	LLJoint*			mRoot;
+	U32					mHierarchySerialNum;
+};
 #endif // LL_LLJOINT_H
 
@@ -39,10 +39,13 @@
 #include "llendianswizzle.h"
 #include "llkeyframemotion.h"
 #include "llquantize.h"
+#include "lltimer.h"
 #include "m3math.h"
 #include "message.h"
 #include "llfilesystem.h"
 
+#include <algorithm>
+
 //-----------------------------------------------------------------------------
 // Static Definitions
 //-----------------------------------------------------------------------------
@@ -61,6 +64,46 @@ static F32 MIN_ACCELERATION_SQUARED = 0.0005f * 0.0005f;
 
 static F32 MAX_CONSTRAINTS = 10;
 
+// key times of old versions were not quantised
+static U16 quantize_time(F32 time, F32 duration)
+{
+	return duration > 0.f ? F32_to_U16_ROUND(time, 0.f, duration) : 0;
+}
+
+//-----------------------------------------------------------------------------
+// buildCurve()
+//-----------------------------------------------------------------------------
+// static
+S32 LLKeyframeMotion::buildCurve(std::vector<QuantizedKey>& keys, KeyTimes& key_times, std::vector<U16>& values)
+{
+	std::stable_sort(keys.begin(), keys.end(),
+		[](const QuantizedKey& a, const QuantizedKey& b)
+		{
+			return a.mTime < b.mTime;
+		});
+
+	std::vector<U16> times;
+	times.reserve(keys.size());
+	values.clear();
+	values.reserve(keys.size() * 3);
+	for (const QuantizedKey& key : keys)
+	{
+		if (!times.empty() && times.back() == key.mTime)
+		{
+			values.resize(values.size() - 3);
+		}
+		else
+		{
+			times.push_back(key.mTime);
+		}
+		values.insert(values.end(), key.mValue, key.mValue + 3);
+	}
+	values.shrink_to_fit();
+
+	key_times.init(times);
+	return (S32)times.size();
+}
+
 //-----------------------------------------------------------------------------
 // JointMotionList
 //-----------------------------------------------------------------------------
@@ -94,26 +137,21 @@ U32 LLKeyframeMotion::JointMotionList::dumpDiagInfo()
 		LLKeyframeMotion::JointMotion* joint_motion_p = mJointMotionArray[i];
 
 		LL_INFOS() << "\tJoint " << joint_motion_p->mJointName << LL_ENDL;
-		if (joint_motion_p->mUsage & LLJointState::SCALE)
-		{
-			LL_INFOS() << "\t" << joint_motion_p->mScaleCurve.mNumKeys << " scale keys at " 
-			<< joint_motion_p->mScaleCurve.mNumKeys * sizeof(ScaleKey) << " bytes" << LL_ENDL;
-
-			total_size += joint_motion_p->mScaleCurve.mNumKeys * sizeof(ScaleKey);
-		}
 		if (joint_motion_p->mUsage & LLJointState::ROT)
 		{
-			LL_INFOS() << "\t" << joint_motion_p->mRotationCurve.mNumKeys << " rotation keys at " 
-			<< joint_motion_p->mRotationCurve.mNumKeys * sizeof(RotationKey) << " bytes" << LL_ENDL;
+			const RotationCurve& curve = joint_motion_p->mRotationCurve;
+			U32 size = curve.mTimes.sizeBytes() + curve.mKeys.capacity() * sizeof(U16);
+			LL_INFOS() << "\t" << curve.mNumKeys << " rotation keys at " << size << " bytes" << LL_ENDL;
 
-			total_size += joint_motion_p->mRotationCurve.mNumKeys * sizeof(RotationKey);
+			total_size += size;
 		}
 		if (joint_motion_p->mUsage & LLJointState::POS)
 		{
-			LL_INFOS() << "\t" << joint_motion_p->mPositionCurve.mNumKeys << " position keys at " 
-			<< joint_motion_p->mPositionCurve.mNumKeys * sizeof(PositionKey) << " bytes" << LL_ENDL;
+			const PositionCurve& curve = joint_motion_p->mPositionCurve;
+			U32 size = curve.mTimes.sizeBytes() + curve.mKeys.capacity() * sizeof(U16);
+			LL_INFOS() << "\t" << curve.mNumKeys << " position keys at " << size << " bytes" << LL_ENDL;
 
-			total_size += joint_motion_p->mPositionCurve.mNumKeys * sizeof(PositionKey);
+			total_size += size;
 		}
 	}
 	LL_INFOS() << "Size: " << total_size << " bytes" << LL_ENDL;
@@ -121,6 +159,23 @@ U32 LLKeyframeMotion::JointMotionList::dumpDiagInfo()
 	return total_size;
 }
 
+//-----------------------------------------------------------------------------
+// JointMotionList::sizeBytes()
+//-----------------------------------------------------------------------------
+U32 LLKeyframeMotion::JointMotionList::sizeBytes() const
+{
+	U32 total_size = sizeof(JointMotionList);
+	for (const JointMotion* joint_motion_p : mJointMotionArray)
+	{
+		const RotationCurve& rot_curve = joint_motion_p->mRotationCurve;
+		const PositionCurve& pos_curve = joint_motion_p->mPositionCurve;
+		total_size += sizeof(JointMotion);
+		total_size += rot_curve.mTimes.sizeBytes() + (U32)rot_curve.mKeys.capacity() * sizeof(U16);
+		total_size += pos_curve.mTimes.sizeBytes() + (U32)pos_curve.mKeys.capacity() * sizeof(U16);
+	}
+	return total_size;
+}
+
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 // ****Curve classes
@@ -129,83 +184,133 @@ U32 LLKeyframeMotion::JointMotionList::dumpDiagInfo()
 
 
 //-----------------------------------------------------------------------------
-// ScaleCurve::ScaleCurve()
+// KeyTimes::KeyTimes()
 //-----------------------------------------------------------------------------
-LLKeyframeMotion::ScaleCurve::ScaleCurve()
+LLKeyframeMotion::KeyTimes::KeyTimes()
+	: mNumKeys(0),
+	  mFirst(0.f),
+	  mStep(0.f)
 {
-	mInterpolationType = LLKeyframeMotion::IT_LINEAR;
-	mNumKeys = 0;
 }
 
 //-----------------------------------------------------------------------------
-// ScaleCurve::~ScaleCurve()
+// KeyTimes::init()
 //-----------------------------------------------------------------------------
-LLKeyframeMotion::ScaleCurve::~ScaleCurve() 
+void LLKeyframeMotion::KeyTimes::init(const std::vector<U16>& times)
 {
-	mKeys.clear();
-	mNumKeys = 0;
+	mNumKeys = (S32)times.size();
+	mFirst = mNumKeys ? (F32)times.front() : 0.f;
+	mStep = 0.f;
+	mTimes.clear();
+	mBuckets.clear();
+
+	if (mNumKeys < 2)
+	{
+		return;
+	}
+
+	// keep only first and step if they reproduce every key time exactly
+	mStep = (F32)(times.back() - times.front()) / (F32)(mNumKeys - 1);
+	for (S32 k = 0; k < mNumKeys; ++k)
+	{
+		if (ll_round(mFirst + (F32)k * mStep) != (S32)times[k])
+		{
+			mStep = 0.f;
+			break;
+		}
+	}
+	if (mStep > 0.f)
+	{
+		return;
+	}
+
+	mTimes = times;
+
+	// one bucket per key over the quantised time range, each holding the
+	// last key at or before the start of the bucket
+	mBuckets.resize(mNumKeys);
+	S32 k = 0;
+	for (S32 b = 0; b < mNumKeys; ++b)
+	{
+		F32 start = (F32)b * 65536.f / (F32)mNumKeys;
+		while (k + 1 < mNumKeys && (F32)mTimes[k + 1] <= start)
+		{
+			++k;
+		}
+		mBuckets[b] = (U16)k;
+	}
 }
 
 //-----------------------------------------------------------------------------
-// getValue()
+// KeyTimes::find()
 //-----------------------------------------------------------------------------
-LLVector3 LLKeyframeMotion::ScaleCurve::getValue(F32 time, F32 duration)
+S32 LLKeyframeMotion::KeyTimes::find(F32 time, F32 duration, F32& u) const
 {
-	LLVector3 value;
-
-	if (mKeys.empty())
-	{
-		value.clearVec();
-		return value;
-	}
-	
-	key_map_t::iterator right = mKeys.lower_bound(time);
-	if (right == mKeys.end())
+	u = 0.f;
+	if (mNumKeys < 2 || duration <= 0.f)
 	{
-		// Past last key
-		--right;
-		value = right->second.mScale;
+		return 0;
 	}
-	else if (right == mKeys.begin() || right->first == time)
+
+	F32 t = llclamp(time / duration, 0.f, 1.f) * (F32)U16MAX;
+	if (t <= mFirst)
 	{
-		// Before first key or exactly on a key
-		value = right->second.mScale;
+		// Before first key or exactly on it
+		return 0;
 	}
-	else
+
+	S32 index;
+	if (mStep > 0.f)
 	{
-		// Between two keys
-		key_map_t::iterator left = right; --left;
-		F32 index_before = left->first;
-		F32 index_after = right->first;
-		ScaleKey& scale_before = left->second;
-		ScaleKey& scale_after = right->second;
-		if (right == mKeys.end())
+		F32 f = (t - mFirst) / mStep;
+		index = llmin((S32)f, mNumKeys - 1);
+		if (index < mNumKeys - 1)
 		{
-			scale_after = mLoopInKey;
-			index_after = duration;
+			u = f - (F32)index;
 		}
+		return index;
+	}
 
-		F32 u = (time - index_before) / (index_after - index_before);
-		value = interp(u, scale_before, scale_after);
+	// the key is between the one this bucket starts at and the one the next
+	// bucket starts at; keys bunched into one bucket are binary searched
+	S32 bucket = llmin((S32)(t * (F32)mNumKeys / 65536.f), mNumKeys - 1);
+	S32 first = mBuckets[bucket];
+	S32 last = (bucket + 1 < mNumKeys) ? mBuckets[bucket + 1] : mNumKeys - 1;
+	std::vector<U16>::const_iterator after = std::upper_bound(mTimes.begin() + first + 1, mTimes.begin() + last + 1, t,
+		[](F32 quantised, U16 key_time)
+		{
+			return quantised < (F32)key_time;
+		});
+	index = (S32)(after - mTimes.begin()) - 1;
+	while (index + 1 < mNumKeys && (F32)mTimes[index + 1] <= t)
+	{ //rounding put t in the bucket before the one it starts
+		++index;
 	}
-	return value;
+	if (index < mNumKeys - 1)
+	{
+		u = (t - (F32)mTimes[index]) / (F32)(mTimes[index + 1] - mTimes[index]);
+	}
+	return index;
 }
 
 //-----------------------------------------------------------------------------
-// interp()
+// KeyTimes::getTime()
 //-----------------------------------------------------------------------------
-LLVector3 LLKeyframeMotion::ScaleCurve::interp(F32 u, ScaleKey& before, ScaleKey& after)
+U16 LLKeyframeMotion::KeyTimes::getTime(S32 index) const
 {
-	switch (mInterpolationType)
+	if (mTimes.empty())
 	{
-	case IT_STEP:
-		return before.mScale;
-
-	default:
-	case IT_LINEAR:
-	case IT_SPLINE:
-		return lerp(before.mScale, after.mScale, u);
+		return (U16)ll_round(mFirst + (F32)index * mStep);
 	}
+	return mTimes[index];
+}
+
+//-----------------------------------------------------------------------------
+// KeyTimes::sizeBytes()
+//-----------------------------------------------------------------------------
+U32 LLKeyframeMotion::KeyTimes::sizeBytes() const
+{
+	return sizeof(KeyTimes) + (U32)(mTimes.capacity() + mBuckets.capacity()) * sizeof(U16);
 }
 
 //-----------------------------------------------------------------------------
@@ -218,76 +323,39 @@ LLKeyframeMotion::RotationCurve::RotationCurve()
 }
 
 //-----------------------------------------------------------------------------
-// RotationCurve::~RotationCurve()
+// RotationCurve::getKey()
 //-----------------------------------------------------------------------------
-LLKeyframeMotion::RotationCurve::~RotationCurve()
+LLQuaternion LLKeyframeMotion::RotationCurve::getKey(S32 index) const
 {
-	mKeys.clear();
-	mNumKeys = 0;
+	const U16* key = &mKeys[index * 3];
+	LLVector3 rot_vec(U16_to_F32(key[VX], -1.f, 1.f),
+					  U16_to_F32(key[VY], -1.f, 1.f),
+					  U16_to_F32(key[VZ], -1.f, 1.f));
+	LLQuaternion rot;
+	rot.unpackFromVector3(rot_vec);
+	return rot;
 }
 
 //-----------------------------------------------------------------------------
 // RotationCurve::getValue()
 //-----------------------------------------------------------------------------
-LLQuaternion LLKeyframeMotion::RotationCurve::getValue(F32 time, F32 duration)
+LLQuaternion LLKeyframeMotion::RotationCurve::getValue(F32 time, F32 duration) const
 {
-	LLQuaternion value;
-
-	if (mKeys.empty())
-	{
-		value = LLQuaternion::DEFAULT;
-		return value;
-	}
-	
-	key_map_t::iterator right = mKeys.lower_bound(time);
-	if (right == mKeys.end())
-	{
-		// Past last key
-		--right;
-		value = right->second.mRotation;
-	}
-	else if (right == mKeys.begin() || right->first == time)
+	if (mNumKeys == 0)
 	{
-		// Before first key or exactly on a key
-		value = right->second.mRotation;
+		return LLQuaternion::DEFAULT;
 	}
-	else
-	{
-		// Between two keys
-		key_map_t::iterator left = right; --left;
-		F32 index_before = left->first;
-		F32 index_after = right->first;
-		RotationKey& rot_before = left->second;
-		RotationKey& rot_after = right->second;
-		if (right == mKeys.end())
-		{
-			rot_after = mLoopInKey;
-			index_after = duration;
-		}
 
-		F32 u = (time - index_before) / (index_after - index_before);
-		value = interp(u, rot_before, rot_after);
-	}
-	return value;
-}
-
-//-----------------------------------------------------------------------------
-// interp()
-//-----------------------------------------------------------------------------
-LLQuaternion LLKeyframeMotion::RotationCurve::interp(F32 u, RotationKey& before, RotationKey& after)
-{
-	switch (mInterpolationType)
+	F32 u;
+	S32 index = mTimes.find(time, duration, u);
+	if (u <= 0.f || mInterpolationType == IT_STEP)
 	{
-	case IT_STEP:
-		return before.mRotation;
-
-	default:
-	case IT_LINEAR:
-	case IT_SPLINE:
-		return nlerp(u, before.mRotation, after.mRotation);
+		return getKey(index);
 	}
-}
 
+	// Between two keys
+	return nlerp(u, getKey(index), getKey(index + 1));
+}
 
 //-----------------------------------------------------------------------------
 // PositionCurve::PositionCurve()
@@ -299,76 +367,39 @@ LLKeyframeMotion::PositionCurve::PositionCurve()
 }
 
 //-----------------------------------------------------------------------------
-// PositionCurve::~PositionCurve()
+// PositionCurve::getKey()
 //-----------------------------------------------------------------------------
-LLKeyframeMotion::PositionCurve::~PositionCurve()
+LLVector3 LLKeyframeMotion::PositionCurve::getKey(S32 index) const
 {
-	mKeys.clear();
-	mNumKeys = 0;
+	const U16* key = &mKeys[index * 3];
+	return LLVector3(U16_to_F32(key[VX], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET),
+					 U16_to_F32(key[VY], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET),
+					 U16_to_F32(key[VZ], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET));
 }
 
 //-----------------------------------------------------------------------------
 // PositionCurve::getValue()
 //-----------------------------------------------------------------------------
-LLVector3 LLKeyframeMotion::PositionCurve::getValue(F32 time, F32 duration)
+LLVector3 LLKeyframeMotion::PositionCurve::getValue(F32 time, F32 duration) const
 {
-	LLVector3 value;
-
-	if (mKeys.empty())
-	{
-		value.clearVec();
-		return value;
-	}
-	
-	key_map_t::iterator right = mKeys.lower_bound(time);
-	if (right == mKeys.end())
+	if (mNumKeys == 0)
 	{
-		// Past last key
-		--right;
-		value = right->second.mPosition;
+		return LLVector3::zero;
 	}
-	else if (right == mKeys.begin() || right->first == time)
+
+	F32 u;
+	S32 index = mTimes.find(time, duration, u);
+	if (u <= 0.f || mInterpolationType == IT_STEP)
 	{
-		// Before first key or exactly on a key
-		value = right->second.mPosition;
+		return getKey(index);
 	}
-	else
-	{
-		// Between two keys
-		key_map_t::iterator left = right; --left;
-		F32 index_before = left->first;
-		F32 index_after = right->first;
-		PositionKey& pos_before = left->second;
-		PositionKey& pos_after = right->second;
-		if (right == mKeys.end())
-		{
-			pos_after = mLoopInKey;
-			index_after = duration;
-		}
 
-		F32 u = (time - index_before) / (index_after - index_before);
-		value = interp(u, pos_before, pos_after);
-	}
+	// Between two keys
+	LLVector3 value = lerp(getKey(index), getKey(index + 1), u);
 
 	llassert(value.isFinite());
-	
-	return value;
-}
 
-//-----------------------------------------------------------------------------
-// interp()
-//-----------------------------------------------------------------------------
-LLVector3 LLKeyframeMotion::PositionCurve::interp(F32 u, PositionKey& before, PositionKey& after)
-{
-	switch (mInterpolationType)
-	{
-	case IT_STEP:
-		return before.mPosition;
-	default:
-	case IT_LINEAR:
-	case IT_SPLINE:
-		return lerp(before.mPosition, after.mPosition, u);
-	}
+	return value;
 }
 
 
@@ -392,14 +423,6 @@ void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time,
 
 	U32 usage = joint_state->getUsage();
 
-	//-------------------------------------------------------------------------
-	// update scale component of joint state
-	//-------------------------------------------------------------------------
-	if ((usage & LLJointState::SCALE) && mScaleCurve.mNumKeys)
-	{
-		joint_state->setScale( mScaleCurve.getValue( time, duration ) );
-	}
-
 	//-------------------------------------------------------------------------
 	// update rotation component of joint state
 	//-------------------------------------------------------------------------
@@ -1531,11 +1554,15 @@ bool LLKeyframeMotion::deserialize(LLDataPacker& dp, const LLUUID& asset_id, boo
 		// scan rotation curve keys
 		//---------------------------------------------------------------------
 		RotationCurve *rCurve = &joint_motion->mRotationCurve;
+		// grown as keys are read, the count comes from the asset
+		std::vector<QuantizedKey> keys;
 
-		for (S32 k = 0; k < joint_motion->mRotationCurve.mNumKeys; k++)
+		for (S32 k = 0; k < rCurve->mNumKeys; k++)
 		{
 			F32 time;
 			U16 time_short;
+			keys.emplace_back();
+			QuantizedKey& rot_key = keys.back();
 
 			if (old_version)
 			{
@@ -1547,6 +1574,7 @@ bool LLKeyframeMotion::deserialize(LLDataPacker& dp, const LLUUID& asset_id, boo
 					return false;
 				}
 
+				time_short = quantize_time(time, joint_motion_list->mDuration);
 			}
 			else
 			{
@@ -1567,13 +1595,11 @@ bool LLKeyframeMotion::deserialize(LLDataPacker& dp, const LLUUID& asset_id, boo
 				}
 			}
 			
-			RotationKey rot_key;
-			rot_key.mTime = time;
-			LLVector3 rot_angles;
-			U16 x, y, z;
+			rot_key.mTime = time_short;
 
 			if (old_version)
 			{
+				LLVector3 rot_angles;
 				if (!dp.unpackVector3(rot_angles, "rot_angles"))
 				{
 					LL_WARNS() << "can't read rot_angles in rotation key (" << k << ")" << LL_ENDL;
@@ -1586,51 +1612,42 @@ bool LLKeyframeMotion::deserialize(LLDataPacker& dp, const LLUUID& asset_id, boo
 				}
 
 				LLQuaternion::Order ro = StringToOrder("ZYX");
-				rot_key.mRotation = mayaQ(rot_angles.mV[VX], rot_angles.mV[VY], rot_angles.mV[VZ], ro);
+				LLQuaternion rotation = mayaQ(rot_angles.mV[VX], rot_angles.mV[VY], rot_angles.mV[VZ], ro);
+				if (!rotation.isFinite())
+				{
+					LL_WARNS() << "non-finite angle in rotation key (" << k << ")"
+                               << " for animation " << asset_id << LL_ENDL;
+					return false;
+				}
+
+				LLVector3 rot_vec = rotation.packToVector3();
+				for (U32 i = 0; i < 3; i++)
+				{
+					rot_key.mValue[i] = F32_to_U16_ROUND(rot_vec.mV[i], -1.f, 1.f);
+				}
 			}
 			else
 			{
-				if (!dp.unpackU16(x, "rot_angle_x"))
+				if (!dp.unpackU16(rot_key.mValue[VX], "rot_angle_x"))
 				{
 					LL_WARNS() << "can't read rot_angle_x in rotation key (" << k << ")" << LL_ENDL;
 					return false;
 				}
-				if (!dp.unpackU16(y, "rot_angle_y"))
+				if (!dp.unpackU16(rot_key.mValue[VY], "rot_angle_y"))
 				{
 					LL_WARNS() << "can't read rot_angle_y in rotation key (" << k << ")" << LL_ENDL;
 					return false;
 				}
-				if (!dp.unpackU16(z, "rot_angle_z"))
+				if (!dp.unpackU16(rot_key.mValue[VZ], "rot_angle_z"))
 				{
 					LL_WARNS() << "can't read rot_angle_z in rotation key (" << k << ")" << LL_ENDL;
 					return false;
 				}
-
-				LLVector3 rot_vec;
-				rot_vec.mV[VX] = U16_to_F32(x, -1.f, 1.f);
-				rot_vec.mV[VY] = U16_to_F32(y, -1.f, 1.f);
-				rot_vec.mV[VZ] = U16_to_F32(z, -1.f, 1.f);
-
-				if(!rot_vec.isFinite())
-				{
-					LL_WARNS() << "non-finite angle in rotation key (" << k << ")"
-						<< " for animation " << asset_id << LL_ENDL;
-					return false;
-				}
-				rot_key.mRotation.unpackFromVector3(rot_vec);
 			}
-
-			if(!rot_key.mRotation.isFinite())
-			{
-				LL_WARNS() << "non-finite angle in rotation key (" << k << ")"
-                           << " for animation " << asset_id << LL_ENDL;
-				return false;
-			}
-
-			rCurve->mKeys[time] = rot_key;
 		}
 
-        if (joint_motion->mRotationCurve.mNumKeys > joint_motion->mRotationCurve.mKeys.size())
+		rCurve->mNumKeys = buildCurve(keys, rCurve->mTimes, rCurve->mKeys);
+        if (keys.size() > (size_t)rCurve->mNumKeys)
         {
             rotation_dupplicates++;
             LL_INFOS() << "Motion: " << asset_id << " had dupplicate rotation keys that were removed" << LL_ENDL;
@@ -1657,88 +1674,86 @@ bool LLKeyframeMotion::deserialize(LLDataPacker& dp, const LLUUID& asset_id, boo
 		//---------------------------------------------------------------------
 		PositionCurve *pCurve = &joint_motion->mPositionCurve;
 		bool is_pelvis = joint_motion->mJointName == "mPelvis";
-		for (S32 k = 0; k < joint_motion->mPositionCurve.mNumKeys; k++)
+		keys.clear();
+		for (S32 k = 0; k < pCurve->mNumKeys; k++)
 		{
-			U16 time_short;
-			PositionKey pos_key;
+			keys.emplace_back();
+			QuantizedKey& pos_key = keys.back();
 
 			if (old_version)
 			{
-				if (!dp.unpackF32(pos_key.mTime, "time") ||
-				    !llfinite(pos_key.mTime))
+				F32 time;
+				if (!dp.unpackF32(time, "time") ||
+				    !llfinite(time))
 				{
 					LL_WARNS() << "can't read position key (" << k << ")"
                                << " for animation " << asset_id << LL_ENDL;
 					return false;
 				}
+
+				pos_key.mTime = quantize_time(time, joint_motion_list->mDuration);
 			}
 			else
 			{
-				if (!dp.unpackU16(time_short, "time"))
+				if (!dp.unpackU16(pos_key.mTime, "time"))
 				{
 					LL_WARNS() << "can't read position key (" << k << ")"
                                << " for animation " << asset_id << LL_ENDL;
 					return false;
 				}
-
-				pos_key.mTime = U16_to_F32(time_short, 0.f, joint_motion_list->mDuration);
 			}
 
+			LLVector3 position;
 			if (old_version)
 			{
-				if (!dp.unpackVector3(pos_key.mPosition, "pos"))
+				if (!dp.unpackVector3(position, "pos"))
 				{
 					LL_WARNS() << "can't read pos in position key (" << k << ")" << LL_ENDL;
 					return false;
 				}
-                
+
+				if (!position.isFinite())
+				{
+					LL_WARNS() << "non-finite position in key"
+                               << " for animation " << asset_id << LL_ENDL;
+					return false;
+				}
+
                 //MAINT-6162
-                pos_key.mPosition.mV[VX] = llclamp( pos_key.mPosition.mV[VX], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
-                pos_key.mPosition.mV[VY] = llclamp( pos_key.mPosition.mV[VY], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
-                pos_key.mPosition.mV[VZ] = llclamp( pos_key.mPosition.mV[VZ], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
-                
+				for (U32 i = 0; i < 3; i++)
+				{
+					pos_key.mValue[i] = F32_to_U16_ROUND(position.mV[i], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
+				}
 			}
 			else
 			{
-				U16 x, y, z;
-
-				if (!dp.unpackU16(x, "pos_x"))
+				if (!dp.unpackU16(pos_key.mValue[VX], "pos_x"))
 				{
 					LL_WARNS() << "can't read pos_x in position key (" << k << ")" << LL_ENDL;
 					return false;
 				}
-				if (!dp.unpackU16(y, "pos_y"))
+				if (!dp.unpackU16(pos_key.mValue[VY], "pos_y"))
 				{
 					LL_WARNS() << "can't read pos_y in position key (" << k << ")" << LL_ENDL;
 					return false;
 				}
-				if (!dp.unpackU16(z, "pos_z"))
+				if (!dp.unpackU16(pos_key.mValue[VZ], "pos_z"))
 				{
 					LL_WARNS() << "can't read pos_z in position key (" << k << ")" << LL_ENDL;
 					return false;
 				};
-
-				pos_key.mPosition.mV[VX] = U16_to_F32(x, -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
-				pos_key.mPosition.mV[VY] = U16_to_F32(y, -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
-				pos_key.mPosition.mV[VZ] = U16_to_F32(z, -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
-			}
-			
-			if(!pos_key.mPosition.isFinite())
-			{
-				LL_WARNS() << "non-finite position in key"
-                           << " for animation " << asset_id << LL_ENDL;
-				return false;
 			}
-			
-			pCurve->mKeys[pos_key.mTime] = pos_key;
 
 			if (is_pelvis)
 			{
-				joint_motion_list->mPelvisBBox.addPoint(pos_key.mPosition);
+				joint_motion_list->mPelvisBBox.addPoint(LLVector3(U16_to_F32(pos_key.mValue[VX], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET),
+																  U16_to_F32(pos_key.mValue[VY], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET),
+																  U16_to_F32(pos_key.mValue[VZ], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET)));
 			}
 		}
 
-        if (joint_motion->mPositionCurve.mNumKeys > joint_motion->mPositionCurve.mKeys.size())
+		pCurve->mNumKeys = buildCurve(keys, pCurve->mTimes, pCurve->mKeys);
+        if (keys.size() > (size_t)pCurve->mNumKeys)
         {
             position_dupplicates++;
         }
@@ -2035,49 +2050,36 @@ bool LLKeyframeMotion::serialize(LLDataPacker& dp) const
 		JointMotion* joint_motionp = mJointMotionList->getJointMotion(i);
 		success &= dp.packString(joint_motionp->mJointName, "joint_name");
 		success &= dp.packS32(joint_motionp->mPriority, "joint_priority");
-        success &= dp.packS32(joint_motionp->mRotationCurve.mKeys.size(), "num_rot_keys");
+		const RotationCurve& rot_curve = joint_motionp->mRotationCurve;
+		const PositionCurve& pos_curve = joint_motionp->mPositionCurve;
+		success &= dp.packS32(rot_curve.mNumKeys, "num_rot_keys");
 
 		LL_DEBUGS("BVH") << "Joint " << i
             << " name: " << joint_motionp->mJointName
-            << " Rotation keys: " << joint_motionp->mRotationCurve.mKeys.size()
-            << " Position keys: " << joint_motionp->mPositionCurve.mKeys.size() << LL_ENDL;
-		for (RotationCurve::key_map_t::value_type& rot_pair : joint_motionp->mRotationCurve.mKeys)
+            << " Rotation keys: " << rot_curve.mNumKeys
+            << " Position keys: " << pos_curve.mNumKeys << LL_ENDL;
+		// keys are kept quantised as read, write them back unchanged
+		for (S32 k = 0; k < rot_curve.mNumKeys; k++)
 		{
-			RotationKey& rot_key = rot_pair.second;
-			U16 time_short = F32_to_U16(rot_key.mTime, 0.f, mJointMotionList->mDuration);
-			success &= dp.packU16(time_short, "time");
-
-			LLVector3 rot_angles = rot_key.mRotation.packToVector3();
-			
-			U16 x, y, z;
-			rot_angles.quantize16(-1.f, 1.f, -1.f, 1.f);
-			x = F32_to_U16(rot_angles.mV[VX], -1.f, 1.f);
-			y = F32_to_U16(rot_angles.mV[VY], -1.f, 1.f);
-			z = F32_to_U16(rot_angles.mV[VZ], -1.f, 1.f);
-			success &= dp.packU16(x, "rot_angle_x");
-			success &= dp.packU16(y, "rot_angle_y");
-			success &= dp.packU16(z, "rot_angle_z");
+			const U16* rot_key = &rot_curve.mKeys[k * 3];
+			success &= dp.packU16(rot_curve.mTimes.getTime(k), "time");
+			success &= dp.packU16(rot_key[VX], "rot_angle_x");
+			success &= dp.packU16(rot_key[VY], "rot_angle_y");
+			success &= dp.packU16(rot_key[VZ], "rot_angle_z");
 
-			LL_DEBUGS("BVH") << "  rot: t " << rot_key.mTime << " angles " << rot_angles.mV[VX] <<","<< rot_angles.mV[VY] <<","<< rot_angles.mV[VZ] << LL_ENDL;
+			LL_DEBUGS("BVH") << "  rot: t " << rot_curve.mTimes.getTime(k) << " rot " << rot_curve.getKey(k) << LL_ENDL;
 		}
 
-		success &= dp.packS32(joint_motionp->mPositionCurve.mKeys.size(), "num_pos_keys");
-		for (PositionCurve::key_map_t::value_type& pos_pair : joint_motionp->mPositionCurve.mKeys)
+		success &= dp.packS32(pos_curve.mNumKeys, "num_pos_keys");
+		for (S32 k = 0; k < pos_curve.mNumKeys; k++)
 		{
-			PositionKey& pos_key = pos_pair.second;
-			U16 time_short = F32_to_U16(pos_key.mTime, 0.f, mJointMotionList->mDuration);
-			success &= dp.packU16(time_short, "time");
+			const U16* pos_key = &pos_curve.mKeys[k * 3];
+			success &= dp.packU16(pos_curve.mTimes.getTime(k), "time");
+			success &= dp.packU16(pos_key[VX], "pos_x");
+			success &= dp.packU16(pos_key[VY], "pos_y");
+			success &= dp.packU16(pos_key[VZ], "pos_z");
 
-			U16 x, y, z;
-			pos_key.mPosition.quantize16(-LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET, -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
-			x = F32_to_U16(pos_key.mPosition.mV[VX], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
-			y = F32_to_U16(pos_key.mPosition.mV[VY], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
-			z = F32_to_U16(pos_key.mPosition.mV[VZ], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
-			success &= dp.packU16(x, "pos_x");
-			success &= dp.packU16(y, "pos_y");
-			success &= dp.packU16(z, "pos_z");
-
-			LL_DEBUGS("BVH") << "  pos: t " << pos_key.mTime << " pos " << pos_key.mPosition.mV[VX] <<","<< pos_key.mPosition.mV[VY] <<","<< pos_key.mPosition.mV[VZ] << LL_ENDL;
+			LL_DEBUGS("BVH") << "  pos: t " << pos_curve.mTimes.getTime(k) << " pos " << pos_curve.getKey(k) << LL_ENDL;
 		}
 	}	
 
@@ -2306,24 +2308,6 @@ void LLKeyframeMotion::setLoopIn(F32 in_point)
 	if (mJointMotionList)
 	{
 		mJointMotionList->mLoopInPoint = in_point; 
-		
-		// set up loop keys
-		for (U32 i = 0; i < mJointMotionList->getNumJointMotions(); i++)
-		{
-			JointMotion* joint_motion = mJointMotionList->getJointMotion(i);
-			
-			PositionCurve* pos_curve = &joint_motion->mPositionCurve;
-			RotationCurve* rot_curve = &joint_motion->mRotationCurve;
-			ScaleCurve* scale_curve = &joint_motion->mScaleCurve;
-			
-			pos_curve->mLoopInKey.mTime = mJointMotionList->mLoopInPoint;
-			rot_curve->mLoopInKey.mTime = mJointMotionList->mLoopInPoint;
-			scale_curve->mLoopInKey.mTime = mJointMotionList->mLoopInPoint;
-
-			pos_curve->mLoopInKey.mPosition = pos_curve->getValue(mJointMotionList->mLoopInPoint, mJointMotionList->mDuration);
-			rot_curve->mLoopInKey.mRotation = rot_curve->getValue(mJointMotionList->mLoopInPoint, mJointMotionList->mDuration);
-			scale_curve->mLoopInKey.mScale = scale_curve->getValue(mJointMotionList->mLoopInPoint, mJointMotionList->mDuration);
-		}
 	}
 }
 
@@ -2335,24 +2319,6 @@ void LLKeyframeMotion::setLoopOut(F32 out_point)
 	if (mJointMotionList)
 	{
 		mJointMotionList->mLoopOutPoint = out_point; 
-		
-		// set up loop keys
-		for (U32 i = 0; i < mJointMotionList->getNumJointMotions(); i++)
-		{
-			JointMotion* joint_motion = mJointMotionList->getJointMotion(i);
-			
-			PositionCurve* pos_curve = &joint_motion->mPositionCurve;
-			RotationCurve* rot_curve = &joint_motion->mRotationCurve;
-			ScaleCurve* scale_curve = &joint_motion->mScaleCurve;
-			
-			pos_curve->mLoopOutKey.mTime = mJointMotionList->mLoopOutPoint;
-			rot_curve->mLoopOutKey.mTime = mJointMotionList->mLoopOutPoint;
-			scale_curve->mLoopOutKey.mTime = mJointMotionList->mLoopOutPoint;
-
-			pos_curve->mLoopOutKey.mPosition = pos_curve->getValue(mJointMotionList->mLoopOutPoint, mJointMotionList->mDuration);
-			rot_curve->mLoopOutKey.mRotation = rot_curve->getValue(mJointMotionList->mLoopOutPoint, mJointMotionList->mDuration);
-			scale_curve->mLoopOutKey.mScale = scale_curve->getValue(mJointMotionList->mLoopOutPoint, mJointMotionList->mDuration);
-		}
 	}
 }
 
@@ -2467,6 +2433,77 @@ void LLKeyframeDataCache::dumpDiagInfo()
 	LL_INFOS() << "-----------------------------------------------------" << LL_ENDL;
 }
 
+//--------------------------------------------------------------------
+// LLKeyframeDataCache::sizeBytes()
+//--------------------------------------------------------------------
+U32 LLKeyframeDataCache::sizeBytes()
+{
+	U32 total_size = 0;
+	for (keyframe_data_map_t::value_type& data_pair : sKeyframeDataMap)
+	{
+		total_size += data_pair.second->sizeBytes();
+	}
+	return total_size;
+}
+
+//--------------------------------------------------------------------
+// LLKeyframeDataCache::benchmark()
+//--------------------------------------------------------------------
+F64 LLKeyframeDataCache::benchmark(U32 characters, U32 motions, U32 frames, U32& sampled)
+{
+	std::vector<LLKeyframeMotion::JointMotionList*> lists;
+	for (keyframe_data_map_t::value_type& data_pair : sKeyframeDataMap)
+	{
+		if (lists.size() >= motions)
+		{
+			break;
+		}
+		if (data_pair.second->mDuration > 0.f)
+		{
+			lists.push_back(data_pair.second);
+		}
+	}
+	sampled = (U32)lists.size();
+	if (lists.empty() || frames == 0)
+	{
+		return 0.0;
+	}
+
+	// one joint state per joint motion of every clip for every character
+	std::vector<LLPointer<LLJointState> > joint_states;
+	for (U32 c = 0; c < characters; ++c)
+	{
+		for (LLKeyframeMotion::JointMotionList* list : lists)
+		{
+			for (U32 i = 0; i < list->getNumJointMotions(); ++i)
+			{
+				LLPointer<LLJointState> joint_state = new LLJointState;
+				joint_state->setUsage(list->getJointMotion(i)->mUsage);
+				joint_states.push_back(joint_state);
+			}
+		}
+	}
+
+	LLTimer timer;
+	for (U32 frame = 0; frame < frames; ++frame)
+	{
+		S32 state = 0;
+		for (U32 c = 0; c < characters; ++c)
+		{
+			// characters start their clips at different times
+			F32 time = (F32)frame / 30.f + (F32)c * 0.37f;
+			for (LLKeyframeMotion::JointMotionList* list : lists)
+			{
+				F32 clip_time = fmodf(time, list->mDuration);
+				for (U32 i = 0; i < list->getNumJointMotions(); ++i)
+				{
+					list->getJointMotion(i)->update(joint_states[state++], clip_time, list->mDuration);
+				}
+			}
+		}
+	}
+	return timer.getElapsedTimeF64() * 1000.0 / (F64)frames;
+}
 
 //--------------------------------------------------------------------
 // LLKeyframeDataCache::addKeyframeData()
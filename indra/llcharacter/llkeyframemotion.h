@@ -284,62 +284,43 @@ public:
 	enum InterpolationType { IT_STEP, IT_LINEAR, IT_SPLINE };
 
 	//-------------------------------------------------------------------------
-	// ScaleKey
+	// KeyTimes
+	// Sorted key times of one curve, quantised to 16 bits over the motion
+	// duration as in the asset.  Evenly spaced keys (most uploads are
+	// sampled at a fixed frame rate) are stored as a first time and a step
+	// only, and finding the keys around a time takes constant time.
+	// Otherwise a bucket table maps a time to the keys it falls between,
+	// and the search is a binary search over those, usually one or two.
 	//-------------------------------------------------------------------------
-	class ScaleKey
+	class KeyTimes
 	{
 	public:
-		ScaleKey() { mTime = 0.0f; }
-		ScaleKey(F32 time, const LLVector3 &scale) { mTime = time; mScale = scale; }
+		KeyTimes();
+		void init(const std::vector<U16>& times);
+		// index of the last key at or before time, clamped to the keys, and
+		// how far time is towards the next key
+		S32 find(F32 time, F32 duration, F32& u) const;
+		U16 getTime(S32 index) const;
+		U32 sizeBytes() const;
 
-		F32			mTime;
-		LLVector3	mScale;
+		S32					mNumKeys;
+		F32					mFirst;
+		F32					mStep;		// > 0 when the keys are evenly spaced
+		std::vector<U16>	mTimes;		// empty when they are
+		std::vector<U16>	mBuckets;
 	};
 
-	//-------------------------------------------------------------------------
-	// RotationKey
-	//-------------------------------------------------------------------------
-	class RotationKey
+	// a curve key as stored in the asset
+	struct QuantizedKey
 	{
-	public:
-		RotationKey() { mTime = 0.0f; }
-		RotationKey(F32 time, const LLQuaternion &rotation) { mTime = time; mRotation = rotation; }
-
-		F32				mTime;
-		LLQuaternion	mRotation;
+		U16 mTime;
+		U16 mValue[3];
 	};
 
-	//-------------------------------------------------------------------------
-	// PositionKey
-	//-------------------------------------------------------------------------
-	class PositionKey
-	{
-	public:
-		PositionKey() { mTime = 0.0f; }
-		PositionKey(F32 time, const LLVector3 &position) { mTime = time; mPosition = position; }
-
-		F32			mTime;
-		LLVector3	mPosition;
-	};
-
-	//-------------------------------------------------------------------------
-	// ScaleCurve
-	//-------------------------------------------------------------------------
-	class ScaleCurve
-	{
-	public:
-		ScaleCurve();
-		~ScaleCurve();
-		LLVector3 getValue(F32 time, F32 duration);
-		LLVector3 interp(F32 u, ScaleKey& before, ScaleKey& after);
-
-		InterpolationType	mInterpolationType;
-		S32					mNumKeys;
-		typedef std::map<F32, ScaleKey> key_map_t;
-		key_map_t 			mKeys;
-		ScaleKey			mLoopInKey;
-		ScaleKey			mLoopOutKey;
-	};
+	// Sort keys read from an asset by time, keeping the last one read for
+	// any time that repeats, and store them in key_times and values.
+	// Returns the number of keys kept.
+	static S32 buildCurve(std::vector<QuantizedKey>& keys, KeyTimes& key_times, std::vector<U16>& values);
 
 	//-------------------------------------------------------------------------
 	// RotationCurve
@@ -348,16 +329,15 @@ public:
 	{
 	public:
 		RotationCurve();
-		~RotationCurve();
-		LLQuaternion getValue(F32 time, F32 duration);
-		LLQuaternion interp(F32 u, RotationKey& before, RotationKey& after);
+		LLQuaternion getValue(F32 time, F32 duration) const;
+		LLQuaternion getKey(S32 index) const;
 
 		InterpolationType	mInterpolationType;
 		S32					mNumKeys;
-		typedef std::map<F32, RotationKey> key_map_t;
-		key_map_t		mKeys;
-		RotationKey		mLoopInKey;
-		RotationKey		mLoopOutKey;
+		KeyTimes			mTimes;
+		// x, y, z of LLQuaternion::packToVector3() per key, quantised over
+		// [-1, 1] as in the asset
+		std::vector<U16>	mKeys;
 	};
 
 	//-------------------------------------------------------------------------
@@ -367,16 +347,15 @@ public:
 	{
 	public:
 		PositionCurve();
-		~PositionCurve();
-		LLVector3 getValue(F32 time, F32 duration);
-		LLVector3 interp(F32 u, PositionKey& before, PositionKey& after);
+		LLVector3 getValue(F32 time, F32 duration) const;
+		LLVector3 getKey(S32 index) const;
 
 		InterpolationType	mInterpolationType;
 		S32					mNumKeys;
-		typedef std::map<F32, PositionKey> key_map_t;
-		key_map_t		mKeys;
-		PositionKey		mLoopInKey;
-		PositionKey		mLoopOutKey;
+		KeyTimes			mTimes;
+		// x, y, z per key, quantised over +/- LL_MAX_PELVIS_OFFSET as in
+		// the asset
+		std::vector<U16>	mKeys;
 	};
 
 	//-------------------------------------------------------------------------
@@ -387,7 +366,6 @@ public:
 	public:
 		PositionCurve	mPositionCurve;
 		RotationCurve	mRotationCurve;
-		ScaleCurve		mScaleCurve;
 		std::string		mJointName;
 		U32				mUsage;
 		LLJoint::JointPriority	mPriority;
@@ -422,6 +400,7 @@ public:
 		JointMotionList();
 		~JointMotionList();
 		U32 dumpDiagInfo();
+		U32 sizeBytes() const;
 		JointMotion* getJointMotion(U32 index) const { llassert(index < mJointMotionArray.size()); return mJointMotionArray[index]; }
 		U32 getNumJointMotions() const { return mJointMotionArray.size(); }
 	};
@@ -459,6 +438,13 @@ public:
 
 	//print out diagnostic info
 	static void dumpDiagInfo();
+	static U32 sizeBytes();
+
+	// Sample every curve of up to motions cached clips for each of
+	// characters characters, as LLKeyframeMotion::onUpdate() does, over
+	// frames frames of 1/30 s.  Returns the mean milliseconds per frame and
+	// sets sampled to the number of clips used, those with a duration.
+	static F64 benchmark(U32 characters, U32 motions, U32 frames, U32& sampled);
 	static void clear();
 };
 
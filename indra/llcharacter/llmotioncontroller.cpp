@@ -805,6 +805,17 @@ void LLMotionController::updateLoadingMotions()
 // updateMotion()
 //-----------------------------------------------------------------------------
 void LLMotionController::updateMotions(bool force_update)
+{
+	if (beginMotionUpdate())
+	{
+		evaluateMotions(force_update);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// beginMotionUpdate()
+//-----------------------------------------------------------------------------
+bool LLMotionController::beginMotionUpdate()
 {
     // SL-763: "Distant animated objects run at super fast speed"
     // The use_quantum optimization or possibly the associated code in setTimeStamp()
@@ -843,7 +854,7 @@ void LLMotionController::updateMotions(bool force_update)
 
 				updateLoadingMotions();
 				
-				return;
+				return false;
 			}
 			
 			// is calculating a new keyframe pose, make sure the last one gets applied
@@ -861,7 +872,17 @@ void LLMotionController::updateMotions(bool force_update)
 	}
 
 	updateLoadingMotions();
-	
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// evaluateMotions()
+//-----------------------------------------------------------------------------
+void LLMotionController::evaluateMotions(bool force_update)
+{
+	bool use_quantum = (mTimeStep != 0.f);
+
 	resetJointSignatures();
 
 	if (mPaused && !force_update)
@@ -132,6 +132,15 @@ public:
 	// deactivates terminated motions`
 	void updateMotions(bool force_update = false);
 
+	// updateMotions() in two steps, for callers animating several characters
+	// at once.  beginMotionUpdate() purges, advances the clock and finishes
+	// loading motions, which may touch the asset system, and must run on the
+	// main thread; it returns false if there is nothing to evaluate this
+	// frame.  evaluateMotions() runs and blends the active motions and only
+	// touches this character, so it may run on any thread.
+	bool beginMotionUpdate();
+	void evaluateMotions(bool force_update = false);
+
 	// minimal update (e.g. while hidden)
 	void updateMotionsMinimal();
 
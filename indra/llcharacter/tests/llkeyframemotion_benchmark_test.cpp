@@ -0,0 +1,183 @@
+/**
+ * @file llkeyframemotion_benchmark_test.cpp
+ * @brief Timing of LLKeyframeMotion curve sampling against the std::map curves it replaced.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llkeyframemotion.h"
+#include "llquantize.h"
+#include "llquaternion.h"
+#include "lltimer.h"
+
+#include "../test/lltut.h"
+
+#include <map>
+#include <vector>
+
+namespace
+{
+	const S32 NUM_CLIPS = 100;
+	const S32 NUM_JOINTS = 20;
+	const S32 NUM_KEYS = 30;
+	const S32 NUM_FRAMES = 60;
+	const F32 DURATION = 2.f;
+
+	// deterministic, so every run times the same curves
+	U32 sSeed = 12345;
+	F32 next_random()
+	{
+		sSeed = sSeed * 1664525 + 1013904223;
+		return (F32)(sSeed >> 8) / (F32)(1 << 24);
+	}
+
+	// what a rotation curve was before it was quantised: key time in
+	// seconds to rotation, sampled with lower_bound
+	typedef std::map<F32, LLQuaternion> reference_curve_t;
+
+	LLQuaternion reference_value(const reference_curve_t& keys, F32 time)
+	{
+		reference_curve_t::const_iterator right = keys.lower_bound(time);
+		if (right == keys.end())
+		{
+			// Past last key
+			--right;
+			return right->second;
+		}
+		if (right == keys.begin() || right->first == time)
+		{
+			// Before first key or exactly on a key
+			return right->second;
+		}
+
+		// Between two keys
+		reference_curve_t::const_iterator left = right; --left;
+		F32 u = (time - left->first) / (right->first - left->first);
+		return nlerp(u, left->second, right->second);
+	}
+
+	// a third of the curves evenly spaced, a third uneven and a third with
+	// most keys bunched together
+	std::vector<U16> make_times(S32 curve)
+	{
+		std::vector<U16> times(NUM_KEYS);
+		for (S32 k = 0; k < NUM_KEYS; ++k)
+		{
+			switch (curve % 3)
+			{
+			case 0:
+				times[k] = (U16)(k * (U16MAX / (NUM_KEYS - 1)));
+				break;
+			case 1:
+				times[k] = (U16)((k * U16MAX + (S32)(next_random() * 1000.f)) / NUM_KEYS);
+				break;
+			default:
+				times[k] = (k < NUM_KEYS - 2) ? (U16)(20000 + k * 8) : (U16)(60000 + k);
+				break;
+			}
+		}
+		return times;
+	}
+}
+
+namespace tut
+{
+	struct llkeyframemotion_benchmark_data
+	{
+		std::vector<LLKeyframeMotion::RotationCurve> mCurves;
+		std::vector<reference_curve_t> mReferenceCurves;
+
+		llkeyframemotion_benchmark_data()
+		:	mCurves(NUM_CLIPS * NUM_JOINTS),
+			mReferenceCurves(NUM_CLIPS * NUM_JOINTS)
+		{
+			// the same keys both ways: the reference keeps the rotations the
+			// quantised curve decodes to
+			for (S32 c = 0; c < NUM_CLIPS * NUM_JOINTS; ++c)
+			{
+				LLKeyframeMotion::RotationCurve& curve = mCurves[c];
+				std::vector<U16> times = make_times(c);
+				curve.mNumKeys = NUM_KEYS;
+				curve.mTimes.init(times);
+				for (S32 k = 0; k < NUM_KEYS; ++k)
+				{
+					LLQuaternion rot(next_random() * F_TWO_PI, LLVector3(next_random(), next_random(), 1.f + next_random()));
+					LLVector3 packed = rot.packToVector3();
+					curve.mKeys.push_back(F32_to_U16(packed.mV[VX], -1.f, 1.f));
+					curve.mKeys.push_back(F32_to_U16(packed.mV[VY], -1.f, 1.f));
+					curve.mKeys.push_back(F32_to_U16(packed.mV[VZ], -1.f, 1.f));
+				}
+				for (S32 k = 0; k < NUM_KEYS; ++k)
+				{
+					mReferenceCurves[c][(F32)times[k] / (F32)U16MAX * DURATION] = curve.getKey(k);
+				}
+			}
+		}
+	};
+
+	typedef test_group<llkeyframemotion_benchmark_data> llkeyframemotion_benchmark_test;
+	typedef llkeyframemotion_benchmark_test::object llkeyframemotion_benchmark_object;
+	tut::llkeyframemotion_benchmark_test llkeyframemotion_benchmark_testcase("LLKeyframeMotionBenchmark");
+
+	template<> template<>
+	void llkeyframemotion_benchmark_object::test<1>()
+	{
+		// 100 clips of 20 joints sampled over 60 frames, std::map curves
+		// against quantised ones; the results are compared so both sides do
+		// the same work, nothing fails on speed
+		std::vector<LLQuaternion> expected(mCurves.size() * NUM_FRAMES);
+		std::vector<LLQuaternion> values(mCurves.size() * NUM_FRAMES);
+		LLTimer timer;
+
+		timer.reset();
+		for (S32 f = 0; f < NUM_FRAMES; ++f)
+		{
+			F32 time = DURATION * (F32)f / (F32)NUM_FRAMES;
+			for (U32 c = 0; c < mReferenceCurves.size(); ++c)
+			{
+				expected[f * mCurves.size() + c] = reference_value(mReferenceCurves[c], time);
+			}
+		}
+		F64 reference_seconds = timer.getElapsedTimeF64();
+
+		timer.reset();
+		for (S32 f = 0; f < NUM_FRAMES; ++f)
+		{
+			F32 time = DURATION * (F32)f / (F32)NUM_FRAMES;
+			for (U32 c = 0; c < mCurves.size(); ++c)
+			{
+				values[f * mCurves.size() + c] = mCurves[c].getValue(time, DURATION);
+			}
+		}
+		F64 current_seconds = timer.getElapsedTimeF64();
+
+		for (U32 i = 0; i < values.size(); ++i)
+		{
+			ensure("same rotation as the map curve", dot(values[i], expected[i]) > 0.9999f || dot(values[i], expected[i]) < -0.9999f);
+		}
+
+		LL_INFOS() << NUM_CLIPS << " clips x " << NUM_JOINTS << " joints x " << NUM_FRAMES << " frames: map "
+			<< reference_seconds * 1000.0 << " ms, quantised " << current_seconds * 1000.0 << " ms" << LL_ENDL;
+	}
+}
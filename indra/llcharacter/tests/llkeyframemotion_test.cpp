@@ -0,0 +1,195 @@
+/**
+ * @file llkeyframemotion_test.cpp
+ * @brief LLKeyframeMotion curve key storage test cases.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llkeyframemotion.h"
+
+#include "../test/lltut.h"
+
+#include <vector>
+
+namespace
+{
+	// time in seconds of a quantised key time, for a one second motion
+	F32 key_seconds(F32 quantised)
+	{
+		return quantised / (F32)U16MAX;
+	}
+
+	// what find() should return, by linear search
+	S32 reference_find(const std::vector<U16>& times, F32 t)
+	{
+		S32 index = 0;
+		while (index + 1 < (S32)times.size() && (F32)times[index + 1] <= t)
+		{
+			++index;
+		}
+		return index;
+	}
+}
+
+namespace tut
+{
+	struct llkeyframemotion_data
+	{
+	};
+	typedef test_group<llkeyframemotion_data> llkeyframemotion_test;
+	typedef llkeyframemotion_test::object llkeyframemotion_object;
+	tut::llkeyframemotion_test llkeyframemotion_testcase("LLKeyframeMotion");
+
+	template<> template<>
+	void llkeyframemotion_object::test<1>()
+	{
+		// evenly spaced keys keep only a first time and a step
+		std::vector<U16> times = { 1000, 2000, 3000, 4000, 5000 };
+		LLKeyframeMotion::KeyTimes key_times;
+		key_times.init(times);
+
+		ensure_equals("key count", key_times.mNumKeys, 5);
+		ensure("step form", key_times.mStep > 0.f);
+		ensure("no time array", key_times.mTimes.empty());
+		ensure("no buckets", key_times.mBuckets.empty());
+		for (S32 k = 0; k < 5; ++k)
+		{
+			ensure_equals("key time", key_times.getTime(k), times[k]);
+		}
+
+		F32 u;
+		ensure_equals("before the first key", key_times.find(key_seconds(500.f), 1.f, u), 0);
+		ensure_equals("no blend before the first key", u, 0.f);
+
+		ensure_equals("between keys", key_times.find(key_seconds(2500.f), 1.f, u), 1);
+		ensure_approximately_equals("halfway between keys", u, 0.5f, 8);
+
+		ensure_equals("just past a key", key_times.find(key_seconds(3100.f), 1.f, u), 2);
+		ensure_approximately_equals("just past a key", u, 0.1f, 8);
+
+		ensure_equals("after the last key", key_times.find(key_seconds(60000.f), 1.f, u), 4);
+		ensure_equals("no blend after the last key", u, 0.f);
+	}
+
+	template<> template<>
+	void llkeyframemotion_object::test<2>()
+	{
+		// unevenly spaced keys go through the bucket table and find the same
+		// key as a linear search, wherever they bunch up
+		std::vector<U16> times = { 0, 10, 20, 5000, 5001, 40000, 65535 };
+		LLKeyframeMotion::KeyTimes key_times;
+		key_times.init(times);
+
+		ensure_equals("key count", key_times.mNumKeys, 7);
+		ensure_equals("bucket form", key_times.mStep, 0.f);
+		ensure("time array kept", key_times.mTimes == times);
+		ensure_equals("one bucket per key", (S32)key_times.mBuckets.size(), 7);
+		for (S32 k = 0; k < 7; ++k)
+		{
+			ensure_equals("key time", key_times.getTime(k), times[k]);
+		}
+
+		for (U32 q = 0; q <= U16MAX; q += 97)
+		{
+			F32 u;
+			S32 index = key_times.find(key_seconds((F32)q), 1.f, u);
+			ensure_equals("same key as a linear search", index, reference_find(times, (F32)q));
+			ensure("blend in range", u >= 0.f && u <= 1.f);
+		}
+
+		F32 u;
+		ensure_equals("between bunched keys", key_times.find(key_seconds(15.f), 1.f, u), 1);
+		ensure_approximately_equals("halfway between bunched keys", u, 0.5f, 8);
+	}
+
+	template<> template<>
+	void llkeyframemotion_object::test<3>()
+	{
+		// keys are sorted by time and a repeated time keeps the last key read
+		std::vector<LLKeyframeMotion::QuantizedKey> keys = {
+			{ 300, { 30, 31, 32 } },
+			{ 100, { 10, 11, 12 } },
+			{ 200, { 20, 21, 22 } },
+			{ 100, { 40, 41, 42 } },
+		};
+
+		LLKeyframeMotion::KeyTimes key_times;
+		std::vector<U16> values;
+		S32 count = LLKeyframeMotion::buildCurve(keys, key_times, values);
+
+		ensure_equals("duplicate time dropped", count, 3);
+		ensure_equals("key times count", key_times.mNumKeys, 3);
+		ensure_equals("three values per key", (S32)values.size(), 9);
+
+		const U16 expected_times[] = { 100, 200, 300 };
+		const U16 expected_values[] = { 40, 41, 42, 20, 21, 22, 30, 31, 32 };
+		for (S32 k = 0; k < 3; ++k)
+		{
+			ensure_equals("sorted key time", key_times.getTime(k), expected_times[k]);
+		}
+		for (S32 i = 0; i < 9; ++i)
+		{
+			ensure_equals("last key read wins", values[i], expected_values[i]);
+		}
+	}
+
+	template<> template<>
+	void llkeyframemotion_object::test<4>()
+	{
+		// most keys bunched into one bucket, as a clip that holds still and
+		// then moves fast does, still find the same key as a linear search
+		std::vector<U16> times;
+		for (U16 q = 30000; q < 30400; q += 2)
+		{
+			times.push_back(q);
+		}
+		times.insert(times.begin(), 0);
+		times.push_back(65535);
+
+		LLKeyframeMotion::KeyTimes key_times;
+		key_times.init(times);
+		ensure_equals("bucket form", key_times.mStep, 0.f);
+
+		const S32 num_keys = (S32)times.size();
+		S32 bucket = (S32)(30200.f * (F32)num_keys / 65536.f);
+		ensure("keys bunched in one bucket", key_times.mBuckets[bucket + 1] - key_times.mBuckets[bucket] > num_keys / 2);
+
+		// every time on and between the bunched keys, compared at the time
+		// find() sees after the round trip through seconds
+		for (U32 q = 29990; q <= 30410; ++q)
+		{
+			F32 u;
+			F32 seconds = key_seconds((F32)q);
+			S32 index = key_times.find(seconds, 1.f, u);
+			ensure_equals("same key as a linear search", index, reference_find(times, seconds * (F32)U16MAX));
+			ensure("blend in range", u >= 0.f && u <= 1.f);
+		}
+		for (U32 q = 0; q <= U16MAX; q += 251)
+		{
+			F32 u;
+			F32 seconds = key_seconds((F32)q);
+			ensure_equals("same key outside the bunch", key_times.find(seconds, 1.f, u), reference_find(times, seconds * (F32)U16MAX));
+		}
+	}
+}
@@ -42,18 +42,32 @@ U64 LLFrameTimer::sTotalTime = 0;
 F64 LLFrameTimer::sTotalSeconds = 0.0;
 S32 LLFrameTimer::sFrameCount = 0;
 U64 LLFrameTimer::sFrameDeltaTime = 0;
+U64 LLFrameTimer::sFixedFrameStep = 0;
+U64 LLFrameTimer::sFixedFrameBase = 0;
+S32 LLFrameTimer::sFixedFrameCountBase = 0;
 const F64 USEC_TO_SEC_F64 = 0.000001;
 
 // static
 void LLFrameTimer::updateFrameTime()
 {
-	U64 total_time = totalTime();
+	// on the fixed clock, calls within the same frame all get the same time
+	U64 total_time = sFixedFrameStep
+		? sFixedFrameBase + (U64)(sFrameCount - sFixedFrameCountBase) * sFixedFrameStep
+		: totalTime();
 	sFrameDeltaTime = total_time - sTotalTime;
 	sTotalTime = total_time;
 	sTotalSeconds = U64_to_F64(sTotalTime) * USEC_TO_SEC_F64;
 	sFrameTime = U64_to_F64(sTotalTime - sStartTotalTime) * USEC_TO_SEC_F64;
 } 
 
+// static
+void LLFrameTimer::setFixedFrameStep(F64 step_seconds)
+{
+	sFixedFrameStep = step_seconds > 0.0 ? (U64)(step_seconds / USEC_TO_SEC_F64) : 0;
+	sFixedFrameBase = sTotalTime ? sTotalTime : totalTime();
+	sFixedFrameCountBase = sFrameCount;
+}
+
 void LLFrameTimer::start()
 {
 	reset();
@@ -68,6 +68,12 @@ public:
 	// Call this method once, and only once, per frame to update the current frame count.
 	static void updateFrameCount()					{ sFrameCount++; }
 
+	// Make updateFrameTime() step the clock by step_seconds per frame counted
+	// instead of reading the system clock, so that everything timed by
+	// LLFrameTimer sees the same times on every run.  0 goes back to real time.
+	static void setFixedFrameStep(F64 step_seconds);
+	static bool isFixedFrameStep()					{ return sFixedFrameStep != 0; }
+
 	static U32  getFrameCount()						{ return sFrameCount; }
 
 	static F32	getFrameDeltaTimeF32();
@@ -129,6 +135,11 @@ protected:
 	// Total number of frames elapsed in application
 	static S32 sFrameCount;
 
+	// Fixed frame clock, see setFixedFrameStep()
+	static U64 sFixedFrameStep;		// usec per frame, 0 for real time
+	static U64 sFixedFrameBase;		// usec since epoch when the fixed clock started
+	static S32 sFixedFrameCountBase;
+
 	//
 	// Member data
 	//
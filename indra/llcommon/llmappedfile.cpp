@@ -0,0 +1,164 @@
+/**
+ * @file llmappedfile.cpp
+ * @brief Read-only memory mapping of a whole file.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#if LL_WINDOWS
+#include "llwin32headerslean.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "linden_common.h"
+#include "llmappedfile.h"
+#include "llstring.h"
+#include "llerror.h"
+
+LLMappedFile::LLMappedFile()
+:	mData(nullptr),
+	mSize(0)
+#if LL_WINDOWS
+	, mFileHandle(INVALID_HANDLE_VALUE),
+	mMappingHandle(NULL)
+#endif
+{
+}
+
+LLMappedFile::~LLMappedFile()
+{
+	close();
+}
+
+#if LL_WINDOWS
+
+bool LLMappedFile::open(const std::string& filename)
+{
+	close();
+
+	llutf16string utf16filename = utf8str_to_utf16str(filename);
+	HANDLE file = CreateFileW(utf16filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+							  NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!mapping)
+	{
+		LL_WARNS() << "CreateFileMapping failed for " << filename << ": " << GetLastError() << LL_ENDL;
+		CloseHandle(file);
+		return false;
+	}
+
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data)
+	{
+		LL_WARNS() << "MapViewOfFile failed for " << filename << ": " << GetLastError() << LL_ENDL;
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	mFileHandle = file;
+	mMappingHandle = mapping;
+	mData = (const U8*)data;
+	mSize = (size_t)size.QuadPart;
+	return true;
+}
+
+void LLMappedFile::close()
+{
+	if (mData)
+	{
+		UnmapViewOfFile(mData);
+		mData = nullptr;
+	}
+	if (mMappingHandle)
+	{
+		CloseHandle(mMappingHandle);
+		mMappingHandle = NULL;
+	}
+	if (mFileHandle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(mFileHandle);
+		mFileHandle = INVALID_HANDLE_VALUE;
+	}
+	mSize = 0;
+}
+
+#else // !LL_WINDOWS
+
+bool LLMappedFile::open(const std::string& filename)
+{
+	close();
+
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	struct stat file_status;
+	if (fstat(fd, &file_status) != 0 || file_status.st_size <= 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	void* data = ::mmap(NULL, file_status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	// the mapping keeps its own reference to the file
+	::close(fd);
+	if (data == MAP_FAILED)
+	{
+		LL_WARNS() << "mmap failed for " << filename << ": " << errno << LL_ENDL;
+		return false;
+	}
+
+	mData = (const U8*)data;
+	mSize = (size_t)file_status.st_size;
+	return true;
+}
+
+void LLMappedFile::close()
+{
+	if (mData)
+	{
+		::munmap((void*)mData, mSize);
+		mData = nullptr;
+	}
+	mSize = 0;
+}
+
+#endif // !LL_WINDOWS
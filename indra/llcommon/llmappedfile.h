@@ -0,0 +1,66 @@
+/**
+ * @file llmappedfile.h
+ * @brief Read-only memory mapping of a whole file.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLMAPPEDFILE_H
+#define LL_LLMAPPEDFILE_H
+
+#include <boost/noncopyable.hpp>
+#include <string>
+
+/**
+ * LLMappedFile maps an entire existing file read-only into the address
+ * space.  Pages are only faulted in when touched, and are backed by the
+ * file itself rather than by the heap, so the OS can drop them again under
+ * memory pressure.
+ *
+ * The file must not be truncated or rewritten in place while it is mapped;
+ * write a new file and rename it over the old one instead.
+ */
+class LL_COMMON_API LLMappedFile : private boost::noncopyable
+{
+public:
+	LLMappedFile();
+	~LLMappedFile();
+
+	// Takes a UTF8 filename.  Returns false if the file does not exist, is
+	// empty or cannot be mapped.
+	bool open(const std::string& filename);
+	void close();
+
+	bool isOpen() const				{ return mData != nullptr; }
+	const U8* getData() const		{ return mData; }
+	size_t getSize() const			{ return mSize; }
+
+private:
+	const U8*	mData;
+	size_t		mSize;
+#if LL_WINDOWS
+	void*		mFileHandle;
+	void*		mMappingHandle;
+#endif
+};
+
+#endif // LL_LLMAPPEDFILE_H
@@ -63,6 +63,10 @@
 
 #if LL_USE_SYSTEM_RAND
 #include <cstdlib>
+#else
+#include <functional>
+#include <mutex>
+#include <thread>
 #endif
 
 #if LL_USE_SYSTEM_RAND
@@ -96,14 +100,31 @@ inline F32 ll_internal_random_float()
 #endif
 }
 #else
-static LLRandLagFib2281 gRandomGenerator(LLUUID::getRandomSeed());
+static U32 ll_internal_thread_seed()
+{
+	// getRandomSeed() fills a static buffer
+	static std::mutex sSeedMutex;
+	std::lock_guard<std::mutex> lock(sSeedMutex);
+
+	// threads started in the same clock tick still get different sequences
+	return LLUUID::getRandomSeed() ^ (U32)std::hash<std::thread::id>()(std::this_thread::get_id());
+}
+
+// One generator per thread: the lagged Fibonacci state is not safe to
+// share, and avatar motions call ll_frand() from the animation thread pool.
+static LLRandLagFib2281& ll_internal_generator()
+{
+	static thread_local LLRandLagFib2281 sRandomGenerator(ll_internal_thread_seed());
+	return sRandomGenerator;
+}
+
 inline F64 ll_internal_random_double()
 {
 	// *HACK: Through experimentation, we have found that dual core
 	// CPUs (or at least multi-threaded processes) seem to
 	// occasionally give an obviously incorrect random number -- like
 	// 5^15 or something. Sooooo, clamp it as described above.
-	F64 rv = gRandomGenerator();
+	F64 rv = ll_internal_generator()();
 	if(!((rv >= 0.0) && (rv < 1.0))) return fmod(rv, 1.0);
 	return rv;
 }
@@ -111,7 +132,7 @@ inline F64 ll_internal_random_double()
 inline F32 ll_internal_random_float()
 {
 	// The clamping rules are described above.
-	F32 rv = (F32)gRandomGenerator();
+	F32 rv = (F32)ll_internal_generator()();
 	if(!((rv >= 0.0f) && (rv < 1.0f))) return fmod(rv, 1.f);
 	return rv;
 }
@@ -62,6 +62,9 @@
  * 0.05				stdlib lrand48()
  * 0.034			stdlib rand()
  * 0.020			the old & lame LLRand
+ *
+ * The c-functions below are safe to call from any thread, each thread
+ * draws from its own generator.
  */
 
 /**
@@ -33,9 +33,13 @@
 #include "llerror.h"
 #include "../llmath/llmath.h"
 #include "llformat.h"
+#include "llmemory.h"
 #include "llsdserialize.h"
 #include "stringize.h"
 
+#include <atomic>
+#include <new>
+
 #ifndef LL_RELEASE_FOR_DOWNLOAD
 #define NAME_UNNAMED_NAMESPACE
 #endif
@@ -84,10 +88,28 @@ protected:
 		//	 finally initialized.
 		
 	virtual ~Impl();
+
+	template<class T, class... Args>
+	static T* create(Args&&... args)
+		///< New node, from the thread's LLSDArena while one is alive (see
+		//   llsd.h), from the heap otherwise
+	{
+		U16 arena_offset = 0;
+		void* mem = LLSDArena::allocate(sizeof(T), arena_offset);
+		if (!mem)
+		{
+			return new T(std::forward<Args>(args)...);
+		}
+		T* impl = new (mem) T(std::forward<Args>(args)...);
+		impl->mArenaOffset = arena_offset;
+		return impl;
+	}
+	static void destroy(Impl* impl);
 	
 	bool shared() const							{ return (mUseCount > 1) && (mUseCount != STATIC_USAGE_COUNT); }
 	
 	U32 mUseCount;
+	U16 mArenaOffset;	// 0 for heap nodes, else bytes back to the arena block, see LLSDArena
 
 public:
 	static void reset(Impl*& var, Impl* impl);
@@ -402,7 +424,7 @@ namespace
 	{
 		if (shared())
 		{
-			ImplMap* i = new ImplMap(mData);
+			ImplMap* i = create<ImplMap>(mData);
 			Impl::assign(var, i);
 			return *i;
 		}
@@ -438,7 +460,9 @@ namespace
 
 	void ImplMap::insert(const LLSD::String& k, const LLSD& v)
 	{
-		mData.insert(DataMap::value_type(k, v));
+		// Parsers and formatters walk maps in key order, so hinting at the
+		// end makes building a map from serialized data linear.
+		mData.insert(mData.end(), DataMap::value_type(k, v));
 	}
 	
 	void ImplMap::erase(const LLSD::String& k)
@@ -535,7 +559,7 @@ namespace
 	{
 		if (shared())
 		{
-			ImplArray* i = new ImplArray(mData);
+			ImplArray* i = create<ImplArray>(mData);
 			Impl::assign(var, i);
 			return *i;
 		}
@@ -633,14 +657,16 @@ namespace
 }
 
 LLSD::Impl::Impl()
-	: mUseCount(0)
+	: mUseCount(0),
+	  mArenaOffset(0)
 {
 	++sAllocationCount;
 	++sOutstandingCount;
 }
 
 LLSD::Impl::Impl(StaticAllocationMarker)
-	: mUseCount(0)
+	: mUseCount(0),
+	  mArenaOffset(0)
 {
 }
 
@@ -657,7 +683,7 @@ void LLSD::Impl::reset(Impl*& var, Impl* impl)
 	}
 	if (var  &&  var->mUseCount != STATIC_USAGE_COUNT && --var->mUseCount == 0)
 	{
-		delete var;
+		destroy(var);
 	}
 	var = impl;
 }
@@ -676,14 +702,14 @@ const LLSD::Impl& LLSD::Impl::safe(const Impl* impl)
 
 ImplMap& LLSD::Impl::makeMap(Impl*& var)
 {
-	ImplMap* im = new ImplMap;
+	ImplMap* im = create<ImplMap>();
 	reset(var, im);
 	return *im;
 }
 
 ImplArray& LLSD::Impl::makeArray(Impl*& var)
 {
-	ImplArray* ia = new ImplArray;
+	ImplArray* ia = create<ImplArray>();
 	reset(var, ia);
 	return *ia;
 }
@@ -701,42 +727,42 @@ void LLSD::Impl::assignUndefined(Impl*& var)
 
 void LLSD::Impl::assign(Impl*& var, LLSD::Boolean v)
 {
-	reset(var, new ImplBoolean(v));
+	reset(var, create<ImplBoolean>(v));
 }
 
 void LLSD::Impl::assign(Impl*& var, LLSD::Integer v)
 {
-	reset(var, new ImplInteger(v));
+	reset(var, create<ImplInteger>(v));
 }
 
 void LLSD::Impl::assign(Impl*& var, LLSD::Real v)
 {
-	reset(var, new ImplReal(v));
+	reset(var, create<ImplReal>(v));
 }
 
 void LLSD::Impl::assign(Impl*& var, const LLSD::String& v)
 {
-	reset(var, new ImplString(v));
+	reset(var, create<ImplString>(v));
 }
 
 void LLSD::Impl::assign(Impl*& var, const LLSD::UUID& v)
 {
-	reset(var, new ImplUUID(v));
+	reset(var, create<ImplUUID>(v));
 }
 
 void LLSD::Impl::assign(Impl*& var, const LLSD::Date& v)
 {
-	reset(var, new ImplDate(v));
+	reset(var, create<ImplDate>(v));
 }
 
 void LLSD::Impl::assign(Impl*& var, const LLSD::URI& v)
 {
-	reset(var, new ImplURI(v));
+	reset(var, create<ImplURI>(v));
 }
 
 void LLSD::Impl::assign(Impl*& var, const LLSD::Binary& v)
 {
-	reset(var, new ImplBinary(v));
+	reset(var, create<ImplBinary>(v));
 }
 
 
@@ -787,6 +813,140 @@ U32 LLSD::Impl::sAllocationCount = 0;
 U32 LLSD::Impl::sOutstandingCount = 0;
 
 
+// A node finds its arena block from its own offset into the block, kept in
+// mArenaOffset where the node had padding anyway, so heap nodes carry nothing
+// extra and blocks need no more than the usual 16 byte alignment.  Blocks
+// stay small so that a value kept after the rest of its tree is gone pins
+// little memory with it, and their offsets fit in 16 bits.
+namespace
+{
+	const size_t ARENA_ALIGNMENT = 16;
+	const U8 ARENA_FIRST_BLOCK_SHIFT = 10;	// 1KB
+	const U8 ARENA_MAX_BLOCK_SHIFT = 13;	// 8KB
+	static_assert(((size_t)1 << ARENA_MAX_BLOCK_SHIFT) <= 65536, "node offsets must fit in mArenaOffset");
+
+	LL_THREAD_LOCAL LLSDArena* sCurrentArena = NULL;
+	// lets threads without an arena skip the thread local lookup
+	std::atomic<U32> sLiveArenas(0);
+	std::atomic<U32> sArenaBlockCount(0);
+}
+
+class LLSDArena::Block
+{
+public:
+	// The arena holds one reference while it is still carving from the
+	// block; each live node holds another.
+	std::atomic<S32>	mRefs;
+	size_t				mUsed;
+
+	static Block* create(U8 shift)
+	{
+		size_t size = (size_t)1 << shift;
+		void* mem = ll_aligned_malloc_fallback(size, (int)ARENA_ALIGNMENT);
+		++sArenaBlockCount;
+		Block* block = new (mem) Block;
+		block->mRefs = 1;
+		block->mUsed = headerSize();
+		return block;
+	}
+
+	static Block* find(void* node, U16 offset)
+	{
+		return reinterpret_cast<Block*>(reinterpret_cast<char*>(node) - offset);
+	}
+
+	void release()
+	{
+		if (--mRefs == 0)
+		{
+			this->~Block();
+			ll_aligned_free_fallback(this);
+			--sArenaBlockCount;
+		}
+	}
+
+	static size_t headerSize()	{ return (sizeof(Block) + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1); }
+};
+
+// static
+void LLSD::Impl::destroy(Impl* impl)
+{
+	U16 arena_offset = impl->mArenaOffset;
+	if (!arena_offset)
+	{
+		delete impl;
+		return;
+	}
+	LLSDArena::Block* block = LLSDArena::Block::find(impl, arena_offset);
+	impl->~Impl();
+	block->release();
+}
+
+LLSDArena::LLSDArena()
+	: mBlock(NULL),
+	  mBlockShift(0),
+	  mNextBlockShift(ARENA_FIRST_BLOCK_SHIFT),
+	  mPrevious(sCurrentArena)
+{
+	sCurrentArena = this;
+	++sLiveArenas;
+}
+
+LLSDArena::~LLSDArena()
+{
+	llassert(sCurrentArena == this);
+	sCurrentArena = mPrevious;
+	--sLiveArenas;
+	retireBlock();
+}
+
+void LLSDArena::retireBlock()
+{
+	if (mBlock)
+	{
+		mBlock->release();
+		mBlock = NULL;
+	}
+}
+
+void* LLSDArena::allocateNode(size_t size, U16& offset)
+{
+	size_t needed = (size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+	if (needed > ((size_t)1 << ARENA_FIRST_BLOCK_SHIFT) / 4)
+	{
+		return NULL;
+	}
+	if (!mBlock || mBlock->mUsed + needed > ((size_t)1 << mBlockShift))
+	{
+		retireBlock();
+		mBlock = Block::create(mNextBlockShift);
+		mBlockShift = mNextBlockShift;
+		mNextBlockShift = llmin((U8)(mNextBlockShift + 1), ARENA_MAX_BLOCK_SHIFT);
+	}
+	char* mem = reinterpret_cast<char*>(mBlock) + mBlock->mUsed;
+	offset = (U16)mBlock->mUsed;
+	mBlock->mUsed += needed;
+	++mBlock->mRefs;
+	return mem;
+}
+
+// static
+void* LLSDArena::allocate(size_t size, U16& offset)
+{
+	if (sLiveArenas.load(std::memory_order_relaxed) == 0 || !sCurrentArena)
+	{
+		return NULL;
+	}
+	return sCurrentArena->allocateNode(size, offset);
+}
+
+// static
+U32 LLSDArena::blockCount()
+{
+	return sArenaBlockCount;
+}
+
+
 
 #ifdef NAME_UNNAMED_NAMESPACE
 namespace LLSDUnnamedNamespace 
@@ -423,6 +423,56 @@ public:
 	static std::string		typeString(Type type);		// Return human-readable type as a string
 };
 
+/**
+ * @class LLSDArena
+ * @brief Carves LLSD values out of a few large blocks instead of making
+ * one heap allocation per value.
+ *
+ * While an LLSDArena is alive, every LLSD value created on the thread
+ * that constructed it takes its storage from the arena. Values remain
+ * reference counted as usual and may outlive the arena: a block (1KB
+ * growing to 8KB) goes back to the heap when the last value carved from it
+ * is destroyed, so freeing a whole parsed tree costs a handful of frees
+ * rather than one per node, and a value kept after the rest of its tree is
+ * gone holds on to at most one block. Arenas nest; the innermost one on
+ * the thread is used.
+ *
+ * Values created with no arena alive in the process cost one relaxed
+ * atomic load on top of their heap allocation.
+ *
+ * Only the LLSD nodes themselves come from the arena. Strings, binaries
+ * and the map and array containers still use the heap.
+ */
+class LL_COMMON_API LLSDArena
+{
+public:
+	LLSDArena();
+	~LLSDArena();
+
+	LLSDArena(const LLSDArena&) = delete;
+	LLSDArena& operator=(const LLSDArena&) = delete;
+
+	/// Storage for one LLSD node of @p size bytes from the innermost arena
+	/// on this thread, NULL if there is none or the node is too big for it.
+	/// @p offset receives the node's offset into its block, which locates
+	/// the block again when the node is released.
+	static void* allocate(size_t size, U16& offset);
+
+	/// Number of blocks obtained from the heap by all arenas.
+	static U32 blockCount();
+
+	class Block;
+
+private:
+	void* allocateNode(size_t size, U16& offset);
+	void retireBlock();
+
+	Block*		mBlock;
+	U8			mBlockShift;
+	U8			mNextBlockShift;
+	LLSDArena*	mPrevious;
+};
+
 struct llsd_select_bool
 {
 	LLSD::Boolean operator()(const LLSD& sd) const
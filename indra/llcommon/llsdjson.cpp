@@ -30,6 +30,7 @@
 #include "linden_common.h"
 
 #include "llsdjson.h"
+#include "llsdserialize.h"
 
 #include "llerror.h"
 #include "../llmath/llmath.h"
@@ -77,6 +78,43 @@ LLSD LlsdFromJson(const Json::Value &val)
     return result;
 }
 
+//=========================================================================
+bool LlsdStreamFromJson(const Json::Value &val, LLSDStreamHandler &handler)
+{
+    switch (val.type())
+    {
+    case Json::arrayValue:
+        if (!handler.beginArray())
+        {
+            return false;
+        }
+        for (Json::ValueConstIterator it = val.begin(); it != val.end(); ++it)
+        {
+            if (!LlsdStreamFromJson((*it), handler))
+            {
+                return false;
+            }
+        }
+        return handler.endArray();
+    case Json::objectValue:
+        if (!handler.beginMap())
+        {
+            return false;
+        }
+        for (Json::ValueConstIterator it = val.begin(); it != val.end(); ++it)
+        {
+            if (!handler.key(it.memberName()) || !LlsdStreamFromJson((*it), handler))
+            {
+                return false;
+            }
+        }
+        return handler.endMap();
+    default:
+        // Scalars convert exactly as they do for a tree.
+        return handler.value(LlsdFromJson(val));
+    }
+}
+
 //=========================================================================
 Json::Value LlsdToJson(const LLSD &val)
 {
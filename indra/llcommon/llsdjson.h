@@ -37,6 +37,8 @@
 #include "llsd.h"
 #include "value.h"
 
+class LLSDStreamHandler;
+
 /// Convert a parsed JSON structure into LLSD maintaining member names and 
 /// array indexes.
 /// JSON/JavaScript types are converted as follows:
@@ -56,6 +58,13 @@
 /// Order is preserved for an array but not for objects.
 LLSD LlsdFromJson(const Json::Value &val);
 
+/// Report a parsed JSON structure to an LLSDStreamHandler as it is walked,
+/// using the same type conversions as LlsdFromJson() but without building
+/// an LLSD copy of the whole document.  jsoncpp has no incremental reader,
+/// so the Json::Value itself is still held in full.
+/// Returns false if the handler stopped the walk.
+bool LlsdStreamFromJson(const Json::Value &val, LLSDStreamHandler &handler);
+
 /// Convert an LLSD object into Parsed JSON object maintaining member names and 
 /// array indexs.
 /// 
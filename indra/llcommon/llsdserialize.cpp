@@ -324,7 +324,7 @@ static const char BINARY_FALSE_SERIAL = '0';
  * LLSDParser
  */
 LLSDParser::LLSDParser()
-	: mCheckLimits(true), mMaxBytesLeft(0), mParseLines(false)
+	: mCheckLimits(true), mMaxBytesLeft(0), mParseLines(false), mUseArena(false)
 {
 }
 
@@ -336,6 +336,11 @@ S32 LLSDParser::parse(std::istream& istr, LLSD& data, std::streamsize max_bytes,
 {
 	mCheckLimits = LLSDSerialize::SIZE_UNLIMITED != max_bytes;
 	mMaxBytesLeft = max_bytes;
+	if (mUseArena)
+	{
+		LLSDArena arena;
+		return doParse(istr, data, max_depth);
+	}
 	return doParse(istr, data, max_depth);
 }
 
@@ -345,9 +350,188 @@ S32 LLSDParser::parseLines(std::istream& istr, LLSD& data)
 {
 	mCheckLimits = false;
 	mParseLines = true;
+	if (mUseArena)
+	{
+		LLSDArena arena;
+		return doParse(istr, data);
+	}
 	return doParse(istr, data);
 }
 
+S32 LLSDParser::parse(std::istream& istr, LLSDStreamHandler& handler, std::streamsize max_bytes, S32 max_depth)
+{
+	mCheckLimits = LLSDSerialize::SIZE_UNLIMITED != max_bytes;
+	mMaxBytesLeft = max_bytes;
+	return doParseStream(istr, handler, max_depth);
+}
+
+// virtual
+S32 LLSDParser::doParseStream(std::istream& istr, LLSDStreamHandler& handler, S32 max_depth) const
+{
+	LLSD data;
+	S32 parse_count = doParse(istr, data, max_depth);
+	if ((parse_count > 0) && !handler.replay(data))
+	{
+		return PARSE_FAILURE;
+	}
+	return parse_count;
+}
+
+
+/**
+ * LLSDStreamHandler
+ */
+bool LLSDStreamHandler::replay(const LLSD& data)
+{
+	switch (data.type())
+	{
+	case LLSD::TypeMap:
+		if (!beginMap())
+		{
+			return false;
+		}
+		for (LLSD::map_const_iterator iter = data.beginMap(); iter != data.endMap(); ++iter)
+		{
+			if (!key(iter->first) || !replay(iter->second))
+			{
+				return false;
+			}
+		}
+		return endMap();
+
+	case LLSD::TypeArray:
+		if (!beginArray())
+		{
+			return false;
+		}
+		for (LLSD::array_const_iterator iter = data.beginArray(); iter != data.endArray(); ++iter)
+		{
+			if (!replay(*iter))
+			{
+				return false;
+			}
+		}
+		return endArray();
+
+	default:
+		return value(data);
+	}
+}
+
+
+/**
+ * LLSDSubtreeHandler
+ */
+LLSDSubtreeHandler::LLSDSubtreeHandler(S32 depth)
+	: mDepth(depth)
+{
+}
+
+// virtual
+bool LLSDSubtreeHandler::isSubtree(const std::string& name)
+{
+	return (S32)mPath.size() == mDepth;
+}
+
+// virtual
+bool LLSDSubtreeHandler::beginMap()
+{
+	return beginContainer(LLSD::emptyMap());
+}
+
+// virtual
+bool LLSDSubtreeHandler::key(const std::string& name)
+{
+	mKey = name;
+	return true;
+}
+
+// virtual
+bool LLSDSubtreeHandler::endMap()
+{
+	return endContainer();
+}
+
+// virtual
+bool LLSDSubtreeHandler::beginArray()
+{
+	return beginContainer(LLSD::emptyArray());
+}
+
+// virtual
+bool LLSDSubtreeHandler::endArray()
+{
+	return endContainer();
+}
+
+// virtual
+bool LLSDSubtreeHandler::value(const LLSD& scalar)
+{
+	if (mStack.empty())
+	{
+		bool keep_going = !isSubtree(mKey) || subtree(mKey, scalar);
+		mKey.clear();
+		return keep_going;
+	}
+	addValue(scalar);
+	return true;
+}
+
+bool LLSDSubtreeHandler::beginContainer(const LLSD& empty)
+{
+	if (mStack.empty())
+	{
+		if (!isSubtree(mKey))
+		{
+			// Entries of an array above the subtree have no name.
+			mPath.push_back(mKey);
+			mKey.clear();
+			return true;
+		}
+		mSubtreeKey = mKey;
+		mSubtree = empty;
+		mStack.push_back(&mSubtree);
+	}
+	else
+	{
+		// Children of a vector-backed array are only appended once the
+		// open child is finished, so this pointer stays valid.
+		mStack.push_back(&addValue(empty));
+	}
+	mKey.clear();
+	return true;
+}
+
+bool LLSDSubtreeHandler::endContainer()
+{
+	if (mStack.empty())
+	{
+		mPath.pop_back();
+		return true;
+	}
+	mStack.pop_back();
+	if (mStack.empty())
+	{
+		bool keep_going = subtree(mSubtreeKey, mSubtree);
+		mSubtree.clear();
+		return keep_going;
+	}
+	return true;
+}
+
+LLSD& LLSDSubtreeHandler::addValue(const LLSD& value)
+{
+	LLSD& parent = *mStack.back();
+	if (parent.isMap())
+	{
+		LLSD& child = parent[mKey];
+		child = value;
+		mKey.clear();
+		return child;
+	}
+	return parent.append(value);
+}
+
 
 int LLSDParser::get(std::istream& istr) const
 {
@@ -776,6 +960,134 @@ S32 LLSDNotationParser::parseArray(std::istream& istr, LLSD& array, S32 max_dept
 	return parse_count;
 }
 
+// virtual
+S32 LLSDNotationParser::doParseStream(std::istream& istr, LLSDStreamHandler& handler, S32 max_depth) const
+{
+	char c = istr.peek();
+	if (max_depth == 0)
+	{
+		return PARSE_FAILURE;
+	}
+	while(isspace(c))
+	{
+		// pop the whitespace.
+		c = get(istr);
+		c = istr.peek();
+	}
+	if(!istr.good())
+	{
+		return 0;
+	}
+	if((c == '{') || (c == '['))
+	{
+		S32 child_count = (c == '{')
+			? streamMap(istr, handler, max_depth - 1)
+			: streamArray(istr, handler, max_depth - 1);
+		if((child_count == PARSE_FAILURE) || istr.fail())
+		{
+			return PARSE_FAILURE;
+		}
+		return child_count + 1;
+	}
+
+	// Scalars are small; read them with the tree parser.
+	LLSD scalar;
+	S32 parse_count = doParse(istr, scalar, max_depth);
+	if((parse_count > 0) && !handler.value(scalar))
+	{
+		return PARSE_FAILURE;
+	}
+	return parse_count;
+}
+
+S32 LLSDNotationParser::streamMap(std::istream& istr, LLSDStreamHandler& handler, S32 max_depth) const
+{
+	// map: { string:object, string:object }
+	S32 parse_count = 0;
+	char c = get(istr);
+	if((c != '{') || !handler.beginMap())
+	{
+		return PARSE_FAILURE;
+	}
+	// eat commas, white
+	bool found_name = false;
+	std::string name;
+	c = get(istr);
+	while(c != '}' && istr.good())
+	{
+		if(!found_name)
+		{
+			if((c == '\"') || (c == '\'') || (c == 's'))
+			{
+				putback(istr, c);
+				found_name = true;
+				auto count = deserialize_string(istr, name, mMaxBytesLeft);
+				if(PARSE_FAILURE == count) return PARSE_FAILURE;
+				account(count);
+				if(!handler.key(name)) return PARSE_FAILURE;
+			}
+			c = get(istr);
+		}
+		else
+		{
+			if(isspace(c) || (c == ':'))
+			{
+				c = get(istr);
+				continue;
+			}
+			putback(istr, c);
+			S32 count = doParseStream(istr, handler, max_depth);
+			if(count <= 0)
+			{
+				// There must be a value for every key.
+				return PARSE_FAILURE;
+			}
+			parse_count += count;
+			found_name = false;
+			c = get(istr);
+		}
+	}
+	if((c != '}') || !handler.endMap())
+	{
+		return PARSE_FAILURE;
+	}
+	return parse_count;
+}
+
+S32 LLSDNotationParser::streamArray(std::istream& istr, LLSDStreamHandler& handler, S32 max_depth) const
+{
+	// array: [ object, object, object ]
+	S32 parse_count = 0;
+	char c = get(istr);
+	if((c != '[') || !handler.beginArray())
+	{
+		return PARSE_FAILURE;
+	}
+	// eat commas, white
+	c = get(istr);
+	while((c != ']') && istr.good())
+	{
+		if(isspace(c) || (c == ','))
+		{
+			c = get(istr);
+			continue;
+		}
+		putback(istr, c);
+		S32 count = doParseStream(istr, handler, max_depth);
+		if(PARSE_FAILURE == count)
+		{
+			return PARSE_FAILURE;
+		}
+		parse_count += count;
+		c = get(istr);
+	}
+	if((c != ']') || !handler.endArray())
+	{
+		return PARSE_FAILURE;
+	}
+	return parse_count;
+}
+
 bool LLSDNotationParser::parseString(std::istream& istr, LLSD& data) const
 {
 	std::string value;
@@ -1214,6 +1526,130 @@ S32 LLSDBinaryParser::parseArray(std::istream& istr, LLSD& array, S32 max_depth)
 	return parse_count;
 }
 
+// virtual
+S32 LLSDBinaryParser::doParseStream(std::istream& istr, LLSDStreamHandler& handler, S32 max_depth) const
+{
+	char c = istr.peek();
+	if(!istr.good())
+	{
+		return 0;
+	}
+	if (max_depth == 0)
+	{
+		return PARSE_FAILURE;
+	}
+	if((c == '{') || (c == '['))
+	{
+		get(istr);
+		S32 child_count = (c == '{')
+			? streamMap(istr, handler, max_depth - 1)
+			: streamArray(istr, handler, max_depth - 1);
+		if((child_count == PARSE_FAILURE) || istr.fail())
+		{
+			LL_INFOS() << "STREAM FAILURE reading binary "
+				<< ((c == '{') ? "map." : "array.") << LL_ENDL;
+			return PARSE_FAILURE;
+		}
+		return child_count + 1;
+	}
+
+	// Scalars are small; read them with the tree parser.
+	LLSD scalar;
+	S32 parse_count = doParse(istr, scalar, max_depth);
+	if((parse_count > 0) && !handler.value(scalar))
+	{
+		return PARSE_FAILURE;
+	}
+	return parse_count;
+}
+
+S32 LLSDBinaryParser::streamMap(std::istream& istr, LLSDStreamHandler& handler, S32 max_depth) const
+{
+	U32 value_nbo = 0;
+	read(istr, (char*)&value_nbo, sizeof(U32));		 /*Flawfinder: ignore*/
+	S32 size = (S32)ntohl(value_nbo);
+	if(!handler.beginMap())
+	{
+		return PARSE_FAILURE;
+	}
+	S32 parse_count = 0;
+	S32 count = 0;
+	char c = get(istr);
+	while(c != '}' && (count < size) && istr.good())
+	{
+		std::string name;
+		switch(c)
+		{
+		case 'k':
+			if(!parseString(istr, name))
+			{
+				return PARSE_FAILURE;
+			}
+			break;
+		case '\'':
+		case '"':
+		{
+			auto cnt = deserialize_string_delim(istr, name, c);
+			if(PARSE_FAILURE == cnt) return PARSE_FAILURE;
+			account(cnt);
+			break;
+		}
+		default:
+			// not a key, the handler must not see a made up empty one
+			return PARSE_FAILURE;
+		}
+		if(!handler.key(name))
+		{
+			return PARSE_FAILURE;
+		}
+		S32 child_count = doParseStream(istr, handler, max_depth);
+		if(child_count <= 0)
+		{
+			// There must be a value for every key.
+			return PARSE_FAILURE;
+		}
+		parse_count += child_count;
+		++count;
+		c = get(istr);
+	}
+	if((c != '}') || (count < size) || !handler.endMap())
+	{
+		return PARSE_FAILURE;
+	}
+	return parse_count;
+}
+
+S32 LLSDBinaryParser::streamArray(std::istream& istr, LLSDStreamHandler& handler, S32 max_depth) const
+{
+	U32 value_nbo = 0;
+	read(istr, (char*)&value_nbo, sizeof(U32));		 /*Flawfinder: ignore*/
+	S32 size = (S32)ntohl(value_nbo);
+	if(!handler.beginArray())
+	{
+		return PARSE_FAILURE;
+	}
+	S32 parse_count = 0;
+	S32 count = 0;
+	char c = istr.peek();
+	while((c != ']') && (count < size) && istr.good())
+	{
+		S32 child_count = doParseStream(istr, handler, max_depth);
+		if(PARSE_FAILURE == child_count)
+		{
+			return PARSE_FAILURE;
+		}
+		parse_count += child_count;
+		++count;
+		c = istr.peek();
+	}
+	c = get(istr);
+	if((c != ']') || (count < size) || !handler.endArray())
+	{
+		return PARSE_FAILURE;
+	}
+	return parse_count;
+}
+
 bool LLSDBinaryParser::parseString(
 	std::istream& istr,
 	std::string& value) const
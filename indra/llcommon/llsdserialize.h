@@ -34,6 +34,96 @@
 #include "llrefcount.h"
 #include "llsd.h"
 
+/** 
+ * @class LLSDStreamHandler
+ * @brief Receives the structure of an LLSD document as it is read,
+ * without a tree being built.
+ *
+ * Pass one to LLSDParser::parse() instead of an LLSD.  Containers arrive
+ * as begin/end pairs, map entries as key() followed by the value, and
+ * everything else as value().  Any callback may return false to stop the
+ * read, which then fails with PARSE_FAILURE.
+ */
+class LL_COMMON_API LLSDStreamHandler
+{
+public:
+	virtual ~LLSDStreamHandler() {}
+
+	virtual bool beginMap() = 0;
+	virtual bool key(const std::string& name) = 0;
+	virtual bool endMap() = 0;
+	virtual bool beginArray() = 0;
+	virtual bool endArray() = 0;
+	virtual bool value(const LLSD& scalar) = 0;
+
+	/** 
+	 * @brief Sends an already built tree to this handler as events.
+	 */
+	bool replay(const LLSD& data);
+};
+
+/** 
+ * @class LLSDSubtreeHandler
+ * @brief Builds each value found at a given nesting depth as its own LLSD
+ * and hands it to subtree(), then lets it go.
+ *
+ * With a depth of 1 and a document that is a large map or array of
+ * records, only one record is ever held in memory.  A depth of 0 yields
+ * each top level value, which suits files of concatenated documents.
+ * Subclasses can pick the values to build by path instead by overriding
+ * isSubtree().
+ */
+class LL_COMMON_API LLSDSubtreeHandler : public LLSDStreamHandler
+{
+public:
+	LLSDSubtreeHandler(S32 depth);
+
+	/** 
+	 * @brief Called with each complete value at the requested depth.
+	 *
+	 * @param name The map key of the value, empty in arrays and at the
+	 * top level.
+	 * @return Return false to stop the read.
+	 */
+	virtual bool subtree(const std::string& name, const LLSD& value) = 0;
+
+	virtual bool beginMap();
+	virtual bool key(const std::string& name);
+	virtual bool endMap();
+	virtual bool beginArray();
+	virtual bool endArray();
+	virtual bool value(const LLSD& scalar);
+
+protected:
+	/** 
+	 * @brief Decides whether the value about to be read under @p name
+	 * (empty in arrays and at the top level) is built and handed to
+	 * subtree().  Values that are not are skipped, except containers,
+	 * which are searched further.
+	 *
+	 * The default picks every value at the depth given to the constructor.
+	 */
+	virtual bool isSubtree(const std::string& name);
+
+	/** 
+	 * @brief Names of the containers enclosing the value being read, from
+	 * the top level down; empty for array entries and the top level.
+	 */
+	const std::vector<std::string>& path() const { return mPath; }
+
+private:
+	bool beginContainer(const LLSD& empty);
+	bool endContainer();
+	LLSD& addValue(const LLSD& value);
+
+	S32 mDepth;
+	std::vector<std::string> mPath;
+	std::string mKey;
+	std::string mSubtreeKey;
+	LLSD mSubtree;
+	std::vector<LLSD*> mStack;
+};
+
 /** 
  * @class LLSDParser
  * @brief Abstract base class for LLSD parsers.
@@ -85,11 +175,33 @@ public:
 	 */
 	S32 parseLines(std::istream& istr, LLSD& data);
 
+	/** 
+	 * @brief Like parse(), but reports what it reads to @p handler
+	 * instead of building a tree.
+	 *
+	 * Memory use is bounded by the largest single scalar in the stream
+	 * (plus whatever the handler itself keeps).
+	 * @return Returns the number of LLSD objects read, or PARSE_FAILURE
+	 * on parse failure or if the handler stopped the read.
+	 */
+	S32 parse(std::istream& istr, LLSDStreamHandler& handler, std::streamsize max_bytes, S32 max_depth = -1);
+
 	/** 
 	 * @brief Resets the parser so parse() or parseLines() can be called again for another <llsd> chunk.
 	 */
 	void reset()	{ doReset();	};
 
+	/** 
+	 * @brief Builds the trees returned by parse() and parseLines() in an
+	 * LLSDArena.
+	 *
+	 * Worth it for large, read-mostly payloads such as mesh headers and
+	 * capability responses, where per-node heap traffic dominates.  The
+	 * tree is used exactly as any other LLSD; it is just much cheaper to
+	 * build and to throw away.
+	 */
+	void setUseArena(bool use_arena)	{ mUseArena = use_arena; }
+
 
 protected:
 	/** 
@@ -110,6 +222,15 @@ protected:
 	 */
 	virtual S32 doParse(std::istream& istr, LLSD& data, S32 max_depth = -1) const = 0;
 
+	/** 
+	 * @brief Virtual base for doing a streaming parse.
+	 *
+	 * The default implementation builds the tree with doParse() and
+	 * replays it, so every parser supports streaming.  Parsers override
+	 * it to avoid building the tree.
+	 */
+	virtual S32 doParseStream(std::istream& istr, LLSDStreamHandler& handler, S32 max_depth) const;
+
 	/** 
 	 * @brief Virtual default function for resetting the parser
 	 */
@@ -211,6 +332,11 @@ protected:
 	 * @brief Use line-based reading to get text
 	 */
 	bool mParseLines;
+
+	/**
+	 * @brief Allocate parsed nodes from an LLSDArena
+	 */
+	bool mUseArena;
 };
 
 /** 
@@ -250,6 +376,11 @@ protected:
 	 */
 	virtual S32 doParse(std::istream& istr, LLSD& data, S32 max_depth = -1) const;
 
+	/** 
+	 * @brief Streaming parse, see LLSDParser::parse().
+	 */
+	virtual S32 doParseStream(std::istream& istr, LLSDStreamHandler& handler, S32 max_depth) const;
+
 private:
 	/** 
 	 * @brief Parse a map from the istream
@@ -261,6 +392,12 @@ private:
 	 */
 	S32 parseMap(std::istream& istr, LLSD& map, S32 max_depth) const;
 
+	/** 
+	 * @brief Streaming counterparts of parseMap() and parseArray().
+	 */
+	S32 streamMap(std::istream& istr, LLSDStreamHandler& handler, S32 max_depth) const;
+	S32 streamArray(std::istream& istr, LLSDStreamHandler& handler, S32 max_depth) const;
+
 	/** 
 	 * @brief Parse an array from the istream.
 	 *
@@ -327,6 +464,11 @@ protected:
 	 */
 	virtual S32 doParse(std::istream& istr, LLSD& data, S32 max_depth = -1) const;
 
+	/** 
+	 * @brief Streaming parse, see LLSDParser::parse().
+	 */
+	virtual S32 doParseStream(std::istream& istr, LLSDStreamHandler& handler, S32 max_depth) const;
+
 	/** 
 	 * @brief Virtual default function for resetting the parser
 	 */
@@ -377,6 +519,11 @@ protected:
 	 */
 	virtual S32 doParse(std::istream& istr, LLSD& data, S32 max_depth = -1) const;
 
+	/** 
+	 * @brief Streaming parse, see LLSDParser::parse().
+	 */
+	virtual S32 doParseStream(std::istream& istr, LLSDStreamHandler& handler, S32 max_depth) const;
+
 private:
 	/** 
 	 * @brief Parse a map from the istream
@@ -388,6 +535,12 @@ private:
 	 */
 	S32 parseMap(std::istream& istr, LLSD& map, S32 max_depth) const;
 
+	/** 
+	 * @brief Streaming counterparts of parseMap() and parseArray().
+	 */
+	S32 streamMap(std::istream& istr, LLSDStreamHandler& handler, S32 max_depth) const;
+	S32 streamArray(std::istream& istr, LLSDStreamHandler& handler, S32 max_depth) const;
+
 	/** 
 	 * @brief Parse an array from the istream.
 	 *
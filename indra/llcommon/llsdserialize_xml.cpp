@@ -259,6 +259,7 @@ public:
 	
 	S32 parse(std::istream& input, LLSD& data);
 	S32 parseLines(std::istream& input, LLSD& data);
+	S32 parseStream(std::istream& input, LLSDStreamHandler& handler, bool lines);
 
 	void parsePart(const char *buf, std::streamsize len);
 	
@@ -277,6 +278,7 @@ private:
 		void* userData, const XML_Char* data, int length);
 
 	void startSkipping();
+	void streamed(bool keep_going);
 	
 	enum Element {
 		ELEMENT_LLSD,
@@ -317,11 +319,20 @@ private:
 	
 	std::string mCurrentKey;		// Current XML <tag>
 	std::string mCurrentContent;	// String data between <tag> and </tag>
+
+	// When streaming, values are reported to mHandler rather than added to
+	// mResult.  mStack then points into mStreamValues, which only holds the
+	// open elements: empty containers and the scalar being read.
+	LLSDStreamHandler* mHandler;
+	bool mStreamStopped;
+	std::deque<LLSD> mStreamValues;
 };
 
 
 LLSDXMLParser::Impl::Impl(bool emit_errors)
-	: mEmitErrors(emit_errors)
+	: mEmitErrors(emit_errors),
+	  mHandler(NULL),
+	  mStreamStopped(false)
 {
 	mParser = XML_ParserCreate(NULL);
 	reset();
@@ -399,6 +410,11 @@ S32 LLSDXMLParser::Impl::parse(std::istream& input, LLSD& data)
 	// preserved
 
 	status = XML_ParseBuffer(mParser, 0, true);
+	if (mStreamStopped)
+	{
+		data = LLSD();
+		return LLSDParser::PARSE_FAILURE;
+	}
 	if (status == XML_STATUS_ERROR && !mGracefullStop)
 	{
 		if (buffer)
@@ -490,8 +506,9 @@ S32 LLSDXMLParser::Impl::parseLines(std::istream& input, LLSD& data)
 		status = XML_ParseBuffer(mParser, 0, true);
 	}
 	
-	if (status == XML_STATUS_ERROR  
-		&& !mGracefullStop)
+	if (mStreamStopped
+		|| (status == XML_STATUS_ERROR  
+			&& !mGracefullStop))
 	{
 		if (mEmitErrors)
 		{
@@ -506,6 +523,28 @@ S32 LLSDXMLParser::Impl::parseLines(std::istream& input, LLSD& data)
 }
 
 
+S32 LLSDXMLParser::Impl::parseStream(std::istream& input, LLSDStreamHandler& handler, bool lines)
+{
+	mHandler = &handler;
+	mStreamStopped = false;
+	LLSD unused;
+	S32 parse_count = lines ? parseLines(input, unused) : parse(input, unused);
+	mHandler = NULL;
+	mStack.clear();
+	mStreamValues.clear();
+	return parse_count;
+}
+
+void LLSDXMLParser::Impl::streamed(bool keep_going)
+{
+	if (!keep_going && !mStreamStopped)
+	{
+		mStreamStopped = true;
+		XML_StopParser(mParser, XML_FALSE);
+	}
+}
+
+
 void LLSDXMLParser::Impl::reset()
 {
 	mResult.clear();
@@ -517,6 +556,8 @@ void LLSDXMLParser::Impl::reset()
 	mGracefullStop = false;
 
 	mStack.clear();
+	mStreamValues.clear();
+	mStreamStopped = false;
 	
 	mSkipping = false;
 	
@@ -636,7 +677,26 @@ void LLSDXMLParser::Impl::startElementHandler(const XML_Char* name, const XML_Ch
 
 	if (!mInLLSDElement) { return startSkipping(); }
 	
-	if (mStack.empty())
+	if (mHandler)
+	{
+		if (!mStack.empty())
+		{
+			if (mStack.back()->isMap())
+			{
+				if (mCurrentKey.empty()) { return startSkipping(); }
+				streamed(mHandler->key(mCurrentKey));
+				mCurrentKey.clear();
+			}
+			else if (!mStack.back()->isArray())
+			{
+				// improperly nested value in a non-structure
+				return startSkipping();
+			}
+		}
+		mStreamValues.push_back(LLSD());
+		mStack.push_back(&mStreamValues.back());
+	}
+	else if (mStack.empty())
 	{
 		mStack.push_back(&mResult);
 	}
@@ -667,10 +727,12 @@ void LLSDXMLParser::Impl::startElementHandler(const XML_Char* name, const XML_Ch
 	{
 		case ELEMENT_MAP:
 			*mStack.back() = LLSD::emptyMap();
+			if (mHandler) { streamed(mHandler->beginMap()); }
 			break;
 		
 		case ELEMENT_ARRAY:
 			*mStack.back() = LLSD::emptyArray();
+			if (mHandler) { streamed(mHandler->beginArray()); }
 			break;
 			
 		default:
@@ -808,6 +870,26 @@ void LLSDXMLParser::Impl::endElementHandler(const XML_Char* name)
 			break;
 	}
 
+	if (mHandler)
+	{
+		switch (element)
+		{
+			case ELEMENT_MAP:
+				streamed(mHandler->endMap());
+				break;
+
+			case ELEMENT_ARRAY:
+				streamed(mHandler->endArray());
+				break;
+
+			default:
+				streamed(mHandler->value(value));
+				break;
+		}
+		// value lives in mStreamValues, so this must come last
+		mStreamValues.pop_back();
+	}
+
 	mCurrentContent.clear();
 }
 
@@ -943,6 +1025,12 @@ S32 LLSDXMLParser::doParse(std::istream& input, LLSD& data, S32 max_depth) const
 	return impl.parse(input, data);
 }
 
+// virtual
+S32 LLSDXMLParser::doParseStream(std::istream& input, LLSDStreamHandler& handler, S32 max_depth) const
+{
+	return impl.parseStream(input, handler, mParseLines);
+}
+
 //	virtual 
 void LLSDXMLParser::doReset()
 {
@@ -0,0 +1,89 @@
+/**
+ * @file   llmappedfile_test.cpp
+ * @brief  Test for llmappedfile.cpp.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llmappedfile.h"
+
+#include "../test/lltut.h"
+#include "../test/namedtempfile.h"
+
+#include <cstring>
+
+namespace tut
+{
+	struct mappedfile_data
+	{
+	};
+	typedef test_group<mappedfile_data> mappedfile_group;
+	typedef mappedfile_group::object mappedfile_object;
+	tut::mappedfile_group mappedfile("LLMappedFile");
+
+	template<> template<>
+	void mappedfile_object::test<1>()
+	{
+		set_test_name("map existing file");
+		std::string content("0123456789abcdef\nsecond line\n");
+		NamedTempFile file("mapped", content);
+
+		LLMappedFile mapped;
+		ensure("open", mapped.open(file.getName()));
+		ensure("isOpen", mapped.isOpen());
+		ensure_equals("size", mapped.getSize(), content.size());
+		ensure("content", memcmp(mapped.getData(), content.data(), content.size()) == 0);
+
+		mapped.close();
+		ensure("closed", !mapped.isOpen());
+		ensure_equals("closed size", mapped.getSize(), size_t(0));
+	}
+
+	template<> template<>
+	void mappedfile_object::test<2>()
+	{
+		set_test_name("missing and empty files");
+		LLMappedFile mapped;
+		ensure("missing file", !mapped.open("/this/file/does/not/exist/llmappedfile"));
+		ensure("not open", !mapped.isOpen());
+
+		NamedTempFile empty("empty", "");
+		ensure("empty file", !mapped.open(empty.getName()));
+		ensure("still not open", !mapped.isOpen());
+	}
+
+	template<> template<>
+	void mappedfile_object::test<3>()
+	{
+		set_test_name("reopen replaces mapping");
+		NamedTempFile first("first", "first");
+		NamedTempFile second("second", "second file");
+
+		LLMappedFile mapped;
+		ensure("open first", mapped.open(first.getName()));
+		ensure("open second", mapped.open(second.getName()));
+		ensure_equals("second size", mapped.getSize(), size_t(11));
+		ensure("second content", memcmp(mapped.getData(), "second file", 11) == 0);
+	}
+}
@@ -56,6 +56,7 @@ using namespace boost::phoenix;
 #include "../llsdserialize.h"
 #include "llsdutil.h"
 #include "../llformat.h"
+#include "../lltimer.h"
 
 #include "../test/lltut.h"
 #include "../test/namedtempfile.h"
@@ -1694,6 +1695,229 @@ namespace tut
 		ensureBinaryAndXML("map", test);
 	}
 
+	// A tree shaped like a mesh header or inventory fetch reply: a map of
+	// many small maps holding short scalars.
+	static LLSD make_bulky_llsd(S32 entries)
+	{
+		LLSD result = LLSD::emptyMap();
+		for (S32 i = 0; i < entries; ++i)
+		{
+			LLSD item = LLSD::emptyMap();
+			item["name"] = llformat("item %d", i);
+			item["offset"] = i * 1024;
+			item["size"] = 512 + i;
+			item["scale"] = 0.25 * i;
+			item["flags"] = LLSD::emptyArray();
+			item["flags"].append(true);
+			item["flags"].append(i);
+			result[llformat("entry_%06d", i)] = item;
+		}
+		return result;
+	}
+
+	template<> template<> 
+	void TestLLSDCompatibleObject::test<9>()
+	{
+		LLSD input = make_bulky_llsd(500);
+		std::stringstream bin;
+		LLSDSerialize::toBinary(input, bin);
+		std::stringstream xml;
+		LLSDSerialize::toXML(input, xml);
+
+		U32 blocks_before = LLSDArena::blockCount();
+		{
+			LLSD from_bin;
+			LLPointer<LLSDBinaryParser> bin_parser = new LLSDBinaryParser;
+			bin_parser->setUseArena(true);
+			bin_parser->parse(bin, from_bin, LLSDSerialize::SIZE_UNLIMITED);
+			bin_parser = NULL;
+			ensure("arena binary parse used arena", LLSDArena::blockCount() > blocks_before);
+			ensure_equals("arena binary parse", from_bin, input);
+
+			LLSD from_xml;
+			LLPointer<LLSDXMLParser> xml_parser = new LLSDXMLParser;
+			xml_parser->setUseArena(true);
+			xml_parser->parse(xml, from_xml, LLSDSerialize::SIZE_UNLIMITED);
+			xml_parser = NULL;
+			ensure_equals("arena xml parse", from_xml, input);
+
+			// Nodes outliving the tree they came from keep their block.
+			LLSD kept = from_bin["entry_000010"];
+			from_bin.clear();
+			from_xml.clear();
+			ensure("kept node pins its block", LLSDArena::blockCount() > blocks_before);
+			// ...and no more than the one or two blocks its subtree spans
+			ensure("kept node pins little", LLSDArena::blockCount() - blocks_before <= 2);
+			ensure_equals("kept node value", kept["name"].asString(), std::string("item 10"));
+		}
+		ensure_equals("arena blocks released", LLSDArena::blockCount(), blocks_before);
+
+		// Outside an arena nodes come from the heap.
+		LLSD heap_only = make_bulky_llsd(10);
+		ensure_equals("no arena, no blocks", LLSDArena::blockCount(), blocks_before);
+	}
+
+	template<> template<> 
+	void TestLLSDCompatibleObject::test<10>()
+	{
+		// Not a pass/fail test: compares parse and release time with and
+		// without an arena.
+		const S32 ROUNDS = 20;
+		LLSD input = make_bulky_llsd(2000);
+		std::stringstream bin;
+		LLSDSerialize::toBinary(input, bin);
+		std::string bin_str = bin.str();
+		std::stringstream xml;
+		LLSDSerialize::toXML(input, xml);
+		std::string xml_str = xml.str();
+
+		for (S32 use_arena = 0; use_arena < 2; ++use_arena)
+		{
+			LLTimer timer;
+			for (S32 i = 0; i < ROUNDS; ++i)
+			{
+				std::istringstream istr(bin_str);
+				LLSD parsed;
+				LLPointer<LLSDBinaryParser> parser = new LLSDBinaryParser;
+				parser->setUseArena(use_arena != 0);
+				parser->parse(istr, parsed, bin_str.size());
+			}
+			F64 bin_time = timer.getElapsedTimeF64();
+
+			timer.reset();
+			for (S32 i = 0; i < ROUNDS; ++i)
+			{
+				std::istringstream istr(xml_str);
+				LLSD parsed;
+				LLPointer<LLSDXMLParser> parser = new LLSDXMLParser;
+				parser->setUseArena(use_arena != 0);
+				parser->parse(istr, parsed, LLSDSerialize::SIZE_UNLIMITED);
+			}
+			F64 xml_time = timer.getElapsedTimeF64();
+
+			LL_INFOS() << (use_arena ? "arena" : "heap") << " parse of " << ROUNDS
+					   << " trees: binary " << bin_time * 1000.0 << "ms, xml "
+					   << xml_time * 1000.0 << "ms" << LL_ENDL;
+		}
+	}
+
+	// Rebuilds the top level map of a document from its depth 1 subtrees,
+	// optionally stopping after a given number of them.
+	class TestSubtreeCollector : public LLSDSubtreeHandler
+	{
+	public:
+		TestSubtreeCollector(S32 stop_after = -1)
+			: LLSDSubtreeHandler(1), mResult(LLSD::emptyMap()), mStopAfter(stop_after)
+		{
+		}
+
+		virtual bool subtree(const std::string& name, const LLSD& value)
+		{
+			mResult[name] = value;
+			return mStopAfter < 0 || (S32)mResult.size() < mStopAfter;
+		}
+
+		LLSD mResult;
+		S32 mStopAfter;
+	};
+
+	template<> template<> 
+	void TestLLSDCompatibleObject::test<11>()
+	{
+		LLSD input = make_bulky_llsd(50);
+		input["entry_000003"]["nested"] = LLSD::emptyArray();
+		input["entry_000003"]["nested"].append(LLSD::emptyMap());
+		input["entry_000003"]["nested"][0]["deep"] = "value";
+		input["entry_000004"] = 4;
+
+		std::stringstream bin;
+		LLSDSerialize::toBinary(input, bin);
+		std::stringstream notation;
+		LLSDSerialize::toNotation(input, notation);
+		std::stringstream xml;
+		LLSDSerialize::toXML(input, xml);
+
+		TestSubtreeCollector from_bin;
+		LLPointer<LLSDParser> parser = new LLSDBinaryParser;
+		ensure("binary stream count", parser->parse(bin, from_bin, LLSDSerialize::SIZE_UNLIMITED) > 0);
+		ensure_equals("binary stream", from_bin.mResult, input);
+
+		TestSubtreeCollector from_notation;
+		parser = new LLSDNotationParser;
+		ensure("notation stream count", parser->parse(notation, from_notation, LLSDSerialize::SIZE_UNLIMITED) > 0);
+		ensure_equals("notation stream", from_notation.mResult, input);
+
+		TestSubtreeCollector from_xml;
+		parser = new LLSDXMLParser;
+		ensure("xml stream count", parser->parse(xml, from_xml, LLSDSerialize::SIZE_UNLIMITED) > 0);
+		ensure_equals("xml stream", from_xml.mResult, input);
+
+		// Stopping early fails the parse and keeps what was delivered.
+		bin.clear();
+		bin.seekg(0);
+		TestSubtreeCollector stopped(5);
+		parser = new LLSDBinaryParser;
+		ensure_equals("stopped stream", parser->parse(bin, stopped, LLSDSerialize::SIZE_UNLIMITED),
+					  (S32)LLSDParser::PARSE_FAILURE);
+		ensure_equals("stopped stream size", stopped.mResult.size(), (size_t)5);
+	}
+
+	// Picks the "flags" array out of every record by path.
+	class TestFlagsCollector : public LLSDSubtreeHandler
+	{
+	public:
+		TestFlagsCollector()
+			: LLSDSubtreeHandler(1), mResult(LLSD::emptyMap())
+		{
+		}
+
+		virtual bool subtree(const std::string& name, const LLSD& value)
+		{
+			mResult[path()[1]] = value;
+			return true;
+		}
+
+		LLSD mResult;
+
+	protected:
+		virtual bool isSubtree(const std::string& name)
+		{
+			return path().size() == 2 && name == "flags";
+		}
+	};
+
+	template<> template<> 
+	void TestLLSDCompatibleObject::test<12>()
+	{
+		LLSD input = make_bulky_llsd(20);
+		std::stringstream xml;
+		LLSDSerialize::toXML(input, xml);
+
+		TestFlagsCollector flags;
+		LLPointer<LLSDParser> parser = new LLSDXMLParser;
+		ensure("xml stream count", parser->parse(xml, flags, LLSDSerialize::SIZE_UNLIMITED) > 0);
+		ensure_equals("flags found", flags.mResult.size(), input.size());
+		for (LLSD::map_const_iterator it = input.beginMap(); it != input.endMap(); ++it)
+		{
+			ensure_equals("flags by path", flags.mResult[it->first], it->second["flags"]);
+		}
+	}
+
+	template<> template<> 
+	void TestLLSDCompatibleObject::test<13>()
+	{
+		// a binary map entry whose key marker is neither 'k' nor a quote
+		// fails the stream instead of handing the handler an empty key
+		const char bad_key[] = { '{', 0, 0, 0, 1, 'x', 'i', 0, 0, 0, 1, '}' };
+		std::stringstream bin(std::string(bad_key, sizeof(bad_key)));
+
+		TestSubtreeCollector collector;
+		LLPointer<LLSDParser> parser = new LLSDBinaryParser;
+		ensure_equals("unknown key marker", parser->parse(bin, collector, LLSDSerialize::SIZE_UNLIMITED),
+					  (S32)LLSDParser::PARSE_FAILURE);
+		ensure("no key delivered", collector.mResult.size() == 0);
+	}
+
     struct TestPythonCompatible
     {
         TestPythonCompatible():
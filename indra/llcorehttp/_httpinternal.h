@@ -153,6 +153,10 @@ const int HTTP_CONNECTION_LIMIT_MAX = 256;
 const long HTTP_PIPELINING_DEFAULT = 0L;
 const long HTTP_PIPELINING_MAX = 20L;
 
+// HTTP/2 stream limits (servers commonly allow 100 concurrent streams)
+const long HTTP_HTTP2_STREAMS_DEFAULT = 0L;
+const long HTTP_HTTP2_STREAMS_MAX = 100L;
+
 // Miscellaneous defaults
 const bool HTTP_USE_RETRY_AFTER_DEFAULT = true;
 const long HTTP_THROTTLE_RATE_DEFAULT = 0L;
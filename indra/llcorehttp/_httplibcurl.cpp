@@ -27,6 +27,7 @@
 #include "_httplibcurl.h"
 
 #include "httpheaders.h"
+#include "httpstats.h"
 #include "bufferarray.h"
 #include "_httpoprequest.h"
 #include "_httppolicy.h"
@@ -40,6 +41,10 @@ namespace
 void check_curl_multi_code(CURLMcode code);
 void check_curl_multi_code(CURLMcode code, int curl_setopt_option);
 
+// Attributes a completed transfer to the connection that carried it
+// in HTTPStats.
+void record_connection_use(CURL * handle);
+
 // This is a template because different 'option' values require different
 // types for 'ARG'. Just pass them through unchanged (by value).
 template <typename ARG>
@@ -399,6 +404,11 @@ bool HttpLibcurl::completeRequest(CURLM * multi_handle, CURL * handle, CURLcode
         }
 	}
 
+    if (handle && CURLE_OK == status)
+    {
+        record_connection_use(handle);
+    }
+
     if (multi_handle && handle)
     {
         // Detach from multi and recycle handle
@@ -476,7 +486,21 @@ void HttpLibcurl::policyUpdated(int policy_class)
 		policy.stallPolicy(policy_class, false);
 		mDirtyPolicy[policy_class] = false;
 
-		if (options.mPipelining > 1)
+		if (options.mHttp2Streams > 0)
+		{
+			// Multiplex requests as HTTP/2 streams over as few
+			// connections per host as allowed
+			check_curl_multi_setopt(multi_handle,
+									 CURLMOPT_PIPELINING,
+									 CURLPIPE_MULTIPLEX);
+			check_curl_multi_setopt(multi_handle,
+									 CURLMOPT_MAX_HOST_CONNECTIONS,
+									 options.mPerHostConnectionLimit);
+			check_curl_multi_setopt(multi_handle,
+									 CURLMOPT_MAX_TOTAL_CONNECTIONS,
+									 options.mConnectionLimit);
+		}
+		else if (options.mPipelining > 1)
 		{
 			// We'll try to do pipelining on this multihandle
 			check_curl_multi_setopt(multi_handle,
@@ -643,4 +667,34 @@ void check_curl_multi_code(CURLMcode code)
 	}
 }
 
+
+void record_connection_use(CURL * handle)
+{
+	char * ip(nullptr);
+	if (CURLE_OK != curl_easy_getinfo(handle, CURLINFO_PRIMARY_IP, &ip) || ! ip || ! *ip)
+	{
+		return;
+	}
+
+	long port(0), local_port(0), http_version(0);
+	double lookup_time(0.0), connect_time(0.0), pretransfer_time(0.0), starttransfer_time(0.0);
+	curl_easy_getinfo(handle, CURLINFO_PRIMARY_PORT, &port);
+	curl_easy_getinfo(handle, CURLINFO_LOCAL_PORT, &local_port);
+	curl_easy_getinfo(handle, CURLINFO_HTTP_VERSION, &http_version);
+	curl_easy_getinfo(handle, CURLINFO_NAMELOOKUP_TIME, &lookup_time);
+	curl_easy_getinfo(handle, CURLINFO_CONNECT_TIME, &connect_time);
+	curl_easy_getinfo(handle, CURLINFO_PRETRANSFER_TIME, &pretransfer_time);
+	curl_easy_getinfo(handle, CURLINFO_STARTTRANSFER_TIME, &starttransfer_time);
+
+	// The local port tells connections to the same server apart
+	std::ostringstream connection;
+	connection << ip << ":" << port << "/" << local_port;
+
+	// Reused connections report no time spent connecting
+	const F32 connect_rtt(connect_time > lookup_time ? F32(connect_time - lookup_time) : -1.f);
+	const F32 first_byte(starttransfer_time > pretransfer_time ? F32(starttransfer_time - pretransfer_time) : 0.f);
+
+	LLCore::HTTPStats::instance().recordConnectionUse(connection.str(), http_version, connect_rtt, first_byte);
+}
+
 }  // end anonymous namespace
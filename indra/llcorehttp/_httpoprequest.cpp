@@ -65,6 +65,11 @@
 namespace
 {
 
+// Largest response body kept in a single preallocated block.  Anything
+// bigger, or of unknown length, is gathered in BufferArray's usual
+// chained blocks.
+const double BODY_RESERVE_LIMIT = 16.0 * 1024.0 * 1024.0;
+
 // Attempts to parse a 'Content-Range:' header.  Caller must already
 // have verified that the header tag is present.  The 'buffer' argument
 // will be processed by strtok_r calls which will modify the buffer.
@@ -709,7 +714,15 @@ HttpStatus HttpOpRequest::prepareRequest(HttpService * service)
 	{
 		xfer_timeout = timeout;
 	}
-	if (cpolicy.mPipelining > 1L)
+	if (cpolicy.mHttp2Streams > 0L)
+	{
+		// Negotiate HTTP/2 via ALPN and wait for a connection that can
+		// carry another stream rather than opening a new one.  Streams
+		// progress independently so timeouts are left alone.
+		check_curl_easy_setopt(mCurlHandle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+		check_curl_easy_setopt(mCurlHandle, CURLOPT_PIPEWAIT, 1L);
+	}
+	else if (cpolicy.mPipelining > 1L)
 	{
 		// Pipelining affects both connection and transfer timeout values.
 		// Requests that are added to a pipeling immediately have completed
@@ -783,6 +796,16 @@ size_t HttpOpRequest::writeCallback(void * data, size_t size, size_t nmemb, void
 	if (! op->mReplyBody)
 	{
 		op->mReplyBody = new BufferArray();
+
+		// Bodies of known length are kept in one piece so consumers
+		// can use them in place instead of copying them out.
+		double content_length(-1.0);
+		if (CURLE_OK == curl_easy_getinfo(op->mCurlHandle, CURLINFO_CONTENT_LENGTH_DOWNLOAD, &content_length)
+			&& content_length > 0.0
+			&& content_length <= BODY_RESERVE_LIMIT)
+		{
+			op->mReplyBody->reserve(size_t(content_length));
+		}
 	}
 	const size_t req_size(size * nmemb);
 	const size_t write_size(op->mReplyBody->append(static_cast<char *>(data), req_size));
@@ -63,6 +63,7 @@ public:
 	long						mConnectionLimit;
 	long						mPerHostConnectionLimit;
 	long						mPipelining;
+	long						mHttp2Streams;
 	long						mThrottleRate;
 };  // end class HttpPolicyClass
 
@@ -62,6 +62,7 @@ const HttpService::OptionDescriptor HttpService::sOptionDesc[] =
 	{	true,		true,		true,		false,		false	},		// PO_LLPROXY
 	{	true,		true,		true,		false,		false	},		// PO_TRACE
 	{	true,		true,		false,		true,		false	},		// PO_ENABLE_PIPELINING
+	{	true,		true,		false,		true,		false	},		// PO_HTTP2_STREAMS
 	{	true,		true,		false,		true,		false	},		// PO_THROTTLE_RATE
 	{   false,		false,		true,		false,		true	}		// PO_SSL_VERIFY_CALLBACK
 };
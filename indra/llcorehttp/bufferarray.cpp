@@ -68,17 +68,27 @@ protected:
 	void * operator new(size_t len, size_t addl_len);
 	
 public:
-	// Only public entry to get a block.
+	// Only public entries to get a block.
 	static Block * alloc(size_t len);
 
+	// Block whose data lives in an aligned buffer of its own
+	// which can be detached from it.
+	static Block * allocAligned(size_t len);
+
+	bool isAligned() const
+		{
+			return mData != mStorage;
+		}
+
 public:
 	size_t mUsed;
 	size_t mAlloced;
+	char * mData;
 
 	// *NOTE:  Must be last member of the object.  We'll
 	// overallocate as requested via operator new and index
 	// into the array at will.
-	char mData[1];		
+	char mStorage[1];
 };
 
 
@@ -184,6 +194,69 @@ void * BufferArray::appendBufferAlloc(size_t len)
 }
 
 
+void BufferArray::reserve(size_t len)
+{
+	if (mLen || ! len)
+	{
+		return;
+	}
+
+	// Drop any empty blocks left by earlier reservations
+	for (container_t::iterator it(mBlocks.begin());
+		 it != mBlocks.end();
+		 ++it)
+	{
+		delete *it;
+	}
+	mBlocks.clear();
+
+	Block * block = Block::allocAligned(len);
+	if (block)
+	{
+		mBlocks.push_back(block);
+	}
+}
+
+
+const char * BufferArray::contiguousData(size_t pos, size_t len) const
+{
+	if (pos + len > mLen)
+		return NULL;
+
+	for (container_t::const_iterator it(mBlocks.begin());
+		 it != mBlocks.end();
+		 ++it)
+	{
+		const Block & block(**it);
+		if (pos < block.mUsed)
+		{
+			return (pos + len <= block.mUsed) ? &block.mData[pos] : NULL;
+		}
+		pos -= block.mUsed;
+	}
+	return NULL;
+}
+
+
+void * BufferArray::detachData(size_t * len)
+{
+	if (mBlocks.empty() || mBlocks.front()->mUsed != mLen || ! mBlocks.front()->isAligned())
+	{
+		return NULL;
+	}
+
+	Block & block(*mBlocks.front());
+	void * data = block.mData;
+	*len = mLen;
+
+	block.mData = block.mStorage;
+	block.mUsed = 0;
+	block.mAlloced = 0;
+	mLen = 0;
+	return data;
+}
+
+
 size_t BufferArray::read(size_t pos, void * dst, size_t len)
 {
 	char * c_dst(static_cast<char *>(dst));
@@ -325,7 +398,8 @@ bool BufferArray::getBlockStartEnd(int block, const char ** start, const char **
 
 BufferArray::Block::Block(size_t len)
 	: mUsed(0),
-	  mAlloced(len)
+	  mAlloced(len),
+	  mData(mStorage)
 {
 	memset(mData, 0, len);
 }
@@ -333,6 +407,11 @@ BufferArray::Block::Block(size_t len)
 
 BufferArray::Block::~Block()
 {
+	if (isAligned())
+	{
+		ll_aligned_free_16(mData);
+	}
+	mData = mStorage;
 	mUsed = 0;
 	mAlloced = 0;
 }
@@ -363,6 +442,22 @@ BufferArray::Block * BufferArray::Block::alloc(size_t len)
 	Block * block = new (len) Block(len);
 	return block;
 }
+
+
+BufferArray::Block * BufferArray::Block::allocAligned(size_t len)
+{
+	char * data = static_cast<char *>(ll_aligned_malloc_16(len));
+	if (! data)
+	{
+		return NULL;
+	}
+
+	// Filled by appends, no need to clear it first
+	Block * block = new (0) Block(0);
+	block->mData = data;
+	block->mAlloced = len;
+	return block;
+}
 	
 
 }  // end namespace LLCore
@@ -104,6 +104,32 @@ public:
 	///					of BufferArray of 'len' size.
 	void * appendBufferAlloc(size_t len);
 
+	/// Preallocates a single contiguous block for an empty
+	/// BufferArray when the final size is known up front,
+	/// e.g. from a Content-Length header.  Appends of up to
+	/// 'len' bytes then stay in one piece and can be handed
+	/// out with @see contiguousData() or @see detachData()
+	/// without copying.  Does nothing if the instance already
+	/// holds data.
+	void reserve(size_t len);
+
+	/// Pointer to 'len' bytes starting at 'pos' when they are
+	/// stored in a single block, NULL otherwise in which case
+	/// the caller should fall back to @see read().  Valid until
+	/// the next modification of the instance.
+	const char * contiguousData(size_t pos, size_t len) const;
+
+	/// Hands over the storage of a BufferArray whose data was
+	/// entirely placed in a block set up by @see reserve().  The
+	/// buffer was allocated with ll_aligned_malloc_16() and now
+	/// belongs to the caller, e.g. to give to
+	/// LLImageFormatted::setData().  The instance is left
+	/// empty.
+	///
+	/// @return			Buffer of '*len' bytes or NULL if the data
+	///					isn't held that way.
+	void * detachData(size_t * len);
+
 	/// Current count of bytes in BufferArray instance.
 	size_t size() const
 		{
@@ -372,6 +372,12 @@ std::string getCURLVersion()
     return std::string(curl_version());
 }
 
+bool isHttp2Available()
+{
+    const curl_version_info_data * info(curl_version_info(CURLVERSION_NOW));
+    return info && (info->features & CURL_VERSION_HTTP2);
+}
+
 void check_curl_code(CURLcode code, int curl_setopt_option)
 {
     if (CURLE_OK != code)
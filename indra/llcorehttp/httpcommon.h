@@ -502,6 +502,9 @@ namespace LLHttp
     CURL_ptr createEasyHandle();
     std::string getCURLVersion();
 
+    // True if libcurl was built with HTTP/2 support (nghttp2)
+    bool isHttp2Available();
+
     void check_curl_code(CURLcode code, int curl_setopt_option);
 }
 
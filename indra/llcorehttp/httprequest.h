@@ -218,6 +218,25 @@ public:
 		/// Per-class only
 		PO_PIPELINING_DEPTH,
 
+		/// If greater than 0, requests in the class negotiate
+		/// HTTP/2 where the server offers it over TLS and are
+		/// multiplexed as streams over shared connections.  Value
+		/// gives the number of requests the class keeps in
+		/// flight.
+		///
+		/// Connection limits are left as they are:
+		/// PO_PER_HOST_CONNECTION_LIMIT and PO_CONNECTION_LIMIT
+		/// still bound the sockets libcurl may open, and the
+		/// in-flight limit is never below the per-host limit.
+		/// New requests wait for a connection that can multiplex
+		/// rather than opening another.  Servers only speaking
+		/// HTTP/1.1, and plain http URLs, get one request per
+		/// connection up to those limits.  Takes precedence over
+		/// PO_PIPELINING_DEPTH.
+		///
+		/// Per-class only
+		PO_HTTP2_STREAMS,
+
 		/// Controls whether client-side throttling should be
 		/// performed on this policy class.  Positive values
 		/// enable throttling and specify the request rate
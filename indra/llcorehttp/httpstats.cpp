@@ -45,6 +45,7 @@ void HTTPStats::resetStats()
     mDataDown.reset();
     mDataUp.reset();
     mRequests = 0;
+    mConnections.clear();
 }
 
 
@@ -61,6 +62,31 @@ void HTTPStats::recordResultCode(S32 code)
 
 }
 
+void HTTPStats::recordConnectionUse(const std::string & connection, long http_version,
+                                    F32 connect_time, F32 first_byte_time)
+{
+    // Long sessions churn through many HTTP/1.1 connections, only
+    // itemize the first ones and lump the rest together.
+    static const size_t MAX_CONNECTIONS = 256;
+    static const std::string other_connections("(other)");
+
+    connection_map_t::iterator it(mConnections.find(connection));
+    if (it == mConnections.end())
+    {
+        const std::string & key(mConnections.size() < MAX_CONNECTIONS ? connection : other_connections);
+        it = mConnections.insert(connection_map_t::value_type(key, ConnectionStats())).first;
+    }
+
+    ConnectionStats & stats((*it).second);
+    stats.mHttpVersion = http_version;
+    ++stats.mStreams;
+    if (connect_time >= 0.f)
+    {
+        stats.mConnectTime.push(connect_time);
+    }
+    stats.mFirstByteTime.push(first_byte_time);
+}
+
 namespace
 {
     std::string byte_count_converter(F32 bytes)
@@ -101,6 +127,18 @@ void HTTPStats::dumpStats()
         out << (*it).first << " " << (*it).second << std::endl;
     }
 
+    out << std::endl;
+    out << "Connections:" << std::endl << "--- -----" << std::endl;
+    for (connection_map_t::iterator it = mConnections.begin(); it != mConnections.end(); ++it)
+    {
+        const ConnectionStats & stats((*it).second);
+        out << (*it).first << " HTTP version: " << stats.mHttpVersion
+            << " streams: " << stats.mStreams
+            << " connect RTT: " << stats.mConnectTime.getMean() * 1000.f << "ms"
+            << " first byte: " << stats.mFirstByteTime.getMean() * 1000.f << "ms avg, "
+            << stats.mFirstByteTime.getMaxValue() * 1000.f << "ms max" << std::endl;
+    }
+
     LL_WARNS("HTTPCore") << out.str() << LL_ENDL;
 }
 
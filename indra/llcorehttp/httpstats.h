@@ -59,6 +59,25 @@ namespace LLCore
 
         void    recordResultCode(S32 code);
 
+        // Per-connection use, fed from completed transfers.  Connect
+        // time is the TCP handshake RTT and only sampled by requests
+        // opening the connection, negative otherwise.
+        struct ConnectionStats
+        {
+            ConnectionStats() : mHttpVersion(0), mStreams(0) {}
+
+            long             mHttpVersion;      // CURL_HTTP_VERSION_* negotiated
+            S32              mStreams;          // requests carried
+            StatsAccumulator mConnectTime;
+            StatsAccumulator mFirstByteTime;    // request sent to first byte received
+        };
+        typedef std::map<std::string, ConnectionStats> connection_map_t;
+
+        void    recordConnectionUse(const std::string & connection, long http_version,
+                                    F32 connect_time, F32 first_byte_time);
+
+        const connection_map_t & getConnections() const { return mConnections; }
+
         void    dumpStats();
     private:
         StatsAccumulator mDataDown;
@@ -67,6 +86,8 @@ namespace LLCore
         S32              mRequests;
 
         std::map<S32, S32> mResutCodes;
+
+        connection_map_t mConnections;
     };
 
 
@@ -162,6 +162,22 @@ std::string get_base_url()
 }
 
 
+std::string get_h2_base_url()
+{
+	// Only set when the peer script could start its HTTP/2 server
+	const char * env(getenv("LL_TEST_H2_PORT"));
+	if (! env)
+	{
+		return std::string();
+	}
+
+	int port(atoi(env));
+	std::ostringstream out;
+	out << "https://127.0.0.1:" << port << "/";
+	return out.str();
+}
+
+
 void stop_thread(LLCore::HttpRequest * req)
 {
 	if (req)
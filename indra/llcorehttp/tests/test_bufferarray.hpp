@@ -27,6 +27,7 @@
 #define TEST_LLCORE_BUFFER_ARRAY_H_
 
 #include "bufferarray.h"
+#include "llmemory.h"
 
 #include <iostream>
 
@@ -374,6 +375,55 @@ void BufferArrayTestObjectType::test<8>()
 	ba->release();
 }
 
+template <> template <>
+void BufferArrayTestObjectType::test<9>()
+{
+	set_test_name("BufferArray reserved contiguous block");
+
+	// create a new ref counted object with an implicit reference
+	BufferArray * ba = new BufferArray();
+
+	char str1[] = "abcdefghij";
+	size_t str1_len(strlen(str1));
+	char buffer[256];
+
+	// appends within the reservation stay in one piece
+	ba->reserve(2 * str1_len);
+	ensure("Nothing in BA after reserve", 0 == ba->size());
+	ba->append(str1, str1_len);
+	ba->append(str1, str1_len);
+	const char * contig(ba->contiguousData(0, 2 * str1_len));
+	ensure("Reserved data contiguous", NULL != contig);
+	ensure("Contiguous content correct", 0 == strncmp(contig + str1_len, str1, str1_len));
+	ensure("Range past the end refused", NULL == ba->contiguousData(str1_len, 2 * str1_len));
+
+	// reserving again is ignored once there is data
+	ba->reserve(1000);
+	ensure("Reserve kept data", 2 * str1_len == ba->size());
+
+	// the buffer can be taken over as is
+	size_t detached_len(0);
+	void * detached(ba->detachData(&detached_len));
+	ensure("Reserved data detached", NULL != detached);
+	ensure("Detached length correct", 2 * str1_len == detached_len);
+	ensure("Detached content correct", 0 == strncmp(static_cast<char *>(detached), str1, str1_len));
+	ensure("BA empty after detach", 0 == ba->size());
+	ll_aligned_free_16(detached);
+
+	// overflowing the reservation chains blocks as usual
+	ba->reserve(str1_len);
+	ba->append(str1, str1_len);
+	ba->append(str1, str1_len);
+	ensure("Overflow not contiguous", NULL == ba->contiguousData(0, 2 * str1_len));
+	ensure("Overflow not detachable", NULL == ba->detachData(&detached_len));
+	size_t len(ba->read(0, buffer, sizeof(buffer)));
+	ensure("Overflow length correct", 2 * str1_len == len);
+	ensure("Overflow content correct", 0 == strncmp(buffer + str1_len, str1, str1_len));
+
+	// release the implicit reference, causing the object to be released
+	ba->release();
+}
+
 }  // end namespace tut
 
 
@@ -32,6 +32,7 @@
 #include "httpheaders.h"
 #include "httpresponse.h"
 #include "httpoptions.h"
+#include "httpstats.h"
 #include "_httpservice.h"
 #include "_httprequestqueue.h"
 
@@ -3056,6 +3057,141 @@ void HttpRequestTestObjectType::test<23>()
 }
 
 
+template <> template <>
+void HttpRequestTestObjectType::test<24>()
+{
+	ScopedCurlInit ready;
+
+	set_test_name("HttpRequest GETs multiplexed over HTTP/2");
+
+	const std::string url_base(get_h2_base_url());
+	if (url_base.empty())
+	{
+		skip("No HTTP/2 peer, needs the python h2 package and openssl");
+	}
+	if (! LLHttp::isHttp2Available())
+	{
+		skip("libcurl built without HTTP/2");
+	}
+
+	// Handler can be stack-allocated *if* there are no dangling
+	// references to it after completion of this method.
+	TestHandler2 handler(this, "handler");
+	LLCore::HttpHandler::ptr_t handlerp(&handler, NoOpDeletor);
+	mHandlerCalls = 0;
+
+	HttpRequest * req = NULL;
+	HttpOptions::ptr_t opts;
+
+	try
+	{
+		// Get singletons created
+		HttpRequest::createService();
+		HTTPStats::instance().resetStats();
+
+		// Eight streams in flight.  The per-host limit allows more
+		// than one connection, multiplexing alone keeps it to one.
+		HttpRequest::policy_t h2_class(HttpRequest::createPolicyClass());
+		ensure("Policy class created", h2_class != HttpRequest::INVALID_POLICY_ID);
+		HttpStatus status(HttpRequest::setStaticPolicyOption(HttpRequest::PO_HTTP2_STREAMS, h2_class, 8, NULL));
+		ensure("HTTP/2 streams set", bool(status));
+		status = HttpRequest::setStaticPolicyOption(HttpRequest::PO_PER_HOST_CONNECTION_LIMIT, h2_class, 4, NULL);
+		ensure("Per-host limit set", bool(status));
+		
+		// Start threading early so that thread memory is invariant
+		// over the test.
+		HttpRequest::startThread();
+
+		// create a new ref counted object with an implicit reference
+		req = new HttpRequest();
+
+		// Test peer has a self-signed certificate
+		opts = HttpOptions::ptr_t(new HttpOptions());
+		opts->setSSLVerifyPeer(false);
+		opts->setSSLVerifyHost(false);
+
+		mStatus = HttpStatus(200);
+		const int url_limit(16);
+		for (int i(0); i < url_limit; ++i)
+		{
+			std::ostringstream url;
+			url << url_base << i;
+			HttpHandle handle = req->requestGet(h2_class,
+												0U,
+												url.str(),
+												opts,
+												HttpHeaders::ptr_t(),
+												handlerp);
+
+			std::ostringstream testtag;
+			testtag << "Valid handle returned for HTTP/2 request #" << i;
+			ensure(testtag.str(), handle != LLCORE_HTTP_HANDLE_INVALID);
+		}
+
+		// Run the notification pump.
+		int count(0);
+		int limit(LOOP_COUNT_LONG);
+		while (count++ < limit && mHandlerCalls < url_limit)
+		{
+			req->update(0);
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Requests executed in reasonable time", count < limit);
+		ensure("One handler invocation for each request", mHandlerCalls == url_limit);
+
+		// Okay, request a shutdown of the servicing thread
+		mStatus = HttpStatus();
+		mHandlerCalls = 0;
+		HttpHandle handle = req->requestStopThread(handlerp);
+		ensure("Valid handle returned for stop request", handle != LLCORE_HTTP_HANDLE_INVALID);
+	
+		// Run the notification pump again
+		count = 0;
+		limit = LOOP_COUNT_LONG;
+		while (count++ < limit && mHandlerCalls < 1)
+		{
+			req->update(1000000);
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Stop request executed in reasonable time", count < limit);
+		ensure("Stop handler invocation", mHandlerCalls == 1);
+
+		// See that we actually shutdown the thread
+		count = 0;
+		limit = LOOP_COUNT_SHORT;
+		while (count++ < limit && ! HttpService::isStopped())
+		{
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Thread actually stopped running", HttpService::isStopped());
+
+		// Every request went out as a stream on the one connection
+		const HTTPStats::connection_map_t & connections(HTTPStats::instance().getConnections());
+		ensure_equals("One connection used", connections.size(), size_t(1));
+		ensure_equals("Connection negotiated HTTP/2", connections.begin()->second.mHttpVersion, long(CURL_HTTP_VERSION_2_0));
+		ensure_equals("Connection carried every request", connections.begin()->second.mStreams, S32(url_limit));
+
+		// release options
+		opts.reset();
+		
+		// release the request object
+		delete req;
+		req = NULL;
+
+		// Shut down service
+		HttpRequest::destroyService();
+	}
+	catch (...)
+	{
+		stop_thread(req);
+		opts.reset();
+		delete req;
+		HttpRequest::destroyService();
+		throw;
+	}
+}
+
+
 }  // end namespace tut
 
 namespace
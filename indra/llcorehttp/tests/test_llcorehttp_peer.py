@@ -34,6 +34,12 @@ import sys
 import time
 import select
 import getopt
+import shutil
+import socket
+import ssl
+import subprocess
+import tempfile
+import threading
 from io import StringIO
 from http.server import HTTPServer, BaseHTTPRequestHandler
 
@@ -47,6 +53,13 @@ sys.path.append(os.path.join(os.path.dirname(__file__), os.pardir, os.pardir,
 
 from testrunner import freeport, run, debug, VERBOSE
 
+try:
+    import h2.config
+    import h2.connection
+    import h2.events
+except ImportError:
+    h2 = None
+
 class TestHTTPRequestHandler(BaseHTTPRequestHandler):
     """This subclass of BaseHTTPRequestHandler is to receive and echo
     LLSD-flavored messages sent by the C++ LLHTTPClient.
@@ -286,6 +299,74 @@ class Server(HTTPServer):
         print('-'*40)
 
 
+class H2Server(threading.Thread):
+    """Minimal HTTP/2 over TLS server for the multiplexing tests.  Every
+    GET is answered with 200 and a small body.  Connections are served
+    one at a time, which is all libcurl should need when multiplexing."""
+    BODY = b"x" * 1024
+
+    def __init__(self, certfile, keyfile):
+        threading.Thread.__init__(self, daemon=True)
+        self.context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        self.context.load_cert_chain(certfile, keyfile)
+        self.context.set_alpn_protocols(["h2"])
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.sock.bind(('127.0.0.1', 0))
+        self.sock.listen(5)
+        self.server_port = self.sock.getsockname()[1]
+
+    def run(self):
+        while True:
+            sock, _ = self.sock.accept()
+            try:
+                self.serve(self.context.wrap_socket(sock, server_side=True))
+            except (OSError, ssl.SSLError) as err:
+                debug("h2 connection dropped: %s", err)
+            finally:
+                sock.close()
+
+    def serve(self, sock):
+        conn = h2.connection.H2Connection(
+            config=h2.config.H2Configuration(client_side=False))
+        conn.initiate_connection()
+        sock.sendall(conn.data_to_send())
+        while True:
+            data = sock.recv(65535)
+            if not data:
+                return
+            for event in conn.receive_data(data):
+                if isinstance(event, h2.events.RequestReceived):
+                    conn.send_headers(event.stream_id,
+                                      [(":status", "200"),
+                                       ("content-type", "application/octet-stream"),
+                                       ("content-length", str(len(self.BODY)))])
+                    conn.send_data(event.stream_id, self.BODY, end_stream=True)
+                elif isinstance(event, h2.events.ConnectionTerminated):
+                    return
+            sock.sendall(conn.data_to_send())
+
+
+def make_h2_server(workdir):
+    """Returns a started H2Server, or None if the h2 package or openssl
+    needed for its self-signed certificate are unavailable."""
+    if h2 is None:
+        debug("h2 package not found, skipping HTTP/2 tests")
+        return None
+    certfile = os.path.join(workdir, "cert.pem")
+    keyfile = os.path.join(workdir, "key.pem")
+    try:
+        subprocess.check_call(["openssl", "req", "-x509", "-newkey", "rsa:2048", "-nodes",
+                               "-days", "1", "-subj", "/CN=127.0.0.1",
+                               "-keyout", keyfile, "-out", certfile],
+                              stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    except (OSError, subprocess.CalledProcessError) as err:
+        debug("no certificate for HTTP/2 tests (%s), skipping", err)
+        return None
+    server = H2Server(certfile, keyfile)
+    server.start()
+    return server
+
+
 if __name__ == "__main__":
     do_valgrind = False
     path_search = False
@@ -313,7 +394,17 @@ if __name__ == "__main__":
     # performed in TUT code rather than our own.
     os.environ["LL_TEST_PORT"] = str(httpd.server_port)
     debug("$LL_TEST_PORT = %s", httpd.server_port)
+
+    # HTTP/2 peer, when it can be run
+    h2_workdir = tempfile.mkdtemp()
+    h2d = make_h2_server(h2_workdir)
+    if h2d is not None:
+        os.environ["LL_TEST_H2_PORT"] = str(h2d.server_port)
+        debug("$LL_TEST_H2_PORT = %s", h2d.server_port)
+
     if do_valgrind:
         args = ["valgrind", "--log-file=./valgrind.log"] + args
         path_search = True
-    sys.exit(run(server_inst=httpd, use_path=path_search, *args))
+    rc = run(server_inst=httpd, use_path=path_search, *args)
+    shutil.rmtree(h2_workdir, ignore_errors=True)
+    sys.exit(rc)
@@ -39,20 +39,64 @@
 
 #include "lldiskcache.h"
 
+namespace
+{
+    // Journal records are: U8 op, U32 time, U64 size, U16 name length, name
+    const size_t JOURNAL_RECORD_HEADER_SIZE = sizeof(U8) + sizeof(U32) + sizeof(U64) + sizeof(U16);
+    const char JOURNAL_MAGIC[] = "LLDC";
+    const U32 JOURNAL_VERSION = 1;
+
+    // Rewrite the journal once it holds this many more records than the index
+    const U32 JOURNAL_COMPACT_SLACK = 20000;
+
+    void append_journal_record(std::string& buffer, U8 op, U32 time, U64 size, const std::string& name)
+    {
+        U16 name_len = (U16)llmin(name.size(), (size_t)U16_MAX);
+
+        buffer.append((const char*)&op, sizeof(op));
+        buffer.append((const char*)&time, sizeof(time));
+        buffer.append((const char*)&size, sizeof(size));
+        buffer.append((const char*)&name_len, sizeof(name_len));
+        buffer.append(name, 0, name_len);
+    }
+}
+
 LLDiskCache::LLDiskCache(const std::string cache_dir,
                          const uintmax_t max_size_bytes,
                          const bool enable_cache_debug_info) :
     mCacheDir(cache_dir),
     mMaxSizeBytes(max_size_bytes),
-    mEnableCacheDebugInfo(enable_cache_debug_info)
+    mEnableCacheDebugInfo(enable_cache_debug_info),
+    mIndexTotalSize(0),
+    mJournalFile(nullptr),
+    mJournalRecords(0),
+    mTouchedCount(0)
 {
     mCacheFilenamePrefix = "sl_cache";
 
     LLFile::mkdir(cache_dir);
+
+    mJournalFilename = mCacheDir + gDirUtilp->getDirDelimiter() + "cache_index.journal";
+
+    LLMutexLock lock(&mIndexMutex);
+    loadIndex();
+}
+
+LLDiskCache::~LLDiskCache()
+{
+    flushIndex();
+
+    LLMutexLock lock(&mIndexMutex);
+    if (mJournalFile)
+    {
+        LLFile::close(mJournalFile);
+        mJournalFile = nullptr;
+    }
 }
 
-// WARNING: purge() is called by LLPurgeDiskCacheThread. As such it must
-// NOT touch any LLDiskCache data without introducing and locking a mutex!
+// purge() is called by LLPurgeDiskCacheThread. The index is only ever touched
+// with mIndexMutex held, and the files themselves are deleted after it has
+// been released.
 
 // Interaction through the filesystem itself should be safe. Let’s say thread
 // A is accessing the cache file for reading/writing and thread B is trimming
@@ -81,17 +125,306 @@ LLDiskCache::LLDiskCache(const std::string cache_dir,
 // asset will have to be re-requested.
 void LLDiskCache::purge()
 {
-    if (mEnableCacheDebugInfo)
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    std::vector<IndexEntry> removed;
+    uintmax_t total_before = 0;
+    uintmax_t total_after = 0;
     {
-        LL_INFOS() << "Total dir size before purge is " << dirFileSize(mCacheDir) << LL_ENDL;
+        LLMutexLock lock(&mIndexMutex);
+
+        total_before = mIndexTotalSize;
+        while (mIndexTotalSize > mMaxSizeBytes && !mIndexList.empty())
+        {
+            IndexEntry entry = mIndexList.back();
+            applyRemove(entry.mName);
+            appendJournal(JOURNAL_REMOVE, entry);
+            removed.push_back(entry);
+        }
+        writeJournalBuffer();
+        total_after = mIndexTotalSize;
+    }
+
+    if (!removed.empty())
+    {
+        LL_INFOS() << "Purging cache to a maximum of " << mMaxSizeBytes << " bytes" << LL_ENDL;
     }
 
     boost::system::error_code ec;
-    auto start_time = std::chrono::high_resolution_clock::now();
+    for (const IndexEntry& entry : removed)
+    {
+        const std::string file_path = mCacheDir + gDirUtilp->getDirDelimiter() + entry.mName;
+#if LL_WINDOWS
+        boost::filesystem::remove(utf8str_to_utf16str(file_path), ec);
+#else
+        boost::filesystem::remove(file_path, ec);
+#endif
+        if (ec.failed())
+        {
+            LL_WARNS() << "Failed to delete cache file " << file_path << ": " << ec.message() << LL_ENDL;
+
+            // Most likely open by a reader right now; keep it as recently used
+            LLMutexLock lock(&mIndexMutex);
+            applyAdd(entry.mName, entry.mSize, (U32)std::time(nullptr));
+            appendJournal(JOURNAL_ADD, mIndexList.front());
+            writeJournalBuffer();
+        }
+    }
+
+    flushIndex();
+
+    if (mEnableCacheDebugInfo)
+    {
+        auto end_time = std::chrono::high_resolution_clock::now();
+        auto execute_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+
+        // Log afterward so it doesn't affect the time measurement
+        for (const IndexEntry& entry : removed)
+        {
+            // have to do this because of LL_INFO/LL_END weirdness
+            std::ostringstream line;
+
+            line << "DELETE:  ";
+            line << entry.mTime << "  ";
+            line << entry.mSize << "  ";
+            line << entry.mName;
+            LL_INFOS() << line.str() << LL_ENDL;
+        }
+
+        LL_INFOS() << "Total indexed size before purge was " << total_before << ", after is " << total_after
+                   << " (" << dirFileSize(mCacheDir) << " on disk)" << LL_ENDL;
+        LL_INFOS() << "Cache purge took " << execute_time << " ms to execute for " << removed.size() << " files" << LL_ENDL;
+    }
+}
+
+void LLDiskCache::flushIndex()
+{
+    LLMutexLock lock(&mIndexMutex);
+
+    // Everything read since the last flush sits at the front of the list,
+    // mixed in with newly written files. Journal them oldest first.
+    std::vector<IndexEntry*> touched;
+    touched.reserve(mTouchedCount);
+    for (index_list_t::iterator iter = mIndexList.begin(); mTouchedCount > 0 && iter != mIndexList.end(); ++iter)
+    {
+        if (iter->mTouched)
+        {
+            iter->mTouched = false;
+            --mTouchedCount;
+            touched.push_back(&*iter);
+        }
+    }
+    for (std::vector<IndexEntry*>::reverse_iterator iter = touched.rbegin(); iter != touched.rend(); ++iter)
+    {
+        appendJournal(JOURNAL_TOUCH, **iter);
+    }
+
+    writeJournalBuffer();
+
+    if (mJournalRecords > mIndexMap.size() + JOURNAL_COMPACT_SLACK)
+    {
+        compactJournal();
+    }
+}
+
+std::string LLDiskCache::getIndexKey(const std::string& file_path) const
+{
+    return gDirUtilp->getBaseFileName(file_path);
+}
+
+void LLDiskCache::applyAdd(const std::string& name, uintmax_t size, U32 time)
+{
+    index_map_t::iterator found = mIndexMap.find(name);
+    if (found != mIndexMap.end())
+    {
+        mIndexTotalSize -= found->second->mSize;
+        if (found->second->mTouched)
+        {
+            --mTouchedCount;
+        }
+        mIndexList.erase(found->second);
+    }
+
+    mIndexList.push_front(IndexEntry{ name, size, time, false });
+    mIndexMap[name] = mIndexList.begin();
+    mIndexTotalSize += size;
+}
+
+void LLDiskCache::applyTouch(const std::string& name, U32 time)
+{
+    index_map_t::iterator found = mIndexMap.find(name);
+    if (found != mIndexMap.end())
+    {
+        found->second->mTime = time;
+        mIndexList.splice(mIndexList.begin(), mIndexList, found->second);
+    }
+}
+
+void LLDiskCache::applyRemove(const std::string& name)
+{
+    index_map_t::iterator found = mIndexMap.find(name);
+    if (found != mIndexMap.end())
+    {
+        mIndexTotalSize -= found->second->mSize;
+        if (found->second->mTouched)
+        {
+            --mTouchedCount;
+        }
+        mIndexList.erase(found->second);
+        mIndexMap.erase(found);
+    }
+}
+
+void LLDiskCache::appendJournal(EJournalOp op, const IndexEntry& entry)
+{
+    append_journal_record(mJournalBuffer, (U8)op, entry.mTime, entry.mSize, entry.mName);
+    ++mJournalRecords;
+}
+
+void LLDiskCache::writeJournalBuffer()
+{
+    if (mJournalBuffer.empty())
+    {
+        return;
+    }
+
+    if (!mJournalFile)
+    {
+        openJournal(false);
+    }
+
+    if (mJournalFile)
+    {
+        if (fwrite(mJournalBuffer.data(), 1, mJournalBuffer.size(), mJournalFile) != mJournalBuffer.size()
+            || fflush(mJournalFile) != 0)
+        {
+            LL_WARNS() << "Failed to write cache index journal " << mJournalFilename << LL_ENDL;
+        }
+    }
+    mJournalBuffer.clear();
+}
+
+void LLDiskCache::openJournal(bool truncate)
+{
+    if (mJournalFile)
+    {
+        LLFile::close(mJournalFile);
+        mJournalFile = nullptr;
+    }
+
+    mJournalFile = LLFile::fopen(mJournalFilename, truncate ? "wb" : "ab");
+    if (!mJournalFile)
+    {
+        LL_WARNS() << "Unable to open cache index journal " << mJournalFilename << LL_ENDL;
+        return;
+    }
+
+    if (truncate)
+    {
+        fwrite(JOURNAL_MAGIC, 1, sizeof(U32), mJournalFile);
+        fwrite(&JOURNAL_VERSION, sizeof(U32), 1, mJournalFile);
+        mJournalRecords = 0;
+    }
+}
+
+void LLDiskCache::loadIndex()
+{
+    mIndexList.clear();
+    mIndexMap.clear();
+    mIndexTotalSize = 0;
+    mTouchedCount = 0;
+    mJournalRecords = 0;
+
+    bool success = false;
+    bool torn = false;
+    LLFILE* journal = LLFile::fopen(mJournalFilename, "rb");
+    if (journal)
+    {
+        char magic[sizeof(U32)];
+        U32 version = 0;
+        success = fread(magic, 1, sizeof(magic), journal) == sizeof(magic)
+            && fread(&version, sizeof(U32), 1, journal) == 1
+            && memcmp(magic, JOURNAL_MAGIC, sizeof(magic)) == 0
+            && version == JOURNAL_VERSION;
+
+        U8 header[JOURNAL_RECORD_HEADER_SIZE];
+        std::string name;
+        while (success)
+        {
+            size_t header_read = fread(header, 1, JOURNAL_RECORD_HEADER_SIZE, journal);
+            if (header_read != JOURNAL_RECORD_HEADER_SIZE)
+            {
+                // end of the journal, possibly with a record torn by a crash
+                torn = header_read != 0;
+                break;
+            }
+
+            U8 op = header[0];
+            U32 time;
+            U64 size;
+            U16 name_len;
+            memcpy(&time, header + sizeof(U8), sizeof(U32));
+            memcpy(&size, header + sizeof(U8) + sizeof(U32), sizeof(U64));
+            memcpy(&name_len, header + sizeof(U8) + sizeof(U32) + sizeof(U64), sizeof(U16));
+
+            name.resize(name_len);
+            if (name_len && fread(&name[0], 1, name_len, journal) != name_len)
+            {
+                torn = true;
+                break;
+            }
+
+            switch (op)
+            {
+            case JOURNAL_ADD:
+                applyAdd(name, size, time);
+                break;
+            case JOURNAL_TOUCH:
+                applyTouch(name, time);
+                break;
+            case JOURNAL_REMOVE:
+                applyRemove(name);
+                break;
+            default:
+                LL_WARNS() << "Corrupt cache index journal " << mJournalFilename << LL_ENDL;
+                success = false;
+                break;
+            }
+            ++mJournalRecords;
+        }
+        LLFile::close(journal);
+    }
+
+    if (success && (torn || mJournalRecords > mIndexMap.size() + JOURNAL_COMPACT_SLACK))
+    {
+        // Start from a clean file so a torn record isn't followed by good ones
+        compactJournal();
+    }
+    else if (success)
+    {
+        openJournal(false);
+    }
+    else
+    {
+        rebuildIndex();
+    }
+
+    LL_INFOS() << "Disk cache index has " << mIndexMap.size() << " files, " << mIndexTotalSize << " bytes" << LL_ENDL;
+}
+
+void LLDiskCache::rebuildIndex()
+{
+    LL_INFOS() << "Rebuilding disk cache index for " << mCacheDir << LL_ENDL;
+
+    mIndexList.clear();
+    mIndexMap.clear();
+    mIndexTotalSize = 0;
+    mTouchedCount = 0;
 
     typedef std::pair<std::time_t, std::pair<uintmax_t, std::string>> file_info_t;
     std::vector<file_info_t> file_info;
 
+    boost::system::error_code ec;
 #if LL_WINDOWS
     std::wstring cache_path(utf8str_to_utf16str(mCacheDir));
 #else
@@ -112,78 +445,78 @@ void LLDiskCache::purge()
                     {
                         continue;
                     }
-                    const std::string file_path = (*iter).path().string();
                     const std::time_t file_time = boost::filesystem::last_write_time(*iter, ec);
                     if (ec.failed())
                     {
                         continue;
                     }
 
-                    file_info.push_back(file_info_t(file_time, { file_size, file_path }));
+                    file_info.push_back(file_info_t(file_time, { file_size, (*iter).path().filename().string() }));
                 }
             }
         }
     }
 
+    // oldest first, each add moves to the front
     std::sort(file_info.begin(), file_info.end(), [](file_info_t& x, file_info_t& y)
     {
-        return x.first > y.first;
+        return x.first < y.first;
     });
 
-    LL_INFOS() << "Purging cache to a maximum of " << mMaxSizeBytes << " bytes" << LL_ENDL;
-
-    std::vector<bool> file_removed;
-    if (mEnableCacheDebugInfo)
+    for (file_info_t& entry : file_info)
     {
-        file_removed.reserve(file_info.size());
+        applyAdd(entry.second.second, entry.second.first, (U32)entry.first);
     }
 
-	uintmax_t file_size_total = 0;
-    for (file_info_t& entry : file_info)
-    {
-        file_size_total += entry.second.first;
+    compactJournal();
+}
 
-        bool should_remove = file_size_total > mMaxSizeBytes;
-        if (mEnableCacheDebugInfo)
-        {
-            file_removed.push_back(should_remove);
-        }
-        if (should_remove)
-        {
-            boost::filesystem::remove(entry.second.second, ec);
-            if (ec.failed())
-            {
-                LL_WARNS() << "Failed to delete cache file " << entry.second.second << ": " << ec.message() << LL_ENDL;
-            }
-        }
-	}
+void LLDiskCache::compactJournal()
+{
+    // Write the whole index, oldest first, next to the journal and swap it in
+    std::string temp_filename = mJournalFilename + ".tmp";
+    LLFILE* temp_file = LLFile::fopen(temp_filename, "wb");
+    if (!temp_file)
+    {
+        LL_WARNS() << "Unable to write cache index " << temp_filename << LL_ENDL;
+        return;
+    }
 
-    if (mEnableCacheDebugInfo)
+    mJournalBuffer.clear();
+    mJournalRecords = 0;
+    for (index_list_t::reverse_iterator iter = mIndexList.rbegin(); iter != mIndexList.rend(); ++iter)
     {
-        auto end_time = std::chrono::high_resolution_clock::now();
-        auto execute_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+        append_journal_record(mJournalBuffer, JOURNAL_ADD, iter->mTime, iter->mSize, iter->mName);
+        ++mJournalRecords;
+    }
 
-        // Log afterward so it doesn't affect the time measurement
-        // Logging thousands of file results can take hundreds of milliseconds
-        for (size_t i = 0; i < file_info.size(); ++i)
-        {
-            const file_info_t& entry = file_info[i];
-            const bool removed = file_removed[i];
-            const std::string action = removed ? "DELETE:" : "KEEP:";
+    bool success = fwrite(JOURNAL_MAGIC, 1, sizeof(U32), temp_file) == sizeof(U32)
+        && fwrite(&JOURNAL_VERSION, sizeof(U32), 1, temp_file) == 1
+        && fwrite(mJournalBuffer.data(), 1, mJournalBuffer.size(), temp_file) == mJournalBuffer.size();
+    success = (LLFile::close(temp_file) == 0) && success;
+    mJournalBuffer.clear();
 
-            // have to do this because of LL_INFO/LL_END weirdness
-            std::ostringstream line;
+    if (mJournalFile)
+    {
+        LLFile::close(mJournalFile);
+        mJournalFile = nullptr;
+    }
 
-            line << action << "  ";
-            line << entry.first << "  ";
-            line << entry.second.first << "  ";
-            line << entry.second.second;
-            line << " (" << file_size_total << "/" << mMaxSizeBytes << ")";
-            LL_INFOS() << line.str() << LL_ENDL;
-        }
+    if (success)
+    {
+        LLFile::remove(mJournalFilename, ENOENT);
+        success = LLFile::rename(temp_filename, mJournalFilename) == 0;
+    }
 
-        LL_INFOS() << "Total dir size after purge is " << dirFileSize(mCacheDir) << LL_ENDL;
-        LL_INFOS() << "Cache purge took " << execute_time << " ms to execute for " << file_info.size() << " files" << LL_ENDL;
+    if (success)
+    {
+        openJournal(false);
+    }
+    else
+    {
+        // Without a journal the index is rebuilt from the folder next time
+        LLFile::remove(temp_filename, ENOENT);
+        LLFile::remove(mJournalFilename, ENOENT);
     }
 }
 
@@ -260,62 +593,69 @@ const std::string LLDiskCache::metaDataToFilepath(const std::string id,
 
 void LLDiskCache::updateFileAccessTime(const std::string file_path)
 {
-    /**
-     * Threshold in time_t units that is used to decide if the last access time
-     * time of the file is updated or not. Added as a precaution for the concern
-     * outlined in SL-14582  about frequent writes on older SSDs reducing their
-     * lifespan. I think this is the right place for the threshold value - rather
-     * than it being a pref - do comment on that Jira if you disagree...
-     *
-     * Let's start with 1 hour in time_t units and see how that unfolds
-     */
-    const std::time_t time_threshold = 1 * 60 * 60;
-
-    // current time
-    const std::time_t cur_time = std::time(nullptr);
+    LLMutexLock lock(&mIndexMutex);
 
-    boost::system::error_code ec;
-#if LL_WINDOWS
-    // file last write time
-    const std::time_t last_write_time = boost::filesystem::last_write_time(utf8str_to_utf16str(file_path), ec);
-    if (ec.failed())
+    index_map_t::iterator found = mIndexMap.find(getIndexKey(file_path));
+    if (found == mIndexMap.end())
     {
-        LL_WARNS() << "Failed to read last write time for cache file " << file_path << ": " << ec.message() << LL_ENDL;
         return;
     }
 
-    // delta between cur time and last time the file was written
-    const std::time_t delta_time = cur_time - last_write_time;
-
-    // we only write the new value if the time in time_threshold has elapsed
-    // before the last one
-    if (delta_time > time_threshold)
+    // Only the in-memory order changes here. flushIndex() journals each
+    // touched file once, which also covers the concern in SL-14582 about
+    // frequent writes wearing out older SSDs.
+    IndexEntry& entry = *found->second;
+    entry.mTime = (U32)std::time(nullptr);
+    if (!entry.mTouched)
     {
-        boost::filesystem::last_write_time(utf8str_to_utf16str(file_path), cur_time, ec);
+        entry.mTouched = true;
+        ++mTouchedCount;
     }
-#else
-    // file last write time
-    const std::time_t last_write_time = boost::filesystem::last_write_time(file_path, ec);
-    if (ec.failed())
+    mIndexList.splice(mIndexList.begin(), mIndexList, found->second);
+}
+
+void LLDiskCache::fileWritten(const std::string& file_path, uintmax_t file_size)
+{
+    LLMutexLock lock(&mIndexMutex);
+
+    applyAdd(getIndexKey(file_path), file_size, (U32)std::time(nullptr));
+    appendJournal(JOURNAL_ADD, mIndexList.front());
+
+    // Anything that changes what is on disk goes out now, so a crash can't
+    // leave files behind that the index doesn't know about. Touches wait.
+    writeJournalBuffer();
+}
+
+void LLDiskCache::fileRenamed(const std::string& old_file_path, const std::string& new_file_path)
+{
+    LLMutexLock lock(&mIndexMutex);
+
+    index_map_t::iterator found = mIndexMap.find(getIndexKey(old_file_path));
+    if (found == mIndexMap.end())
     {
-        LL_WARNS() << "Failed to read last write time for cache file " << file_path << ": " << ec.message() << LL_ENDL;
         return;
     }
 
-    // delta between cur time and last time the file was written
-    const std::time_t delta_time = cur_time - last_write_time;
+    IndexEntry entry = *found->second;
+    applyRemove(entry.mName);
+    appendJournal(JOURNAL_REMOVE, entry);
 
-    // we only write the new value if the time in time_threshold has elapsed
-    // before the last one
-    if (delta_time > time_threshold)
-    {
-        boost::filesystem::last_write_time(file_path, cur_time, ec);
-    }
-#endif
+    applyAdd(getIndexKey(new_file_path), entry.mSize, (U32)std::time(nullptr));
+    appendJournal(JOURNAL_ADD, mIndexList.front());
+    writeJournalBuffer();
+}
+
+void LLDiskCache::fileRemoved(const std::string& file_path)
+{
+    LLMutexLock lock(&mIndexMutex);
 
-    if (ec.failed())
+    index_map_t::iterator found = mIndexMap.find(getIndexKey(file_path));
+    if (found != mIndexMap.end())
     {
-        LL_WARNS() << "Failed to update last write time for cache file " << file_path << ": " << ec.message() << LL_ENDL;
+        IndexEntry entry = *found->second;
+        applyRemove(entry.mName);
+        appendJournal(JOURNAL_REMOVE, entry);
+        writeJournalBuffer();
     }
 }
 
@@ -323,8 +663,14 @@ const std::string LLDiskCache::getCacheInfo()
 {
     std::ostringstream cache_info;
 
+    uintmax_t used_size;
+    {
+        LLMutexLock lock(&mIndexMutex);
+        used_size = mIndexTotalSize;
+    }
+
     F32 max_in_mb = (F32)mMaxSizeBytes / (1024.0 * 1024.0);
-    F32 percent_used = ((F32)dirFileSize(mCacheDir) / (F32)mMaxSizeBytes) * 100.0;
+    F32 percent_used = ((F32)used_size / (F32)mMaxSizeBytes) * 100.0;
 
     cache_info << std::fixed;
     cache_info << std::setprecision(1);
@@ -342,6 +688,16 @@ void LLDiskCache::clearCache()
      * the component files but it's called infrequently so it's
      * likely just fine
      */
+    {
+        LLMutexLock lock(&mIndexMutex);
+        mIndexList.clear();
+        mIndexMap.clear();
+        mIndexTotalSize = 0;
+        mTouchedCount = 0;
+        mJournalBuffer.clear();
+        openJournal(true);
+    }
+
     boost::system::error_code ec;
 #if LL_WINDOWS
     std::wstring cache_path(utf8str_to_utf16str(mCacheDir));
@@ -22,20 +22,21 @@
                     that identifies the type of asset being stored.
         .asset      A file extension of .asset is used to help
                     identify this as a Viewer asset file
- * 2/ The time of last access for a file can be updated instantly
- *    for file reads and automatically as part of the file writes.
- * 3/ The purge algorithm collects a list of all files in the
- *    directory, sorts them by date of last access (write) and then
- *    deletes any files based on age until the total size of all
- *    the files is less than the maximum size specified.
- * 4/ An LLSingleton idiom is used since there will only ever be
+ * 2/ The time of last access for a file is tracked in memory: reads
+ *    move the file to the front of an LRU list and writes record its
+ *    new size. Nothing touches the file itself on a read.
+ * 3/ The index of file sizes and LRU order is persisted in a journal
+ *    (cache_index.journal) in the cache folder. Writes, renames and
+ *    removals are appended as they happen; read accesses are batched
+ *    and appended whenever the purge thread runs. The journal is
+ *    replayed at startup and rewritten compactly once it grows too
+ *    large. If it is missing or unreadable, the index is rebuilt once
+ *    from a directory scan using the file write times.
+ * 4/ The purge algorithm pops files off the old end of the LRU list
+ *    until the total size is less than the maximum size specified,
+ *    so it never has to scan or stat the cache folder.
+ * 5/ An LLSingleton idiom is used since there will only ever be
  *    a single cache and we want to access it from numerous places.
- * 5/ Performance on my modest system seems very acceptable. For
- *    example, in testing, I was able to purge a directory of
- *    10,000 files, deleting about half of them in ~ 1700ms. For
- *    the same sized directory of files, writing the last updated
- *    time to each took less than 600ms indicating that this
- *    important part of the mechanism has almost no overhead.
  *
  * $LicenseInfo:firstyear=2009&license=viewerlgpl$
  * Second Life Viewer Source Code
@@ -63,6 +64,11 @@
 #define _LLDISKCACHE
 
 #include "llsingleton.h"
+#include "llfile.h"
+#include "llmutex.h"
+
+#include <list>
+#include <unordered_map>
 
 class LLDiskCache :
     public LLParamSingleton<LLDiskCache>
@@ -94,7 +100,7 @@ class LLDiskCache :
                      */
                     const bool enable_cache_debug_info);
 
-        virtual ~LLDiskCache() = default;
+        virtual ~LLDiskCache();
 
     public:
         /**
@@ -109,25 +115,41 @@ class LLDiskCache :
                                              const std::string extra_info);
 
         /**
-         * Update the "last write time" of a file to "now". This must be called whenever a
-         * file in the cache is read (not written) so that the last time the file was
-         * accessed is up to date (This is used in the mechanism for purging the cache)
+         * Mark a file as used "now". This must be called whenever a file in the
+         * cache is read (not written) so that it moves to the front of the LRU
+         * order used for purging. Only the in-memory index is touched; the new
+         * order reaches the journal the next time purge() runs, once per file
+         * however often it was read.
          */
         void updateFileAccessTime(const std::string file_path);
 
+        /**
+         * Record the size of a file that has just been written. Also marks
+         * the file as used "now".
+         */
+        void fileWritten(const std::string& file_path, uintmax_t file_size);
+
+        /**
+         * Record that a file has been renamed or removed by the caller
+         */
+        void fileRenamed(const std::string& old_file_path, const std::string& new_file_path);
+        void fileRemoved(const std::string& file_path);
+
         /**
          * Purge the oldest items in the cache so that the combined size of all files
          * is no bigger than mMaxSizeBytes.
          *
-         * WARNING: purge() is called by LLPurgeDiskCacheThread. As such it must
-         * NOT touch any LLDiskCache data without introducing and locking a mutex!
-         *
-         * Purging the disk cache involves nontrivial work on the viewer's
-         * filesystem. If called on the main thread, this causes a noticeable
-         * freeze.
+         * purge() is called by LLPurgeDiskCacheThread. The index is guarded by
+         * mIndexMutex, and files are deleted with the mutex released.
          */
         void purge();
 
+        /**
+         * Write out batched access times and compact the journal if needed.
+         * Called from purge() and on shutdown.
+         */
+        void flushIndex();
+
         /**
          * Clear the cache by removing all the files in the specified cache
          * directory individually. Only the files that contain a prefix defined
@@ -148,6 +170,44 @@ class LLDiskCache :
          */
         uintmax_t dirFileSize(const std::string dir);
 
+        /**
+         * An entry in the in-memory index. The list is kept in LRU order,
+         * most recently used at the front.
+         */
+        struct IndexEntry
+        {
+            std::string mName;      // file name within mCacheDir
+            uintmax_t   mSize;
+            U32         mTime;      // last access, seconds since the epoch
+            bool        mTouched;   // read since the last flushIndex()
+        };
+        typedef std::list<IndexEntry> index_list_t;
+        typedef std::unordered_map<std::string, index_list_t::iterator> index_map_t;
+
+        enum EJournalOp
+        {
+            JOURNAL_ADD = 1,        // new size, moves to the front
+            JOURNAL_TOUCH = 2,      // moves to the front
+            JOURNAL_REMOVE = 3
+        };
+
+        // All of these expect mIndexMutex to be held
+        void loadIndex();
+        void rebuildIndex();
+        void compactJournal();
+        void openJournal(bool truncate);
+        void appendJournal(EJournalOp op, const IndexEntry& entry);
+        void writeJournalBuffer();
+        void applyAdd(const std::string& name, uintmax_t size, U32 time);
+        void applyTouch(const std::string& name, U32 time);
+        void applyRemove(const std::string& name);
+
+        /**
+         * Utility function to strip the cache folder from a cache file path,
+         * giving the key used by the index
+         */
+        std::string getIndexKey(const std::string& file_path) const;
+
         /**
          * Utility function to convert an LLAssetType enum into a
          * string that we use as part of the cache file filename
@@ -185,6 +245,24 @@ class LLDiskCache :
          * various parts of the code
          */
         bool mEnableCacheDebugInfo;
+
+        /**
+         * The index of cached files: LRU order, sizes and their total
+         */
+        LLMutex         mIndexMutex;
+        index_list_t    mIndexList;
+        index_map_t     mIndexMap;
+        uintmax_t       mIndexTotalSize;
+
+        /**
+         * Journal of index changes, appended to as they happen. Access
+         * time updates collect in mJournalBuffer until flushIndex().
+         */
+        std::string     mJournalFilename;
+        LLFILE*         mJournalFile;
+        std::string     mJournalBuffer;
+        U32             mJournalRecords;
+        U32             mTouchedCount;
 };
 
 class LLPurgeDiskCacheThread : public LLThread
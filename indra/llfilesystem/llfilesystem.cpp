@@ -60,15 +60,12 @@ LLFileSystem::LLFileSystem(const LLUUID& file_id, const LLAssetType::EType file_
         const std::string extra_info = "";
         const std::string filename = LLDiskCache::getInstance()->metaDataToFilepath(id, mFileType, extra_info);
 
-        // update the last access time for the file if it exists - this is required
+        // update the last access time for the file - this is required
         // even though we are reading and not writing because this is the
         // way the cache works - it relies on a valid "last accessed time" for
-        // each file so it knows how to remove the oldest, unused files
-        bool exists = gDirUtilp->fileExists(filename);
-        if (exists)
-        {
-            LLDiskCache::getInstance()->updateFileAccessTime(filename);
-        }
+        // each file so it knows how to remove the oldest, unused files.
+        // Files the cache index doesn't know about are ignored.
+        LLDiskCache::getInstance()->updateFileAccessTime(filename);
     }
 }
 
@@ -102,6 +99,7 @@ bool LLFileSystem::removeFile(const LLUUID& file_id, const LLAssetType::EType fi
     const std::string filename =  LLDiskCache::getInstance()->metaDataToFilepath(id_str, file_type, extra_info);
 
     LLFile::remove(filename.c_str(), suppress_error);
+    LLDiskCache::getInstance()->fileRemoved(filename);
 
     return true;
 }
@@ -130,6 +128,10 @@ bool LLFileSystem::renameFile(const LLUUID& old_file_id, const LLAssetType::ETyp
         //return false;
         LL_WARNS() << "Failed to rename " << old_file_id << " to " << new_id_str << " reason: "  << strerror(errno) << LL_ENDL;
     }
+    else
+    {
+        LLDiskCache::getInstance()->fileRenamed(old_filename, new_filename);
+    }
 
     return true;
 }
@@ -208,6 +210,7 @@ bool LLFileSystem::write(const U8* buffer, S32 bytes)
     const std::string filename =  LLDiskCache::getInstance()->metaDataToFilepath(id_str, mFileType, extra_info);
 
     bool success = false;
+    S32 file_size = 0;
 
     if (mMode == APPEND)
     {
@@ -217,6 +220,7 @@ bool LLFileSystem::write(const U8* buffer, S32 bytes)
             ofs.write((const char*)buffer, bytes);
 
             mPosition = ofs.tellp(); // <FS:Ansariel> Fix asset caching
+            file_size = mPosition;
 
             success = true;
         }
@@ -231,6 +235,8 @@ bool LLFileSystem::write(const U8* buffer, S32 bytes)
             ofs.seekp(mPosition, std::ios::beg);
             ofs.write((const char*)buffer, bytes);
             mPosition += bytes;
+            ofs.seekp(0, std::ios::end);
+            file_size = ofs.tellp();
             success = true;
         }
         else
@@ -241,6 +247,7 @@ bool LLFileSystem::write(const U8* buffer, S32 bytes)
             {
                 ofs.write((const char*)buffer, bytes);
                 mPosition += bytes;
+                file_size = mPosition;
                 success = true;
             }
         }
@@ -254,11 +261,17 @@ bool LLFileSystem::write(const U8* buffer, S32 bytes)
             ofs.write((const char*)buffer, bytes);
 
             mPosition += bytes;
+            file_size = mPosition;
 
             success = true;
         }
     }
 
+    if (success)
+    {
+        LLDiskCache::getInstance()->fileWritten(filename, file_size);
+    }
+
     return success;
 }
 
@@ -0,0 +1,135 @@
+/**
+ * @file lldiskcache_test.cpp
+ * @brief LLDiskCache index and purge test cases.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "../lldiskcache.h"
+#include "../lldir.h"
+
+#include <boost/filesystem.hpp>
+
+#include "../test/lltut.h"
+
+namespace tut
+{
+    struct LLDiskCacheFixture
+    {
+        LLDiskCacheFixture()
+        {
+            mCacheDir = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+        }
+
+        ~LLDiskCacheFixture()
+        {
+            if (LLDiskCache::instanceExists())
+            {
+                LLDiskCache::deleteSingleton();
+            }
+            boost::system::error_code ec;
+            boost::filesystem::remove_all(mCacheDir, ec);
+        }
+
+        std::string filePath(const std::string& name)
+        {
+            return mCacheDir + gDirUtilp->getDirDelimiter() + name;
+        }
+
+        void writeFile(const std::string& name, S32 size)
+        {
+            std::string path = filePath(name);
+            llofstream ofs(path, std::ios::binary);
+            ofs << std::string(size, 'x');
+            ofs.close();
+            LLDiskCache::getInstance()->fileWritten(path, size);
+        }
+
+        bool exists(const std::string& name)
+        {
+            return LLFile::isfile(filePath(name));
+        }
+
+        std::string mCacheDir;
+    };
+    typedef test_group<LLDiskCacheFixture> LLDiskCache_group;
+    typedef LLDiskCache_group::object object;
+    LLDiskCache_group tf("LLDiskCache");
+
+    template<> template<>
+    void object::test<1>()
+    {
+        set_test_name("purge removes least recently used first");
+
+        LLDiskCache::initParamSingleton(mCacheDir, 300, false);
+        writeFile("sl_cache_a.asset", 100);
+        writeFile("sl_cache_b.asset", 100);
+        writeFile("sl_cache_c.asset", 100);
+        LLDiskCache::getInstance()->updateFileAccessTime(filePath("sl_cache_a.asset"));
+        writeFile("sl_cache_d.asset", 100);
+
+        LLDiskCache::getInstance()->purge();
+
+        ensure("recently read file kept", exists("sl_cache_a.asset"));
+        ensure("oldest file purged", !exists("sl_cache_b.asset"));
+        ensure("newer file kept", exists("sl_cache_c.asset"));
+        ensure("newest file kept", exists("sl_cache_d.asset"));
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        set_test_name("index survives a restart");
+
+        LLDiskCache::initParamSingleton(mCacheDir, 1000, false);
+        writeFile("sl_cache_a.asset", 100);
+        writeFile("sl_cache_b.asset", 100);
+        writeFile("sl_cache_c.asset", 100);
+        LLDiskCache::getInstance()->updateFileAccessTime(filePath("sl_cache_a.asset"));
+        LLDiskCache::deleteSingleton();
+
+        // a restart with a smaller cache must purge from the journal alone
+        LLDiskCache::initParamSingleton(mCacheDir, 150, false);
+        LLDiskCache::getInstance()->purge();
+
+        ensure("recently read file kept", exists("sl_cache_a.asset"));
+        ensure("old file purged", !exists("sl_cache_b.asset"));
+        ensure("newer file purged", !exists("sl_cache_c.asset"));
+    }
+
+    template<> template<>
+    void object::test<3>()
+    {
+        set_test_name("index is rebuilt without a journal");
+
+        LLFile::mkdir(mCacheDir);
+        llofstream ofs(filePath("sl_cache_a.asset"), std::ios::binary);
+        ofs << std::string(100, 'x');
+        ofs.close();
+
+        LLDiskCache::initParamSingleton(mCacheDir, 50, false);
+        LLDiskCache::getInstance()->purge();
+
+        ensure("file found by the rebuild purged", !exists("sl_cache_a.asset"));
+    }
+}
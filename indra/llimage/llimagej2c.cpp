@@ -40,6 +40,7 @@ LLImageJ2CImpl* fallbackCreateLLImageJ2CImpl();
 
 // Test data gathering handle
 LLImageCompressionTester* LLImageJ2C::sTesterp = NULL ;
+S32 LLImageJ2C::sDecodeThreadsPerImage = 1;
 const std::string sTesterName("ImageCompressionTester");
 
 //static
@@ -78,6 +78,10 @@ public:
 
 	static std::string getEngineInfo();
 
+	// Threads the codec may use to decode one large image, 1 to disable
+	static void setDecodeThreadsPerImage(S32 threads) { sDecodeThreadsPerImage = llmax(threads, 1); }
+	static S32 getDecodeThreadsPerImage() { return sDecodeThreadsPerImage; }
+
 protected:
 	friend class LLImageJ2CImpl;
 	friend class LLImageJ2COJ;
@@ -98,6 +102,8 @@ protected:
 
     // Image compression/decompression tester
 	static LLImageCompressionTester* sTesterp;
+
+	static S32 sDecodeThreadsPerImage;
 };
 
 // Derive from this class to implement JPEG2000 decoding
@@ -31,19 +31,86 @@
 
 //----------------------------------------------------------------------------
 
+// Additional decode thread. It serves the same priority queue as the
+// LLImageDecodeThread it belongs to, so requests keep being taken highest
+// priority first whichever thread picks them up.
+class LLImageDecodeThread::PoolThread : public LLThread
+{
+public:
+	PoolThread(const std::string& name, LLImageDecodeThread* queue)
+		: LLThread(name),
+		  mQueue(queue)
+	{
+	}
+
+protected:
+	/*virtual*/ bool runCondition()
+	{
+		return mQueue->getPending() > 0;
+	}
+
+	/*virtual*/ void run()
+	{
+		while (1)
+		{
+			// sleeps until the queue wakes us up with pending requests
+			checkPause();
+
+			if (isQuitting())
+			{
+				break;
+			}
+
+			mQueue->processNextRequest();
+		}
+		LL_INFOS() << "LLImageDecodeThread pool thread " << mName << " EXITING." << LL_ENDL;
+	}
+
+private:
+	LLImageDecodeThread* mQueue;
+};
+
+//----------------------------------------------------------------------------
+
 // MAIN THREAD
-LLImageDecodeThread::LLImageDecodeThread(bool threaded)
+LLImageDecodeThread::LLImageDecodeThread(bool threaded, U32 pool_size)
 	: LLQueuedThread("imagedecode", threaded)
 {
 	mCreationMutex = new LLMutex();
+
+	if (threaded)
+	{
+		for (U32 i = 1; i < pool_size; ++i)
+		{
+			PoolThread* thread = new PoolThread(llformat("imagedecode%u", i), this);
+			thread->start();
+			mPoolThreads.push_back(thread);
+		}
+		LL_INFOS() << "Image decode pool started with " << getPoolSize() << " threads" << LL_ENDL;
+	}
 }
 
 //virtual 
 LLImageDecodeThread::~LLImageDecodeThread()
 {
+	shutdown();
 	delete mCreationMutex ;
 }
 
+// MAIN THREAD
+//virtual
+void LLImageDecodeThread::shutdown()
+{
+	// The pool threads must be gone before the queue aborts what is left in it
+	for (std::vector<PoolThread*>::iterator iter = mPoolThreads.begin(); iter != mPoolThreads.end(); ++iter)
+	{
+		delete *iter; // waits for the thread to finish its current request
+	}
+	mPoolThreads.clear();
+
+	LLQueuedThread::shutdown();
+}
+
 // MAIN THREAD
 // virtual
 size_t LLImageDecodeThread::update(F32 max_time_ms)
@@ -65,6 +132,14 @@ size_t LLImageDecodeThread::update(F32 max_time_ms)
 	}
 	mCreationList.clear();
 	auto res = LLQueuedThread::update(max_time_ms);
+
+	if (res > 0)
+	{
+		for (std::vector<PoolThread*>::iterator iter = mPoolThreads.begin(); iter != mPoolThreads.end(); ++iter)
+		{
+			(*iter)->wake();
+		}
+	}
 	return res;
 }
 
@@ -32,6 +32,8 @@
 #include "threadpool_fwd.h"
 #include "llworkerthread.h"
 
+#include <vector>
+
 class LLImageDecodeThread : public LLQueuedThread
 {
 public:
@@ -74,8 +76,11 @@ public:
 	};
 	
 public:
-	LLImageDecodeThread(bool threaded = true);
+	// pool_size threads, including this one, take requests from the queue
+	// in priority order so several images decode at once.
+	LLImageDecodeThread(bool threaded = true, U32 pool_size = 1);
 	virtual ~LLImageDecodeThread();
+	/*virtual*/ void shutdown();
 
 	handle_t decodeImage(LLImageFormatted* image,
 						 U32 priority, S32 discard, bool needs_aux,
@@ -85,7 +90,12 @@ public:
 	// Used by unit tests to check the consistency of the thread instance
 	S32 tut_size();
 	
+	U32 getPoolSize() const { return (U32)mPoolThreads.size() + 1; }
+
 private:
+	class PoolThread;
+	std::vector<PoolThread*> mPoolThreads;
+
 	struct creation_info
 	{
 		handle_t handle;
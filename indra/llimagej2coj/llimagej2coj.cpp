@@ -34,6 +34,9 @@
 
 #define MAX_ENCODED_DISCARD_LEVELS 5
 
+// Decoded area from which a single image is split across codec threads
+const S32 MIN_THREADED_DECODE_AREA = 512 * 512;
+
 // Factory function: see declaration in llimagej2c.cpp
 LLImageJ2CImpl* fallbackCreateLLImageJ2CImpl()
 {
@@ -333,13 +336,19 @@ public:
         return true;
     }
 
-    bool decode(U8* data, U32 dataSize, U32* channels, U8 discard_level)
+    bool decode(U8* data, U32 dataSize, U32* channels, U8 discard_level, S32 threads = 1)
     {
         parameters.flags &= ~OPJ_DPARAMETERS_DUMP_FLAG;
 
         decoder = opj_create_decompress(OPJ_CODEC_J2K);
         opj_setup_decoder(decoder, &parameters);
 
+        // code blocks are decoded in parallel, needs to happen before opj_read_header
+        if (threads > 1 && opj_has_thread_support())
+        {
+            opj_codec_set_threads(decoder, threads);
+        }
+
         opj_set_info_handler(decoder, opj_info, this);
         opj_set_warning_handler(decoder, opj_warn, this);
         opj_set_error_handler(decoder, opj_error, this);
@@ -732,12 +741,25 @@ bool LLImageJ2COJ::initEncode(LLImageJ2C &base, LLImageRaw &raw_image, int block
 
 bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decode_time, S32 first_channel, S32 max_channel_count)
 {
+    // Every discard level is decoded from scratch.  OpenJPEG cannot append
+    // bytes to a codec that already read a truncated codestream, nor start
+    // from previously decoded wavelet levels, and the fetcher hands each
+    // upgrade over in a new buffer, so there is no codec state to carry over.
     JPEG2KDecode decoder(0);
 
+    // Spinning up codec threads only pays off for large images, small ones
+    // and low resolution levels are better served by the decode pool alone.
+    S32 threads = 1;
+    S32 discard = llmax((S32)base.mDiscardLevel, 0);
+    if ((base.getWidth() >> discard) * (base.getHeight() >> discard) >= MIN_THREADED_DECODE_AREA)
+    {
+        threads = LLImageJ2C::getDecodeThreadsPerImage();
+    }
+
     U32 image_channels = 0;
     S32 data_size = base.getDataSize();
     S32 max_bytes = (base.getMaxBytes() ? base.getMaxBytes() : data_size);
-    bool decoded = decoder.decode(base.getData(), max_bytes, &image_channels, base.mDiscardLevel);
+    bool decoded = decoder.decode(base.getData(), max_bytes, &image_channels, base.mDiscardLevel, threads);
 
     // set correct channel count early so failed decodes don't miss it...
     S32 channels = (S32)image_channels - first_channel;
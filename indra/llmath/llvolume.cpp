@@ -27,6 +27,7 @@
 #include "llmemory.h"
 #include "llmath.h"
 
+#include <algorithm>
 #include <set>
 #if !LL_WINDOWS
 #include <stdint.h>
@@ -2170,19 +2171,11 @@ bool LLVolume::generate()
 		{
 			F32* scale = mPathp->mPath[s].mScale.getF32ptr();
 			
-			F32 sc [] = 
-			{ scale[0], 0, 0, 0,
-				0, scale[1], 0, 0,
-				0, 0, scale[2], 0,
-					0, 0, 0, 1 };
-			
-			LLMatrix4 rot((F32*) mPathp->mPath[s].mRot.mMatrix);
-			LLMatrix4 scale_mat(sc);
-			
-			scale_mat *= rot;
-			
-			LLMatrix4a rot_mat;
-			rot_mat.loadu(scale_mat);
+			// scale * rot for a diagonal scale is just rot with each row scaled
+			LLMatrix4a rot_mat = mPathp->mPath[s].mRot;
+			rot_mat.mMatrix[0].mul(scale[0]);
+			rot_mat.mMatrix[1].mul(scale[1]);
+			rot_mat.mMatrix[2].mul(scale[2]);
 			
 			LLVector4a* profile = mProfilep->mProfile.mArray;
 			LLVector4a* end_profile = profile+sizeT;
@@ -2776,6 +2769,13 @@ void LLVolume::copyVolumeFaces(const LLVolume* volume)
 	mSculptLevel = 0;
 }
 
+void LLVolume::moveVolumeFaces(LLVolume* volume)
+{
+	mVolumeFaces.swap(volume->mVolumeFaces);
+	volume->mVolumeFaces.clear();
+	mSculptLevel = 0;
+}
+
 bool LLVolume::cacheOptimize()
 {
 	for (S32 i = 0; i < mVolumeFaces.size(); ++i)
@@ -3048,83 +3048,90 @@ void LLVolume::sculptGenerateMapVertices(U16 sculpt_width, U16 sculpt_height, S8
 	
 	S32 sizeS = mPathp->mPath.size();
 	S32 sizeT = mProfilep->mProfile.size();
-	
-	S32 line = 0;
-	for (S32 s = 0; s < sizeS; s++)
+
+	// The map column sampled depends only on t and the row only on s, so
+	// work out the columns once instead of once per vertex.
+	static thread_local std::vector<U32> column_offsets;
+	column_offsets.resize(sizeT);
+	for (S32 t = 0; t < sizeT; t++)
 	{
-		// Run along the profile.
-		for (S32 t = 0; t < sizeT; t++)
-		{
-			S32 i = t + line;
-			LLVector4a& pt = mMesh[i];
+		S32 reversed_t = t;
 
-			S32 reversed_t = t;
+		if (reverse_horizontal)
+		{
+			reversed_t = sizeT - t - 1;
+		}
+		
+		U32 x = (U32) ((F32)reversed_t/(sizeT-1) * (F32) sculpt_width);
 
-			if (reverse_horizontal)
+		if (x == sculpt_width)   // side stitching
+		{
+			// wrap?
+			if ((sculpt_stitching == LL_SCULPT_TYPE_SPHERE) ||
+				(sculpt_stitching == LL_SCULPT_TYPE_TORUS) ||
+				(sculpt_stitching == LL_SCULPT_TYPE_CYLINDER))
 			{
-				reversed_t = sizeT - t - 1;
+				x = 0;
 			}
-			
-			U32 x = (U32) ((F32)reversed_t/(sizeT-1) * (F32) sculpt_width);
-			U32 y = (U32) ((F32)s/(sizeS-1) * (F32) sculpt_height);
-
-			
-			if (y == 0)  // top row stitching
+				
+			else
 			{
-				// pinch?
-				if (sculpt_stitching == LL_SCULPT_TYPE_SPHERE)
-				{
-					x = sculpt_width / 2;
-				}
+				x = sculpt_width - 1;
 			}
+		}
 
-			if (y == sculpt_height)  // bottom row stitching
-			{
-				// wrap?
-				if (sculpt_stitching == LL_SCULPT_TYPE_TORUS)
-				{
-					y = 0;
-				}
-				else
-				{
-					y = sculpt_height - 1;
-				}
+		column_offsets[t] = x * sculpt_components;
+	}
 
-				// pinch?
-				if (sculpt_stitching == LL_SCULPT_TYPE_SPHERE)
-				{
-					x = sculpt_width / 2;
-				}
-			}
+	const U32 pinch_offset = (sculpt_width / 2) * sculpt_components;
+	const U32 row_size = sculpt_width * sculpt_components;
+
+	LLVector4a mirror(-1.f,1,1,1);
+	
+	LLVector4a* pt = mMesh.mArray;
+	for (S32 s = 0; s < sizeS; s++)
+	{
+		U32 y = (U32) ((F32)s/(sizeS-1) * (F32) sculpt_height);
 
-			if (x == sculpt_width)   // side stitching
+		bool pinch = false;
+		
+		if (y == 0)  // top row stitching
+		{
+			// pinch?
+			pinch = (sculpt_stitching == LL_SCULPT_TYPE_SPHERE);
+		}
+
+		if (y == sculpt_height)  // bottom row stitching
+		{
+			// wrap?
+			if (sculpt_stitching == LL_SCULPT_TYPE_TORUS)
 			{
-				// wrap?
-				if ((sculpt_stitching == LL_SCULPT_TYPE_SPHERE) ||
-					(sculpt_stitching == LL_SCULPT_TYPE_TORUS) ||
-					(sculpt_stitching == LL_SCULPT_TYPE_CYLINDER))
-				{
-					x = 0;
-				}
-					
-				else
-				{
-					x = sculpt_width - 1;
-				}
+				y = 0;
+			}
+			else
+			{
+				y = sculpt_height - 1;
 			}
 
-			pt = sculpt_xy_to_vector(x, y, sculpt_width, sculpt_height, sculpt_components, sculpt_data);
+			// pinch?
+			pinch = (sculpt_stitching == LL_SCULPT_TYPE_SPHERE);
+		}
+
+		const U8* row = sculpt_data + y * row_size;
+
+		// Run along the profile.
+		for (S32 t = 0; t < sizeT; t++)
+		{
+			*pt = sculpt_index_to_vector(pinch ? pinch_offset : column_offsets[t], row);
 
 			if (sculpt_mirror)
 			{
-				LLVector4a scale(-1.f,1,1,1);
-				pt.mul(scale);
+				pt->mul(mirror);
 			}
 
-			llassert(pt.isFinite3());
+			llassert(pt->isFinite3());
+			++pt;
 		}
-		
-		line += sizeT;
 	}
 }
 
@@ -4706,10 +4713,10 @@ LLVolumeFace::LLVolumeFace() :
 	mTexCoords(nullptr),
 	mIndices(nullptr),
 	mWeights(nullptr),
-#if USE_SEPARATE_JOINT_INDICES_AND_WEIGHTS
-    mJustWeights(NULL),
-    mJointIndices(NULL),
-#endif
+    mJointIndices(nullptr),
+    mJointWeights(nullptr),
+    mJointExtents(nullptr),
+    mNumPackedJoints(0),
     mWeightsScrubbed(false),
 	mOctree(nullptr),
     mOctreeTriangles(nullptr),
@@ -4737,10 +4744,10 @@ LLVolumeFace::LLVolumeFace(const LLVolumeFace& src)
 	mTexCoords(nullptr),
 	mIndices(nullptr),
 	mWeights(nullptr),
-#if USE_SEPARATE_JOINT_INDICES_AND_WEIGHTS
-    mJustWeights(NULL),
-    mJointIndices(NULL),
-#endif
+    mJointIndices(nullptr),
+    mJointWeights(nullptr),
+    mJointExtents(nullptr),
+    mNumPackedJoints(0),
     mWeightsScrubbed(false),
     mOctree(nullptr),
     mOctreeTriangles(nullptr)
@@ -4818,20 +4825,6 @@ LLVolumeFace& LLVolumeFace::operator=(const LLVolumeFace& src)
             mWeightsScrubbed = false;
 		}   
 
-    #if USE_SEPARATE_JOINT_INDICES_AND_WEIGHTS
-        if (src.mJointIndices)
-        {
-            llassert(!mJointIndices); // don't orphan an old alloc here accidentally
-            allocateJointIndices(src.mNumVertices);
-            LLVector4a::memcpyNonAliased16((F32*) mJointIndices, (F32*) src.mJointIndices, src.mNumVertices * sizeof(U8) * 4);
-        }
-        else*/
-        {
-            ll_aligned_free_16(mJointIndices);
-            mJointIndices = NULL;
-        }     
-    #endif
-
 	}
     
 	if (mNumIndices)
@@ -4877,12 +4870,7 @@ void LLVolumeFace::freeData()
 	ll_aligned_free_16(mWeights);
 	mWeights = nullptr;
 
-#if USE_SEPARATE_JOINT_INDICES_AND_WEIGHTS
-    ll_aligned_free_16(mJointIndices);
-	mJointIndices = NULL;
-    ll_aligned_free_16(mJustWeights);
-	mJustWeights = NULL;
-#endif
+    freePackedSkinWeights();
 
     destroyOctree();
 }
@@ -5602,12 +5590,7 @@ bool LLVolumeFace::cacheOptimize()
 	// DO NOT free mNormals and mTexCoords as they are part of mPositions buffer
 	ll_aligned_free_16(mWeights);
 	ll_aligned_free_16(mTangents);
-#if USE_SEPARATE_JOINT_INDICES_AND_WEIGHTS
-    ll_aligned_free_16(mJointIndices);
-    ll_aligned_free_16(mJustWeights);
-    mJustWeights = NULL;
-    mJointIndices = NULL; // filled in later as necessary by skinning code for acceleration
-#endif
+    freePackedSkinWeights(); // filled in later as necessary by skinning code for acceleration
 
 	mPositions = pos;
 	mNormals = norm;
@@ -6491,9 +6474,6 @@ void LLVolumeFace::resizeVertices(S32 num_verts)
         mNumVertices = 0;
         mNumAllocatedVertices = 0;
     }
-
-    // Force update
-    mJointRiggingInfoTab.clear();
 }
 
 void LLVolumeFace::pushVertex(const LLVolumeFace::VertexData& cv)
@@ -6561,18 +6541,102 @@ void LLVolumeFace::allocateWeights(S32 num_verts)
 {
 	ll_aligned_free_16(mWeights);
 	mWeights = (LLVector4a*)ll_aligned_malloc_16(sizeof(LLVector4a)*num_verts);
-    
+	freePackedSkinWeights();
 }
 
-void LLVolumeFace::allocateJointIndices(S32 num_verts)
+void LLVolumeFace::packSkinWeights(S32 max_joints) const
 {
-#if USE_SEPARATE_JOINT_INDICES_AND_WEIGHTS
-    ll_aligned_free_16(mJointIndices);
-    ll_aligned_free_16(mJustWeights);
+	if (!mWeights || mNumVertices <= 0 || max_joints <= 0)
+	{
+		freePackedSkinWeights();
+		return;
+	}
 
-    mJointIndices = (U8*)ll_aligned_malloc_16(sizeof(U8) * 4 * num_verts);    
-    mJustWeights = (LLVector4a*)ll_aligned_malloc_16(sizeof(LLVector4a) * num_verts);    
-#endif
+	if (mJointIndices && mNumPackedJoints == max_joints)
+	{
+		return;
+	}
+
+	freePackedSkinWeights();
+
+	mJointIndices = (U8*)ll_aligned_malloc_16(((sizeof(U8) * 4 * mNumVertices) + 0xF) & ~0xF);
+	mJointWeights = (U16*)ll_aligned_malloc_16(((sizeof(U16) * 4 * mNumVertices) + 0xF) & ~0xF);
+	mJointExtents = (LLVector4a*)ll_aligned_malloc_16(sizeof(LLVector4a) * 2 * max_joints);
+	mNumPackedJoints = max_joints;
+
+	if (!mJointIndices || !mJointWeights || !mJointExtents)
+	{
+		LL_WARNS("LLVOLUME") << "Allocation of packed skin weights for " << mNumVertices << " vertices failed" << LL_ENDL;
+		freePackedSkinWeights();
+		return;
+	}
+
+	// empty boxes, min above max
+	LLVector4a big;
+	big.splat(F32_MAX);
+	for (S32 j = 0; j < max_joints; ++j)
+	{
+		mJointExtents[j * 2] = big;
+		mJointExtents[j * 2 + 1].setSub(LLVector4a::getZero(), big);
+	}
+
+	for (S32 i = 0; i < mNumVertices; ++i)
+	{
+		// same unpacking as LLSkinningUtil::getPerVertexSkinMatrix()
+		const F32* w = mWeights[i].getF32ptr();
+		S32 idx[4];
+		F32 wght[4];
+		F32 scale = 0.f;
+		for (U32 k = 0; k < 4; ++k)
+		{
+			F32 f = floorf(w[k]);
+			idx[k] = llclamp((S32) f, 0, max_joints - 1);
+			wght[k] = w[k] - f;
+			scale += wght[k];
+		}
+
+		if (scale <= 0.f)
+		{ //bad weights, all on the first joint
+			wght[0] = 1.f;
+			wght[1] = wght[2] = wght[3] = 0.f;
+			scale = 1.f;
+		}
+
+		// heaviest first so the skinning loop can stop at the first zero
+		U32 order[4] = { 0, 1, 2, 3 };
+		std::sort(order, order + 4, [&wght](U32 a, U32 b) { return wght[a] > wght[b]; });
+
+		U8* dst_idx = mJointIndices + i * 4;
+		U16* dst_wght = mJointWeights + i * 4;
+		U32 total = 0;
+		for (U32 k = 0; k < 4; ++k)
+		{
+			U32 q = (U32) llround(wght[order[k]] / scale * 65535.f);
+			q = llmin(q, 65535 - total);
+			dst_idx[k] = (U8) idx[order[k]];
+			dst_wght[k] = (U16) q;
+			total += q;
+		}
+		// rounding error goes to the heaviest influence
+		dst_wght[0] += (U16) (65535 - total);
+
+		for (U32 k = 0; k < 4 && dst_wght[k] > 0; ++k)
+		{
+			LLVector4a* extents = mJointExtents + dst_idx[k] * 2;
+			update_min_max(extents[0], extents[1], mPositions[i]);
+		}
+	}
+}
+
+void LLVolumeFace::freePackedSkinWeights() const
+{
+	ll_aligned_free_16(mJointIndices);
+	ll_aligned_free_16(mJointWeights);
+	ll_aligned_free_16(mJointExtents);
+	mJointIndices = nullptr;
+	mJointWeights = nullptr;
+	mJointExtents = nullptr;
+	mNumPackedJoints = 0;
 }
 
 void LLVolumeFace::resizeIndices(S32 num_indices)
@@ -6693,46 +6757,57 @@ bool LLVolumeFace::createSide(LLVolume* volume, bool partial_build)
 	S32 end_t = mBeginT+mNumT;
 	bool test = (mTypeMask & INNER_MASK) && (mTypeMask & FLAT_MASK) && mNumS > 2;
 
-	// Copy the vertices into the array
-	for (t = mBeginT; t < end_t; t++)
+	// The texture s coordinate of a column is the same on every row, work
+	// them out once instead of once per vertex.
+	static thread_local std::vector<F32> s_coords;
+	s_coords.resize(num_s);
+	for (s = 0; s < num_s; s++)
 	{
-		tt = path_data[t].mTexT;
-		for (s = 0; s < num_s; s++)
+		if (mTypeMask & END_MASK)
 		{
-			if (mTypeMask & END_MASK)
+			if (s)
 			{
-				if (s)
-				{
-					ss = 1.f;
-				}
-				else
-				{
-					ss = 0.f;
-				}
+				ss = 1.f;
 			}
 			else
 			{
-				// Get s value for tex-coord.
-                S32 index = mBeginS + s;
-                if (index >= profile.size())
-                {
-                    // edge?
-                    ss = flat ? 1.f - begin_stex : 1.f;
-                }
-				else if (!flat)
-				{
-					ss = profile[index][2];
-				}
-				else
-				{
-					ss = profile[index][2] - begin_stex;
-				}
+				ss = 0.f;
 			}
-
-			if (sculpt_reverse_horizontal)
+		}
+		else
+		{
+			// Get s value for tex-coord.
+            S32 index = mBeginS + s;
+            if (index >= profile.size())
+            {
+                // edge?
+                ss = flat ? 1.f - begin_stex : 1.f;
+            }
+			else if (!flat)
 			{
-				ss = 1.f - ss;
+				ss = profile[index][2];
 			}
+			else
+			{
+				ss = profile[index][2] - begin_stex;
+			}
+		}
+
+		if (sculpt_reverse_horizontal)
+		{
+			ss = 1.f - ss;
+		}
+
+		s_coords[s] = ss;
+	}
+
+	// Copy the vertices into the array
+	for (t = mBeginT; t < end_t; t++)
+	{
+		tt = path_data[t].mTexT;
+		for (s = 0; s < num_s; s++)
+		{
+			ss = s_coords[s];
 			
 			// Check to see if this triangle wraps around the array.
 			if (mBeginS + s >= max_s)
@@ -7188,25 +7263,16 @@ void CalculateTangentArray(U32 vertexCount, const LLVector4a *vertex, const LLVe
         U32 i2 = *index_array++;
         U32 i3 = *index_array++;
         
-        const LLVector4a& v1 = vertex[i1];
-        const LLVector4a& v2 = vertex[i2];
-        const LLVector4a& v3 = vertex[i3];
+        // triangle edges, all three components at once
+        LLVector4a e1;
+        LLVector4a e2;
+        e1.setSub(vertex[i2], vertex[i1]);
+        e2.setSub(vertex[i3], vertex[i1]);
         
         const LLVector2& w1 = texcoord[i1];
         const LLVector2& w2 = texcoord[i2];
         const LLVector2& w3 = texcoord[i3];
         
-		const F32* v1ptr = v1.getF32ptr();
-		const F32* v2ptr = v2.getF32ptr();
-		const F32* v3ptr = v3.getF32ptr();
-		
-        float x1 = v2ptr[0] - v1ptr[0];
-        float x2 = v3ptr[0] - v1ptr[0];
-        float y1 = v2ptr[1] - v1ptr[1];
-        float y2 = v3ptr[1] - v1ptr[1];
-        float z1 = v2ptr[2] - v1ptr[2];
-        float z2 = v3ptr[2] - v1ptr[2];
-        
         float s1 = w2.mV[0] - w1.mV[0];
         float s2 = w3.mV[0] - w1.mV[0];
         float t1 = w2.mV[1] - w1.mV[1];
@@ -7220,10 +7286,18 @@ void CalculateTangentArray(U32 vertexCount, const LLVector4a *vertex, const LLVe
 		llassert(llfinite(r));
 		llassert(!llisnan(r));
 
-		LLVector4a sdir((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r,
-				(t2 * z1 - t1 * z2) * r);
-		LLVector4a tdir((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r,
-				(s1 * z2 - s2 * z1) * r);
+		// sdir = (e1*t2 - e2*t1)*r, tdir = (e2*s1 - e1*s2)*r
+		LLVector4a sdir = e1;
+		LLVector4a tdir = e2;
+		LLVector4a tmp;
+		sdir.mul(t2 * r);
+		tmp = e2;
+		tmp.mul(t1 * r);
+		sdir.sub(tmp);
+		tdir.mul(s1 * r);
+		tmp = e1;
+		tmp.mul(s2 * r);
+		tdir.sub(tmp);
         
 		tan1[i1].add(sdir);
 		tan1[i2].add(sdir);
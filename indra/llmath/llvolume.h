@@ -876,7 +876,12 @@ public:
 	void resizeVertices(S32 num_verts);
 	void allocateTangents(S32 num_verts);
 	void allocateWeights(S32 num_verts);
-    void allocateJointIndices(S32 num_verts);
+
+	// build mJointIndices, mJointWeights and mJointExtents from mWeights if
+	// they are missing or were packed for a different joint count; joint
+	// indices are clamped to max_joints - 1
+	void packSkinWeights(S32 max_joints) const;
+	void freePackedSkinWeights() const;
 	void resizeIndices(S32 num_indices);
 	void fillFromLegacyData(std::vector<LLVolumeFace::VertexData>& v, std::vector<U16>& idx);
 
@@ -971,17 +976,19 @@ public:
 	// mWeights.size() should be empty or match mVertices.size()  
 	LLVector4a* mWeights;
 
-#if USE_SEPARATE_JOINT_INDICES_AND_WEIGHTS
-    LLVector4a* mJustWeights;
-    U8* mJointIndices;
-#endif
+    // mWeights unpacked by packSkinWeights() for CPU skinning.  Per vertex,
+    // four joint indices in mJointIndices and four 16 bit weights summing to
+    // 0xFFFF in mJointWeights, heaviest first, unused influences zero.
+    // mJointExtents holds min and max of the vertices each of the
+    // mNumPackedJoints joint indices influences.  NULL until packed, and
+    // dropped again whenever mWeights changes.
+    mutable U8* mJointIndices;
+    mutable U16* mJointWeights;
+    mutable LLVector4a* mJointExtents;
+    mutable S32 mNumPackedJoints;
 
     mutable bool mWeightsScrubbed;
 
-    // Which joints are rigged to, and the bounding box of any rigged
-    // vertices per joint.
-    LLJointRiggingInfoTab mJointRiggingInfoTab;
-
 	//whether or not face has been cache optimized
 	bool mOptimized;
 
@@ -1087,6 +1094,7 @@ public:
 	void sculpt(U16 sculpt_width, U16 sculpt_height, S8 sculpt_components, const U8* sculpt_data, S32 sculpt_level, bool visible_placeholder);
 
 	void copyVolumeFaces(const LLVolume* volume);
+	void moveVolumeFaces(LLVolume* volume); // leaves volume without faces
 	void copyFacesTo(std::vector<LLVolumeFace> &faces) const;
 	void copyFacesFrom(const std::vector<LLVolumeFace> &faces);
 	bool cacheOptimize();
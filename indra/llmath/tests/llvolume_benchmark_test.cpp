@@ -0,0 +1,186 @@
+/**
+ * @file   llvolume_benchmark_test.cpp
+ * @brief  Timing of the LLVolume SSE paths against the scalar code they replaced.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../llvolume.h"
+#include "../llvector4a.h"
+#include "lltimer.h"
+#include "llvolume_reference.h"
+
+#include <vector>
+
+// defined in llvolume.cpp, what LLVolumeFace::createTangents() runs
+void CalculateTangentArray(U32 vertexCount, const LLVector4a *vertex, const LLVector4a *normal,
+		const LLVector2 *texcoord, U32 triangleCount, const U16* index_array, LLVector4a *tangent);
+
+// Both sides of each case run on the same input, the results are compared
+// so the timings are of equivalent work, and the totals go to the log.
+// Nothing here fails on speed.
+namespace tut
+{
+	struct llvolume_benchmark_data
+	{
+		// passes over the prim set per case, enough to get past timer noise
+		static const S32 PASSES = 20;
+
+		std::vector<LLPointer<LLVolume> > mVolumes;
+
+		llvolume_benchmark_data()
+		{
+			const U8 profiles[] = { LL_PCODE_PROFILE_CIRCLE, LL_PCODE_PROFILE_SQUARE, LL_PCODE_PROFILE_ISOTRI,
+									LL_PCODE_PROFILE_EQUALTRI, LL_PCODE_PROFILE_RIGHTTRI, LL_PCODE_PROFILE_CIRCLE_HALF };
+			const U8 paths[] = { LL_PCODE_PATH_LINE, LL_PCODE_PATH_CIRCLE, LL_PCODE_PATH_CIRCLE2 };
+
+			for (U8 profile : profiles)
+			{
+				for (U8 path : paths)
+				{
+					for (S32 variant = 0; variant < 4; ++variant)
+					{
+						LLVolumeParams params;
+						params.setType(profile, path);
+						params.setHollow((variant & 1) ? 0.5f : 0.f);
+						params.setTwistEnd((variant & 2) ? 0.5f : 0.f);
+						// highest LOD, the most vertices per face
+						mVolumes.push_back(new LLVolume(params, 4.f));
+					}
+				}
+			}
+		}
+	};
+
+	typedef test_group<llvolume_benchmark_data> llvolume_benchmark_test;
+	typedef llvolume_benchmark_test::object llvolume_benchmark_object;
+	tut::llvolume_benchmark_test tllvolume_benchmark("LLVolumeBenchmark");
+
+	template<> template<>
+	void llvolume_benchmark_object::test<1>()
+	{
+		// tangents, scalar reference against CalculateTangentArray()
+		F64 reference_seconds = 0.0;
+		F64 current_seconds = 0.0;
+		U64 vertices = 0;
+		LLTimer timer;
+
+		for (LLVolume* volume : mVolumes)
+		{
+			for (S32 f = 0; f < volume->getNumVolumeFaces(); ++f)
+			{
+				const LLVolumeFace& face = volume->getVolumeFace(f);
+				if (!face.mNumVertices)
+				{
+					continue;
+				}
+
+				std::vector<LLVector4a> expected(face.mNumVertices);
+				std::vector<LLVector4a> tangents(face.mNumVertices);
+
+				timer.reset();
+				for (S32 pass = 0; pass < PASSES; ++pass)
+				{
+					reference_tangents(face.mNumVertices, face.mPositions, face.mNormals, face.mTexCoords,
+									   face.mNumIndices/3, face.mIndices, &expected[0]);
+				}
+				reference_seconds += timer.getElapsedTimeF64();
+
+				timer.reset();
+				for (S32 pass = 0; pass < PASSES; ++pass)
+				{
+					CalculateTangentArray(face.mNumVertices, face.mPositions, face.mNormals, face.mTexCoords,
+										  face.mNumIndices/3, face.mIndices, &tangents[0]);
+				}
+				current_seconds += timer.getElapsedTimeF64();
+
+				for (S32 i = 0; i < face.mNumVertices; ++i)
+				{
+					ensure("tangent matches reference", nearly_equal(tangents[i], expected[i], 1.e-3f));
+				}
+				vertices += face.mNumVertices;
+			}
+		}
+
+		LL_INFOS() << "Tangents, " << vertices << " vertices x " << PASSES << " passes: scalar "
+			<< reference_seconds * 1000.0 << " ms, current " << current_seconds * 1000.0 << " ms" << LL_ENDL;
+	}
+
+	template<> template<>
+	void llvolume_benchmark_object::test<2>()
+	{
+		// path point transforms, scalar LLMatrix4 product against the row
+		// scaling generate() does now
+		F64 reference_seconds = 0.0;
+		F64 current_seconds = 0.0;
+		U64 points = 0;
+		LLTimer timer;
+
+		for (LLVolume* volume : mVolumes)
+		{
+			const LLAlignedArray<LLPath::PathPt, 64>& path = volume->getPath().mPath;
+			std::vector<LLMatrix4a> expected(path.size());
+			std::vector<LLMatrix4a> matrices(path.size());
+
+			timer.reset();
+			for (S32 pass = 0; pass < PASSES; ++pass)
+			{
+				for (U32 s = 0; s < path.size(); ++s)
+				{
+					expected[s] = reference_path_matrix(path[s]);
+				}
+			}
+			reference_seconds += timer.getElapsedTimeF64();
+
+			timer.reset();
+			for (S32 pass = 0; pass < PASSES; ++pass)
+			{
+				for (U32 s = 0; s < path.size(); ++s)
+				{
+					const F32* scale = path[s].mScale.getF32ptr();
+					LLMatrix4a& rot_mat = matrices[s];
+					rot_mat = path[s].mRot;
+					rot_mat.mMatrix[0].mul(scale[0]);
+					rot_mat.mMatrix[1].mul(scale[1]);
+					rot_mat.mMatrix[2].mul(scale[2]);
+				}
+			}
+			current_seconds += timer.getElapsedTimeF64();
+
+			for (U32 s = 0; s < path.size(); ++s)
+			{
+				for (S32 row = 0; row < 3; ++row)
+				{
+					ensure("path matrix matches reference", nearly_equal(matrices[s].mMatrix[row], expected[s].mMatrix[row], 1.e-5f));
+				}
+			}
+			points += path.size();
+		}
+
+		LL_INFOS() << "Path transforms, " << points << " points x " << PASSES << " passes: scalar "
+			<< reference_seconds * 1000.0 << " ms, current " << current_seconds * 1000.0 << " ms" << LL_ENDL;
+	}
+}
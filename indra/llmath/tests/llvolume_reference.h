@@ -0,0 +1,191 @@
+/**
+ * @file   llvolume_reference.h
+ * @brief  Scalar reference versions of the LLVolume generation loops.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLVOLUME_REFERENCE_H
+#define LL_LLVOLUME_REFERENCE_H
+
+#include "../llvolume.h"
+#include "../llvector4a.h"
+#include "../llmatrix4a.h"
+#include "../m4math.h"
+
+#include <vector>
+
+// The scalar code LLVolume used before its SSE paths, kept as the reference
+// llvolume_test checks results against and llvolume_benchmark times the
+// current code against.
+inline void reference_tangents(U32 vertexCount, const LLVector4a *vertex, const LLVector4a *normal,
+						const LLVector2 *texcoord, U32 triangleCount, const U16* index_array, LLVector4a *tangent)
+{
+	std::vector<LLVector4a> tan1(vertexCount);
+	std::vector<LLVector4a> tan2(vertexCount);
+	for (U32 i = 0; i < vertexCount; i++)
+	{
+		tan1[i].clear();
+		tan2[i].clear();
+	}
+
+	for (U32 a = 0; a < triangleCount; a++)
+	{
+		U32 i1 = *index_array++;
+		U32 i2 = *index_array++;
+		U32 i3 = *index_array++;
+
+		const F32* v1ptr = vertex[i1].getF32ptr();
+		const F32* v2ptr = vertex[i2].getF32ptr();
+		const F32* v3ptr = vertex[i3].getF32ptr();
+
+		const LLVector2& w1 = texcoord[i1];
+		const LLVector2& w2 = texcoord[i2];
+		const LLVector2& w3 = texcoord[i3];
+
+		float x1 = v2ptr[0] - v1ptr[0];
+		float x2 = v3ptr[0] - v1ptr[0];
+		float y1 = v2ptr[1] - v1ptr[1];
+		float y2 = v3ptr[1] - v1ptr[1];
+		float z1 = v2ptr[2] - v1ptr[2];
+		float z2 = v3ptr[2] - v1ptr[2];
+
+		float s1 = w2.mV[0] - w1.mV[0];
+		float s2 = w3.mV[0] - w1.mV[0];
+		float t1 = w2.mV[1] - w1.mV[1];
+		float t2 = w3.mV[1] - w1.mV[1];
+
+		F32 rd = s1*t2-s2*t1;
+
+		float r = ((rd*rd) > FLT_EPSILON) ? (1.0f / rd) : ((rd > 0.0f) ? 1024.f : -1024.f);
+
+		LLVector4a sdir((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r,
+				(t2 * z1 - t1 * z2) * r);
+		LLVector4a tdir((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r,
+				(s1 * z2 - s2 * z1) * r);
+
+		tan1[i1].add(sdir);
+		tan1[i2].add(sdir);
+		tan1[i3].add(sdir);
+
+		tan2[i1].add(tdir);
+		tan2[i2].add(tdir);
+		tan2[i3].add(tdir);
+	}
+
+	for (U32 a = 0; a < vertexCount; a++)
+	{
+		LLVector4a n = normal[a];
+		const LLVector4a& t = tan1[a];
+
+		LLVector4a ncrosst;
+		ncrosst.setCross3(n,t);
+
+		n.mul(n.dot3(t).getF32());
+
+		LLVector4a tsubn;
+		tsubn.setSub(t,n);
+
+		if (tsubn.dot3(tsubn).getF32() > F_APPROXIMATELY_ZERO)
+		{
+			tsubn.normalize3fast();
+			tsubn.getF32ptr()[3] = ncrosst.dot3(tan2[a]).getF32() < 0.f ? -1.f : 1.f;
+			tangent[a] = tsubn;
+		}
+		else
+		{
+			tangent[a].set(0,0,1,1);
+		}
+	}
+}
+
+inline LLVector4a reference_sculpt_vertex(S32 s, S32 t, S32 sizeS, S32 sizeT, U16 width, U16 height, const U8* data, U8 sculpt_type)
+{
+	U8 stitching = sculpt_type & LL_SCULPT_TYPE_MASK;
+	bool invert = sculpt_type & LL_SCULPT_FLAG_INVERT;
+	bool mirror = sculpt_type & LL_SCULPT_FLAG_MIRROR;
+	bool reverse_horizontal = (invert ? !mirror : mirror);
+
+	S32 reversed_t = reverse_horizontal ? sizeT - t - 1 : t;
+
+	U32 x = (U32) ((F32)reversed_t/(sizeT-1) * (F32) width);
+	U32 y = (U32) ((F32)s/(sizeS-1) * (F32) height);
+
+	if (y == 0 && stitching == LL_SCULPT_TYPE_SPHERE)
+	{
+		x = width / 2;
+	}
+
+	if (y == height)
+	{
+		y = (stitching == LL_SCULPT_TYPE_TORUS) ? 0 : height - 1;
+		if (stitching == LL_SCULPT_TYPE_SPHERE)
+		{
+			x = width / 2;
+		}
+	}
+
+	if (x == width)
+	{
+		x = (stitching == LL_SCULPT_TYPE_SPHERE || stitching == LL_SCULPT_TYPE_TORUS ||
+			 stitching == LL_SCULPT_TYPE_CYLINDER) ? 0 : width - 1;
+	}
+
+	const U8* p = data + (x + y * width) * 3;
+	LLVector4a pt(p[0] / 255.f - 0.5f, p[1] / 255.f - 0.5f, p[2] / 255.f - 0.5f);
+	if (mirror)
+	{
+		pt.getF32ptr()[0] *= -1.f;
+	}
+	return pt;
+}
+
+// the path point transform generate() built before it scaled the rows
+// of the path rotation directly
+inline LLMatrix4a reference_path_matrix(const LLPath::PathPt& point)
+{
+	const F32* scale = point.mScale.getF32ptr();
+
+	F32 sc [] =
+	{ scale[0], 0, 0, 0,
+		0, scale[1], 0, 0,
+		0, 0, scale[2], 0,
+			0, 0, 0, 1 };
+
+	LLMatrix4 rot((F32*) point.mRot.mMatrix);
+	LLMatrix4 scale_mat(sc);
+
+	scale_mat *= rot;
+
+	LLMatrix4a rot_mat;
+	rot_mat.loadu(scale_mat);
+	return rot_mat;
+}
+
+inline bool nearly_equal(const LLVector4a& a, const LLVector4a& b, F32 tolerance)
+{
+	LLVector4a diff;
+	diff.setSub(a, b);
+	return diff.dot3(diff).getF32() <= tolerance * tolerance;
+}
+
+#endif // LL_LLVOLUME_REFERENCE_H
@@ -0,0 +1,237 @@
+/**
+ * @file   llvolume_test.cpp
+ * @brief  Test of LLVolume prim and sculpt generation.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../llvolume.h"
+#include "../llvector4a.h"
+#include "lluuid.h"
+#include "llvolume_reference.h"
+
+#include <vector>
+
+namespace tut
+{
+	struct llvolume_data
+	{
+		// the prim shapes builders use most, across profile, path, hollow and twist
+		std::vector<LLVolumeParams> mParams;
+
+		llvolume_data()
+		{
+			const U8 profiles[] = { LL_PCODE_PROFILE_CIRCLE, LL_PCODE_PROFILE_SQUARE, LL_PCODE_PROFILE_ISOTRI,
+									LL_PCODE_PROFILE_EQUALTRI, LL_PCODE_PROFILE_RIGHTTRI, LL_PCODE_PROFILE_CIRCLE_HALF };
+			const U8 paths[] = { LL_PCODE_PATH_LINE, LL_PCODE_PATH_CIRCLE, LL_PCODE_PATH_CIRCLE2 };
+
+			for (U8 profile : profiles)
+			{
+				for (U8 path : paths)
+				{
+					for (S32 variant = 0; variant < 4; ++variant)
+					{
+						LLVolumeParams params;
+						params.setType(profile, path);
+						params.setHollow((variant & 1) ? 0.5f : 0.f);
+						params.setTwistEnd((variant & 2) ? 0.5f : 0.f);
+						mParams.push_back(params);
+					}
+				}
+			}
+		}
+	};
+
+	typedef test_group<llvolume_data> llvolume_test;
+	typedef llvolume_test::object llvolume_object;
+	tut::llvolume_test tllvolume("LLVolume");
+
+	template<> template<>
+	void llvolume_object::test<1>()
+	{
+		// tangents match the scalar reference for every face of every prim at every LOD
+		const F32 details[] = { 1.f, 1.5f, 2.5f, 4.f };
+
+		for (const LLVolumeParams& params : mParams)
+		{
+			for (F32 detail : details)
+			{
+				LLPointer<LLVolume> volume = new LLVolume(params, detail);
+				for (S32 f = 0; f < volume->getNumVolumeFaces(); ++f)
+				{
+					LLVolumeFace& face = volume->getVolumeFace(f);
+					if (!face.mNumVertices || face.mTangents)
+					{
+						continue;
+					}
+
+					// createTangents() normalizes the normals afterwards, keep what it started from
+					std::vector<LLVector4a> normals(face.mNormals, face.mNormals + face.mNumVertices);
+					std::vector<LLVector4a> expected(face.mNumVertices);
+
+					reference_tangents(face.mNumVertices, face.mPositions, &normals[0], face.mTexCoords,
+									   face.mNumIndices/3, face.mIndices, &expected[0]);
+					face.createTangents();
+
+					for (S32 i = 0; i < face.mNumVertices; ++i)
+					{
+						ensure("tangent matches reference", nearly_equal(face.mTangents[i], expected[i], 1.e-3f));
+					}
+				}
+			}
+		}
+	}
+
+	template<> template<>
+	void llvolume_object::test<2>()
+	{
+		// sculpt map sampling matches the scalar reference for every stitching type and flag
+		const U16 width = 64;
+		const U16 height = 64;
+		std::vector<U8> data(width * height * 3);
+		for (U32 i = 0; i < data.size(); ++i)
+		{
+			data[i] = (U8) ((i * 37 + (i / 3) * 11) & 0xff);
+		}
+
+		const U8 types[] = { LL_SCULPT_TYPE_SPHERE, LL_SCULPT_TYPE_TORUS, LL_SCULPT_TYPE_PLANE, LL_SCULPT_TYPE_CYLINDER };
+		const U8 flags[] = { 0, LL_SCULPT_FLAG_INVERT, LL_SCULPT_FLAG_MIRROR, LL_SCULPT_FLAG_INVERT | LL_SCULPT_FLAG_MIRROR };
+
+		for (U8 type : types)
+		{
+			for (U8 flag : flags)
+			{
+				LLVolumeParams params;
+				params.setType(LL_PCODE_PROFILE_CIRCLE, LL_PCODE_PATH_CIRCLE);
+				params.setSculptID(LLUUID::generateNewID(), type | flag);
+
+				// detail 1 skips the surface area check, so the map is always used
+				LLPointer<LLVolume> volume = new LLVolume(params, 1.f);
+
+				volume->sculpt(width, height, 3, &data[0], 0, false);
+
+				const LLAlignedArray<LLVector4a,64>& mesh = volume->getMesh();
+				S32 sizeS = volume->getPath().mPath.size();
+				S32 sizeT = volume->getProfile().mProfile.size();
+				ensure_equals("sculpt mesh size", (S32) mesh.size(), sizeS * sizeT);
+
+				for (S32 s = 0; s < sizeS; ++s)
+				{
+					for (S32 t = 0; t < sizeT; ++t)
+					{
+						LLVector4a expected = reference_sculpt_vertex(s, t, sizeS, sizeT, width, height, &data[0], type | flag);
+						ensure("sculpt vertex matches reference", nearly_equal(mesh[s * sizeT + t], expected, 1.e-5f));
+					}
+				}
+			}
+		}
+	}
+
+	template<> template<>
+	void llvolume_object::test<3>()
+	{
+		// profile x path sweep produces finite geometry inside the unit box
+		LLVector4a box_min(-0.5001f, -0.5001f, -0.5001f);
+		LLVector4a box_max(0.5001f, 0.5001f, 0.5001f);
+		for (const LLVolumeParams& params : mParams)
+		{
+			LLPointer<LLVolume> volume = new LLVolume(params, 4.f);
+			const LLAlignedArray<LLVector4a,64>& mesh = volume->getMesh();
+			ensure("volume has a mesh", mesh.size() > 0);
+			for (U32 i = 0; i < mesh.size(); ++i)
+			{
+				ensure("mesh point is finite", mesh[i].isFinite3());
+				ensure("mesh point is inside the unit box",
+					   box_min.lessEqual(mesh[i]).areAllSet(LLVector4Logical::MASK_XYZ) &&
+					   mesh[i].lessEqual(box_max).areAllSet(LLVector4Logical::MASK_XYZ));
+			}
+		}
+	}
+
+	template<> template<>
+	void llvolume_object::test<4>()
+	{
+		// packed skin weights keep the joints and normalized weights of
+		// mWeights, heaviest first, and bound the vertices of every joint
+		const S32 max_joints = 8;
+
+		LLPointer<LLVolume> volume = new LLVolume(mParams[0], 2.f);
+		LLVolumeFace& face = volume->getVolumeFace(0);
+		ensure("face has vertices", face.mNumVertices > 0);
+
+		face.allocateWeights(face.mNumVertices);
+		for (S32 i = 0; i < face.mNumVertices; ++i)
+		{
+			// <joint>.<weight>, the last one out of range to test clamping
+			switch (i % 4)
+			{
+			case 0: face.mWeights[i].set(1.999f, 0.f, 0.f, 0.f); break;
+			case 1: face.mWeights[i].set(2.25f, 3.75f, 0.f, 0.f); break;
+			case 2: face.mWeights[i].set(1.1f, 4.2f, 5.3f, 6.4f); break;
+			default: face.mWeights[i].set(12.5f, 0.f, 0.f, 0.f); break;
+			}
+		}
+
+		face.packSkinWeights(max_joints);
+		ensure("weights packed", face.mJointIndices && face.mJointWeights && face.mJointExtents);
+		ensure_equals("packed joint count", face.mNumPackedJoints, max_joints);
+
+		for (S32 i = 0; i < face.mNumVertices; ++i)
+		{
+			const U8* idx = face.mJointIndices + i * 4;
+			const U16* w = face.mJointWeights + i * 4;
+			ensure_equals("weights sum to one", (U32) w[0] + w[1] + w[2] + w[3], (U32) 0xFFFF);
+			for (U32 k = 0; k < 4; ++k)
+			{
+				ensure("joint index in range", idx[k] < max_joints);
+				ensure("heaviest first", k == 0 || w[k] <= w[k - 1]);
+				if (w[k])
+				{
+					const LLVector4a* extents = face.mJointExtents + idx[k] * 2;
+					ensure("joint box holds its vertex",
+						   extents[0].lessEqual(face.mPositions[i]).areAllSet(LLVector4Logical::MASK_XYZ) &&
+						   face.mPositions[i].lessEqual(extents[1]).areAllSet(LLVector4Logical::MASK_XYZ));
+				}
+			}
+
+			switch (i % 4)
+			{
+			case 1:
+				ensure_equals("heavier joint first", (S32) idx[0], 3);
+				ensure("weights normalized", fabsf(w[0] / 65535.f - 0.75f) < 1.e-4f);
+				break;
+			case 3:
+				ensure_equals("joint clamped", (S32) idx[0], max_joints - 1);
+				ensure_equals("single influence", (U32) w[0], (U32) 0xFFFF);
+				break;
+			}
+		}
+
+		// new weights drop the packed copy
+		face.allocateWeights(face.mNumVertices);
+		ensure("repack after new weights", face.mJointIndices == nullptr);
+	}
+}
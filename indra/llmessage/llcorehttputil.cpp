@@ -30,6 +30,8 @@
 #include <sstream>
 #include <algorithm>
 #include <iterator>
+#include <deque>
+#include <map>
 #include "llcorehttputil.h"
 #include "llhttpconstants.h"
 #include "llsd.h"
@@ -37,7 +39,9 @@
 #include "llsdserialize.h"
 #include "reader.h" // JSON
 #include "writer.h" // JSON
+#include "llfile.h"
 #include "llfilesystem.h"
+#include "lltimer.h"
 
 #include "message.h" // for getting the port
 
@@ -120,7 +124,9 @@ bool responseToLLSD(HttpResponse * response, bool log, LLSD & out_llsd)
 
     LLCore::BufferArrayStream bas(body);
     LLSD body_llsd;
-    S32 parse_status(LLSDSerialize::fromXML(body_llsd, bas, log));
+    LLPointer<LLSDXMLParser> parser = new LLSDXMLParser(log);
+    parser->setUseArena(true);
+    S32 parse_status(parser->parse(bas, body_llsd, LLSDSerialize::SIZE_UNLIMITED));
     if (LLSDParser::PARSE_FAILURE == parse_status){
         return false;
     }
@@ -583,6 +589,44 @@ LLSD HttpCoroRawHandler::parseBody(LLCore::HttpResponse *response, bool &success
     return LLSD();
 }
 
+//========================================================================
+/// The HttpCoroStreamedLLSDHandler is used by HttpCoroutineAdapter when
+/// setRawResponse() is on.  A successful LLSD body is handed back unparsed
+/// in the "raw" entry, for the caller to read as a stream, while error
+/// bodies are parsed as LLSD just as HttpCoroLLSDHandler does, so error
+/// maps reach the caller unchanged.
+///                      
+class HttpCoroStreamedLLSDHandler : public HttpCoroRawHandler
+{
+public:
+    HttpCoroStreamedLLSDHandler(LLEventStream &reply);
+
+    virtual LLSD parseBody(LLCore::HttpResponse *response, bool &success);
+};
+
+//-------------------------------------------------------------------------
+HttpCoroStreamedLLSDHandler::HttpCoroStreamedLLSDHandler(LLEventStream &reply):
+    HttpCoroRawHandler(reply)
+{
+}
+
+LLSD HttpCoroStreamedLLSDHandler::parseBody(LLCore::HttpResponse *response, bool &success)
+{
+    success = true;
+    if (response->getBodySize() == 0)
+        return LLSD();
+
+    LLSD result;
+
+    if (!LLCoreHttpUtil::responseToLLSD(response, true, result))
+    {
+        success = false;
+        return LLSD();
+    }
+
+    return result;
+}
+
 //========================================================================
 /// The HttpCoroJSONHandler is a specialization of the LLCore::HttpHandler for 
 /// interacting with coroutines. 
@@ -704,7 +748,8 @@ HttpCoroutineAdapter::HttpCoroutineAdapter(const std::string &name,
     mPriority(priority),
     mYieldingHandle(LLCORE_HTTP_HANDLE_INVALID),
     mWeakRequest(),
-    mWeakHandler()
+    mWeakHandler(),
+    mRawResponse(false)
 {
 }
 
@@ -713,12 +758,21 @@ HttpCoroutineAdapter::~HttpCoroutineAdapter()
     cancelSuspendedOperation();
 }
 
+HttpCoroHandler::ptr_t HttpCoroutineAdapter::makeLLSDHandler(LLEventStream &replyPump) const
+{
+    if (mRawResponse)
+    {
+        return HttpCoroHandler::ptr_t(new HttpCoroStreamedLLSDHandler(replyPump));
+    }
+    return HttpCoroHandler::ptr_t(new HttpCoroLLSDHandler(replyPump));
+}
+
 LLSD HttpCoroutineAdapter::postAndSuspend(LLCore::HttpRequest::ptr_t request,
     const std::string & url, const LLSD & body,
     LLCore::HttpOptions::ptr_t options, LLCore::HttpHeaders::ptr_t headers)
 {
     LLEventStream  replyPump(mAdapterName, true);
-    HttpCoroHandler::ptr_t httpHandler(new HttpCoroLLSDHandler(replyPump));
+    HttpCoroHandler::ptr_t httpHandler(makeLLSDHandler(replyPump));
 
     return postAndSuspend_(request, url, body, options, headers, httpHandler);
 }
@@ -728,6 +782,12 @@ LLSD HttpCoroutineAdapter::postAndSuspend_(LLCore::HttpRequest::ptr_t &request,
     LLCore::HttpOptions::ptr_t &options, LLCore::HttpHeaders::ptr_t &headers,
     HttpCoroHandler::ptr_t &handler)
 {
+    LLSD replayed;
+    if (HttpRecording::replay(HTTP_VERB_POST, url, replayed))
+    {
+        return replayed;
+    }
+
     HttpRequestPumper pumper(request);
 
     checkDefaultHeaders(headers);
@@ -746,6 +806,7 @@ LLSD HttpCoroutineAdapter::postAndSuspend_(LLCore::HttpRequest::ptr_t &request,
     saveState(hhandle, request, handler);
     LLSD results = llcoro::suspendUntilEventOn(handler->getReplyPump());
     cleanState();
+    HttpRecording::record(HTTP_VERB_POST, url, results);
 
     return results;
 }
@@ -755,7 +816,7 @@ LLSD HttpCoroutineAdapter::postAndSuspend(LLCore::HttpRequest::ptr_t request,
     LLCore::HttpOptions::ptr_t options, LLCore::HttpHeaders::ptr_t headers)
 {
     LLEventStream  replyPump(mAdapterName, true);
-    HttpCoroHandler::ptr_t httpHandler(new HttpCoroLLSDHandler(replyPump));
+    HttpCoroHandler::ptr_t httpHandler(makeLLSDHandler(replyPump));
 
     return postAndSuspend_(request, url, rawbody, options, headers, httpHandler);
 }
@@ -852,6 +913,12 @@ LLSD HttpCoroutineAdapter::postAndSuspend_(LLCore::HttpRequest::ptr_t &request,
     LLCore::HttpOptions::ptr_t &options, LLCore::HttpHeaders::ptr_t &headers,
     HttpCoroHandler::ptr_t &handler)
 {
+    LLSD replayed;
+    if (HttpRecording::replay(HTTP_VERB_POST, url, replayed))
+    {
+        return replayed;
+    }
+
     HttpRequestPumper pumper(request);
 
     checkDefaultHeaders(headers);
@@ -869,6 +936,7 @@ LLSD HttpCoroutineAdapter::postAndSuspend_(LLCore::HttpRequest::ptr_t &request,
     saveState(hhandle, request, handler);
     LLSD results = llcoro::suspendUntilEventOn(handler->getReplyPump());
     cleanState();
+    HttpRecording::record(HTTP_VERB_POST, url, results);
 
     return results;
 }
@@ -878,7 +946,7 @@ LLSD HttpCoroutineAdapter::putAndSuspend(LLCore::HttpRequest::ptr_t request,
     LLCore::HttpOptions::ptr_t options, LLCore::HttpHeaders::ptr_t headers)
 {
     LLEventStream  replyPump(mAdapterName + "Reply", true);
-    HttpCoroHandler::ptr_t httpHandler(new HttpCoroLLSDHandler(replyPump));
+    HttpCoroHandler::ptr_t httpHandler(makeLLSDHandler(replyPump));
 
     return putAndSuspend_(request, url, body, options, headers, httpHandler);
 }
@@ -909,6 +977,12 @@ LLSD HttpCoroutineAdapter::putAndSuspend_(LLCore::HttpRequest::ptr_t &request,
     LLCore::HttpOptions::ptr_t &options, LLCore::HttpHeaders::ptr_t &headers,
     HttpCoroHandler::ptr_t &handler)
 {
+    LLSD replayed;
+    if (HttpRecording::replay(HTTP_VERB_PUT, url, replayed))
+    {
+        return replayed;
+    }
+
     HttpRequestPumper pumper(request);
 
     checkDefaultHeaders(headers);
@@ -927,6 +1001,7 @@ LLSD HttpCoroutineAdapter::putAndSuspend_(LLCore::HttpRequest::ptr_t &request,
     saveState(hhandle, request, handler);
     LLSD results = llcoro::suspendUntilEventOn(handler->getReplyPump());
     cleanState();
+    HttpRecording::record(HTTP_VERB_PUT, url, results);
 
     return results;
 }
@@ -936,6 +1011,12 @@ LLSD HttpCoroutineAdapter::putAndSuspend_(LLCore::HttpRequest::ptr_t &request,
     LLCore::HttpOptions::ptr_t &options, LLCore::HttpHeaders::ptr_t &headers,
     HttpCoroHandler::ptr_t &handler)
 {
+    LLSD replayed;
+    if (HttpRecording::replay(HTTP_VERB_PUT, url, replayed))
+    {
+        return replayed;
+    }
+
     HttpRequestPumper pumper(request);
 
     checkDefaultHeaders(headers);
@@ -953,6 +1034,7 @@ LLSD HttpCoroutineAdapter::putAndSuspend_(LLCore::HttpRequest::ptr_t &request,
     saveState(hhandle, request, handler);
     LLSD results = llcoro::suspendUntilEventOn(handler->getReplyPump());
     cleanState();
+    HttpRecording::record(HTTP_VERB_PUT, url, results);
 
     return results;
 }
@@ -963,7 +1045,7 @@ LLSD HttpCoroutineAdapter::getAndSuspend(LLCore::HttpRequest::ptr_t request,
     LLCore::HttpOptions::ptr_t options, LLCore::HttpHeaders::ptr_t headers)
 {
     LLEventStream  replyPump(mAdapterName + "Reply", true);
-    HttpCoroHandler::ptr_t httpHandler(new HttpCoroLLSDHandler(replyPump));
+    HttpCoroHandler::ptr_t httpHandler(makeLLSDHandler(replyPump));
 
     return getAndSuspend_(request, url, options, headers, httpHandler);
 }
@@ -993,6 +1075,12 @@ LLSD HttpCoroutineAdapter::getAndSuspend_(LLCore::HttpRequest::ptr_t &request,
     LLCore::HttpOptions::ptr_t &options, LLCore::HttpHeaders::ptr_t &headers, 
     HttpCoroHandler::ptr_t &handler)
 {
+    LLSD replayed;
+    if (HttpRecording::replay(HTTP_VERB_GET, url, replayed))
+    {
+        return replayed;
+    }
+
     HttpRequestPumper pumper(request);
     checkDefaultHeaders(headers);
 
@@ -1009,6 +1097,7 @@ LLSD HttpCoroutineAdapter::getAndSuspend_(LLCore::HttpRequest::ptr_t &request,
     saveState(hhandle, request, handler);
     LLSD results = llcoro::suspendUntilEventOn(handler->getReplyPump());
     cleanState();
+    HttpRecording::record(HTTP_VERB_GET, url, results);
 
     return results;
 }
@@ -1019,7 +1108,7 @@ LLSD HttpCoroutineAdapter::deleteAndSuspend(LLCore::HttpRequest::ptr_t request,
     LLCore::HttpOptions::ptr_t options, LLCore::HttpHeaders::ptr_t headers)
 {
     LLEventStream  replyPump(mAdapterName + "Reply", true);
-    HttpCoroHandler::ptr_t httpHandler(new HttpCoroLLSDHandler(replyPump));
+    HttpCoroHandler::ptr_t httpHandler(makeLLSDHandler(replyPump));
 
     return deleteAndSuspend_(request, url, options, headers, httpHandler);
 }
@@ -1039,6 +1128,12 @@ LLSD HttpCoroutineAdapter::deleteAndSuspend_(LLCore::HttpRequest::ptr_t &request
     const std::string & url, LLCore::HttpOptions::ptr_t &options, 
     LLCore::HttpHeaders::ptr_t &headers, HttpCoroHandler::ptr_t &handler)
 {
+    LLSD replayed;
+    if (HttpRecording::replay(HTTP_VERB_DELETE, url, replayed))
+    {
+        return replayed;
+    }
+
     HttpRequestPumper pumper(request);
 
     checkDefaultHeaders(headers);
@@ -1055,6 +1150,7 @@ LLSD HttpCoroutineAdapter::deleteAndSuspend_(LLCore::HttpRequest::ptr_t &request
     saveState(hhandle, request, handler);
     LLSD results = llcoro::suspendUntilEventOn(handler->getReplyPump());
     cleanState();
+    HttpRecording::record(HTTP_VERB_DELETE, url, results);
 
     return results;
 }
@@ -1064,7 +1160,7 @@ LLSD HttpCoroutineAdapter::patchAndSuspend(LLCore::HttpRequest::ptr_t request,
     LLCore::HttpOptions::ptr_t options, LLCore::HttpHeaders::ptr_t headers)
 {
     LLEventStream  replyPump(mAdapterName + "Reply", true);
-    HttpCoroHandler::ptr_t httpHandler(new HttpCoroLLSDHandler(replyPump));
+    HttpCoroHandler::ptr_t httpHandler(makeLLSDHandler(replyPump));
 
     return patchAndSuspend_(request, url, body, options, headers, httpHandler);
 }
@@ -1075,6 +1171,12 @@ LLSD HttpCoroutineAdapter::patchAndSuspend_(LLCore::HttpRequest::ptr_t &request,
     LLCore::HttpOptions::ptr_t &options, LLCore::HttpHeaders::ptr_t &headers,
     HttpCoroHandler::ptr_t &handler)
 {
+    LLSD replayed;
+    if (HttpRecording::replay(std::string("PATCH"), url, replayed))
+    {
+        return replayed;
+    }
+
     HttpRequestPumper pumper(request);
 
     checkDefaultHeaders(headers);
@@ -1093,6 +1195,7 @@ LLSD HttpCoroutineAdapter::patchAndSuspend_(LLCore::HttpRequest::ptr_t &request,
     saveState(hhandle, request, handler);
     LLSD results = llcoro::suspendUntilEventOn(handler->getReplyPump());
     cleanState();
+    HttpRecording::record(std::string("PATCH"), url, results);
 
     return results;
 }
@@ -1102,7 +1205,7 @@ LLSD HttpCoroutineAdapter::copyAndSuspend(LLCore::HttpRequest::ptr_t request,
     LLCore::HttpOptions::ptr_t options, LLCore::HttpHeaders::ptr_t headers)
 {
     LLEventStream  replyPump(mAdapterName + "Reply", true);
-    HttpCoroHandler::ptr_t httpHandler(new HttpCoroLLSDHandler(replyPump));
+    HttpCoroHandler::ptr_t httpHandler(makeLLSDHandler(replyPump));
 
     if (!headers)
         headers.reset(new LLCore::HttpHeaders);
@@ -1117,6 +1220,12 @@ LLSD HttpCoroutineAdapter::copyAndSuspend_(LLCore::HttpRequest::ptr_t &request,
     LLCore::HttpOptions::ptr_t &options, LLCore::HttpHeaders::ptr_t &headers,
     HttpCoroHandler::ptr_t &handler)
 {
+    LLSD replayed;
+    if (HttpRecording::replay(std::string("COPY"), url, replayed))
+    {
+        return replayed;
+    }
+
     HttpRequestPumper pumper(request);
 
     checkDefaultHeaders(headers);
@@ -1135,6 +1244,7 @@ LLSD HttpCoroutineAdapter::copyAndSuspend_(LLCore::HttpRequest::ptr_t &request,
     saveState(hhandle, request, handler);
     LLSD results = llcoro::suspendUntilEventOn(handler->getReplyPump());
     cleanState();
+    HttpRecording::record(std::string("COPY"), url, results);
 
     return results;
 }
@@ -1144,7 +1254,7 @@ LLSD HttpCoroutineAdapter::moveAndSuspend(LLCore::HttpRequest::ptr_t request,
     LLCore::HttpOptions::ptr_t options, LLCore::HttpHeaders::ptr_t headers)
 {
     LLEventStream  replyPump(mAdapterName + "Reply", true);
-    HttpCoroHandler::ptr_t httpHandler(new HttpCoroLLSDHandler(replyPump));
+    HttpCoroHandler::ptr_t httpHandler(makeLLSDHandler(replyPump));
 
     if (!headers)
         headers.reset(new LLCore::HttpHeaders);
@@ -1159,6 +1269,12 @@ LLSD HttpCoroutineAdapter::moveAndSuspend_(LLCore::HttpRequest::ptr_t &request,
     LLCore::HttpOptions::ptr_t &options, LLCore::HttpHeaders::ptr_t &headers,
     HttpCoroHandler::ptr_t &handler)
 {
+    LLSD replayed;
+    if (HttpRecording::replay(HTTP_VERB_MOVE, url, replayed))
+    {
+        return replayed;
+    }
+
     HttpRequestPumper pumper(request);
 
     checkDefaultHeaders(headers);
@@ -1177,6 +1293,7 @@ LLSD HttpCoroutineAdapter::moveAndSuspend_(LLCore::HttpRequest::ptr_t &request,
     saveState(hhandle, request, handler);
     LLSD results = llcoro::suspendUntilEventOn(handler->getReplyPump());
     cleanState();
+    HttpRecording::record(HTTP_VERB_MOVE, url, results);
 
     return results;
 }
@@ -1361,7 +1478,182 @@ void HttpCoroutineAdapter::trivialPostCoro(std::string url, LLCore::HttpRequest:
     }
 }
 
+//=========================================================================
+namespace
+{
+    const char HTTP_RECORDING_MAGIC[4] = { 'L', 'L', 'H', 'R' };
+    const U32 HTTP_RECORDING_VERSION = 1;
+
+    LLFILE* sHttpRecordFile = NULL;
+    U64 sHttpRecordStart = 0;
+
+    bool sHttpReplaying = false;
+    // recorded results by "method url", oldest first
+    std::map<std::string, std::deque<LLSD> > sHttpReplayResults;
+
+    std::string recording_key(const std::string &method, const std::string &url)
+    {
+        return method + " " + url;
+    }
+}
+
+/*static*/
+bool HttpRecording::startRecording(const std::string &filename)
+{
+    stopRecording();
 
+    sHttpRecordFile = LLFile::fopen(filename, "wb");     /* Flawfinder: ignore */
+    if (!sHttpRecordFile)
+    {
+        LL_WARNS("CoreHTTP") << "Unable to open HTTP recording " << filename << LL_ENDL;
+        return false;
+    }
+
+    fwrite(HTTP_RECORDING_MAGIC, sizeof(HTTP_RECORDING_MAGIC), 1, sHttpRecordFile);
+    fwrite(&HTTP_RECORDING_VERSION, sizeof(HTTP_RECORDING_VERSION), 1, sHttpRecordFile);
+    sHttpRecordStart = totalTime();
+
+    LL_INFOS("CoreHTTP") << "Recording HTTP results to " << filename << LL_ENDL;
+    return true;
+}
+
+/*static*/
+void HttpRecording::stopRecording()
+{
+    if (sHttpRecordFile)
+    {
+        LLFile::close(sHttpRecordFile);
+        sHttpRecordFile = NULL;
+    }
+}
+
+/*static*/
+bool HttpRecording::isRecording()
+{
+    return sHttpRecordFile != NULL;
+}
+
+/*static*/
+bool HttpRecording::startReplay(const std::string &filename)
+{
+    stopReplay();
+
+    LLFILE* file = LLFile::fopen(filename, "rb");        /* Flawfinder: ignore */
+    if (!file)
+    {
+        LL_WARNS("CoreHTTP") << "Unable to open HTTP recording " << filename << LL_ENDL;
+        return false;
+    }
+
+    char magic[sizeof(HTTP_RECORDING_MAGIC)];
+    U32 version = 0;
+    if (fread(magic, sizeof(magic), 1, file) != 1 ||
+        fread(&version, sizeof(version), 1, file) != 1 ||
+        memcmp(magic, HTTP_RECORDING_MAGIC, sizeof(magic)) ||
+        version != HTTP_RECORDING_VERSION)
+    {
+        LL_WARNS("CoreHTTP") << filename << " is not an HTTP recording" << LL_ENDL;
+        LLFile::close(file);
+        return false;
+    }
+
+    // the whole recording is read up front, requests can come in any order
+    U32 count = 0;
+    U64 time = 0;
+    U32 size = 0;
+    while (fread(&time, sizeof(time), 1, file) == 1 &&
+           fread(&size, sizeof(size), 1, file) == 1)
+    {
+        std::string data(size, '\0');
+        if (size == 0 || fread(&data[0], size, 1, file) != 1)
+        {
+            LL_WARNS("CoreHTTP") << filename << " is truncated" << LL_ENDL;
+            break;
+        }
+
+        LLSD entry;
+        std::istringstream istr(data);
+        if (LLSDSerialize::fromBinary(entry, istr, size) == LLSDParser::PARSE_FAILURE)
+        {
+            LL_WARNS("CoreHTTP") << filename << " holds a bad entry" << LL_ENDL;
+            break;
+        }
+
+        sHttpReplayResults[recording_key(entry["method"].asString(), entry["url"].asString())].push_back(entry["result"]);
+        ++count;
+    }
+    LLFile::close(file);
+
+    sHttpReplaying = true;
+    LL_INFOS("CoreHTTP") << "Replaying " << count << " HTTP results from " << filename << LL_ENDL;
+    return true;
+}
+
+/*static*/
+void HttpRecording::stopReplay()
+{
+    sHttpReplaying = false;
+    sHttpReplayResults.clear();
+}
+
+/*static*/
+bool HttpRecording::isReplaying()
+{
+    return sHttpReplaying;
+}
+
+/*static*/
+void HttpRecording::record(const std::string &method, const std::string &url, const LLSD &result)
+{
+    if (!sHttpRecordFile)
+    {
+        return;
+    }
+
+    LLSD entry = LLSD::emptyMap();
+    entry["method"] = method;
+    entry["url"] = url;
+    entry["result"] = result;
+
+    std::ostringstream ostr;
+    LLSDSerialize::toBinary(entry, ostr);
+    std::string data = ostr.str();
+
+    U64 time = totalTime() - sHttpRecordStart;
+    U32 size = (U32)data.size();
+    if (fwrite(&time, sizeof(time), 1, sHttpRecordFile) != 1 ||
+        fwrite(&size, sizeof(size), 1, sHttpRecordFile) != 1 ||
+        fwrite(data.data(), size, 1, sHttpRecordFile) != 1)
+    {
+        LL_WARNS("CoreHTTP") << "HTTP recording failed, stopping" << LL_ENDL;
+        stopRecording();
+    }
+}
+
+/*static*/
+bool HttpRecording::replay(const std::string &method, const std::string &url, LLSD &result)
+{
+    if (!sHttpReplaying)
+    {
+        return false;
+    }
+
+    std::map<std::string, std::deque<LLSD> >::iterator iter = sHttpReplayResults.find(recording_key(method, url));
+    if (iter == sHttpReplayResults.end() || iter->second.empty())
+    {
+        LL_DEBUGS("CoreHTTP") << "No recorded result for " << method << " " << url << LL_ENDL;
+
+        LLSD httpresults = LLSD::emptyMap();
+        HttpCoroHandler::writeStatusCodes(LLCore::HttpStatus(HTTP_NOT_FOUND, "Not in the HTTP recording"), url, httpresults);
+        result = LLSD::emptyMap();
+        result[HttpCoroutineAdapter::HTTP_RESULTS] = httpresults;
+        return true;
+    }
+
+    result = iter->second.front();
+    iter->second.pop_front();
+    return true;
+}
 
 } // end namespace LLCoreHttpUtil
 
@@ -297,6 +297,35 @@ private:
     LLEventStream &mReplyPump;
 };
 
+//=========================================================================
+/// Records the results HttpCoroutineAdapter requests return, and answers
+/// requests from such a recording instead of the network.  Results are kept
+/// per method and URL: a replayed request gets the next unused result
+/// recorded for the same method and URL, or a 404 when there is none left,
+/// so nothing goes out while replaying.  Together with LLPacketRing packet
+/// recording this lets a session be rerun without a grid.
+///
+/// Recording file layout, in host byte order: the magic and version, then
+/// for each result its time in usec since the recording started (U64), the
+/// size (U32) and a binary LLSD map of "method", "url" and "result".
+class HttpRecording
+{
+public:
+    static bool startRecording(const std::string &filename);
+    static void stopRecording();
+    static bool isRecording();
+
+    static bool startReplay(const std::string &filename);
+    static void stopReplay();
+    static bool isReplaying();
+
+    /// Add result to the recording, if there is one.
+    static void record(const std::string &method, const std::string &url, const LLSD &result);
+    /// If replaying, put the recorded result for method and url in result
+    /// and return true.
+    static bool replay(const std::string &method, const std::string &url, LLSD &result);
+};
+
 //=========================================================================
 /// An adapter to handle some of the boilerplate code surrounding HTTP and coroutine 
 /// interaction.
@@ -333,6 +362,12 @@ public:
         LLCore::HttpRequest::priority_t priority = 0L);
     ~HttpCoroutineAdapter();
 
+    /// When set, the methods that would parse an LLSD response body return
+    /// it unparsed in the HTTP_RESULTS_RAW entry instead, for callers that
+    /// read large bodies as a stream (see LLSDStreamHandler).  Error bodies
+    /// are still parsed as LLSD.
+    void setRawResponse(bool raw) { mRawResponse = raw; }
+
     /// Execute a Post transaction on the supplied URL and yield execution of 
     /// the coroutine until a result is available. 
     /// 
@@ -671,6 +706,7 @@ private:
     static void trivialPostCoro(std::string url, LLCore::HttpRequest::policy_t policyId, LLSD postData, completionCallback_t success, completionCallback_t failure);
 
     void checkDefaultHeaders(LLCore::HttpHeaders::ptr_t &headers);
+    HttpCoroHandler::ptr_t makeLLSDHandler(LLEventStream &replyPump) const;
 
     std::string                     mAdapterName;
     LLCore::HttpRequest::priority_t mPriority;
@@ -679,6 +715,7 @@ private:
     LLCore::HttpHandle              mYieldingHandle;
     LLCore::HttpRequest::wptr_t     mWeakRequest;
     HttpCoroHandler::wptr_t         mWeakHandler;
+    bool                            mRawResponse;
 };
 
 
@@ -37,12 +37,23 @@
 
 // linden library includes
 #include "llerror.h"
+#include "llframetimer.h"
 #include "lltimer.h"
 #include "llproxy.h"
 #include "llrand.h"
 #include "message.h"
 #include "u64.h"
 
+// Recording file layout, in host byte order: the magic and version, then
+// for each packet its arrival time in usec since the recording started (U64),
+// sender address and port (U32 each), size (U32) and data.
+static const char PACKET_RECORDING_MAGIC[4] = { 'L', 'L', 'P', 'R' };
+static const U32 PACKET_RECORDING_VERSION = 1;
+
+// Replayed objects get local IDs from here up, well clear of the ones
+// simulators hand out.
+static const U32 REPLAY_LOCAL_ID_BASE = 0xC0000000;
+
 ///////////////////////////////////////////////////////////
 LLPacketRing::LLPacketRing () :
 	mUseInThrottle(false),
@@ -55,7 +66,18 @@ LLPacketRing::LLPacketRing () :
 	mInBufferLength(0),
 	mOutBufferLength(0),
 	mDropPercentage(0.0f),
-	mPacketsToDrop(0x0)
+	mPacketsToDrop(0x0),
+	mLastPacketReplayed(false),
+	mRecordFile(NULL),
+	mRecordStart(0),
+	mOffline(false),
+	mReplayFile(NULL),
+	mReplaySpeed(1.f),
+	mReplayStart(0),
+	mReplayFirstTime(0),
+	mReplayNextTime(0),
+	mReplayNextSize(0),
+	mReplayNextLocalID(REPLAY_LOCAL_ID_BASE)
 {
 }
 
@@ -68,6 +90,9 @@ LLPacketRing::~LLPacketRing ()
 ///////////////////////////////////////////////////////////
 void LLPacketRing::cleanup ()
 {
+	stopRecording();
+	stopReplay();
+
 	LLPacketBuffer *packetp;
 
 	while (!mReceiveQueue.empty())
@@ -158,6 +183,22 @@ S32 LLPacketRing::receivePacket (S32 socket, char *datap)
 {
 	S32 packet_size = 0;
 
+	mLastPacketReplayed = false;
+	if (mReplayFile)
+	{
+		packet_size = receiveReplayPacket(datap);
+		if (packet_size)
+		{
+			mLastPacketReplayed = true;
+			return packet_size;
+		}
+	}
+
+	if (mOffline)
+	{
+		return 0;
+	}
+
 	// If using the throttle, simulate a limited size input buffer.
 	if (mUseInThrottle)
 	{
@@ -267,11 +308,186 @@ S32 LLPacketRing::receivePacket (S32 socket, char *datap)
 		}
 	}
 
+	if (packet_size > 0 && mRecordFile)
+	{
+		recordPacket(datap, packet_size);
+	}
+
 	return packet_size;
 }
 
+///////////////////////////////////////////////////////////
+bool LLPacketRing::startRecording(const std::string& filename)
+{
+	stopRecording();
+
+	mRecordFile = LLFile::fopen(filename, "wb");		/* Flawfinder: ignore */
+	if (!mRecordFile)
+	{
+		LL_WARNS("Messaging") << "Unable to open packet recording " << filename << LL_ENDL;
+		return false;
+	}
+
+	fwrite(PACKET_RECORDING_MAGIC, sizeof(PACKET_RECORDING_MAGIC), 1, mRecordFile);
+	fwrite(&PACKET_RECORDING_VERSION, sizeof(PACKET_RECORDING_VERSION), 1, mRecordFile);
+	mRecordStart = totalTime();
+
+	LL_INFOS("Messaging") << "Recording incoming packets to " << filename << LL_ENDL;
+	return true;
+}
+
+void LLPacketRing::stopRecording()
+{
+	if (mRecordFile)
+	{
+		LLFile::close(mRecordFile);
+		mRecordFile = NULL;
+	}
+}
+
+void LLPacketRing::recordPacket(const char* datap, S32 size)
+{
+	U64 time = totalTime() - mRecordStart;
+	U32 header[3] = { mLastSender.getAddress(), mLastSender.getPort(), (U32) size };
+
+	if (fwrite(&time, sizeof(time), 1, mRecordFile) != 1 ||
+		fwrite(header, sizeof(header), 1, mRecordFile) != 1 ||
+		fwrite(datap, size, 1, mRecordFile) != 1)
+	{
+		LL_WARNS("Messaging") << "Packet recording failed, stopping" << LL_ENDL;
+		stopRecording();
+	}
+}
+
+///////////////////////////////////////////////////////////
+bool LLPacketRing::startReplay(const std::string& filename, F32 speed, const LLHost& replay_host)
+{
+	stopReplay();
+
+	mReplayFile = LLFile::fopen(filename, "rb");		/* Flawfinder: ignore */
+	if (!mReplayFile)
+	{
+		LL_WARNS("Messaging") << "Unable to open packet recording " << filename << LL_ENDL;
+		return false;
+	}
+
+	char magic[sizeof(PACKET_RECORDING_MAGIC)];
+	U32 version = 0;
+	if (fread(magic, sizeof(magic), 1, mReplayFile) != 1 ||
+		fread(&version, sizeof(version), 1, mReplayFile) != 1 ||
+		memcmp(magic, PACKET_RECORDING_MAGIC, sizeof(magic)) ||
+		version != PACKET_RECORDING_VERSION)
+	{
+		LL_WARNS("Messaging") << filename << " is not a packet recording" << LL_ENDL;
+		stopReplay();
+		return false;
+	}
+
+	mReplaySpeed = llmax(speed, 0.f);
+	mReplayHost = replay_host;
+	mReplayStart = LLFrameTimer::getTotalTime();
+	mReplayLocalIDs.clear();
+	mReplayNextLocalID = REPLAY_LOCAL_ID_BASE;
+	mReplayIDMask.generate();
+	if (!readReplayPacket())
+	{
+		LL_WARNS("Messaging") << filename << " holds no packets" << LL_ENDL;
+		stopReplay();
+		return false;
+	}
+	mReplayFirstTime = mReplayNextTime;
+
+	LL_INFOS("Messaging") << "Replaying packets from " << filename << " at " << mReplaySpeed << "x" << LL_ENDL;
+	return true;
+}
+
+void LLPacketRing::stopReplay()
+{
+	if (mReplayFile)
+	{
+		LLFile::close(mReplayFile);
+		mReplayFile = NULL;
+	}
+}
+
+bool LLPacketRing::readReplayPacket()
+{
+	U64 time = 0;
+	U32 header[3];
+	if (fread(&time, sizeof(time), 1, mReplayFile) != 1 ||
+		fread(header, sizeof(header), 1, mReplayFile) != 1 ||
+		header[2] == 0 || header[2] > NET_BUFFER_SIZE ||
+		fread(mReplayNextData, header[2], 1, mReplayFile) != 1)
+	{
+		return false;
+	}
+
+	mReplayNextTime = time;
+	mReplayNextSender = LLHost(header[0], header[1]);
+	mReplayNextSize = (S32) header[2];
+	return true;
+}
+
+S32 LLPacketRing::receiveReplayPacket(char* datap)
+{
+	U64 elapsed = LLFrameTimer::getTotalTime() - mReplayStart;
+	if (mReplaySpeed > 0.f && (F64) elapsed * mReplaySpeed < (F64) (mReplayNextTime - mReplayFirstTime))
+	{
+		// not due yet
+		return 0;
+	}
+
+	S32 packet_size = mReplayNextSize;
+	memcpy(datap, mReplayNextData, packet_size);		/* Flawfinder: ignore */
+	mLastSender = mReplayHost.isOk() ? mReplayHost : mReplayNextSender;
+
+	// The recorded circuit already acked these, and their sequence numbers
+	// mean nothing to the live one.  Strip the appended acks and send the
+	// packet through as unreliable.  A malformed ack count is left for
+	// checkMessages() to reject.
+	if (datap[0] & LL_ACK_FLAG)
+	{
+		S32 acks = (U8) datap[packet_size - 1];
+		S32 stripped_size = packet_size - 1 - acks * (S32) sizeof(TPACKETID);
+		if (stripped_size >= (S32) LL_MINIMUM_VALID_PACKET_SIZE)
+		{
+			packet_size = stripped_size;
+			datap[0] &= ~LL_ACK_FLAG;
+		}
+	}
+	datap[0] &= ~(LL_RELIABLE_FLAG | LL_RESENT_FLAG);
+
+	if (!readReplayPacket())
+	{
+		LL_INFOS("Messaging") << "Packet replay finished" << LL_ENDL;
+		stopReplay();
+	}
+
+	return packet_size;
+}
+
+U32 LLPacketRing::remapReplayedLocalID(U32 local_id)
+{
+	if (!local_id)
+	{
+		return 0;
+	}
+
+	std::map<U32, U32>::iterator iter = mReplayLocalIDs.find(local_id);
+	if (iter == mReplayLocalIDs.end())
+	{
+		iter = mReplayLocalIDs.insert(std::make_pair(local_id, mReplayNextLocalID++)).first;
+	}
+	return iter->second;
+}
+
 bool LLPacketRing::sendPacket(int h_socket, char * send_buffer, S32 buf_size, LLHost host)
 {
+	if (mOffline)
+	{
+		return true;
+	}
+
 	bool status = true;
 	if (!mUseOutThrottle)
 	{
@@ -28,12 +28,15 @@
 #ifndef LL_LLPACKETRING_H
 #define LL_LLPACKETRING_H
 
+#include <map>
 #include <queue>
 
+#include "llfile.h"
 #include "llhost.h"
 #include "llpacketbuffer.h"
 #include "llproxy.h"
 #include "llthrottle.h"
+#include "lluuid.h"
 #include "net.h"
 
 class LLPacketRing
@@ -55,6 +58,38 @@ public:
 
 	bool sendPacket(int h_socket, char * send_buffer, S32 buf_size, LLHost host);
 
+	// Capture every packet received from the network, with its sender and
+	// arrival time, to filename until stopRecording().
+	bool startRecording(const std::string& filename);
+	void stopRecording();
+	bool isRecording() const					{ return mRecordFile != NULL; }
+
+	// Feed the packets of a recording back through receivePacket(),
+	// interleaved with live traffic, at speed times the recorded rate
+	// (0 for as fast as they are asked for).  Replay time runs on the
+	// LLFrameTimer clock and starts at the first recorded packet.
+	// If replay_host is valid every replayed packet appears to come from it
+	// instead of its recorded sender, and object IDs are remapped so they
+	// do not clash with the live session's.
+	// Replayed packets lose their reliable, resent and ack flags so they
+	// stay out of the live circuit's sequence and ack bookkeeping.
+	bool startReplay(const std::string& filename, F32 speed, const LLHost& replay_host);
+	void stopReplay();
+	bool isReplaying() const					{ return mReplayFile != NULL; }
+	bool isLastPacketReplayed() const			{ return mLastPacketReplayed; }
+	bool isReplayMixedWithLive() const			{ return mReplayHost.isOk(); }
+
+	// With no live session: receivePacket() only returns replayed packets
+	// and sendPacket() drops everything, reporting success.
+	void setOffline(bool offline)				{ mOffline = offline; }
+	bool isOffline() const						{ return mOffline; }
+
+	// Object local IDs and UUIDs of the recorded session, mapped to ones
+	// that cannot clash with the live session.  Zero and null map to
+	// themselves.
+	U32 remapReplayedLocalID(U32 local_id);
+	LLUUID remapReplayedID(const LLUUID& id) const	{ return id.isNull() ? id : id ^ mReplayIDMask; }
+
 	inline LLHost getLastSender();
 	inline LLHost getLastReceivingInterface();
 
@@ -82,9 +117,32 @@ protected:
 
 	LLHost mLastSender;
 	LLHost mLastReceivingIF;
+	bool mLastPacketReplayed;
+
+	LLFILE* mRecordFile;
+	U64 mRecordStart;				// usec
+
+	bool mOffline;
+
+	LLFILE* mReplayFile;
+	F32 mReplaySpeed;
+	LLHost mReplayHost;
+	U64 mReplayStart;				// LLFrameTimer usec
+	U64 mReplayFirstTime;			// usec since the start of the recording
+	U64 mReplayNextTime;			// usec since the start of the recording
+	LLHost mReplayNextSender;
+	S32 mReplayNextSize;
+	U8 mReplayNextData[NET_BUFFER_SIZE];
+	std::map<U32, U32> mReplayLocalIDs;
+	U32 mReplayNextLocalID;
+	LLUUID mReplayIDMask;
 
 private:
 	bool sendPacketImpl(int h_socket, const char * send_buffer, S32 buf_size, LLHost host);
+
+	void recordPacket(const char* datap, S32 size);
+	bool readReplayPacket();
+	S32 receiveReplayPacket(char* datap);
 };
 
 
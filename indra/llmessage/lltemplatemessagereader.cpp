@@ -718,6 +718,12 @@ bool LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
 			decode_timer.reset();
 		}
 
+		if (gMessageSystem->mPacketRing.isLastPacketReplayed() &&
+			gMessageSystem->mPacketRing.isReplayMixedWithLive())
+		{
+			remapReplayedObjectIDs(gMessageSystem->mPacketRing);
+		}
+
 		if( !mCurrentRMessageTemplate->callHandlerFunc(gMessageSystem) )
 		{
 			LL_WARNS() << "Message from " << sender << " with no handler function received: " << mCurrentRMessageTemplate->mName << LL_ENDL;
@@ -795,6 +801,118 @@ bool LLTemplateMessageReader::validateMessage(const U8* buffer,
 	return valid;
 }
 
+// Pointer to the data of varname in block, or NULL if it is missing or
+// shorter than min_size.
+static U8* replayed_var_data(LLMsgBlkData* block, const char* varname, S32 min_size)
+{
+	LLMsgBlkData::msg_var_data_map_t& var_data_map = block->mMemberVarData;
+	if (var_data_map.find(varname) == var_data_map.end())
+	{
+		return NULL;
+	}
+
+	LLMsgVarData& vardata = var_data_map[varname];
+	return vardata.getSize() >= min_size ? (U8*) vardata.getData() : NULL;
+}
+
+static void remap_replayed_local_id(LLPacketRing& ring, U8* datap)
+{
+	U32 local_id;
+	htolememcpy(&local_id, datap, MVT_U32, sizeof(U32));
+	local_id = ring.remapReplayedLocalID(local_id);
+	htolememcpy(datap, &local_id, MVT_U32, sizeof(U32));
+}
+
+static void remap_replayed_id(LLPacketRing& ring, U8* datap)
+{
+	LLUUID id;
+	memcpy(id.mData, datap, UUID_BYTES);		/* Flawfinder: ignore */
+	id = ring.remapReplayedID(id);
+	memcpy(datap, id.mData, UUID_BYTES);		/* Flawfinder: ignore */
+}
+
+// Object messages from a packet recording name objects by the local IDs
+// and UUIDs of the recorded session, which can belong to other objects, or
+// to the same objects under other local IDs, in the live one.  Rewrite them
+// in the decoded data before any handler sees them.
+void LLTemplateMessageReader::remapReplayedObjectIDs(LLPacketRing& ring)
+{
+	const char* name = mCurrentRMessageTemplate->mName;
+	if (name != _PREHASH_ObjectUpdate &&
+		name != _PREHASH_ObjectUpdateCompressed &&
+		name != _PREHASH_ObjectUpdateCached &&
+		name != _PREHASH_ImprovedTerseObjectUpdate &&
+		name != _PREHASH_KillObject)
+	{
+		return;
+	}
+
+	S32 blocks = getNumberOfBlocks(_PREHASH_ObjectData);
+	for (S32 i = 0; i < blocks; ++i)
+	{
+		LLMsgData::msg_blk_data_map_t::iterator iter =
+			mCurrentRMessageData->mMemberBlocks.find((char*) _PREHASH_ObjectData + i);
+		if (iter == mCurrentRMessageData->mMemberBlocks.end())
+		{
+			continue;
+		}
+		LLMsgBlkData* block = iter->second;
+
+		if (name == _PREHASH_ObjectUpdateCompressed)
+		{
+			// see LLViewerObject::initObjectDataMap() for the layout
+			const S32 LOCAL_ID_OFFSET = 16;
+			const S32 SPECIAL_CODE_OFFSET = 64;
+			const S32 OMEGA_OFFSET = 84;
+			U8* datap = replayed_var_data(block, _PREHASH_Data, SPECIAL_CODE_OFFSET + sizeof(U32));
+			if (datap)
+			{
+				remap_replayed_id(ring, datap);
+				remap_replayed_local_id(ring, datap + LOCAL_ID_OFFSET);
+
+				U32 special_code;
+				htolememcpy(&special_code, datap + SPECIAL_CODE_OFFSET, MVT_U32, sizeof(U32));
+				S32 parent_offset = OMEGA_OFFSET + ((special_code & 0x80) ? sizeof(LLVector3) : 0);
+				if ((special_code & 0x20) &&
+					replayed_var_data(block, _PREHASH_Data, parent_offset + sizeof(U32)))
+				{
+					remap_replayed_local_id(ring, datap + parent_offset);
+				}
+			}
+		}
+		else if (name == _PREHASH_ImprovedTerseObjectUpdate)
+		{
+			U8* datap = replayed_var_data(block, _PREHASH_Data, sizeof(U32));
+			if (datap)
+			{
+				remap_replayed_local_id(ring, datap);
+			}
+		}
+		else
+		{
+			U8* datap = replayed_var_data(block, _PREHASH_ID, sizeof(U32));
+			if (datap)
+			{
+				remap_replayed_local_id(ring, datap);
+			}
+
+			if (name == _PREHASH_ObjectUpdate)
+			{
+				datap = replayed_var_data(block, _PREHASH_ParentID, sizeof(U32));
+				if (datap)
+				{
+					remap_replayed_local_id(ring, datap);
+				}
+				datap = replayed_var_data(block, _PREHASH_FullID, UUID_BYTES);
+				if (datap)
+				{
+					remap_replayed_id(ring, datap);
+				}
+			}
+		}
+	}
+}
+
 bool LLTemplateMessageReader::readMessage(const U8* buffer,
 										  const LLHost& sender)
 {
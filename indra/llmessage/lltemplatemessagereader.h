@@ -33,6 +33,7 @@
 
 class LLMessageTemplate;
 class LLMsgData;
+class LLPacketRing;
 
 class LLTemplateMessageReader : public LLMessageReader
 {
@@ -120,6 +121,8 @@ private:
 
 	bool decodeData(const U8* buffer, const LLHost& sender );
 
+	void remapReplayedObjectIDs(LLPacketRing& ring);
+
 	S32	mReceiveSize;
 	LLMessageTemplate* mCurrentRMessageTemplate;
 	LLMsgData* mCurrentRMessageData;
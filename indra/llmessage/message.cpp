@@ -679,7 +679,7 @@ bool LLMessageSystem::checkMessages(LockMessageChecker&, S64 frame_count )
 
 			if( valid_packet )
 			{
-				logValidMsg(cdp, host, recv_reliable, recv_resent, (acks>0) );
+				logValidMsg(cdp, host, recv_reliable, recv_resent, (acks>0), mPacketRing.isLastPacketReplayed() );
 				valid_packet = mTemplateMessageReader->readMessage(buffer, host);
 			}
 
@@ -767,8 +767,12 @@ void LLMessageSystem::processAcks(LockMessageChecker&, F32 collect_time)
 
 	bool dump = false;
 	{
-		// Check the status of circuits
-		mCircuitInfo.updateWatchDogTimers(this);
+		// Check the status of circuits, unless they are replayed and
+		// cannot answer pings
+		if (!mPacketRing.isOffline())
+		{
+			mCircuitInfo.updateWatchDogTimers(this);
+		}
 
 		//resend any necessary packets
 		mCircuitInfo.resendUnackedPackets(mUnackedListDepth, mUnackedListSize);
@@ -1197,7 +1201,15 @@ S32 LLMessageSystem::sendMessage(const LLHost &host)
 					<< buffer_length << LL_ENDL;
 		}
 	}
-	if (mSendReliable)
+	if (mSendReliable && mPacketRing.isOffline())
+	{
+		// nothing will ever ack it, report it delivered
+		if (mReliablePacketParams.mCallback)
+		{
+			mReliablePacketParams.mCallback(mReliablePacketParams.mCallbackData, LL_ERR_NOERR);
+		}
+	}
+	else if (mSendReliable)
 	{
 		buf_ptr[0] |= LL_RELIABLE_FLAG;
 
@@ -1394,7 +1406,7 @@ void LLMessageSystem::logTrustedMsgFromUntrustedCircuit( const LLHost& host )
 	}
 }
 
-void LLMessageSystem::logValidMsg(LLCircuitData *cdp, const LLHost& host, bool recv_reliable, bool recv_resent, bool recv_acks )
+void LLMessageSystem::logValidMsg(LLCircuitData *cdp, const LLHost& host, bool recv_reliable, bool recv_resent, bool recv_acks, bool recv_replayed )
 {
 	if (mNumMessageCounts >= MAX_MESSAGE_COUNT_NUM)
 	{
@@ -1409,7 +1421,9 @@ void LLMessageSystem::logValidMsg(LLCircuitData *cdp, const LLHost& host, bool r
 		mNumMessageCounts++;
 	}
 
-	if (cdp)
+	// replayed packets carry the recorded circuit's packet IDs, keep them out
+	// of the live circuit's missing/out of order tracking and bandwidth
+	if (cdp && !recv_replayed)
 	{
 		// update circuit packet ID tracking (missing/out of order packets)
 		cdp->checkPacketInID( mCurrentRecvPacketID, recv_resent );
@@ -1426,7 +1440,8 @@ void LLMessageSystem::logValidMsg(LLCircuitData *cdp, const LLHost& host, bool r
 			<< nullToEmpty(mMessageReader->getMessageName())
 			<< (recv_reliable ? " reliable" : "")
 			<< (recv_resent ? " resent" : "")
-			<< (recv_acks ? " acks" : "");
+			<< (recv_acks ? " acks" : "")
+			<< (recv_replayed ? " replayed" : "");
 		LL_INFOS("Messaging") << str.str() << LL_ENDL;
 	}
 }
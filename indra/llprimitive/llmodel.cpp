@@ -1601,6 +1601,7 @@ U32 LLMeshSkinInfo::sizeBytes() const
     res += sizeof(std::vector<LLMatrix4>) + 16 * sizeof(float) * mAlternateBindMatrix.size();
     res += 16 * sizeof(float); //mBindShapeMatrix
     res += sizeof(float) + 3 * sizeof(bool);
+    res += sizeof(rigging_info_list_t) + sizeof(LLJointRiggingInfo) * mJointRiggingInfo.size();
 
     return res;
 }
@@ -69,6 +69,14 @@ public:
     bool mInvalidJointsScrubbed;
     bool mJointNumsInitialized;
     U64 mHash = 0;
+
+    // Per skin joint, whether the mesh is rigged to it and the weighted
+    // bounds of its vertices in joint space, from the highest LOD seen so
+    // far (mRiggingInfoLOD, -1 for none).  Computed once for the mesh and
+    // shared by every object wearing it, see LLSkinningUtil::updateRiggingInfo().
+    typedef std::vector<LLJointRiggingInfo, boost::alignment::aligned_allocator<LLJointRiggingInfo, 16>> rigging_info_list_t;
+    mutable rigging_info_list_t mJointRiggingInfo;
+    mutable S32 mRiggingInfoLOD = -1;
 } LL_ALIGN_POSTFIX(16);
 
 LL_ALIGN_PREFIX(16)
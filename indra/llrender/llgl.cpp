@@ -202,6 +202,12 @@ PFNGLISVERTEXARRAYPROC glIsVertexArray = NULL;
 PFNGLMAPBUFFERRANGEPROC			glMapBufferRange = NULL;
 PFNGLFLUSHMAPPEDBUFFERRANGEPROC	glFlushMappedBufferRange = NULL;
 
+// GL_ARB_buffer_storage
+PFNGLBUFFERSTORAGEPROC			glBufferStorage = NULL;
+
+// GL 1.4
+PFNGLMULTIDRAWELEMENTSPROC		glMultiDrawElements = NULL;
+
 // GL_ARB_sync
 PFNGLFENCESYNCPROC				glFenceSync = NULL;
 PFNGLISSYNCPROC					glIsSync = NULL;
@@ -269,6 +275,12 @@ PFNGLTRANSFORMFEEDBACKVARYINGSPROC glTransformFeedbackVaryings = NULL;
 PFNGLBINDBUFFERRANGEPROC glBindBufferRange = NULL;
 PFNGLBINDBUFFERBASEPROC glBindBufferBase = NULL;
 
+//GL_ARB_get_program_binary
+PFNGLGETPROGRAMBINARYPROC glGetProgramBinary = NULL;
+PFNGLPROGRAMBINARYPROC glProgramBinary = NULL;
+PFNGLPROGRAMPARAMETERIPROC glProgramParameteri = NULL;
+PFNGLGETPROGRAMIVPROC glGetProgramiv = NULL;
+
 //GL_ARB_debug_output
 PFNGLDEBUGMESSAGECONTROLARBPROC glDebugMessageControlARB = NULL;
 PFNGLDEBUGMESSAGEINSERTARBPROC glDebugMessageInsertARB = NULL;
@@ -367,6 +379,8 @@ LLGLManager::LLGLManager() :
 	mHasVertexBufferObject(false),
 	mHasVertexArrayObject(false),
 	mHasMapBufferRange(false),
+	mHasBufferStorage(false),
+	mHasMultiDrawElements(false),
 	mHasFlushBufferRange(false),
 	mHasPBuffer(false),
 	mNumTextureImageUnits(0),
@@ -378,6 +392,7 @@ LLGLManager::LLGLManager() :
 	mHasTextureRectangle(false),
 	mHasTextureMultisample(false),
 	mHasTransformFeedback(false),
+	mHasProgramBinary(false),
 	mMaxSampleMaskWords(0),
 	mMaxColorTextureSamples(0),
 	mMaxDepthTextureSamples(0),
@@ -877,6 +892,8 @@ void LLGLManager::asLLSD(LLSD& info)
 	info["has_vertex_array_object"] = mHasVertexArrayObject;
 	info["has_sync"] = mHasSync;
 	info["has_map_buffer_range"] = mHasMapBufferRange;
+	info["has_buffer_storage"] = mHasBufferStorage;
+	info["has_multi_draw_elements"] = mHasMultiDrawElements;
 	info["has_flush_buffer_range"] = mHasFlushBufferRange;
 	info["has_pbuffer"] = mHasPBuffer;
     info["has_shader_objects"] = std::string("Assumed TRUE");   // was mHasShaderObjects;
@@ -892,6 +909,7 @@ void LLGLManager::asLLSD(LLSD& info)
 	info["has_texture_rectangle"] = mHasTextureRectangle;
 	info["has_texture_multisample"] = mHasTextureMultisample;
 	info["has_transform_feedback"] = mHasTransformFeedback;
+	info["has_program_binary"] = mHasProgramBinary;
 	info["max_sample_mask_words"] = mMaxSampleMaskWords;
 	info["max_color_texture_samples"] = mMaxColorTextureSamples;
 	info["max_depth_texture_samples"] = mMaxDepthTextureSamples;
@@ -1004,7 +1022,11 @@ void LLGLManager::initExtensions()
 #endif
 	mHasSync = ExtensionExists("GL_ARB_sync", gGLHExts.mSysExts);
 	mHasMapBufferRange = ExtensionExists("GL_ARB_map_buffer_range", gGLHExts.mSysExts);
+#if !LL_DARWIN
+	mHasBufferStorage = ExtensionExists("GL_ARB_buffer_storage", gGLHExts.mSysExts);
+#endif
 	mHasFlushBufferRange = ExtensionExists("GL_APPLE_flush_buffer_range", gGLHExts.mSysExts);
+	mHasMultiDrawElements = mGLVersion >= 1.4f;
     // NOTE: Using extensions breaks reflections when Shadows are set to projector.  See: SL-16727
     //mHasDepthClamp = ExtensionExists("GL_ARB_depth_clamp", gGLHExts.mSysExts) || ExtensionExists("GL_NV_depth_clamp", gGLHExts.mSysExts);
     mHasDepthClamp = false;
@@ -1041,6 +1063,10 @@ void LLGLManager::initExtensions()
 	mHasTextureMultisample = ExtensionExists("GL_ARB_texture_multisample", gGLHExts.mSysExts);
 	mHasDebugOutput = ExtensionExists("GL_ARB_debug_output", gGLHExts.mSysExts);
 	mHasTransformFeedback = mGLVersion >= 4.f;
+#if !LL_DARWIN
+	// the legacy profile used on OS X does not expose program binaries
+	mHasProgramBinary = ExtensionExists("GL_ARB_get_program_binary", gGLHExts.mSysExts);
+#endif
 #if !LL_DARWIN
 	mHasPointParameters = ExtensionExists("GL_ARB_point_parameters", gGLHExts.mSysExts);
 #endif
@@ -1148,6 +1174,11 @@ void LLGLManager::initExtensions()
 		glMapBufferRange = (PFNGLMAPBUFFERRANGEPROC) GLH_EXT_GET_PROC_ADDRESS("glMapBufferRange");
 		glFlushMappedBufferRange = (PFNGLFLUSHMAPPEDBUFFERRANGEPROC) GLH_EXT_GET_PROC_ADDRESS("glFlushMappedBufferRange");
 	}
+	if (mHasBufferStorage)
+	{
+		glBufferStorage = (PFNGLBUFFERSTORAGEPROC) GLH_EXT_GET_PROC_ADDRESS("glBufferStorage");
+		mHasBufferStorage = glBufferStorage && mHasMapBufferRange;
+	}
 	if (mHasFramebufferObject)
 	{
 		LL_INFOS() << "initExtensions() FramebufferObject-related procs..." << LL_ENDL;
@@ -1195,6 +1226,14 @@ void LLGLManager::initExtensions()
 		glBindBufferRange = (PFNGLBINDBUFFERRANGEPROC) GLH_EXT_GET_PROC_ADDRESS("glBindBufferRange");
 		glBindBufferBase = (PFNGLBINDBUFFERBASEPROC) GLH_EXT_GET_PROC_ADDRESS("glBindBufferBase");
 	}
+	if (mHasProgramBinary)
+	{
+		glGetProgramBinary = (PFNGLGETPROGRAMBINARYPROC) GLH_EXT_GET_PROC_ADDRESS("glGetProgramBinary");
+		glProgramBinary = (PFNGLPROGRAMBINARYPROC) GLH_EXT_GET_PROC_ADDRESS("glProgramBinary");
+		glProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC) GLH_EXT_GET_PROC_ADDRESS("glProgramParameteri");
+		glGetProgramiv = (PFNGLGETPROGRAMIVPROC) GLH_EXT_GET_PROC_ADDRESS("glGetProgramiv");
+		mHasProgramBinary = glGetProgramBinary && glProgramBinary && glProgramParameteri && glGetProgramiv;
+	}
 	if (mHasDebugOutput)
 	{
 		glDebugMessageControlARB = (PFNGLDEBUGMESSAGECONTROLARBPROC) GLH_EXT_GET_PROC_ADDRESS("glDebugMessageControlARB");
@@ -1210,6 +1249,12 @@ void LLGLManager::initExtensions()
 		mGLMaxIndexRange = 0;
 	}
 
+	if (mHasMultiDrawElements)
+	{
+		glMultiDrawElements = (PFNGLMULTIDRAWELEMENTSPROC)GLH_EXT_GET_PROC_ADDRESS("glMultiDrawElements");
+		mHasMultiDrawElements = glMultiDrawElements != NULL;
+	}
+
 	if (mHasOcclusionQuery)
 	{
 		LL_INFOS() << "initExtensions() OcclusionQuery-related procs..." << LL_ENDL;
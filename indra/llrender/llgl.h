@@ -94,6 +94,8 @@ public:
 	bool mHasVertexArrayObject;
 	bool mHasSync;
 	bool mHasMapBufferRange;
+	bool mHasBufferStorage;
+	bool mHasMultiDrawElements;
 	bool mHasFlushBufferRange;
 	bool mHasPBuffer;
 	S32  mNumTextureImageUnits;
@@ -106,6 +108,7 @@ public:
 	bool mHasTextureRectangle;
 	bool mHasTextureMultisample;
 	bool mHasTransformFeedback;
+	bool mHasProgramBinary;
 	S32 mMaxSampleMaskWords;
 	S32 mMaxColorTextureSamples;
 	S32 mMaxDepthTextureSamples;
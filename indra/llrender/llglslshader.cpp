@@ -32,6 +32,7 @@
 #include "llfile.h"
 #include "llrender.h"
 #include "llvertexbuffer.h"
+#include "lltimer.h"
 
 #if LL_DARWIN
 #include "OpenGL/OpenGL.h"
@@ -316,7 +317,8 @@ LLGLSLShader::LLGLSLShader()
       mShaderGroup(SG_DEFAULT), 
       mUniformsDirty(false),
       mTimerQuery(0),
-      mSamplesQuery(0)
+      mSamplesQuery(0),
+      mLoadedFromCache(false)
 
 {
     
@@ -417,11 +419,26 @@ bool LLGLSLShader::createShader(std::vector<LLStaticHashedString> * attributes,
     fprintf(stderr, "--- %s ---\n", mName.c_str());
 #endif // DEBUG_SHADER_INCLUDES
 
+    LLTimer build_timer;
+
+    // attachShaderFeatures may change the number of indexed texture channels,
+    // but the source files are built with the value requested by the caller
+    S32 texture_index_channels = mFeatures.mIndexedTextureChannels;
+
+    // Attach existing objects first so the program cache key can cover them
+    mFeatureObjects.clear();
+    if (!LLShaderMgr::instance()->attachShaderFeatures(this))
+    {
+        return false;
+    }
+
+    mLoadedFromCache = LLShaderMgr::instance()->loadCachedProgramBinary(this, texture_index_channels);
+
     //compile new source
     vector< pair<string,GLenum> >::iterator fileIter = mShaderFiles.begin();
-    for ( ; fileIter != mShaderFiles.end(); fileIter++ )
+    for ( ; fileIter != mShaderFiles.end() && !mLoadedFromCache; fileIter++ )
     {
-        GLhandleARB shaderhandle = LLShaderMgr::instance()->loadShaderFile((*fileIter).first, mShaderLevel, (*fileIter).second, &mDefines, mFeatures.mIndexedTextureChannels);
+        GLhandleARB shaderhandle = LLShaderMgr::instance()->loadShaderFile((*fileIter).first, mShaderLevel, (*fileIter).second, &mDefines, texture_index_channels);
         LL_DEBUGS("ShaderLoading") << "SHADER FILE: " << (*fileIter).first << " mShaderLevel=" << mShaderLevel << LL_ENDL;
         if (shaderhandle)
         {
@@ -434,12 +451,6 @@ bool LLGLSLShader::createShader(std::vector<LLStaticHashedString> * attributes,
         }
     }
 
-    // Attach existing objects
-    if (!LLShaderMgr::instance()->attachShaderFeatures(this))
-    {
-        return false;
-    }
-
     if (gGLManager.mGLSLVersionMajor < 2 && gGLManager.mGLSLVersionMinor < 3)
     { //indexed texture rendering requires GLSL 1.3 or later
         //attachShaderFeatures may have set the number of indexed texture channels, so set to 1 again
@@ -460,6 +471,10 @@ bool LLGLSLShader::createShader(std::vector<LLStaticHashedString> * attributes,
     {
         success = mapAttributes(attributes);
     }
+    if (success && !mLoadedFromCache)
+    {
+        LLShaderMgr::instance()->saveCachedProgramBinary(this, build_timer.getElapsedTimeF32());
+    }
     if (success)
     {
         success = mapUniforms(uniforms);
@@ -530,6 +545,7 @@ bool LLGLSLShader::attachVertexObject(std::string object_path)
     {
         stop_glerror();
         glAttachObjectARB(mProgramObject, LLShaderMgr::instance()->mVertexShaderObjects[object_path]);
+        mFeatureObjects.push_back(make_pair(object_path, GL_VERTEX_SHADER_ARB));
 #if DEBUG_SHADER_INCLUDES
         dumpAttachObject("attachVertexObject", mProgramObject, object_path);
 #endif // DEBUG_SHADER_INCLUDES
@@ -549,6 +565,7 @@ bool LLGLSLShader::attachFragmentObject(std::string object_path)
     {
         stop_glerror();
         glAttachObjectARB(mProgramObject, LLShaderMgr::instance()->mFragmentShaderObjects[object_path]);
+        mFeatureObjects.push_back(make_pair(object_path, GL_FRAGMENT_SHADER_ARB));
 #if DEBUG_SHADER_INCLUDES
         dumpAttachObject("attachFragmentObject", mProgramObject, object_path);
 #endif // DEBUG_SHADER_INCLUDES
@@ -590,15 +607,20 @@ void LLGLSLShader::attachObjects(GLhandleARB* objects, S32 count)
 
 bool LLGLSLShader::mapAttributes(const std::vector<LLStaticHashedString> * attributes)
 {
-    //before linking, make sure reserved attributes always have consistent locations
-    for (U32 i = 0; i < LLShaderMgr::instance()->mReservedAttribs.size(); i++)
+    bool res = true;
+    if (!mLoadedFromCache)
     {
-        const char* name = LLShaderMgr::instance()->mReservedAttribs[i].c_str();
-        glBindAttribLocationARB(mProgramObject, i, (const GLcharARB *) name);
+        //before linking, make sure reserved attributes always have consistent locations
+        for (U32 i = 0; i < LLShaderMgr::instance()->mReservedAttribs.size(); i++)
+        {
+            const char* name = LLShaderMgr::instance()->mReservedAttribs[i].c_str();
+            glBindAttribLocationARB(mProgramObject, i, (const GLcharARB *) name);
+        }
+
+        //link the program
+        res = link();
     }
-    
-    //link the program
-    bool res = link();
+    //else the cached binary was linked with the same locations
 
     mAttribute.clear();
     U32 numAttributes = (attributes == NULL) ? 0 : attributes->size();
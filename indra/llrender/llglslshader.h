@@ -267,6 +267,7 @@ public:
 	bool mUniformsDirty;
 	LLShaderFeatures mFeatures;
 	std::vector< std::pair< std::string, GLenum > > mShaderFiles;
+	std::vector< std::pair< std::string, GLenum > > mFeatureObjects; // shared objects attached by attachShaderFeatures
 	std::string mName;
     typedef std::unordered_map<std::string, std::string> defines_map_t;
 	defines_map_t mDefines;
@@ -287,6 +288,9 @@ public:
 	std::vector<U32> mTextureMagFilter;
 	std::vector<U32> mTextureMinFilter;
 
+	std::string mProgramCacheKey; // empty when the program binary cache is not in use
+	bool mLoadedFromCache;
+
     // this pointer should be set to whichever shader represents this shader's rigged variant
     LLGLSLShader* mRiggedVariant = nullptr;
 
@@ -1663,24 +1663,26 @@ void LLRender::flush()
 
         if (mBuffer)
         {
-            if (mBuffer->useVBOs() && !mBuffer->isLocked())
-            { //hack to only flush the part of the buffer that was updated (relies on stream draw using buffersubdata)
-                mBuffer->getVertexStrider(mVerticesp, 0, count);
-                mBuffer->getTexCoord0Strider(mTexcoordsp, 0, count);
-                mBuffer->getColorStrider(mColorsp, 0, count);
-            }
-
-            mBuffer->flush();
-            mBuffer->setBuffer(immediate_mask);
-
+            U32 mode = mMode;
             if (mMode == LLRender::QUADS && sGLCoreProfile)
             {
-                mBuffer->drawArrays(LLRender::TRIANGLES, 0, count);
+                mode = LLRender::TRIANGLES;
                 mQuadCycle = 1;
             }
-            else
+
+            //the vertices are rewritten before every flush, so they can go through the stream ring
+            if (!mBuffer->drawArraysStreamed(mode, immediate_mask, count))
             {
-                mBuffer->drawArrays(mMode, 0, count);
+                if (mBuffer->useVBOs() && !mBuffer->isLocked())
+                { //hack to only flush the part of the buffer that was updated (relies on stream draw using buffersubdata)
+                    mBuffer->getVertexStrider(mVerticesp, 0, count);
+                    mBuffer->getTexCoord0Strider(mTexcoordsp, 0, count);
+                    mBuffer->getColorStrider(mColorsp, 0, count);
+                }
+
+                mBuffer->flush();
+                mBuffer->setBuffer(immediate_mask);
+                mBuffer->drawArrays(mode, 0, count);
             }
         }
         else
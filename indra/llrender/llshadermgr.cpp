@@ -28,6 +28,9 @@
 #include "llshadermgr.h"
 #include "llrender.h"
 #include "llfile.h"
+#include "lldir.h"
+#include "llmd5.h"
+#include "lltimer.h"
 
 #if LL_DARWIN
 #include "OpenGL/OpenGL.h"
@@ -42,6 +45,10 @@ using std::string;
 LLShaderMgr * LLShaderMgr::sInstance = NULL;
 
 LLShaderMgr::LLShaderMgr()
+:	mShaderCacheEnabled(false),
+	mShaderCacheHits(0),
+	mShaderCacheMisses(0),
+	mShaderCacheSecondsSaved(0.f)
 {
 }
 
@@ -1018,6 +1025,21 @@ GLhandleARB LLShaderMgr::loadShaderFile(const std::string& filename, S32 & shade
 	}
 	stop_glerror();
 
+	//remember what was compiled so linked programs can be cached
+	std::string source_hash;
+	if (ret)
+	{
+		LLMD5 md5;
+		for (GLuint i = 0; i < shader_code_count; i++)
+		{
+			md5.update((const uint8_t*) shader_code_text[i], strlen(shader_code_text[i]));
+		}
+		md5.finalize();
+		char digest[33];
+		md5.hex_digest(digest);
+		source_hash = digest;
+	}
+
 	//free memory
 	for (GLuint i = 0; i < shader_code_count; i++)
 	{
@@ -1030,9 +1052,11 @@ GLhandleARB LLShaderMgr::loadShaderFile(const std::string& filename, S32 & shade
 		// Add shader file to map
         if (type == GL_VERTEX_SHADER_ARB) {
             mVertexShaderObjects[filename] = ret;
+            mVertexShaderHashes[filename] = source_hash;
         }
         else if (type == GL_FRAGMENT_SHADER_ARB) {
             mFragmentShaderObjects[filename] = ret;
+            mFragmentShaderHashes[filename] = source_hash;
         }
 		shader_level = try_gpu_class;
 	}
@@ -1090,6 +1114,289 @@ bool LLShaderMgr::validateProgramObject(GLhandleARB obj)
 	return success;
 }
 
+// Header written in front of every cached program binary
+struct LLProgramBinaryHeader
+{
+	U32 mMagic;
+	U32 mVersion;
+	U32 mFormat;
+	U32 mSize;
+	S32 mShaderLevel;
+	F32 mBuildSeconds;
+};
+
+static const U32 PROGRAM_BINARY_MAGIC = 0x4250474c; // "LGPB"
+// Bump when anything that goes into building a program changes in code
+// rather than in the shader sources, to invalidate existing caches.
+static const U32 PROGRAM_BINARY_VERSION = 1;
+static const U32 PROGRAM_BINARY_MAX_SIZE = 64 * 1024 * 1024;
+
+static std::string get_gl_identity()
+{
+	return gGLManager.mGLVendor + "\n" + gGLManager.mGLRenderer + "\n" +
+		gGLManager.mGLVersionString + "\n" + gGLManager.mDriverVersionVendorString + "\n";
+}
+
+void LLShaderMgr::initShaderCache(bool enabled, const std::string& cache_dir)
+{
+	mShaderCacheEnabled = false;
+	mShaderCacheDir = cache_dir;
+	mShaderCacheHits = 0;
+	mShaderCacheMisses = 0;
+	mShaderCacheSecondsSaved = 0.f;
+
+	if (!enabled || cache_dir.empty())
+	{
+		return;
+	}
+
+	if (!gGLManager.mHasProgramBinary)
+	{
+		LL_INFOS("ShaderLoading") << "Program binaries not supported, shader cache disabled" << LL_ENDL;
+		return;
+	}
+
+	LLFile::mkdir(mShaderCacheDir);
+
+	// Binaries are only valid for the driver that produced them.  Their keys
+	// already cover the driver, so this just stops stale entries piling up.
+	std::string identity = get_gl_identity();
+	std::string identity_file = mShaderCacheDir + gDirUtilp->getDirDelimiter() + "driver.txt";
+	std::string cached_identity;
+	llifstream in(identity_file.c_str());
+	if (in.is_open())
+	{
+		std::stringstream buffer;
+		buffer << in.rdbuf();
+		cached_identity = buffer.str();
+		in.close();
+	}
+
+	if (cached_identity != identity)
+	{
+		clearShaderCache();
+		llofstream out(identity_file.c_str());
+		if (!out.is_open())
+		{
+			LL_WARNS("ShaderLoading") << "Unable to write " << identity_file << ", shader cache disabled" << LL_ENDL;
+			return;
+		}
+		out << identity;
+		out.close();
+	}
+
+	mShaderCacheEnabled = true;
+}
+
+void LLShaderMgr::clearShaderCache()
+{
+	if (!mShaderCacheDir.empty())
+	{
+		S32 count = gDirUtilp->deleteFilesInDir(mShaderCacheDir, "*.bin");
+		LL_INFOS("ShaderLoading") << "Removed " << count << " cached shader programs" << LL_ENDL;
+	}
+}
+
+std::string LLShaderMgr::getShaderSourcePath(const std::string& filename, S32 shader_level)
+{
+	//same search order as loadShaderFile
+	for (S32 gpu_class = shader_level; gpu_class > 0; gpu_class--)
+	{
+		std::stringstream fname;
+		fname << getShaderDirPrefix();
+		fname << gpu_class << "/" << filename;
+		if (LLFile::isfile(fname.str()))
+		{
+			return fname.str();
+		}
+	}
+	return std::string();
+}
+
+std::string LLShaderMgr::getProgramCacheKey(LLGLSLShader* shader, S32 texture_index_channels)
+{
+	LLMD5 md5;
+	std::stringstream inputs;
+	inputs << PROGRAM_BINARY_VERSION << "\n" << get_gl_identity();
+	inputs << shader->mName << "\n" << shader->mShaderLevel << "\n";
+
+	const LLShaderFeatures& features = shader->mFeatures;
+	inputs << features.atmosphericHelpers << features.calculatesLighting << features.calculatesAtmospherics
+		<< features.hasLighting << features.isAlphaLighting << features.isShiny << features.isFullbright
+		<< features.isSpecular << features.hasWaterFog << features.hasTransport << features.hasSkinning
+		<< features.hasObjectSkinning << features.hasAtmospherics << features.hasGamma << features.hasShadows
+		<< features.hasAmbientOcclusion << features.hasSrgb << features.encodesNormal << features.isDeferred
+		<< features.hasIndirect << features.disableTextureIndex << features.hasAlphaMask << features.attachNothing
+		<< "\n" << texture_index_channels << " " << features.mIndexedTextureChannels << "\n";
+
+	//defines are unordered, sort them so the key is stable
+	std::map<std::string, std::string> defines(shader->mDefines.begin(), shader->mDefines.end());
+	for (std::map<std::string, std::string>::iterator iter = defines.begin(); iter != defines.end(); ++iter)
+	{
+		inputs << "#define " << iter->first << " " << iter->second << "\n";
+	}
+	for (std::map<std::string, std::string>::iterator iter = mDefinitions.begin(); iter != mDefinitions.end(); ++iter)
+	{
+		inputs << "#define " << iter->first << " " << iter->second << "\n";
+	}
+
+	for (U32 i = 0; i < shader->mFeatureObjects.size(); ++i)
+	{
+		const std::string& name = shader->mFeatureObjects[i].first;
+		std::map<std::string, std::string>& hashes = shader->mFeatureObjects[i].second == GL_VERTEX_SHADER_ARB ? mVertexShaderHashes : mFragmentShaderHashes;
+		inputs << name << " " << hashes[name] << "\n";
+	}
+	md5.update(inputs.str());
+
+	for (U32 i = 0; i < shader->mShaderFiles.size(); ++i)
+	{
+		const std::string& name = shader->mShaderFiles[i].first;
+		std::string path = getShaderSourcePath(name, shader->mShaderLevel);
+		md5.update(llformat("%s %d\n", name.c_str(), shader->mShaderFiles[i].second));
+		LLFILE* file = path.empty() ? NULL : LLFile::fopen(path, "rb");
+		if (file)
+		{
+			md5.update(file);	// closes the file
+		}
+	}
+
+	md5.finalize();
+	char digest[33];
+	md5.hex_digest(digest);
+	return std::string(digest);
+}
+
+std::string LLShaderMgr::getProgramCacheFilename(const std::string& key)
+{
+	return mShaderCacheDir + gDirUtilp->getDirDelimiter() + key + ".bin";
+}
+
+bool LLShaderMgr::loadCachedProgramBinary(LLGLSLShader* shader, S32 texture_index_channels)
+{
+	shader->mProgramCacheKey.clear();
+#if LL_DARWIN
+	// The OS X GL headers have no program binary entry points, and
+	// LLGLManager never reports them, so the cache is never enabled there.
+	return false;
+#else
+	if (!mShaderCacheEnabled)
+	{
+		return false;
+	}
+
+	LLTimer load_timer;
+	shader->mProgramCacheKey = getProgramCacheKey(shader, texture_index_channels);
+	std::string filename = getProgramCacheFilename(shader->mProgramCacheKey);
+
+	bool loaded = false;
+	LLProgramBinaryHeader header;
+	LLFILE* file = LLFile::fopen(filename, "rb");
+	if (file)
+	{
+		if (fread(&header, sizeof(header), 1, file) == 1 &&
+			header.mMagic == PROGRAM_BINARY_MAGIC &&
+			header.mVersion == PROGRAM_BINARY_VERSION &&
+			header.mSize > 0 && header.mSize <= PROGRAM_BINARY_MAX_SIZE)
+		{
+			std::vector<U8> data(header.mSize);
+			if (fread(&data[0], 1, header.mSize, file) == header.mSize)
+			{
+				glProgramBinary(shader->mProgramObject, header.mFormat, &data[0], header.mSize);
+				GLint success = GL_FALSE;
+				glGetObjectParameterivARB(shader->mProgramObject, GL_OBJECT_LINK_STATUS_ARB, &success);
+				loaded = success == GL_TRUE;
+			}
+		}
+		fclose(file);
+
+		if (!loaded)
+		{	//corrupt, or rejected by a driver that did not change its version strings
+			LL_DEBUGS("ShaderLoading") << "Discarding cached program for " << shader->mName << LL_ENDL;
+			LLFile::remove(filename);
+		}
+	}
+	//a rejected binary may raise an error, don't let it leak into the build
+	glGetError();
+
+	if (loaded)
+	{
+		shader->mShaderLevel = header.mShaderLevel;
+		mShaderCacheHits++;
+		mShaderCacheSecondsSaved += llmax(header.mBuildSeconds - load_timer.getElapsedTimeF32(), 0.f);
+		LL_DEBUGS("ShaderLoading") << "Loaded cached program for " << shader->mName << LL_ENDL;
+	}
+	else
+	{
+		mShaderCacheMisses++;
+		glProgramParameteri(shader->mProgramObject, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		stop_glerror();
+	}
+	return loaded;
+#endif // LL_DARWIN
+}
+
+void LLShaderMgr::saveCachedProgramBinary(LLGLSLShader* shader, F32 build_seconds)
+{
+#if !LL_DARWIN
+	if (!mShaderCacheEnabled || shader->mProgramCacheKey.empty())
+	{
+		return;
+	}
+
+	GLint size = 0;
+	glGetProgramiv(shader->mProgramObject, GL_PROGRAM_BINARY_LENGTH, &size);
+	if (size <= 0 || (U32) size > PROGRAM_BINARY_MAX_SIZE)
+	{
+		glGetError();
+		return;
+	}
+
+	std::vector<U8> data(size);
+	GLsizei length = 0;
+	GLenum format = 0;
+	glGetProgramBinary(shader->mProgramObject, size, &length, &format, &data[0]);
+	if (glGetError() != GL_NO_ERROR || length <= 0)
+	{
+		return;
+	}
+
+	LLProgramBinaryHeader header;
+	header.mMagic = PROGRAM_BINARY_MAGIC;
+	header.mVersion = PROGRAM_BINARY_VERSION;
+	header.mFormat = format;
+	header.mSize = length;
+	header.mShaderLevel = shader->mShaderLevel;
+	header.mBuildSeconds = build_seconds;
+
+	//write to a temporary name so a crash never leaves a truncated entry
+	std::string filename = getProgramCacheFilename(shader->mProgramCacheKey);
+	std::string temp_filename = filename + ".tmp";
+	LLFILE* file = LLFile::fopen(temp_filename, "wb");
+	if (!file)
+	{
+		return;
+	}
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+		fwrite(&data[0], 1, length, file) == (size_t) length;
+	fclose(file);
+
+	LLFile::remove(filename, ENOENT);
+	if (!written || LLFile::rename(temp_filename, filename) != 0)
+	{
+		LLFile::remove(temp_filename);
+	}
+#endif // !LL_DARWIN
+}
+
+void LLShaderMgr::logShaderCacheStats()
+{
+	if (mShaderCacheEnabled)
+	{
+		LL_INFOS("ShaderLoading") << "Shader cache: " << mShaderCacheHits << " hits, " << mShaderCacheMisses
+			<< " misses, " << mShaderCacheSecondsSaved << " seconds saved" << LL_ENDL;
+	}
+}
+
 //virtual
 void LLShaderMgr::initAttribsAndUniforms()
 {
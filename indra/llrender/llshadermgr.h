@@ -266,6 +266,18 @@ public:
 	bool	validateProgramObject(GLhandleARB obj);
 	GLhandleARB loadShaderFile(const std::string& filename, S32 & shader_level, GLenum type, std::unordered_map<std::string, std::string>* defines = NULL, S32 texture_index_channels = -1);
 
+	// Linked program binaries are kept in cache_dir, keyed by everything
+	// that goes into building the program, so unchanged programs skip
+	// compiling and linking on the next launch or settings change.
+	void initShaderCache(bool enabled, const std::string& cache_dir);
+	void clearShaderCache();
+	// On a hit the program is ready to use and true is returned.  On a
+	// miss the shader is set up so that saveCachedProgramBinary() can
+	// store it once it has been built.
+	bool loadCachedProgramBinary(LLGLSLShader* shader, S32 texture_index_channels);
+	void saveCachedProgramBinary(LLGLSLShader* shader, F32 build_seconds);
+	void logShaderCacheStats();
+
 	// Implemented in the application to actually point to the shader directory.
 	virtual std::string getShaderDirPrefix(void) = 0; // Pure Virtual
 
@@ -285,6 +297,21 @@ public:
 	//preprocessor definitions (name/value)
 	std::map<std::string, std::string> mDefinitions;
 
+	// Hash of the final source of each compiled shader object, by file name
+	std::map<std::string, std::string> mVertexShaderHashes;
+	std::map<std::string, std::string> mFragmentShaderHashes;
+
+private:
+	std::string getProgramCacheKey(LLGLSLShader* shader, S32 texture_index_channels);
+	std::string getProgramCacheFilename(const std::string& key);
+	std::string getShaderSourcePath(const std::string& filename, S32 shader_level);
+
+	bool mShaderCacheEnabled;
+	std::string mShaderCacheDir;
+	U32 mShaderCacheHits;
+	U32 mShaderCacheMisses;
+	F32 mShaderCacheSecondsSaved;
+
 protected:
 
 	// our parameter manager singleton instance
@@ -79,6 +79,9 @@ U32 vbo_block_index(U32 size)
 
 const U32 LL_VBO_POOL_SEED_COUNT = vbo_block_index(LL_VBO_POOL_MAX_SEED_SIZE);
 
+//a frame of UI and HUD text is typically well under a megabyte of immediate mode vertices
+const U32 LL_VBO_STREAM_SEGMENT_SIZE = 2*1024*1024;
+
 
 //============================================================================
 
@@ -89,6 +92,8 @@ LLVBOPool LLVertexBuffer::sDynamicCopyVBOPool(GL_DYNAMIC_COPY_ARB, GL_ARRAY_BUFF
 LLVBOPool LLVertexBuffer::sStreamIBOPool(GL_STREAM_DRAW_ARB, GL_ELEMENT_ARRAY_BUFFER_ARB);
 LLVBOPool LLVertexBuffer::sDynamicIBOPool(GL_DYNAMIC_DRAW_ARB, GL_ELEMENT_ARRAY_BUFFER_ARB);
 
+LLVBOStreamRing LLVertexBuffer::sStreamRing;
+
 U32 LLVBOPool::sBytesPooled = 0;
 U32 LLVBOPool::sIndexBytesPooled = 0;
 U32 LLVBOPool::sNameIdx = 0;
@@ -102,6 +107,8 @@ U32 LLVertexBuffer::sIndexCount = 0;
 
 U32 LLVertexBuffer::sBindCount = 0;
 U32 LLVertexBuffer::sSetCount = 0;
+U32 LLVertexBuffer::sDrawCount = 0;
+U32 LLVertexBuffer::sMergedDrawCount = 0;
 S32 LLVertexBuffer::sCount = 0;
 S32 LLVertexBuffer::sGLCount = 0;
 S32 LLVertexBuffer::sMappedCount = 0;
@@ -119,6 +126,7 @@ bool LLVertexBuffer::sMapped = false;
 bool LLVertexBuffer::sUseStreamDraw = true;
 bool LLVertexBuffer::sUseVAO = false;
 bool LLVertexBuffer::sPreferStreamDraw = false;
+U32 LLVertexBuffer::sStreamRingMode = 0;
 
 
 U32 LLVBOPool::genBuffer()
@@ -335,6 +343,179 @@ void LLVBOPool::cleanup()
 	std::fill(mMissCount.begin(), mMissCount.end(), 0);
 }
 
+//============================================================================
+
+LLVBOStreamRing::LLVBOStreamRing()
+: mGLName(0),
+  mData(NULL),
+  mSegmentSize(0),
+  mSegment(0),
+  mHead(0),
+  mPersistent(false)
+{
+	for (U32 i = 0; i < NUM_SEGMENTS; ++i)
+	{
+		mFences[i] = NULL;
+	}
+}
+
+void LLVBOStreamRing::init(U32 segment_size, bool persistent)
+{
+	llassert(!isInitialized());
+
+	mSegmentSize = vbo_block_size(segment_size);
+	mSegment = 0;
+	mHead = 0;
+	mPersistent = false;
+
+	U32 size = mSegmentSize*NUM_SEGMENTS;
+
+	LLVertexBuffer::unbind();
+
+	glGenBuffersARB(1, &mGLName);
+	glBindBufferARB(GL_ARRAY_BUFFER_ARB, mGLName);
+
+#ifdef GL_ARB_buffer_storage
+	if (persistent && gGLManager.mHasBufferStorage && gGLManager.mHasMapBufferRange && gGLManager.mHasSync)
+	{
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_ARRAY_BUFFER_ARB, size, NULL, flags);
+		mData = (U8*) glMapBufferRange(GL_ARRAY_BUFFER_ARB, 0, size, flags);
+
+		if (mData)
+		{
+			mPersistent = true;
+		}
+		else
+		{ //storage is immutable, start over with a plain buffer
+			LL_WARNS() << "Failed to map stream ring persistently, falling back to glBufferSubData." << LL_ENDL;
+			glBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
+			glDeleteBuffersARB(1, &mGLName);
+			glGenBuffersARB(1, &mGLName);
+			glBindBufferARB(GL_ARRAY_BUFFER_ARB, mGLName);
+		}
+	}
+#endif
+
+	if (!mPersistent)
+	{
+		glBufferDataARB(GL_ARRAY_BUFFER_ARB, size, NULL, GL_STREAM_DRAW_ARB);
+		mData = (U8*) ll_aligned_malloc<64>(size);
+		if (!mData)
+		{
+			LL_ERRS() << "Failed to allocate " << size << " bytes for stream ring." << LL_ENDL;
+		}
+	}
+	else
+	{
+		for (U32 i = 0; i < NUM_SEGMENTS; ++i)
+		{
+			mFences[i] = new LLGLSyncFence();
+		}
+	}
+
+	glBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
+	stop_glerror();
+
+	LLVertexBuffer::sAllocatedBytes += size;
+
+	LL_INFOS() << "Created " << (mPersistent ? "persistently mapped" : "glBufferSubData") << " stream ring of " << size << " bytes." << LL_ENDL;
+}
+
+void LLVBOStreamRing::cleanup()
+{
+	if (!isInitialized())
+	{
+		return;
+	}
+
+	for (U32 i = 0; i < NUM_SEGMENTS; ++i)
+	{
+		delete mFences[i];
+		mFences[i] = NULL;
+	}
+
+	if (mPersistent)
+	{
+		if (gGLManager.mInited)
+		{
+			LLVertexBuffer::unbind();
+			glBindBufferARB(GL_ARRAY_BUFFER_ARB, mGLName);
+			glUnmapBufferARB(GL_ARRAY_BUFFER_ARB);
+			glBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
+		}
+	}
+	else
+	{
+		ll_aligned_free<64>(mData);
+	}
+
+	if (gGLManager.mInited)
+	{
+		glDeleteBuffersARB(1, &mGLName);
+	}
+
+	LLVertexBuffer::sAllocatedBytes -= mSegmentSize*NUM_SEGMENTS;
+
+	mGLName = 0;
+	mData = NULL;
+	mPersistent = false;
+}
+
+U8* LLVBOStreamRing::allocate(U32 size, U32& offset)
+{
+	//keep every allocation 16 byte aligned like LLVertexBuffer::calcOffsets
+	size = (size + 0xF) & ~0xF;
+
+	if (size > mSegmentSize)
+	{
+		return NULL;
+	}
+
+	if (mHead + size > (mSegment+1)*mSegmentSize)
+	{
+		nextSegment();
+	}
+
+	offset = mHead;
+	mHead += size;
+
+	return mData + offset;
+}
+
+void LLVBOStreamRing::flushRange(U32 offset, U32 size)
+{
+	if (!mPersistent)
+	{ //coherent persistent mappings need no flush
+		glBufferSubDataARB(GL_ARRAY_BUFFER_ARB, offset, size, mData + offset);
+	}
+}
+
+void LLVBOStreamRing::nextFrame()
+{
+	if (isInitialized() && mHead != mSegment*mSegmentSize)
+	{
+		nextSegment();
+	}
+}
+
+void LLVBOStreamRing::nextSegment()
+{
+	if (mPersistent)
+	{
+		mFences[mSegment]->placeFence();
+	}
+
+	mSegment = (mSegment+1) % NUM_SEGMENTS;
+	mHead = mSegment*mSegmentSize;
+
+	if (mPersistent)
+	{ //only stalls if the GPU is still reading this segment from NUM_SEGMENTS frames ago
+		mFences[mSegment]->wait();
+	}
+	// glBufferSubData is ordered against earlier draws by the driver
+}
+
 
 //NOTE: each component must be AT LEAST 4 bytes in size to avoid a performance penalty on AMD hardware
 const S32 LLVertexBuffer::sTypeSize[LLVertexBuffer::TYPE_MAX] =
@@ -608,6 +789,7 @@ void LLVertexBuffer::drawRange(U32 mode, U32 start, U32 end, U32 count, U32 indi
 
 	stop_glerror();
 	LLGLSLShader::startProfile();
+	sDrawCount++;
     LL_PROFILER_GPU_ZONEC( "gl.DrawRangeElements", 0xFFFF00 )
 	glDrawRangeElements(sGLMode[mode], start, end, count, GL_UNSIGNED_SHORT, 
 		idx);
@@ -626,11 +808,45 @@ void LLVertexBuffer::drawRangeFast(U32 mode, U32 start, U32 end, U32 count, U32
 
     U16* idx = ((U16*)getIndicesPointer()) + indices_offset;
 
+    sDrawCount++;
     LL_PROFILER_GPU_ZONEC("gl.DrawRangeElements", 0xFFFF00)
         glDrawRangeElements(sGLMode[mode], start, end, count, GL_UNSIGNED_SHORT,
             idx);
 }
 
+void LLVertexBuffer::drawRangesFast(U32 mode, U32 start, U32 end, const U32* counts, const U32* indices_offsets, U32 num_ranges) const
+{
+    if (num_ranges == 1 || !gGLManager.mHasMultiDrawElements)
+    {
+        for (U32 i = 0; i < num_ranges; ++i)
+        {
+            drawRangeFast(mode, start, end, counts[i], indices_offsets[i]);
+        }
+        return;
+    }
+
+    mMappable = false;
+    gGL.syncMatrices();
+
+    // scratch space for the GL parameter arrays, only ever touched by the render thread
+    static std::vector<GLsizei> gl_counts;
+    static std::vector<const GLvoid*> gl_indices;
+    gl_counts.resize(num_ranges);
+    gl_indices.resize(num_ranges);
+
+    U16* idx = (U16*)getIndicesPointer();
+    for (U32 i = 0; i < num_ranges; ++i)
+    {
+        gl_counts[i] = counts[i];
+        gl_indices[i] = idx + indices_offsets[i];
+    }
+
+    sDrawCount++;
+    sMergedDrawCount += num_ranges - 1;
+    LL_PROFILER_GPU_ZONEC("gl.MultiDrawElements", 0xFFC000)
+        glMultiDrawElements(sGLMode[mode], &gl_counts[0], GL_UNSIGNED_SHORT, &gl_indices[0], num_ranges);
+}
+
 void LLVertexBuffer::draw(U32 mode, U32 count, U32 indices_offset) const
 {
 	llassert(LLGLSLShader::sCurBoundShaderPtr != NULL);
@@ -672,6 +888,7 @@ void LLVertexBuffer::draw(U32 mode, U32 count, U32 indices_offset) const
 
 	stop_glerror();
 	LLGLSLShader::startProfile();
+	sDrawCount++;
     LL_PROFILER_GPU_ZONEC( "gl.DrawElements", 0xA0FFA0 )
 	glDrawElements(sGLMode[mode], count, GL_UNSIGNED_SHORT,
 		((U16*) getIndicesPointer()) + indices_offset);
@@ -718,6 +935,7 @@ void LLVertexBuffer::drawArrays(U32 mode, U32 first, U32 count) const
 #endif
 
     LLGLSLShader::startProfile();
+    sDrawCount++;
     {
         LL_PROFILER_GPU_ZONEC("gl.DrawArrays", 0xFF4040)
             glDrawArrays(sGLMode[mode], first, count);
@@ -728,6 +946,77 @@ void LLVertexBuffer::drawArrays(U32 mode, U32 first, U32 count) const
     placeFence();
 }
 
+bool LLVertexBuffer::drawArraysStreamed(U32 mode, U32 data_mask, U32 count)
+{
+	if (!sStreamRingMode || !sEnableVBOs || sUseVAO || mGLArray || mMappable || !mMappedData)
+	{ //needs client side data and the global vertex array state
+		return false;
+	}
+
+	llassert((data_mask & mTypeMask) == data_mask);
+	llassert(count <= (U32) mNumVerts);
+	llassert(mode < LLRender::NUM_MODES);
+
+	if (!sStreamRing.isInitialized())
+	{
+		sStreamRing.init(LL_VBO_STREAM_SEGMENT_SIZE, sStreamRingMode == 1);
+	}
+
+	//pack just the vertices being drawn
+	S32 offsets[TYPE_MAX] = { 0 };
+	U32 size = calcOffsets(data_mask, offsets, count);
+
+	U32 offset = 0;
+	U8* dst = sStreamRing.allocate(size, offset);
+	if (!dst)
+	{
+		return false;
+	}
+
+	for (U32 i = 0; i < TYPE_TEXTURE_INDEX; ++i)
+	{ //texture index is packed into the vertex stream
+		if (data_mask & (1 << i))
+		{
+			memcpy(dst + offsets[i], mMappedData + mOffsets[i], sTypeSize[i]*count);
+		}
+	}
+
+	U32 name = sStreamRing.getGLName();
+	if (name != sGLRenderBuffer || !sVBOActive)
+	{
+		glBindBufferARB(GL_ARRAY_BUFFER_ARB, name);
+		sGLRenderBuffer = name;
+		sBindCount++;
+		sVBOActive = true;
+	}
+
+	sStreamRing.flushRange(offset, size);
+
+	setupClientArrays(data_mask);
+	setupVertexPointers(data_mask, (U8*) (ptrdiff_t) offset, offsets);
+	sSetCount++;
+
+	llassert(LLGLSLShader::sCurBoundShaderPtr != NULL);
+	gGL.syncMatrices();
+
+	LLGLSLShader::startProfile();
+	sDrawCount++;
+	{
+		LL_PROFILER_GPU_ZONEC("gl.DrawArrays", 0xFF4040)
+		glDrawArrays(sGLMode[mode], 0, count);
+	}
+	LLGLSLShader::stopProfile(count, mode);
+
+	stop_glerror();
+	return true;
+}
+
+//static
+void LLVertexBuffer::nextStreamFrame()
+{
+	sStreamRing.nextFrame();
+}
+
 //static
 void LLVertexBuffer::initClass(bool use_vbo, bool no_vbo_mapping)
 {
@@ -775,6 +1064,8 @@ void LLVertexBuffer::cleanupClass()
 	sStreamVBOPool.cleanup();
 	sDynamicVBOPool.cleanup();
 	sDynamicCopyVBOPool.cleanup();
+
+	sStreamRing.cleanup();
 }
 
 //----------------------------------------------------------------------------
@@ -843,6 +1134,7 @@ LLVertexBuffer::LLVertexBuffer(U32 typemask, S32 usage)
 	mIndexLocked(false),
 	mFinal(false),
 	mEmpty(true),
+	mThreadedWrite(false),
 	mMappable(false),
 	mFence(NULL)
 {
@@ -1416,6 +1708,12 @@ bool expand_region(LLVertexBuffer::MappedRegion& region, S32 index, S32 count)
 // Map for data access
 U8* LLVertexBuffer::mapVertexBuffer(S32 type, S32 index, S32 count, bool map_range)
 {
+	if (mThreadedWrite)
+	{ //already mapped in full, may be on a worker thread
+		llassert(!map_range);
+		return mMappedData+mOffsets[type]+sTypeSize[type]*index;
+	}
+
 	bindGLBuffer(true);
 	if (mFinal)
 	{
@@ -1592,6 +1890,12 @@ U8* LLVertexBuffer::mapVertexBuffer(S32 type, S32 index, S32 count, bool map_ran
 
 U8* LLVertexBuffer::mapIndexBuffer(S32 index, S32 count, bool map_range)
 {
+	if (mThreadedWrite)
+	{ //already mapped in full, may be on a worker thread
+		llassert(!map_range);
+		return mMappedIndexData+sizeof(U16)*index;
+	}
+
 	bindGLIndices(true);
 	if (mFinal)
 	{
@@ -2129,12 +2433,32 @@ bool LLVertexBuffer::bindGLIndicesFast()
 
 void LLVertexBuffer::flush()
 {
+	mThreadedWrite = false;
 	if (useVBOs())
 	{
 		unmapBuffer();
 	}
 }
 
+void LLVertexBuffer::mapForThreadedWrite()
+{
+	if (mThreadedWrite)
+	{
+		return;
+	}
+
+	for (S32 type = 0; type < TYPE_TEXTURE_INDEX; ++type)
+	{ //texture index is packed into the vertex stream
+		if (hasDataType(type))
+		{
+			mapVertexBuffer(type, 0, -1, false);
+		}
+	}
+	mapIndexBuffer(0, -1, false);
+
+	mThreadedWrite = true;
+}
+
 // bind for transform feedback (quick 'n dirty)
 void LLVertexBuffer::bindForFeedback(U32 channel, U32 type, U32 index, U32 count)
 {
@@ -2460,55 +2784,59 @@ void LLVertexBuffer::setupVertexBuffer(U32 data_mask)
 
 void LLVertexBuffer::setupVertexBufferFast(U32 data_mask)
 {
-    U8* base = (U8*)mAlignedOffset;
+    setupVertexPointers(data_mask, (U8*) mAlignedOffset, mOffsets);
+}
 
+//static
+void LLVertexBuffer::setupVertexPointers(U32 data_mask, U8* base, const S32* offsets)
+{
     if (data_mask & MAP_NORMAL)
     {
         S32 loc = TYPE_NORMAL;
-        void* ptr = (void*)(base + mOffsets[TYPE_NORMAL]);
+        void* ptr = (void*)(base + offsets[TYPE_NORMAL]);
         glVertexAttribPointerARB(loc, 3, GL_FLOAT, GL_FALSE, LLVertexBuffer::sTypeSize[TYPE_NORMAL], ptr);
     }
     if (data_mask & MAP_TEXCOORD3)
     {
         S32 loc = TYPE_TEXCOORD3;
-        void* ptr = (void*)(base + mOffsets[TYPE_TEXCOORD3]);
+        void* ptr = (void*)(base + offsets[TYPE_TEXCOORD3]);
         glVertexAttribPointerARB(loc, 2, GL_FLOAT, GL_FALSE, LLVertexBuffer::sTypeSize[TYPE_TEXCOORD3], ptr);
     }
     if (data_mask & MAP_TEXCOORD2)
     {
         S32 loc = TYPE_TEXCOORD2;
-        void* ptr = (void*)(base + mOffsets[TYPE_TEXCOORD2]);
+        void* ptr = (void*)(base + offsets[TYPE_TEXCOORD2]);
         glVertexAttribPointerARB(loc, 2, GL_FLOAT, GL_FALSE, LLVertexBuffer::sTypeSize[TYPE_TEXCOORD2], ptr);
     }
     if (data_mask & MAP_TEXCOORD1)
     {
         S32 loc = TYPE_TEXCOORD1;
-        void* ptr = (void*)(base + mOffsets[TYPE_TEXCOORD1]);
+        void* ptr = (void*)(base + offsets[TYPE_TEXCOORD1]);
         glVertexAttribPointerARB(loc, 2, GL_FLOAT, GL_FALSE, LLVertexBuffer::sTypeSize[TYPE_TEXCOORD1], ptr);
     }
     if (data_mask & MAP_TANGENT)
     {
         S32 loc = TYPE_TANGENT;
-        void* ptr = (void*)(base + mOffsets[TYPE_TANGENT]);
+        void* ptr = (void*)(base + offsets[TYPE_TANGENT]);
         glVertexAttribPointerARB(loc, 4, GL_FLOAT, GL_FALSE, LLVertexBuffer::sTypeSize[TYPE_TANGENT], ptr);
     }
     if (data_mask & MAP_TEXCOORD0)
     {
         S32 loc = TYPE_TEXCOORD0;
-        void* ptr = (void*)(base + mOffsets[TYPE_TEXCOORD0]);
+        void* ptr = (void*)(base + offsets[TYPE_TEXCOORD0]);
         glVertexAttribPointerARB(loc, 2, GL_FLOAT, GL_FALSE, LLVertexBuffer::sTypeSize[TYPE_TEXCOORD0], ptr);
     }
     if (data_mask & MAP_COLOR)
     {
         S32 loc = TYPE_COLOR;
         //bind emissive instead of color pointer if emissive is present
-        void* ptr = (data_mask & MAP_EMISSIVE) ? (void*)(base + mOffsets[TYPE_EMISSIVE]) : (void*)(base + mOffsets[TYPE_COLOR]);
+        void* ptr = (data_mask & MAP_EMISSIVE) ? (void*)(base + offsets[TYPE_EMISSIVE]) : (void*)(base + offsets[TYPE_COLOR]);
         glVertexAttribPointerARB(loc, 4, GL_UNSIGNED_BYTE, GL_TRUE, LLVertexBuffer::sTypeSize[TYPE_COLOR], ptr);
     }
     if (data_mask & MAP_EMISSIVE)
     {
         S32 loc = TYPE_EMISSIVE;
-        void* ptr = (void*)(base + mOffsets[TYPE_EMISSIVE]);
+        void* ptr = (void*)(base + offsets[TYPE_EMISSIVE]);
         glVertexAttribPointerARB(loc, 4, GL_UNSIGNED_BYTE, GL_TRUE, LLVertexBuffer::sTypeSize[TYPE_EMISSIVE], ptr);
 
         if (!(data_mask & MAP_COLOR))
@@ -2520,33 +2848,33 @@ void LLVertexBuffer::setupVertexBufferFast(U32 data_mask)
     if (data_mask & MAP_WEIGHT)
     {
         S32 loc = TYPE_WEIGHT;
-        void* ptr = (void*)(base + mOffsets[TYPE_WEIGHT]);
+        void* ptr = (void*)(base + offsets[TYPE_WEIGHT]);
         glVertexAttribPointerARB(loc, 1, GL_FLOAT, GL_FALSE, LLVertexBuffer::sTypeSize[TYPE_WEIGHT], ptr);
     }
     if (data_mask & MAP_WEIGHT4)
     {
         S32 loc = TYPE_WEIGHT4;
-        void* ptr = (void*)(base + mOffsets[TYPE_WEIGHT4]);
+        void* ptr = (void*)(base + offsets[TYPE_WEIGHT4]);
         glVertexAttribPointerARB(loc, 4, GL_FLOAT, GL_FALSE, LLVertexBuffer::sTypeSize[TYPE_WEIGHT4], ptr);
     }
     if (data_mask & MAP_CLOTHWEIGHT)
     {
         S32 loc = TYPE_CLOTHWEIGHT;
-        void* ptr = (void*)(base + mOffsets[TYPE_CLOTHWEIGHT]);
+        void* ptr = (void*)(base + offsets[TYPE_CLOTHWEIGHT]);
         glVertexAttribPointerARB(loc, 4, GL_FLOAT, GL_TRUE, LLVertexBuffer::sTypeSize[TYPE_CLOTHWEIGHT], ptr);
     }
     if (data_mask & MAP_TEXTURE_INDEX)
     {
 #if !LL_DARWIN
         S32 loc = TYPE_TEXTURE_INDEX;
-        void* ptr = (void*)(base + mOffsets[TYPE_VERTEX] + 12);
+        void* ptr = (void*)(base + offsets[TYPE_VERTEX] + 12);
         glVertexAttribIPointer(loc, 1, GL_UNSIGNED_INT, LLVertexBuffer::sTypeSize[TYPE_VERTEX], ptr);
 #endif
     }
     if (data_mask & MAP_VERTEX)
     {
         S32 loc = TYPE_VERTEX;
-        void* ptr = (void*)(base + mOffsets[TYPE_VERTEX]);
+        void* ptr = (void*)(base + offsets[TYPE_VERTEX]);
         glVertexAttribPointerARB(loc, 3, GL_FLOAT, GL_FALSE, LLVertexBuffer::sTypeSize[TYPE_VERTEX], ptr);
     }
 }
@@ -94,6 +94,53 @@ public:
 	static U32 sNameIdx;
 };
 
+//============================================================================
+// One GL buffer that vertex data rewritten before every draw is streamed
+// through (see LLVertexBuffer::drawArraysStreamed).  The buffer is split into
+// segments; each frame sub-allocates from its own segment, and a segment is
+// only written again once the fence placed when it was left has passed.
+// With ARB_buffer_storage the buffer stays mapped for its whole lifetime.
+// Without it (or when forced) writes go to a client side copy and are
+// uploaded with glBufferSubData, which is what software GL falls back to.
+class LLVBOStreamRing
+{
+public:
+	LLVBOStreamRing();
+
+	void init(U32 segment_size, bool persistent);
+	void cleanup();
+
+	bool isInitialized() const { return mGLName != 0; }
+	bool isPersistent() const { return mPersistent; }
+	U32 getGLName() const { return mGLName; }
+
+	//reserve size bytes for writing, sets offset to their offset into the GL buffer
+	//returns NULL if size is bigger than a segment
+	U8* allocate(U32 size, U32& offset);
+
+	//make an allocation visible to GL, ring must be bound to GL_ARRAY_BUFFER
+	void flushRange(U32 offset, U32 size);
+
+	//fence the current segment and start the next frame in a fresh one
+	void nextFrame();
+
+	enum
+	{
+		NUM_SEGMENTS = 3
+	};
+
+private:
+	void nextSegment();
+
+	U32 mGLName;
+	U8* mData;		// persistent mapping, or client copy when not persistent
+	U32 mSegmentSize;
+	U32 mSegment;	// segment being allocated from
+	U32 mHead;		// next free byte in the GL buffer
+	bool mPersistent;
+	LLGLSyncFence* mFences[NUM_SEGMENTS];
+};
+
 
 //============================================================================
 // base class 
@@ -133,10 +180,20 @@ public:
 	static std::list<U32> sAvailableVAOName;
 	static U32 sCurVAOName;
 
+	static LLVBOStreamRing sStreamRing;
+
 	static bool	sUseStreamDraw;
 	static bool sUseVAO;
 	static bool	sPreferStreamDraw;
 
+	//0 - streamed draws disabled
+	//1 - stream through a persistently mapped ring buffer if ARB_buffer_storage is available
+	//2 - stream through a ring buffer updated with glBufferSubData
+	static U32 sStreamRingMode;
+
+	//start the next frame's streamed draws in a fresh part of the ring
+	static void nextStreamFrame();
+
 	static void seedPools();
 
 	static U32 getVAOName();
@@ -212,6 +269,8 @@ protected:
     void setupVertexBufferFast(U32 data_mask);
 
 	void setupVertexArray();
+
+	static void setupVertexPointers(U32 data_mask, U8* base, const S32* offsets);
 	
 	void	genBuffer(U32 size);
 	void	genIndices(U32 size);
@@ -244,6 +303,11 @@ public:
     void	setBufferFast(U32 data_mask); 	// calls setupVertexBufferFast(), assumes data_mask is not 0 among other assumptions
 
 	void flush(); //flush pending data to GL memory
+
+	// Map every attribute and the indices on the GL thread so that until the
+	// next flush() the getXXXStrider() calls touch no GL state and may be made
+	// from worker threads, each writing a different range of the buffer.
+	void mapForThreadedWrite();
 	// allocate buffer
 	bool	allocateBuffer(S32 nverts, S32 nindices, bool create);
 	virtual bool resizeBuffer(S32 newnverts, S32 newnindices);
@@ -291,11 +355,21 @@ public:
 
 	void draw(U32 mode, U32 count, U32 indices_offset) const;
 	void drawArrays(U32 mode, U32 offset, U32 count) const;
+
+	//draw the first count vertices of this buffer's client side data by
+	//copying them into sStreamRing instead of uploading them to this buffer
+	//only for data that is rewritten before every draw
+	//returns false if streaming is unavailable, in which case nothing is drawn
+	bool drawArraysStreamed(U32 mode, U32 data_mask, U32 count);
 	void drawRange(U32 mode, U32 start, U32 end, U32 count, U32 indices_offset) const;
 
     //implementation for inner loops that does no safety checking
     void drawRangeFast(U32 mode, U32 start, U32 end, U32 count, U32 indices_offset) const;
 
+    //draw several index ranges of this buffer that all reference vertices in [start, end]
+    //with a single glMultiDrawElements where available, no safety checking
+    void drawRangesFast(U32 mode, U32 start, U32 end, const U32* counts, const U32* indices_offsets, U32 num_ranges) const;
+
 	//for debugging, validate data in given range is valid
 	void validateRange(U32 start, U32 end, U32 count, U32 offset) const;
 
@@ -326,6 +400,7 @@ protected:
 	bool	mIndexLocked : 1;			// if true, index buffer is being or has been written to in client memory
 	bool	mFinal : 1;			// if true, buffer can not be mapped again
 	bool 	mEmpty : 1;			// if true, client buffer is empty (or NULL). Old values have been discarded.
+	bool	mThreadedWrite : 1;	// if true, the whole buffer is mapped for writing from other threads (see mapForThreadedWrite())
 	
 	mutable bool	mMappable;     // if true, use memory mapping to upload data (otherwise doublebuffer and use glBufferSubData)
 
@@ -367,6 +442,8 @@ public:
 	static U32 sIndexCount;
 	static U32 sBindCount;
 	static U32 sSetCount;
+	static U32 sDrawCount;
+	static U32 sMergedDrawCount; //index ranges folded into another draw call by drawRangesFast
 };
 
 
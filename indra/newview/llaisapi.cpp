@@ -31,6 +31,8 @@
 #include "llagent.h"
 #include "llcallbacklist.h"
 #include "llinventorymodel.h"
+#include "llmemorystream.h"
+#include "llsdserialize.h"
 #include "llsdutil.h"
 #include "llviewerregion.h"
 #include "llinventoryobserver.h"
@@ -430,7 +432,11 @@ void AISAPI::InvokeAISCommandCoro(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t ht
 
     LL_DEBUGS("Inventory") << "url: " << url << LL_ENDL;
 
+    // The body comes back unparsed and is read as a stream by AISUpdate, so
+    // large responses are never held as a whole LLSD tree.
+    httpAdapter->setRawResponse(true);
     LLSD result = invoke(httpAdapter, httpRequest, url, body, httpOptions, httpHeaders);
+    httpAdapter->setRawResponse(false);
     LLSD httpResults = result[LLCoreHttpUtil::HttpCoroutineAdapter::HTTP_RESULTS];
     LLCore::HttpStatus status = LLCoreHttpUtil::HttpCoroutineAdapter::getStatusFromLLSD(httpResults);
 
@@ -478,8 +484,23 @@ void AISAPI::InvokeAISCommandCoro(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t ht
         LL_WARNS("Inventory") << ll_pretty_print_sd(result) << LL_ENDL;
     }
 
+    // Only the top level entries of the body are merged into result;
+    // embedded inventory has already been applied.
+    LLSD top_level;
+    LLSD raw = result[LLCoreHttpUtil::HttpCoroutineAdapter::HTTP_RESULTS_RAW];
+    result.erase(LLCoreHttpUtil::HttpCoroutineAdapter::HTTP_RESULTS_RAW);
+    if (gInventory.onAISUpdateReceived("AISCommand", raw.asBinary(), top_level))
+    {
+        for (LLSD::map_const_iterator it = top_level.beginMap(); it != top_level.endMap(); ++it)
+        {
+            result[it->first] = it->second;
+        }
+    }
+    else if (status && !raw.asBinary().empty())
+    {
+        LL_WARNS("Inventory") << "Inventory error: malformed response contents" << LL_ENDL;
+    }
 	LL_DEBUGS("Inventory") << result << LL_ENDL;
-    gInventory.onAISUpdateReceived("AISCommand", result);
 
     if (callback && !callback.empty())
     {   
@@ -517,12 +538,145 @@ void AISAPI::InvokeAISCommandCoro(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t ht
 
 }
 
+//-------------------------------------------------------------------------
+// Collects the top level entries of an AIS response, except _embedded.
+class AISUpdate::TopLevelReader : public LLSDSubtreeHandler
+{
+public:
+	TopLevelReader(LLSD& top_level)
+		: LLSDSubtreeHandler(1),
+		  mTopLevel(top_level)
+	{
+	}
+
+	virtual bool beginMap()
+	{
+		if (path().empty())
+		{
+			// Only a map at the top level is an update.
+			mTopLevel = LLSD::emptyMap();
+		}
+		return LLSDSubtreeHandler::beginMap();
+	}
+
+	virtual bool subtree(const std::string& name, const LLSD& value)
+	{
+		if (mTopLevel.isMap())
+		{
+			mTopLevel[name] = value;
+		}
+		return true;
+	}
+
+protected:
+	virtual bool isSubtree(const std::string& name)
+	{
+		return (path().size() == 1) && (name != "_embedded");
+	}
+
+private:
+	LLSD& mTopLevel;
+};
+
+// Hands each entry of the top level _embedded map to the AISUpdate as soon
+// as it has been read, so only one entry is held at a time.
+class AISUpdate::EmbeddedReader : public LLSDSubtreeHandler
+{
+public:
+	EmbeddedReader(AISUpdate& update)
+		: LLSDSubtreeHandler(0),
+		  mUpdate(update)
+	{
+	}
+
+	// Same rule as AISUpdate::parseDescendentCount().
+	bool getDescendentCount(S32& count) const
+	{
+		if (mGroupSizes.size() < 3)
+		{
+			return false;
+		}
+		count = 0;
+		for (std::map<std::string, S32>::const_iterator it = mGroupSizes.begin();
+			 it != mGroupSizes.end(); ++it)
+		{
+			count += it->second;
+		}
+		return true;
+	}
+
+	virtual bool subtree(const std::string& name, const LLSD& value)
+	{
+		const std::string& group = path().back();
+		if (group == "links")
+		{
+			mUpdate.parseEmbeddedLinkEntry(LLUUID(name), value);
+		}
+		else if (group == "items")
+		{
+			mUpdate.parseEmbeddedItemEntry(LLUUID(name), value);
+		}
+		else if (group == "categories")
+		{
+			mUpdate.parseEmbeddedCategoryEntry(LLUUID(name), value);
+		}
+		else if (name == "item")
+		{
+			mUpdate.parseEmbeddedItem(value);
+		}
+		else if (name == "category")
+		{
+			mUpdate.parseEmbeddedCategory(value);
+		}
+		return true;
+	}
+
+protected:
+	virtual bool isSubtree(const std::string& name)
+	{
+		const std::vector<std::string>& open = path();
+		if (open.size() < 2 || open[1] != "_embedded")
+		{
+			return false;
+		}
+		if (open.size() == 2)
+		{
+			if (isGroup(name))
+			{
+				mGroupSizes[name];
+				return false;
+			}
+			return (name == "item") || (name == "category");
+		}
+		if (open.size() == 3 && isGroup(open[2]))
+		{
+			++mGroupSizes[open[2]];
+			return true;
+		}
+		return false;
+	}
+
+private:
+	static bool isGroup(const std::string& name)
+	{
+		return (name == "links") || (name == "items") || (name == "categories");
+	}
+
+	AISUpdate& mUpdate;
+	std::map<std::string, S32> mGroupSizes;
+};
+
 //-------------------------------------------------------------------------
 AISUpdate::AISUpdate(const LLSD& update)
 {
 	parseUpdate(update);
 }
 
+AISUpdate::AISUpdate(const LLSD::Binary& body, LLSD& top_level)
+{
+	parseStream(body, top_level);
+}
+
 void AISUpdate::clearParseResults()
 {
 	mCatDescendentDeltas.clear();
@@ -544,6 +698,64 @@ void AISUpdate::parseUpdate(const LLSD& update)
 	parseContent(update);
 }
 
+bool AISUpdate::parseStream(const LLSD::Binary& body, LLSD& top_level)
+{
+	clearParseResults();
+	top_level.clear();
+	if (body.empty())
+	{
+		return false;
+	}
+
+	// Two passes over the body: parseMeta() decides which embedded content
+	// is wanted, and _embedded may come before the lists it depends on.
+	TopLevelReader top_reader(top_level);
+	{
+		LLMemoryStream istr(&body[0], (S32)body.size());
+		LLPointer<LLSDXMLParser> parser = new LLSDXMLParser(true);
+		if (parser->parse(istr, top_reader, body.size()) == LLSDParser::PARSE_FAILURE)
+		{
+			top_level.clear();
+			return false;
+		}
+	}
+	if (!top_level.isMap())
+	{
+		top_level.clear();
+		return false;
+	}
+
+	parseMeta(top_level);
+	if (top_level.has("linked_id"))
+	{
+		parseLink(top_level);
+	}
+	else if (top_level.has("item_id"))
+	{
+		parseItem(top_level);
+	}
+
+	EmbeddedReader embedded_reader(*this);
+	{
+		LLMemoryStream istr(&body[0], (S32)body.size());
+		LLPointer<LLSDXMLParser> parser = new LLSDXMLParser(true);
+		parser->parse(istr, embedded_reader, body.size());
+	}
+
+	// As in parseContent(), but the category comes last since its
+	// descendent count is only known once _embedded has been read.
+	if (top_level.has("category_id"))
+	{
+		S32 descendent_count;
+		if (embedded_reader.getDescendentCount(descendent_count))
+		{
+			mCatDescendentsKnown[top_level["category_id"].asUUID()] = descendent_count;
+		}
+		parseCategory(top_level);
+	}
+	return true;
+}
+
 void AISUpdate::parseMeta(const LLSD& update)
 {
 	// parse _categories_removed -> mObjectsDeletedIds
@@ -862,16 +1074,19 @@ void AISUpdate::parseEmbeddedLinks(const LLSD& links)
 			linkend = links.endMap();
 		linkit != linkend; ++linkit)
 	{
-		const LLUUID link_id((*linkit).first);
-		const LLSD& link_map = (*linkit).second;
-		if (mItemIds.end() == mItemIds.find(link_id))
-		{
-			LL_DEBUGS("Inventory") << "Ignoring link not in items list " << link_id << LL_ENDL;
-		}
-		else
-		{
-			parseLink(link_map);
-		}
+		parseEmbeddedLinkEntry(LLUUID((*linkit).first), (*linkit).second);
+	}
+}
+
+void AISUpdate::parseEmbeddedLinkEntry(const LLUUID& link_id, const LLSD& link_map)
+{
+	if (mItemIds.end() == mItemIds.find(link_id))
+	{
+		LL_DEBUGS("Inventory") << "Ignoring link not in items list " << link_id << LL_ENDL;
+	}
+	else
+	{
+		parseLink(link_map);
 	}
 }
 
@@ -894,16 +1109,19 @@ void AISUpdate::parseEmbeddedItems(const LLSD& items)
 			itemend = items.endMap();
 		itemit != itemend; ++itemit)
 	{
-		const LLUUID item_id((*itemit).first);
-		const LLSD& item_map = (*itemit).second;
-		if (mItemIds.end() == mItemIds.find(item_id))
-		{
-			LL_DEBUGS("Inventory") << "Ignoring item not in items list " << item_id << LL_ENDL;
-		}
-		else
-		{
-			parseItem(item_map);
-		}
+		parseEmbeddedItemEntry(LLUUID((*itemit).first), (*itemit).second);
+	}
+}
+
+void AISUpdate::parseEmbeddedItemEntry(const LLUUID& item_id, const LLSD& item_map)
+{
+	if (mItemIds.end() == mItemIds.find(item_id))
+	{
+		LL_DEBUGS("Inventory") << "Ignoring item not in items list " << item_id << LL_ENDL;
+	}
+	else
+	{
+		parseItem(item_map);
 	}
 }
 
@@ -926,16 +1144,19 @@ void AISUpdate::parseEmbeddedCategories(const LLSD& categories)
 			categoryend = categories.endMap();
 		categoryit != categoryend; ++categoryit)
 	{
-		const LLUUID category_id((*categoryit).first);
-		const LLSD& category_map = (*categoryit).second;
-		if (mCategoryIds.end() == mCategoryIds.find(category_id))
-		{
-			LL_DEBUGS("Inventory") << "Ignoring category not in categories list " << category_id << LL_ENDL;
-		}
-		else
-		{
-			parseCategory(category_map);
-		}
+		parseEmbeddedCategoryEntry(LLUUID((*categoryit).first), (*categoryit).second);
+	}
+}
+
+void AISUpdate::parseEmbeddedCategoryEntry(const LLUUID& category_id, const LLSD& category_map)
+{
+	if (mCategoryIds.end() == mCategoryIds.find(category_id))
+	{
+		LL_DEBUGS("Inventory") << "Ignoring category not in categories list " << category_id << LL_ENDL;
+	}
+	else
+	{
+		parseCategory(category_map);
 	}
 }
 
@@ -89,7 +89,13 @@ class AISUpdate
 {
 public:
 	AISUpdate(const LLSD& update);
+	// Reads an LLSD XML response body as a stream rather than as one tree:
+	// embedded items, links and categories are built and parsed one at a
+	// time. top_level receives the other entries of the body, and is left
+	// undefined if the body could not be read.
+	AISUpdate(const LLSD::Binary& body, LLSD& top_level);
 	void parseUpdate(const LLSD& update);
+	bool parseStream(const LLSD::Binary& body, LLSD& top_level);
 	void parseMeta(const LLSD& update);
 	void parseContent(const LLSD& update);
 	void parseUUIDArray(const LLSD& content, const std::string& name, uuid_list_t& ids);
@@ -105,7 +111,13 @@ public:
 	void parseEmbeddedCategory(const LLSD& category);
 	void doUpdate();
 private:
+	class TopLevelReader;
+	class EmbeddedReader;
+
 	void clearParseResults();
+	void parseEmbeddedLinkEntry(const LLUUID& link_id, const LLSD& link_map);
+	void parseEmbeddedItemEntry(const LLUUID& item_id, const LLSD& item_map);
+	void parseEmbeddedCategoryEntry(const LLUUID& category_id, const LLSD& category_map);
 
 	typedef std::map<LLUUID,S32> uuid_int_map_t;
 	uuid_int_map_t mCatDescendentDeltas;
@@ -59,57 +59,58 @@ static const struct
 	U32							mMax;
 	U32							mRate;
 	bool						mPipelined;
+	bool						mHttp2;
 	std::string					mKey;
 	const char *				mUsage;
 } init_data[LLAppCoreHttp::AP_COUNT] =
 {
 	{ // AP_DEFAULT
-		8,		8,		8,		0,		false,
+		8,		8,		8,		0,		false,	false,
 		"",
 		"other"
 	},
 	{ // AP_TEXTURE
-		8,		1,		12,		0,		true,
+		8,		1,		12,		0,		true,	true,
 		"TextureFetchConcurrency",
 		"texture fetch"
 	},
 	{ // AP_MESH1
-		32,		1,		128,	0,		false,
+		32,		1,		128,	0,		false,	false,
 		"MeshMaxConcurrentRequests",
 		"mesh fetch"
 	},
 	{ // AP_MESH2
-		8,		1,		32,		0,		true,	
+		8,		1,		32,		0,		true,	true,	
 		"Mesh2MaxConcurrentRequests",
 		"mesh2 fetch"
 	},
 	{ // AP_LARGE_MESH
-		2,		1,		8,		0,		false,
+		2,		1,		8,		0,		false,	true,
 		"",
 		"large mesh fetch"
 	},
 	{ // AP_UPLOADS 
-		2,		1,		8,		0,		false,
+		2,		1,		8,		0,		false,	false,
 		"",
 		"asset upload"
 	},
 	{ // AP_LONG_POLL
-		32,		32,		32,		0,		false,
+		32,		32,		32,		0,		false,	false,
 		"",
 		"long poll"
 	},
 	{ // AP_INVENTORY
-		4,		1,		4,		0,		false,
+		4,		1,		4,		0,		false,	false,
 		"",
 		"inventory"
 	},
 	{ // AP_MATERIALS
-		2,		1,		8,		0,		false,
+		2,		1,		8,		0,		false,	false,
 		"RenderMaterials",
 		"material manager requests"
 	},
 	{ // AP_AGENT
-		2,		1,		32,		0,		false,
+		2,		1,		32,		0,		false,	false,
 		"Agent",
 		"Agent requests"
 	}
@@ -122,7 +123,8 @@ static void ssl_verification_changed();
 LLAppCoreHttp::HttpClass::HttpClass()
 	: mPolicy(LLCore::HttpRequest::DEFAULT_POLICY_ID),
 	  mConnLimit(0U),
-	  mPipelined(false)
+	  mPipelined(false),
+	  mHttp2(false)
 {}
 
 
@@ -131,7 +133,8 @@ LLAppCoreHttp::LLAppCoreHttp()
 	  mStopHandle(LLCORE_HTTP_HANDLE_INVALID),
 	  mStopRequested(0.0),
 	  mStopped(false),
-	  mPipelined(true)
+	  mPipelined(true),
+	  mHttp2(false)
 {}
 
 
@@ -261,6 +264,22 @@ void LLAppCoreHttp::init()
 	// Need a request object to handle dynamic options before setting them
 	mRequest = new LLCore::HttpRequest;
 
+	// Global HTTP/2 setting, needed by the initial settings.  Only
+	// worth asking for when libcurl was built with HTTP/2 support,
+	// otherwise classes keep their HTTP/1.1 connection limits.
+	static const std::string http_http2("HttpHTTP2");
+	if (gSavedSettings.controlExists(http_http2))
+	{
+		// Default to false (in ctor) if absent.
+		mHttp2 = gSavedSettings.getbool(http_http2);
+	}
+	if (mHttp2 && ! LLCore::LLHttp::isHttp2Available())
+	{
+		LL_INFOS("Init") << "libcurl lacks HTTP/2 support, multiplexing not available." << LL_ENDL;
+		mHttp2 = false;
+	}
+	LL_INFOS("Init") << "HTTP/2 " << (mHttp2 ? "enabled" : "disabled") << "!" << LL_ENDL;
+
 	// Apply initial settings
 	refreshSettings(true);
 	
@@ -449,6 +468,10 @@ void LLAppCoreHttp::refreshSettings(bool initial)
 					mHttpClasses[app_policy].mPipelined = to_pipeline;
 				}
 			}
+
+			// Multiplexing is elected at init and sized with the
+			// concurrency settings below
+			mHttpClasses[app_policy].mHttp2 = mHttp2 && init_data[i].mHttp2;
 		}
 		
 		// Get target connection concurrency value
@@ -479,10 +502,31 @@ void LLAppCoreHttp::refreshSettings(bool initial)
 			// avatars, etc.) can request additional outbound connections
 			// to other servers via 2X total connection limit.
 			//
+			// HTTP/2.  Connection limits are as for pipelining, libcurl
+			// only multiplexes once a host has answered over h2.  Hosts
+			// on plain http or HTTP/1.1 keep their per-host connections
+			// instead of collapsing onto a single serial one.
+			//
 			LLCore::HttpHandle handle;
+			if (mHttpClasses[app_policy].mHttp2)
+			{
+				handle = mRequest->setPolicyOption(LLCore::HttpRequest::PO_HTTP2_STREAMS,
+												   mHttpClasses[app_policy].mPolicy,
+												   setting,
+												   LLCore::HttpHandler::ptr_t());
+				if (LLCORE_HTTP_HANDLE_INVALID == handle)
+				{
+					status = mRequest->getStatus();
+					LL_WARNS("Init") << "Unable to set " << init_data[i].mUsage
+									 << " HTTP/2 streams.  Reason:  " << status.toString()
+									 << LL_ENDL;
+					mHttpClasses[app_policy].mHttp2 = false;
+				}
+			}
+			const bool shared(mHttpClasses[app_policy].mPipelined || mHttpClasses[app_policy].mHttp2);
 			handle = mRequest->setPolicyOption(LLCore::HttpRequest::PO_CONNECTION_LIMIT,
 											   mHttpClasses[app_policy].mPolicy,
-											   (mHttpClasses[app_policy].mPipelined ? 2 * setting : setting),
+											   (shared ? 2 * setting : setting),
                                                LLCore::HttpHandler::ptr_t());
 			if (LLCORE_HTTP_HANDLE_INVALID == handle)
 			{
@@ -495,7 +539,7 @@ void LLAppCoreHttp::refreshSettings(bool initial)
 			{
 				handle = mRequest->setPolicyOption(LLCore::HttpRequest::PO_PER_HOST_CONNECTION_LIMIT,
 												   mHttpClasses[app_policy].mPolicy,
-												   setting,
+												   long(setting),
                                                    LLCore::HttpHandler::ptr_t());
 				if (LLCORE_HTTP_HANDLE_INVALID == handle)
 				{
@@ -228,6 +228,12 @@ public:
 			return mHttpClasses[policy].mPipelined;
 		}
 
+	// Return whether a policy multiplexes requests over HTTP/2.
+	bool isHttp2(EAppPolicy policy) const
+		{
+			return mHttpClasses[policy].mHttp2;
+		}
+
 	// Apply initial or new settings from the environment.
 	void refreshSettings(bool initial);
 	
@@ -246,6 +252,7 @@ private:
 		policy_t					mPolicy;			// Policy class id for the class
 		U32							mConnLimit;
 		bool						mPipelined;
+		bool						mHttp2;				// Multiplexed over HTTP/2
 		boost::signals2::connection mSettingsSignal;	// Signal to global setting that affect this class (if any)
 	};
 		
@@ -255,6 +262,7 @@ private:
 	bool						mStopped;
 	HttpClass					mHttpClasses[AP_COUNT];
 	bool						mPipelined;				// Global setting
+	bool						mHttp2;					// Global setting, 'HttpHTTP2'
 	boost::signals2::connection	mPipelinedSignal;		// Signal for 'HttpPipelining' setting
 	boost::signals2::connection	mSSLNoVerifySignal;		// Signal for 'NoVerifySSLCert' setting
 
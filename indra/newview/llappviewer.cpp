@@ -130,11 +130,19 @@
 #include "llnotificationmanager.h"
 #include "llnotifications.h"
 #include "llnotificationsutil.h"
+#include "llobjectupdatedecoder.h"
+#include "llgeometryrebuilder.h"
+#include "llparallelcull.h"
+#include "llvolumeinstancecache.h"
+#include "llframetimingreport.h"
+#include "llavataranimationupdater.h"
+#include "llavatarimpostoratlas.h"
 
 #include "sanitycheck.h"
 #include "llleap.h"
 #include "stringize.h"
 #include "llcoros.h"
+#include "llcorehttputil.h"
 #include "llexception.h"
 #include "cef/dullahan_version.h"
 #include "vlc/libvlc_version.h"
@@ -144,6 +152,7 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/regex.hpp>
 #include <boost/throw_exception.hpp>
+#include <thread>
 
 #if LL_WINDOWS
 #	include <share.h> // For _SH_DENYWR in processMarkerFiles
@@ -1493,6 +1502,11 @@ bool LLAppViewer::doFrame()
 	LLTrace::get_frame_recording().nextPeriod();
 	LLTrace::BlockTimer::logStats();
 
+	if (LLFrameTimingReport::instanceExists())
+	{
+		LLFrameTimingReport::getInstance()->frame();
+	}
+
 	LLTrace::get_thread_recorder()->pullFromChildren();
 
 	//clear call stack records
@@ -1648,7 +1662,9 @@ bool LLAppViewer::doFrame()
 
 			// yield cooperatively when not running as foreground window
 			// and when not quiting (causes trouble at mac's cleanup stage)
+			// a frame timing report runs flat out, headless windows are never visible
 			if (!LLApp::isExiting()
+				&& !LLFrameTimingReport::instanceExists()
 				&& ((gViewerWindow && !gViewerWindow->getWindow()->getVisible())
 					|| !gFocusMgr.getAppHasFocus()))
 			{
@@ -2214,12 +2230,19 @@ bool LLAppViewer::cleanup()
     {
         mGeneralThreadPool->close();
     }
+	LLObjectUpdateDecoder::deleteSingleton();
+	LLGeometryRebuilder::deleteSingleton();
+	LLParallelCull::deleteSingleton();
+	LLVolumeInstanceCache::deleteSingleton();
+	LLAvatarAnimationUpdater::deleteSingleton();
+	LLAvatarImpostorAtlas::deleteSingleton();
 
 	sTextureFetch->shutDownTextureCacheThread() ;
 	sTextureFetch->shutDownImageDecodeThread() ;
 
 	LL_INFOS() << "Shutting down message system" << LL_ENDL;
 	end_messaging_system();
+	LLCoreHttpUtil::HttpRecording::stopRecording();
 
 	// Non-LLCurl libcurl library
 	mAppCoreHttp.cleanup();
@@ -2236,6 +2259,7 @@ bool LLAppViewer::cleanup()
     sImageDecodeThread = NULL;
 	delete mFastTimerLogThread;
 	mFastTimerLogThread = NULL;
+	LLFrameTimingReport::deleteSingleton();
 	delete sPurgeDiskCacheThread;
 	sPurgeDiskCacheThread = NULL;
     delete mGeneralThreadPool;
@@ -2347,7 +2371,21 @@ bool LLAppViewer::initThreads()
 	LLLFSThread::initClass(false);
 
 	// Image decoding
-	LLAppViewer::sImageDecodeThread = new LLImageDecodeThread(true);
+	// Several textures decode at once and large ones are split across codec
+	// threads, leaving the remaining cores to the main and other threads.
+	U32 cores = llmax(std::thread::hardware_concurrency(), 1U);
+	U32 decode_threads = gSavedSettings.getU32("ImageDecodeThreads");
+	if (!decode_threads)
+	{
+		decode_threads = llclamp(cores / 2, 1U, 8U);
+	}
+	U32 threads_per_image = gSavedSettings.getU32("ImageDecodeThreadsPerImage");
+	if (!threads_per_image)
+	{
+		threads_per_image = llmax(cores / decode_threads, 1U);
+	}
+	LLImageJ2C::setDecodeThreadsPerImage(threads_per_image);
+	LLAppViewer::sImageDecodeThread = new LLImageDecodeThread(true, decode_threads);
 	LLAppViewer::sTextureCache = new LLTextureCache(true);
 	LLAppViewer::sTextureFetch = new LLTextureFetch(LLAppViewer::getTextureCache(),
 													sImageDecodeThread,
@@ -2365,6 +2403,18 @@ bool LLAppViewer::initThreads()
 	// Mesh streaming and caching
 	gMeshRepo.init();
 
+	// Object update decoding
+	LLObjectUpdateDecoder::sEnabled = gSavedSettings.getbool("ObjectUpdateThreadedDecode");
+	LLObjectUpdateDecoder::createInstance();
+
+	// Face geometry rebuilds
+	LLGeometryRebuilder::sEnabled = gSavedSettings.getbool("RenderThreadedGeometryRebuild");
+	LLGeometryRebuilder::createInstance();
+	LLParallelCull::createInstance();
+	LLVolumeInstanceCache::createInstance();
+	LLAvatarAnimationUpdater::createInstance();
+	LLAvatarImpostorAtlas::createInstance();
+
 	LLFilePickerThread::initClass();
 	LLDirPickerThread::initClass();
 
@@ -2925,6 +2975,14 @@ bool LLAppViewer::initConfiguration()
 		LLTrace::BlockTimer::sLogName = test_name;
 	}
 
+	U32 report_frames = gSavedSettings.getU32("FrameTimingReportFrames");
+	if (report_frames > 0)
+	{
+		LLFrameTimingReport::createInstance(report_frames,
+											gSavedSettings.getF32("FrameTimingReportWarmup"),
+											gSavedSettings.getString("FrameTimingReportFile"));
+	}
+
 	if (clp.hasOption("graphicslevel"))
 	{
         // User explicitly requested --graphicslevel on the command line. We
@@ -4398,7 +4456,7 @@ U32 LLAppViewer::getObjectCacheVersion()
 {
 	// Viewer object cache version, change if object update
 	// format changes. JC
-	const U32 INDRA_OBJECT_CACHE_VERSION = 15;
+	const U32 INDRA_OBJECT_CACHE_VERSION = 16;
 
 	return INDRA_OBJECT_CACHE_VERSION;
 }
@@ -5640,6 +5698,13 @@ void LLAppViewer::disconnectViewer()
 	// Also writes cached agent settings to gSavedSettings
 	gAgent.cleanup();
 
+	// Object updates still being decoded have to reach their region caches
+	// before the regions below save them.
+	if (LLObjectUpdateDecoder::instanceExists())
+	{
+		LLObjectUpdateDecoder::getInstance()->flushAll();
+	}
+
 	// This is where we used to call gObjectList.destroy() and then delete gWorldp.
 	// Now we just ask the LLWorld singleton to cleanly shut down.
 	if(LLWorld::instanceExists())
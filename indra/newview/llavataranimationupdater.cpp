@@ -0,0 +1,179 @@
+/**
+ * @file llavataranimationupdater.cpp
+ * @brief Evaluates avatar motions for many avatars at once on a worker pool
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llavataranimationupdater.h"
+
+#include "lljoint.h"
+#include "llviewercontrol.h"
+#include "llvoavatar.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+static LLTrace::BlockTimerStatHandle FTM_PARALLEL_AVATAR_ANIMATION("Parallel Avatar Animation");
+static LLTrace::BlockTimerStatHandle FTM_FINISH_AVATAR_ANIMATION("Finish Avatar Animation");
+
+// The avatars of one update() call, handed out in order to whoever asks
+// next.  It outlives update() if a worker only gets to it afterwards.
+struct LLAvatarAnimationBatch
+{
+	LLAvatarAnimationBatch(const std::vector<LLPointer<LLVOAvatar> >& avatars)
+		: mNext(0), mDone(0)
+	{
+		mAvatars.reserve(avatars.size());
+		for (LLVOAvatar* avatar : avatars)
+		{
+			if (!avatar->isDead())
+			{
+				mAvatars.push_back(avatar);
+			}
+		}
+		mJointTouches.resize(mAvatars.size(), 0);
+		mJointUpdates.resize(mAvatars.size(), 0);
+	}
+
+	void run()
+	{
+		const U32 count = (U32)mAvatars.size();
+		for (U32 i = mNext++; i < count; i = mNext++)
+		{
+			// the joint debug counts are per thread, keep this avatar's apart
+			// for the main thread to pick up
+			S32 touches = LLJoint::sNumTouches;
+			S32 updates = LLJoint::sNumUpdates;
+
+			mAvatars[i]->animateCharacter();
+
+			mJointTouches[i] = LLJoint::sNumTouches - touches;
+			mJointUpdates[i] = LLJoint::sNumUpdates - updates;
+			LLJoint::sNumTouches = touches;
+			LLJoint::sNumUpdates = updates;
+
+			if (++mDone == count)
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mDoneCondition.notify_all();
+			}
+		}
+	}
+
+	void wait()
+	{
+		const U32 count = (U32)mAvatars.size();
+		std::unique_lock<std::mutex> lock(mMutex);
+		mDoneCondition.wait(lock, [this, count]() { return mDone.load() == count; });
+	}
+
+	// raw pointers, update() holds the references until every task is done
+	std::vector<LLVOAvatar*>	mAvatars;
+	std::vector<S32>			mJointTouches;
+	std::vector<S32>			mJointUpdates;
+	std::atomic<U32>			mNext;
+	std::atomic<U32>			mDone;
+	std::mutex					mMutex;
+	std::condition_variable		mDoneCondition;
+};
+
+LLAvatarAnimationUpdater::LLAvatarAnimationUpdater()
+	// Each task is one avatar's skeleton; four threads keep up with a
+	// crowded region on most machines.  Override with "ThreadPoolSizes".
+	: LL::ThreadPool("AvatarAnimation", 4)
+{
+	LL::ThreadPool::start();
+}
+
+LLAvatarAnimationUpdater::~LLAvatarAnimationUpdater()
+{
+	LL::ThreadPool::close();
+}
+
+//static
+bool LLAvatarAnimationUpdater::isEnabled()
+{
+	static LLCachedControl<bool> parallel_animation(gSavedSettings, "AvatarParallelAnimation", true);
+	return parallel_animation && instanceExists();
+}
+
+void LLAvatarAnimationUpdater::add(LLVOAvatar* avatar)
+{
+	mPending.push_back(avatar);
+}
+
+void LLAvatarAnimationUpdater::update()
+{
+	if (mPending.empty())
+	{
+		return;
+	}
+
+	std::shared_ptr<LLAvatarAnimationBatch> batch = std::make_shared<LLAvatarAnimationBatch>(mPending);
+
+	{
+		LL_RECORD_BLOCK_TIME(FTM_PARALLEL_AVATAR_ANIMATION);
+
+		const U32 count = (U32)batch->mAvatars.size();
+		size_t helpers = count ? llmin(getWidth(), (size_t)count - 1) : 0;
+		for (size_t i = 0; i < helpers; ++i)
+		{
+			// if the pool is shutting down the main thread does it all
+			getQueue().postIfOpen([batch]()
+				{
+					batch->run();
+				});
+		}
+
+		batch->run();
+
+		// the remaining avatars are already being animated by workers
+		batch->wait();
+	}
+
+	LL_RECORD_BLOCK_TIME(FTM_FINISH_AVATAR_ANIMATION);
+
+	// swap out first, finishing an idle update can add or kill avatars
+	std::vector<LLPointer<LLVOAvatar> > avatars;
+	avatars.swap(mPending);
+
+	for (U32 i = 0; i < batch->mAvatars.size(); ++i)
+	{
+		LLVOAvatar* avatar = batch->mAvatars[i];
+		if (avatar->isDead())
+		{
+			continue;
+		}
+
+		LLJoint::sNumTouches += batch->mJointTouches[i];
+		LLJoint::sNumUpdates += batch->mJointUpdates[i];
+
+		bool detailed_update = avatar->finishCharacterUpdate();
+		avatar->idleUpdateAfterAnimation(detailed_update);
+	}
+}
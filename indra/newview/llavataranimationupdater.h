@@ -0,0 +1,76 @@
+/**
+ * @file llavataranimationupdater.h
+ * @brief Evaluates avatar motions for many avatars at once on a worker pool
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+
+#ifndef LL_LLAVATARANIMATIONUPDATER_H
+#define LL_LLAVATARANIMATIONUPDATER_H
+
+#include "llpointer.h"
+#include "llsingleton.h"
+#include "threadpool.h"
+
+#include <vector>
+
+class LLVOAvatar;
+
+// LLAvatarAnimationUpdater takes motion evaluation for other residents'
+// avatars off the main thread.  LLVOAvatar::idleUpdate() runs
+// prepareCharacterUpdate() (motion loading and purging, sitting, root
+// position) and queues the avatar here instead of animating it; once the
+// idle loop is done, update() runs animateCharacter() (keyframes,
+// constraints, blending and the joint world matrices) of every queued
+// avatar on the "AvatarAnimation" thread pool, one avatar per task, then
+// finishes each of them on the main thread: head offset, footstep sounds,
+// lip sync, name tags and the rest of idleUpdate().
+//
+// An avatar's motions only touch its own joints and visual params, so
+// avatars are independent of each other.  Self and animated objects stay
+// on the serial path.  "AvatarParallelAnimation" switches it off.
+class LLAvatarAnimationUpdater : public LLSimpleton<LLAvatarAnimationUpdater>, LL::ThreadPool
+{
+	LOG_CLASS(LLAvatarAnimationUpdater);
+public:
+	// LL::ThreadPool is an LLInstanceTracker and has its own getInstance()
+	using LLSimpleton<LLAvatarAnimationUpdater>::getInstance;
+	using LLSimpleton<LLAvatarAnimationUpdater>::instanceExists;
+
+	LLAvatarAnimationUpdater();
+	~LLAvatarAnimationUpdater();
+
+	static bool isEnabled();
+
+	// main thread: avatar has been through prepareCharacterUpdate() this frame
+	void add(LLVOAvatar* avatar);
+
+	// main thread: animate every avatar added since the last call and wait
+	// for all of them, then finish their idle updates
+	void update();
+
+private:
+	std::vector<LLPointer<LLVOAvatar> > mPending;
+};
+
+#endif // LL_LLAVATARANIMATIONUPDATER_H
@@ -0,0 +1,203 @@
+/**
+ * @file llavatarimpostoratlas.cpp
+ * @brief Texture atlas shared by all avatar impostors
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llavatarimpostoratlas.h"
+
+#include "llviewercontrol.h"
+
+// the largest impostor LLPipeline::generateImpostor() renders
+static const U32 MAX_SLOT_SIZE = 512;
+
+LLAvatarImpostorAtlas::LLAvatarImpostorAtlas()
+{
+	reset();
+}
+
+void LLAvatarImpostorAtlas::reset()
+{
+	U32 size = llclamp(gSavedSettings.getU32("RenderAvatarImpostorAtlasSize"), MAX_SLOT_SIZE, (U32) 8192);
+	mSize = MAX_SLOT_SIZE;
+	while (mSize * 2 <= size)
+	{
+		mSize *= 2;
+	}
+	mMaxSlotSize = MAX_SLOT_SIZE;
+
+	S32 levels = 1;
+	for (U32 side = mSize; side > MIN_SLOT_SIZE; side >>= 1)
+	{
+		++levels;
+	}
+	mFree.clear();
+	mFree.resize(levels);
+	mFree[0].insert(makeKey(0, 0));
+}
+
+void LLAvatarImpostorAtlas::setNumImpostors(U32 count)
+{
+	U32 per_row = 1;
+	while (per_row * per_row < count)
+	{
+		per_row *= 2;
+	}
+	mMaxSlotSize = llclamp(mSize / per_row, (U32) MIN_SLOT_SIZE, MAX_SLOT_SIZE);
+}
+
+S32 LLAvatarImpostorAtlas::getLevel(U32 size) const
+{
+	S32 level = 0;
+	for (U32 side = mSize; side > size; side >>= 1)
+	{
+		++level;
+	}
+	return level;
+}
+
+bool LLAvatarImpostorAtlas::allocate(U32 size, Slot& slot)
+{
+	S32 level = getLevel(size);
+	S32 l = level;
+	while (l >= 0 && mFree[l].empty())
+	{
+		--l;
+	}
+	if (l < 0)
+	{
+		return false;
+	}
+
+	U32 key = *mFree[l].begin();
+	mFree[l].erase(mFree[l].begin());
+	U32 x = key >> 16;
+	U32 y = key & 0xFFFF;
+
+	// split down to the requested size, keeping the first quarter each time
+	for (; l < level; ++l)
+	{
+		U32 half = mSize >> (l + 1);
+		mFree[l + 1].insert(makeKey(x + half, y));
+		mFree[l + 1].insert(makeKey(x, y + half));
+		mFree[l + 1].insert(makeKey(x + half, y + half));
+	}
+
+	slot.mX = (U16) x;
+	slot.mY = (U16) y;
+	slot.mSize = (U16) size;
+	return true;
+}
+
+void LLAvatarImpostorAtlas::free(Slot& slot)
+{
+	if (!slot.isValid())
+	{
+		return;
+	}
+
+	U32 x = slot.mX;
+	U32 y = slot.mY;
+	U32 size = slot.mSize;
+	S32 level = getLevel(size);
+	slot = Slot();
+
+	// merge with the other three quarters of the parent while they are free
+	while (level > 0)
+	{
+		U32 parent = size * 2;
+		U32 px = x & ~(parent - 1);
+		U32 py = y & ~(parent - 1);
+		const U32 quarters[] = { makeKey(px, py), makeKey(px + size, py), makeKey(px, py + size), makeKey(px + size, py + size) };
+
+		bool all_free = true;
+		for (U32 key : quarters)
+		{
+			if (key != makeKey(x, y) && mFree[level].find(key) == mFree[level].end())
+			{
+				all_free = false;
+				break;
+			}
+		}
+		if (!all_free)
+		{
+			break;
+		}
+
+		for (U32 key : quarters)
+		{
+			mFree[level].erase(key);
+		}
+		x = px;
+		y = py;
+		size = parent;
+		--level;
+	}
+
+	mFree[level].insert(makeKey(x, y));
+}
+
+bool LLAvatarImpostorAtlas::assign(Slot& slot, U32 width, U32 height)
+{
+	U32 size = llclamp(llmax(width, height), (U32) MIN_SLOT_SIZE, mMaxSlotSize);
+	if (!slot.isValid() || slot.mSize != size)
+	{
+		// the old square is free again while looking, so a full atlas still
+		// gives back at least that much
+		free(slot);
+		while (size >= MIN_SLOT_SIZE && !allocate(size, slot))
+		{
+			size >>= 1;
+		}
+		if (!slot.isValid())
+		{
+			return false;
+		}
+	}
+
+	// scale both sides alike so a smaller slot keeps the aspect ratio
+	U32 longest = llmax(width, height);
+	if (longest > slot.mSize)
+	{
+		width = llmax(width * slot.mSize / longest, (U32) 1);
+		height = llmax(height * slot.mSize / longest, (U32) 1);
+	}
+	slot.mWidth = (U16) width;
+	slot.mHeight = (U16) height;
+	return true;
+}
+
+void LLAvatarImpostorAtlas::getTexCoords(const Slot& slot, LLVector2& tc_min, LLVector2& tc_max) const
+{
+	F32 scale = 1.f / (F32) mSize;
+	tc_min.set(slot.mX * scale, slot.mY * scale);
+	tc_max.set((slot.mX + slot.mWidth) * scale, (slot.mY + slot.mHeight) * scale);
+}
+
+void LLAvatarImpostorAtlas::release()
+{
+	mTarget.release();
+	reset();
+}
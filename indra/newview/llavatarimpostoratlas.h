@@ -0,0 +1,103 @@
+/**
+ * @file llavatarimpostoratlas.h
+ * @brief Texture atlas shared by all avatar impostors
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLAVATARIMPOSTORATLAS_H
+#define LL_LLAVATARIMPOSTORATLAS_H
+
+#include "llrendertarget.h"
+#include "llsingleton.h"
+#include "v2math.h"
+
+#include <set>
+#include <vector>
+
+// Every avatar impostor used to be its own LLRenderTarget, so GPU memory
+// grew with the crowd.  LLAvatarImpostorAtlas is a single render target of
+// "RenderAvatarImpostorAtlasSize" squared that LLPipeline::generateImpostor()
+// renders each impostor into a square slot of, handed out by a quadtree
+// buddy allocator.  LLVOAvatar::updateImpostors() caps the slot size so
+// every impostor holding a slot fits at once, takes slots back from
+// impostors out of view for a while, and regenerates at most
+// "RenderAvatarImpostorUpdateBudget" impostors a frame, largest on screen
+// and longest waiting first.
+class LLAvatarImpostorAtlas : public LLSimpleton<LLAvatarImpostorAtlas>
+{
+	LOG_CLASS(LLAvatarImpostorAtlas);
+public:
+	static constexpr U32 MIN_SLOT_SIZE = 32;
+
+	// a square of the atlas, the impostor uses mWidth x mHeight of it
+	struct Slot
+	{
+		Slot() : mX(0), mY(0), mSize(0), mWidth(0), mHeight(0) {}
+		bool isValid() const { return mSize != 0; }
+
+		U16 mX;
+		U16 mY;
+		U16 mSize;
+		U16 mWidth;
+		U16 mHeight;
+	};
+
+	LLAvatarImpostorAtlas();
+
+	// allocated by LLPipeline::generateImpostor() on first use
+	LLRenderTarget& getTarget() { return mTarget; }
+	U32 getSize() const { return mSize; }
+
+	// size the slots for this many impostors sharing the atlas
+	void setNumImpostors(U32 count);
+	U32 getMaxSlotSize() const { return mMaxSlotSize; }
+
+	// main thread: make slot hold a width x height impostor (powers of two),
+	// reusing it if it is the right size and shrinking the request, both
+	// sides alike, while the atlas is too full; false and an invalid slot
+	// if nothing fits
+	bool assign(Slot& slot, U32 width, U32 height);
+	void free(Slot& slot);
+
+	// texture coordinates of the part of slot the impostor uses
+	void getTexCoords(const Slot& slot, LLVector2& tc_min, LLVector2& tc_max) const;
+
+	// drop the render target and every slot, avatars forget theirs in
+	// LLVOAvatar::resetImpostors(); picks up a new atlas size
+	void release();
+
+private:
+	void reset();
+	bool allocate(U32 size, Slot& slot);
+	S32 getLevel(U32 size) const;
+
+	static U32 makeKey(U32 x, U32 y) { return (x << 16) | y; }
+
+	LLRenderTarget mTarget;
+	U32 mSize;
+	U32 mMaxSlotSize;
+	// free squares per level, level l squares have a side of mSize >> l
+	std::vector<std::set<U32> > mFree;
+};
+
+#endif // LL_LLAVATARIMPOSTORATLAS_H
@@ -197,8 +197,9 @@ LLVector3 LLBreastMotion::calculateAcceleration_local(const LLVector3 &new_char_
 
 bool LLBreastMotion::onUpdate(F32 time, U8* joint_mask)
 {
-	// Skip if disabled globally.
-	if (!gSavedSettings.getbool("AvatarPhysics"))
+	// Skip if disabled globally.  Cached, this can run on an animation worker.
+	static LLCachedControl<bool> avatar_physics(gSavedSettings, "AvatarPhysics", true);
+	if (!avatar_physics)
 	{
 		return true;
 	}
@@ -320,7 +321,8 @@ bool LLBreastMotion::onUpdate(F32 time, U8* joint_mask)
 	mBreastVelocity_local_vec.clamp(-mBreastMaxVelocityParam*100.0, mBreastMaxVelocityParam*100.0);
 
 	// Temporary debugging setting to cause all avatars to move, for profiling purposes.
-	if (gSavedSettings.getbool("AvatarPhysicsTest"))
+	static LLCachedControl<bool> avatar_physics_test(gSavedSettings, "AvatarPhysicsTest", false);
+	if (avatar_physics_test)
 	{
 		mBreastVelocity_local_vec[0] = sin(mTimer.getElapsedTimeF32()*4.0)*5.0;
 		mBreastVelocity_local_vec[1] = sin(mTimer.getElapsedTimeF32()*3.0)*5.0;
@@ -427,12 +427,17 @@ void LLRenderPass::renderRiggedGroup(LLSpatialGroup* group, U32 type, U32 mask,
 
 void LLRenderPass::pushBatches(U32 type, U32 mask, bool texture, bool batch_textures)
 {
-	for (LLCullResult::drawinfo_iterator i = gPipeline.beginRenderMap(type); i != gPipeline.endRenderMap(type); ++i)
+	LLCullResult::drawinfo_iterator end = gPipeline.endRenderMap(type);
+	for (LLCullResult::drawinfo_iterator i = gPipeline.beginRenderMap(type); i != end; )
 	{
 		LLDrawInfo* pparams = *i;
 		if (pparams) 
 		{
-			pushBatch(*pparams, mask, texture, batch_textures);
+			i = pushBatchRun(i, end, mask, texture, batch_textures);
+		}
+		else
+		{
+			++i;
 		}
 	}
 }
@@ -442,7 +447,8 @@ void LLRenderPass::pushRiggedBatches(U32 type, U32 mask, bool texture, bool batc
     LLVOAvatar* lastAvatar = nullptr;
     U64 lastMeshId = 0;
     mask |= LLVertexBuffer::MAP_WEIGHT4;
-    for (LLCullResult::drawinfo_iterator i = gPipeline.beginRenderMap(type); i != gPipeline.endRenderMap(type); ++i)
+    LLCullResult::drawinfo_iterator end = gPipeline.endRenderMap(type);
+    for (LLCullResult::drawinfo_iterator i = gPipeline.beginRenderMap(type); i != end; )
     {
         LLDrawInfo* pparams = *i;
         if (pparams)
@@ -454,20 +460,29 @@ void LLRenderPass::pushRiggedBatches(U32 type, U32 mask, bool texture, bool batc
                 lastMeshId = pparams->mSkinInfo->mHash;
             }
 
-            pushBatch(*pparams, mask, texture, batch_textures);
+            i = pushBatchRun(i, end, mask, texture, batch_textures);
+        }
+        else
+        {
+            ++i;
         }
     }
 }
 
 void LLRenderPass::pushMaskBatches(U32 type, U32 mask, bool texture, bool batch_textures)
 {
-	for (LLCullResult::drawinfo_iterator i = gPipeline.beginRenderMap(type); i != gPipeline.endRenderMap(type); ++i)
+	LLCullResult::drawinfo_iterator end = gPipeline.endRenderMap(type);
+	for (LLCullResult::drawinfo_iterator i = gPipeline.beginRenderMap(type); i != end; )
 	{
 		LLDrawInfo* pparams = *i;
 		if (pparams) 
 		{
 			LLGLSLShader::sCurBoundShaderPtr->setMinimumAlpha(pparams->mAlphaMaskCutoff);
-			pushBatch(*pparams, mask, texture, batch_textures);
+			i = pushBatchRun(i, end, mask, texture, batch_textures);
+		}
+		else
+		{
+			++i;
 		}
 	}
 }
@@ -476,7 +491,8 @@ void LLRenderPass::pushRiggedMaskBatches(U32 type, U32 mask, bool texture, bool
 {
     LLVOAvatar* lastAvatar = nullptr;
     U64 lastMeshId = 0;
-    for (LLCullResult::drawinfo_iterator i = gPipeline.beginRenderMap(type); i != gPipeline.endRenderMap(type); ++i)
+    LLCullResult::drawinfo_iterator end = gPipeline.endRenderMap(type);
+    for (LLCullResult::drawinfo_iterator i = gPipeline.beginRenderMap(type); i != end; )
     {
         LLDrawInfo* pparams = *i;
         if (pparams)
@@ -497,11 +513,90 @@ void LLRenderPass::pushRiggedMaskBatches(U32 type, U32 mask, bool texture, bool
                 lastMeshId = pparams->mSkinInfo->mHash;
             }
 
-            pushBatch(*pparams, mask | LLVertexBuffer::MAP_WEIGHT4, texture, batch_textures);
+            i = pushBatchRun(i, end, mask | LLVertexBuffer::MAP_WEIGHT4, texture, batch_textures);
+        }
+        else
+        {
+            ++i;
         }
     }
 }
 
+LLDrawInfo** LLRenderPass::sBatchRunBegin = nullptr;
+LLDrawInfo** LLRenderPass::sBatchRunEnd = nullptr;
+
+LLDrawInfo** LLRenderPass::pushBatchRun(LLDrawInfo** begin, LLDrawInfo** end, U32 mask, bool texture, bool batch_textures)
+{
+	LLDrawInfo& params = **begin;
+	LLDrawInfo** run_end = begin + 1;
+	if (LLPipeline::RenderBatchMerge)
+	{
+		while (run_end != end && *run_end && params.sharesBatchState(**run_end))
+		{
+			++run_end;
+		}
+	}
+
+	sBatchRunBegin = begin + 1;
+	sBatchRunEnd = run_end;
+	pushBatch(params, mask, texture, batch_textures);
+
+	// pushBatch() returned without drawing or doesn't go through drawBatch(),
+	// push whatever is left of the run one at a time
+	LLDrawInfo** remaining = sBatchRunBegin;
+	sBatchRunBegin = sBatchRunEnd = nullptr;
+	for (; remaining != run_end; ++remaining)
+	{
+		pushBatch(**remaining, mask, texture, batch_textures);
+	}
+
+	return run_end;
+}
+
+// static
+void LLRenderPass::drawBatch(LLDrawInfo& params, U32 mask)
+{
+	params.mVertexBuffer->setBufferFast(mask);
+
+	if (sBatchRunBegin == sBatchRunEnd)
+	{
+		params.mVertexBuffer->drawRangeFast(params.mDrawMode, params.mStart, params.mEnd, params.mCount, params.mOffset);
+		return;
+	}
+
+	// scratch space for the merged ranges, only ever touched by the render thread
+	static std::vector<U32> counts;
+	static std::vector<U32> offsets;
+	counts.assign(1, params.mCount);
+	offsets.assign(1, params.mOffset);
+
+	U32 start = params.mStart;
+	U32 end = params.mEnd;
+	for (LLDrawInfo** i = sBatchRunBegin; i != sBatchRunEnd; ++i)
+	{
+		const LLDrawInfo& next = **i;
+		if (!next.mCount)
+		{
+			continue;
+		}
+
+		start = llmin(start, (U32) next.mStart);
+		end = llmax(end, (U32) next.mEnd);
+		if (next.mOffset == offsets.back() + counts.back())
+		{ //contiguous with the previous range, extend it
+			counts.back() += next.mCount;
+		}
+		else
+		{
+			counts.push_back(next.mCount);
+			offsets.push_back(next.mOffset);
+		}
+	}
+	sBatchRunBegin = sBatchRunEnd;
+
+	params.mVertexBuffer->drawRangesFast(params.mDrawMode, start, end, &counts[0], &offsets[0], (U32) counts.size());
+}
+
 void LLRenderPass::applyModelMatrix(const LLDrawInfo& params)
 {
 	if (params.mModelMatrix != gGLLastMatrix)
@@ -568,8 +663,7 @@ void LLRenderPass::pushBatch(LLDrawInfo& params, U32 mask, bool texture, bool ba
 
     LLGLEnableFunc stencil_test(GL_STENCIL_TEST, params.mSelected, &LLGLCommonFunc::selected_stencil_test);
 
-    params.mVertexBuffer->setBufferFast(mask);
-    params.mVertexBuffer->drawRangeFast(params.mDrawMode, params.mStart, params.mEnd, params.mCount, params.mOffset);
+    drawBatch(params, mask);
 
 	if (tex_setup)
 	{
@@ -206,10 +206,25 @@ public:
 	virtual void pushMaskBatches(U32 type, U32 mask, bool texture = true, bool batch_textures = false);
     virtual void pushRiggedMaskBatches(U32 type, U32 mask, bool texture = true, bool batch_textures = false);
 	virtual void pushBatch(LLDrawInfo& params, U32 mask, bool texture, bool batch_textures = false);
+
+	// push *begin along with the draw infos after it that share its GL state
+	// (see LLDrawInfo::sharesBatchState), returns the first draw info not pushed
+	LLDrawInfo** pushBatchRun(LLDrawInfo** begin, LLDrawInfo** end, U32 mask, bool texture, bool batch_textures = false);
+
+	// bind params.mVertexBuffer and draw params, folding in the rest of the
+	// run pushBatchRun() is pushing when there is one
+	static void drawBatch(LLDrawInfo& params, U32 mask);
+
     static bool uploadMatrixPalette(LLDrawInfo& params);
     static bool uploadMatrixPalette(LLVOAvatar* avatar, LLMeshSkinInfo* skinInfo);
 	virtual void renderGroup(LLSpatialGroup* group, U32 type, U32 mask, bool texture = true);
     virtual void renderRiggedGroup(LLSpatialGroup* group, U32 type, U32 mask, bool texture = true);
+
+private:
+	// draw infos following the one pushBatchRun() passes to pushBatch(),
+	// empty once drawBatch() has drawn them
+	static LLDrawInfo** sBatchRunBegin;
+	static LLDrawInfo** sBatchRunEnd;
 };
 
 class LLFacePool : public LLDrawPool
@@ -876,22 +876,23 @@ void LLDrawPoolAvatar::renderAvatars(LLVOAvatar* single_avatar, S32 pass)
 //		if (impostor || (LLVOAvatar::AV_DO_NOT_RENDER == avatarp->getVisualMuteSettings() && !avatarp->needsImpostorUpdate()))
 		if (impostor || (LLVOAvatar::AOA_NORMAL != avatarp->getOverallAppearance() && !avatarp->needsImpostorUpdate()))
 		{
-			if (LLPipeline::sRenderDeferred && !LLPipeline::sReflectionRender && avatarp->mImpostor.isComplete()) 
+			LLRenderTarget& impostor_target = LLAvatarImpostorAtlas::getInstance()->getTarget();
+			if (LLPipeline::sRenderDeferred && !LLPipeline::sReflectionRender && avatarp->hasImpostor() && impostor_target.isComplete()) 
 			{
 				// <FS:Ansariel> FIRE-9179: Crash fix
 				//if (normal_channel > -1)
-				U32 num_tex = avatarp->mImpostor.getNumTextures();
+				U32 num_tex = impostor_target.getNumTextures();
 				if (normal_channel > -1 && num_tex >= 3)
 				// </FS:Ansariel>
 				{
-					avatarp->mImpostor.bindTexture(2, normal_channel);
+					impostor_target.bindTexture(2, normal_channel);
 				}
 				// <FS:Ansariel> FIRE-9179: Crash fix
 				//if (specular_channel > -1)
 				if (specular_channel > -1 && num_tex >= 2)
 				// </FS:Ansariel>
 				{
-					avatarp->mImpostor.bindTexture(1, specular_channel);
+					impostor_target.bindTexture(1, specular_channel);
 				}
 			}
 			avatarp->renderImpostor(avatarp->getMutedAVColor(), sDiffuseChannel);
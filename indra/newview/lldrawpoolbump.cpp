@@ -1311,7 +1311,7 @@ void LLDrawPoolBump::renderBump(U32 type, U32 mask)
     LLCullResult::drawinfo_iterator begin = gPipeline.beginRenderMap(type);
     LLCullResult::drawinfo_iterator end = gPipeline.endRenderMap(type);
 
-	for (LLCullResult::drawinfo_iterator i = begin; i != end; ++i)	
+	for (LLCullResult::drawinfo_iterator i = begin; i != end; )	
 	{
 		LLDrawInfo& params = **i;
 
@@ -1328,11 +1328,17 @@ void LLDrawPoolBump::renderBump(U32 type, U32 mask)
                     }
                     else
                     {
+                        ++i;
                         continue;
                     }
                 }
             }
-			pushBatch(params, mask, false);
+			// a run shares mBump and mTexture, so the bump map bound above serves all of it
+			i = pushBatchRun(i, end, mask, false);
+		}
+		else
+		{
+			++i;
 		}
 	}
 }
@@ -1393,8 +1399,7 @@ void LLDrawPoolBump::pushBatch(LLDrawInfo& params, U32 mask, bool texture, bool
 	{
 		params.mGroup->rebuildMesh();
 	}
-	params.mVertexBuffer->setBufferFast(mask);
-	params.mVertexBuffer->drawRangeFast(params.mDrawMode, params.mStart, params.mEnd, params.mCount, params.mOffset);
+	drawBatch(params, mask);
 
     if (tex_setup)
 	{
@@ -56,6 +56,7 @@
 #include "llviewertexture.h"
 #include "llvoavatar.h"
 #include "llsculptidsize.h"
+#include "llvolumeinstancecache.h"
 #include "llmeshrepository.h"
 
 
@@ -214,6 +215,8 @@ void LLFace::destroy()
 	
 	setDrawInfo(NULL);
 
+	releaseSharedGeometry();
+
 	mDrawablep = NULL;
 	mVObjp = NULL;
 }
@@ -424,6 +427,7 @@ void LLFace::setSize(S32 num_vertices, S32 num_indices, bool align)
 	{
 		mGeomCount    = num_vertices;
 		mIndicesCount = num_indices;
+		releaseSharedGeometry();
 		mVertexBuffer = NULL;
 	}
 
@@ -435,6 +439,7 @@ void LLFace::setGeomIndex(U16 idx)
 	if (mGeomIndex != idx)
 	{
 		mGeomIndex = idx; 
+		releaseSharedGeometry();
 		mVertexBuffer = NULL;
 	}
 }
@@ -464,6 +469,7 @@ void LLFace::setIndicesIndex(S32 idx)
 	if (mIndicesIndex != idx)
 	{
 		mIndicesIndex = idx; 
+		releaseSharedGeometry();
 		mVertexBuffer = NULL;
 	}
 }
@@ -546,6 +552,10 @@ void LLFace::renderSelected(LLViewerTexture *imagep, const LLColor4& color)
 		{
 			gGL.multMatrix((GLfloat*)mDrawablep->getRenderMatrix().mMatrix);
 		}
+		else if (isState(INSTANCED))
+		{
+			gGL.multMatrix((GLfloat*)mDrawablep->getVOVolume()->getInstanceXform().mMatrix);
+		}
 		else
 		{
 			gGL.multMatrix((GLfloat*)mDrawablep->getRegion()->mRenderMatrix.mMatrix);
@@ -559,6 +569,13 @@ void LLFace::renderSelected(LLViewerTexture *imagep, const LLColor4& color)
 			if (volume)
 			{
 				LLRiggedVolume* rigged = volume->getRiggedVolume();
+				if (rigged && !rigged->hasSkinnedPositions())
+				{
+					// bounds-only updates leave the vertices in an old pose,
+					// skin them before outlining a selected or highlighted face
+					volume->updateRiggedVolume(false, LLRiggedVolume::UPDATE_ALL_FACES, false);
+					rigged = volume->getRiggedVolume();
+				}
 				if (rigged)
 				{
                     // called when selecting a face during edit of a mesh object
@@ -2700,6 +2717,8 @@ LLViewerTexture* LLFace::getTexture(U32 ch) const
 
 void LLFace::setVertexBuffer(LLVertexBuffer* buffer)
 {
+	releaseSharedGeometry();
+
 	if (buffer)
 	{
 		LLSculptIDSize::instance().inc(mDrawablep, buffer->getSize() + buffer->getIndicesSize());
@@ -2716,6 +2735,8 @@ void LLFace::setVertexBuffer(LLVertexBuffer* buffer)
 
 void LLFace::clearVertexBuffer()
 {
+	releaseSharedGeometry();
+
 	if (mVertexBuffer)
 	{
 		LLSculptIDSize::instance().dec(mDrawablep);
@@ -2724,6 +2745,18 @@ void LLFace::clearVertexBuffer()
 	mVertexBuffer = NULL;
 }
 
+void LLFace::releaseSharedGeometry()
+{
+	if (isState(INSTANCED))
+	{
+		clearState(INSTANCED);
+		if (mVertexBuffer && LLVolumeInstanceCache::instanceExists())
+		{
+			LLVolumeInstanceCache::getInstance()->removeUser(mVertexBuffer);
+		}
+	}
+}
+
 S32 LLFace::getRiggedIndex(U32 type) const
 {
 	if (mRiggedIndex.empty())
@@ -79,6 +79,7 @@ public:
 		TEXTURE_ANIM	= 0x0020, 
 		RIGGED			= 0x0040,
 		PARTICLE		= 0x0080,
+		INSTANCED		= 0x0100,	// drawn from geometry shared with identical faces, see LLVolumeInstanceCache
 	};
 
 	static void cacheFaceInVRAM(const LLVolumeFace& vf);
@@ -269,6 +270,9 @@ public:
     U64 getSkinHash();
 
 private:
+	// stop drawing from LLVolumeInstanceCache geometry, if this face was
+	void releaseSharedGeometry();
+
 	LLPointer<LLVertexBuffer> mVertexBuffer;
 		
 	U32			mState;
@@ -0,0 +1,180 @@
+/**
+ * @file llframetimingreport.cpp
+ * @brief Block timer breakdown of a fixed number of frames, as JSON
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llframetimingreport.h"
+
+#include "llappviewer.h"
+#include "llcharacter.h"
+#include "llfasttimer.h"
+#include "llgl.h"
+#include "llkeyframemotion.h"
+#include "llsdjson.h"
+#include "llstartup.h"
+#include "lltrace.h"
+#include "lltracerecording.h"
+#include "llviewercontrol.h"
+#include "llviewerobjectlist.h"
+#include "llworld.h"
+#include "writer.h" // JSON
+
+#include <algorithm>
+
+// keyframe sampling run on the clips the session loaded
+static const U32 ANIMATION_BENCHMARK_AVATARS = 100;
+static const U32 ANIMATION_BENCHMARK_MOTIONS = 20;
+static const U32 ANIMATION_BENCHMARK_FRAMES = 60;
+
+LLFrameTimingReport::LLFrameTimingReport(U32 frames, F32 warmup_seconds, const std::string& filename)
+:	mState(WAIT_FOR_WORLD),
+	mFrames(frames),
+	mWarmupSeconds(warmup_seconds),
+	mFilename(filename)
+{
+	mFrameMS.reserve(frames);
+}
+
+void LLFrameTimingReport::frame()
+{
+	switch (mState)
+	{
+	case WAIT_FOR_WORLD:
+		if (LLStartUp::getStartupState() >= STATE_STARTED)
+		{
+			LL_INFOS() << "In world, recording " << mFrames << " frames after " << mWarmupSeconds << " seconds" << LL_ENDL;
+			mWarmupTimer.reset();
+			mState = WARMUP;
+		}
+		break;
+	case WARMUP:
+		if (mWarmupTimer.getElapsedTimeF32() >= mWarmupSeconds)
+		{ //the frame that just ended is still warmup, start with the next one
+			mState = RECORDING;
+		}
+		break;
+	case RECORDING:
+		record();
+		if (mFrameMS.size() >= mFrames)
+		{
+			writeReport();
+			mState = DONE;
+			LLAppViewer::instance()->forceQuit();
+		}
+		break;
+	case DONE:
+		break;
+	}
+}
+
+void LLFrameTimingReport::record()
+{
+	LLTrace::Recording& last_frame = LLTrace::get_frame_recording().getLastRecording();
+
+	mFrameMS.push_back(last_frame.getDuration().valueInUnits<LLUnits::Milliseconds>());
+
+	for (auto& base : LLTrace::BlockTimerStatHandle::instance_snapshot())
+	{
+		// because of indirect derivation from LLInstanceTracker, have to downcast
+		LLTrace::BlockTimerStatHandle& timer = static_cast<LLTrace::BlockTimerStatHandle&>(base);
+		S32 calls = last_frame.getSum(timer.callCount());
+		if (calls <= 0)
+		{
+			continue;
+		}
+
+		F64 ms = last_frame.getSum(timer).valueInUnits<LLUnits::Milliseconds>();
+		TimerStats& stats = mTimers[timer.getName()];
+		stats.mTotalMS += ms;
+		stats.mMaxMS = llmax(stats.mMaxMS, ms);
+		stats.mCalls += calls;
+	}
+}
+
+void LLFrameTimingReport::writeReport()
+{
+	const F64 frames = (F64) mFrameMS.size();
+
+	std::vector<F64> sorted(mFrameMS);
+	std::sort(sorted.begin(), sorted.end());
+	F64 total_ms = 0.0;
+	for (F64 ms : sorted)
+	{
+		total_ms += ms;
+	}
+
+	LLSD report;
+	report["frames"] = (LLSD::Integer) mFrameMS.size();
+	report["frame_ms"]["mean"] = total_ms / frames;
+	report["frame_ms"]["median"] = sorted[sorted.size() / 2];
+	report["frame_ms"]["p95"] = sorted[llmin(sorted.size() - 1, (size_t) (frames * 0.95))];
+	report["frame_ms"]["min"] = sorted.front();
+	report["frame_ms"]["max"] = sorted.back();
+
+	report["replay"]["file"] = gSavedSettings.getBOOL("PacketReplayOffline") ? gSavedSettings.getString("PacketReplayFile") : std::string();
+	report["replay"]["fixed_frame_step"] = LLFrameTimer::isFixedFrameStep();
+	report["replay"]["frame_step"] = gSavedSettings.getF32("PacketReplayFrameStep");
+
+	report["scene"]["objects"] = gObjectList.getNumObjects();
+	report["scene"]["avatars"] = (LLSD::Integer) LLCharacter::sInstances.size();
+	report["scene"]["regions"] = (LLSD::Integer) LLWorld::getInstance()->getRegionList().size();
+
+	U32 motions = 0;
+	report["animation"]["sample_ms_per_frame"] = LLKeyframeDataCache::benchmark(ANIMATION_BENCHMARK_AVATARS, ANIMATION_BENCHMARK_MOTIONS, ANIMATION_BENCHMARK_FRAMES, motions);
+	report["animation"]["avatars"] = (LLSD::Integer) ANIMATION_BENCHMARK_AVATARS;
+	report["animation"]["motions"] = (LLSD::Integer) motions;
+	report["animation"]["cached_clips"] = (LLSD::Integer) LLKeyframeDataCache::sKeyframeDataMap.size();
+	report["animation"]["cached_bytes"] = (LLSD::Integer) LLKeyframeDataCache::sizeBytes();
+
+	report["gl"]["vendor"] = gGLManager.mGLVendor;
+	report["gl"]["renderer"] = gGLManager.mGLRenderer;
+	report["gl"]["version"] = gGLManager.mGLVersionString;
+
+	for (auto& timer : mTimers)
+	{
+		const TimerStats& stats = timer.second;
+		LLSD& entry = report["timers"][timer.first];
+		entry["total_ms"] = stats.mTotalMS;
+		entry["ms_per_frame"] = stats.mTotalMS / frames;
+		entry["max_ms"] = stats.mMaxMS;
+		entry["calls_per_frame"] = (F64) stats.mCalls / frames;
+	}
+
+	std::string filename = gDirUtilp->getExpandedFilename(LL_PATH_LOGS, mFilename);
+	llofstream out(filename.c_str());
+	if (!out.is_open())
+	{
+		LL_WARNS() << "Unable to write frame timing report to " << filename << LL_ENDL;
+		return;
+	}
+
+	Json::StyledStreamWriter writer;
+	writer.write(out, LlsdToJson(report));
+	out.close();
+
+	LL_INFOS() << "Frame timing report: " << mFrameMS.size() << " frames, " << total_ms / frames
+		<< " ms mean frame time, report written to " << filename << LL_ENDL;
+}
@@ -0,0 +1,94 @@
+/**
+ * @file llframetimingreport.h
+ * @brief Block timer breakdown of a fixed number of frames, as JSON
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLFRAMETIMINGREPORT_H
+#define LL_LLFRAMETIMINGREPORT_H
+
+#include "llsingleton.h"
+#include "llframetimer.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+// LLFrameTimingReport records where frame time goes.  Once the viewer is
+// in world it waits "FrameTimingReportWarmup" seconds of frame time, then
+// accumulates every LLTrace block timer (cull, state sort, geometry
+// rebuilds, the render passes...) for "FrameTimingReportFrames" frames,
+// writes the totals and per-frame figures as JSON to "FrameTimingReportFile"
+// in the logs directory and quits.  The report also times sampling 20 of
+// the keyframe animations the session loaded for 100 avatars, see
+// LLKeyframeDataCache::benchmark().
+//
+// In a live session the figures depend on the region.  For numbers that
+// can be compared run to run, record a session once with --recordpackets
+// and run the report off it with --replaypackets <file> --replayoffline: the
+// scene, login and HTTP replies come from the recording, nothing goes to
+// the grid, and the frame clock steps "PacketReplayFrameStep" seconds per
+// frame, so every run sees the same objects arrive on the same frame.  The
+// <viewer>-headless target (BUILD_HEADLESS) draws into an OSMesa offscreen
+// context for machines with no display or GPU.
+class LLFrameTimingReport : public LLSimpleton<LLFrameTimingReport>
+{
+	LOG_CLASS(LLFrameTimingReport);
+public:
+	LLFrameTimingReport(U32 frames, F32 warmup_seconds, const std::string& filename);
+
+	// call once per frame, right after the frame recording moved on
+	void frame();
+
+private:
+	void record();
+	void writeReport();
+
+	struct TimerStats
+	{
+		TimerStats() : mTotalMS(0.0), mMaxMS(0.0), mCalls(0) {}
+
+		F64 mTotalMS;
+		F64 mMaxMS;
+		U64 mCalls;
+	};
+
+	enum EState
+	{
+		WAIT_FOR_WORLD,
+		WARMUP,
+		RECORDING,
+		DONE
+	};
+
+	EState		mState;
+	U32			mFrames;
+	F32			mWarmupSeconds;
+	std::string	mFilename;
+	LLFrameTimer	mWarmupTimer;	// frame time, fixed steps when replaying offline
+
+	std::map<std::string, TimerStats> mTimers;
+	std::vector<F64> mFrameMS;
+};
+
+#endif // LL_LLFRAMETIMINGREPORT_H
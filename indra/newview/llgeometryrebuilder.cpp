@@ -0,0 +1,164 @@
+/**
+ * @file llgeometryrebuilder.cpp
+ * @brief Worker-thread stage of LLVolumeGeometryManager::rebuildGeom()
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llgeometryrebuilder.h"
+
+#include "llface.h"
+#include "lltextureentry.h"
+#include "llvertexbuffer.h"
+#include "llvolume.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+bool LLGeometryRebuilder::sEnabled = true;
+
+// below this many faces per thread, waking another worker costs more than it saves
+static const U32 MIN_FACES_PER_WORKER = 16;
+
+static LLTrace::BlockTimerStatHandle FTM_GEOMETRY_REBUILD_FINISH("Threaded Geometry Rebuild");
+
+// The queued faces of one finish() call.  Workers and the main thread take
+// faces from it in order until none are left; it outlives finish() if a
+// worker only gets to it afterwards.
+struct LLGeometryRebuilder::Batch
+{
+	Batch() : mNext(0), mDone(0) {}
+
+	void run()
+	{
+		const U32 count = (U32)mJobs.size();
+		for (U32 i = mNext++; i < count; i = mNext++)
+		{
+			Job& job = mJobs[i];
+			job.mResult = job.mFace->getGeometryVolume(*job.mVolume, job.mTEOffset,
+				job.mMatVert, job.mMatNorm, job.mIndexOffset, true);
+			mDone++;
+		}
+	}
+
+	std::vector<Job>	mJobs;
+	std::atomic<U32>	mNext;
+	std::atomic<U32>	mDone;
+};
+
+static size_t default_rebuild_threads()
+{
+	// leave the main thread and the GL driver a core each
+	size_t cores = std::thread::hardware_concurrency();
+	return llclamp(cores > 2 ? cores - 2 : 1, (size_t)1, (size_t)6);
+}
+
+LLGeometryRebuilder::LLGeometryRebuilder()
+	// Override with "ThreadPoolSizes".
+	: LL::ThreadPool("GeometryRebuild", default_rebuild_threads())
+{
+	LL::ThreadPool::start();
+}
+
+LLGeometryRebuilder::~LLGeometryRebuilder()
+{
+	LL::ThreadPool::close();
+}
+
+void LLGeometryRebuilder::addBuffer(LLVertexBuffer* buffer)
+{
+	buffer->mapForThreadedWrite();
+	mBuffers.push_back(buffer);
+}
+
+void LLGeometryRebuilder::addFace(LLFace* facep, LLVolume* volume, S32 te_offset,
+								  const LLMatrix4& mat_vert, const LLMatrix3& mat_norm, U16 index_offset)
+{
+	if (te_offset < volume->getNumVolumeFaces())
+	{
+		// Tangents are generated lazily by getGeometryVolume() and volumes are
+		// shared between objects, so make sure they exist before going wide.
+		const LLTextureEntry* te = facep->getTextureEntry();
+		if (facep->getVertexBuffer()->hasDataType(LLVertexBuffer::TYPE_TANGENT) ||
+			(te && (te->getBumpmap() || te->getTexGen() != LLTextureEntry::TEX_GEN_DEFAULT)))
+		{
+			volume->genTangents(te_offset);
+		}
+	}
+
+	Job job;
+	job.mFace = facep;
+	job.mVolume = volume;
+	job.mTEOffset = te_offset;
+	job.mMatVert = mat_vert;
+	job.mMatNorm = mat_norm;
+	job.mIndexOffset = index_offset;
+	job.mResult = false;
+	mJobs.push_back(job);
+}
+
+void LLGeometryRebuilder::finish()
+{
+	if (!mJobs.empty())
+	{
+		LL_RECORD_BLOCK_TIME(FTM_GEOMETRY_REBUILD_FINISH);
+
+		std::shared_ptr<Batch> batch = std::make_shared<Batch>();
+		batch->mJobs.swap(mJobs);
+
+		const U32 count = (U32)batch->mJobs.size();
+		size_t helpers = llmin(getWidth(), (size_t)(count / MIN_FACES_PER_WORKER));
+		for (size_t i = 0; i < helpers; ++i)
+		{
+			// if the pool is shutting down the main thread does it all
+			getQueue().postIfOpen([batch]()
+				{
+					batch->run();
+				});
+		}
+
+		batch->run();
+
+		// the remaining faces are already being written by workers
+		while (batch->mDone.load() < count)
+		{
+			std::this_thread::yield();
+		}
+
+		for (const Job& job : batch->mJobs)
+		{
+			if (!job.mResult)
+			{
+				LL_WARNS() << "Failed to get geometry for face!" << LL_ENDL;
+			}
+		}
+	}
+
+	for (LLPointer<LLVertexBuffer>& buffer : mBuffers)
+	{
+		buffer->flush();
+	}
+	mBuffers.clear();
+}
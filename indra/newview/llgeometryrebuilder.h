@@ -0,0 +1,98 @@
+/**
+ * @file llgeometryrebuilder.h
+ * @brief Worker-thread stage of LLVolumeGeometryManager::rebuildGeom()
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLGEOMETRYREBUILDER_H
+#define LL_LLGEOMETRYREBUILDER_H
+
+#include "llsingleton.h"
+#include "llpointer.h"
+#include "m3math.h"
+#include "m4math.h"
+#include "threadpool.h"
+
+#include <vector>
+
+class LLFace;
+class LLVolume;
+class LLVertexBuffer;
+
+// LLGeometryRebuilder splits the face geometry generation of
+// LLVolumeGeometryManager::genDrawInfo() into a CPU phase and a GL phase.
+// genDrawInfo() still allocates the vertex buffers and lays out the faces on
+// the main thread, but instead of calling LLFace::getGeometryVolume() inline
+// it maps each buffer in full (LLVertexBuffer::mapForThreadedWrite()) and
+// queues the faces here.  finish() then fills the buffers on the
+// "GeometryRebuild" thread pool, with the main thread working alongside, and
+// uploads them once every face is written.
+//
+// Everything a queued face reads (its drawable, object, volume and texture
+// entry) must stay untouched until finish() returns, so finish() is called
+// from the same rebuildGeom() that queued the faces.
+class LLGeometryRebuilder : public LLSimpleton<LLGeometryRebuilder>, LL::ThreadPool
+{
+	LOG_CLASS(LLGeometryRebuilder);
+public:
+	// LL::ThreadPool is an LLInstanceTracker and has its own getInstance()
+	using LLSimpleton<LLGeometryRebuilder>::getInstance;
+	using LLSimpleton<LLGeometryRebuilder>::instanceExists;
+
+	// follows gSavedSettings "RenderThreadedGeometryRebuild"
+	static bool sEnabled;
+
+	LLGeometryRebuilder();
+	~LLGeometryRebuilder();
+
+	static bool isEnabled() { return sEnabled && instanceExists(); }
+
+	// main thread: map a freshly laid out buffer so faces can be queued into it
+	void addBuffer(LLVertexBuffer* buffer);
+
+	// main thread: queue one face of a buffer passed to addBuffer()
+	void addFace(LLFace* facep, LLVolume* volume, S32 te_offset,
+				 const LLMatrix4& mat_vert, const LLMatrix3& mat_norm, U16 index_offset);
+
+	// main thread: write every queued face, then flush the buffers
+	void finish();
+
+private:
+	struct Job
+	{
+		LLFace*		mFace;
+		LLVolume*	mVolume;
+		S32			mTEOffset;
+		LLMatrix4	mMatVert;
+		LLMatrix3	mMatNorm;
+		U16			mIndexOffset;
+		bool		mResult;
+	};
+
+	struct Batch;
+
+	std::vector<Job> mJobs;
+	std::vector<LLPointer<LLVertexBuffer> > mBuffers;
+};
+
+#endif // LL_LLGEOMETRYREBUILDER_H
@@ -46,6 +46,7 @@
 #include "llfloaterpreviewtrash.h"
 #include "llnotificationsutil.h"
 #include "llmarketplacefunctions.h"
+#include "llmemorystream.h"
 #include "llwindow.h"
 #include "llviewercontrol.h"
 #include "llviewernetwork.h"
@@ -1519,6 +1520,27 @@ void LLInventoryModel::onAISUpdateReceived(const std::string& context, const LLS
 	LL_INFOS(LOG_INV) << "elapsed: " << timer.getElapsedTimeF32() << LL_ENDL;
 }
 
+bool LLInventoryModel::onAISUpdateReceived(const std::string& context, const LLSD::Binary& body, LLSD& top_level)
+{
+	LLTimer timer;
+	if (gSavedSettings.getbool("DebugAvatarAppearanceMessage"))
+	{
+		LLSD update;
+		LLMemoryStream istr(body.empty() ? NULL : &body[0], (S32)body.size());
+		LLSDSerialize::fromXML(update, istr);
+		dump_sequential_xml(gAgentAvatarp->getFullname() + "_ais_update", update);
+	}
+
+	AISUpdate ais_update(body, top_level); // parse the body into stuff to do.
+	if (top_level.isUndefined())
+	{
+		return false;
+	}
+	ais_update.doUpdate(); // execute the updates in the appropriate order.
+	LL_INFOS(LOG_INV) << "elapsed: " << timer.getElapsedTimeF32() << LL_ENDL;
+	return true;
+}
+
 // Does not appear to be used currently.
 void LLInventoryModel::onItemUpdated(const LLUUID& item_id, const LLSD& updates, bool update_parent_version)
 {
@@ -2960,72 +2982,66 @@ bool LLUUIDAndName::operator>(const LLUUIDAndName& rhs) const
 	return (mID > rhs.mID);
 }
 
-// static
-bool LLInventoryModel::loadFromFile(const std::string& filename,
-									LLInventoryModel::cat_array_t& categories,
-									LLInventoryModel::item_array_t& items,
-									LLInventoryModel::changed_items_t& cats_to_update,
-									bool &is_cache_obsolete)
+// Consumes one inventory cache entry (one top level LLSD value) at a time
+// for loadFromFile().
+class LLInventoryCacheReader : public LLSDSubtreeHandler
 {
-	if(filename.empty())
+public:
+	LLInventoryCacheReader(LLInventoryModel::cat_array_t& categories,
+						   LLInventoryModel::item_array_t& items,
+						   LLInventoryModel::changed_items_t& cats_to_update,
+						   bool& is_cache_obsolete,
+						   S32 cache_version)
+		: LLSDSubtreeHandler(0),
+		  mCategories(categories),
+		  mItems(items),
+		  mCatsToUpdate(cats_to_update),
+		  mIsCacheObsolete(is_cache_obsolete),
+		  mCacheVersion(cache_version),
+		  mDone(false)
 	{
-		LL_ERRS(LOG_INV) << "filename is Null!" << LL_ENDL;
-		return false;
 	}
-	LL_INFOS(LOG_INV) << "loading inventory from: (" << filename << ")" << LL_ENDL;
 
-	llifstream file(filename.c_str());
+	// True if reading stopped because the cache turned out to be unusable
+	// rather than because of a parse error.
+	bool isDone() const { return mDone; }
 
-	if (!file.is_open())
+	virtual bool subtree(const std::string&, const LLSD& s_item)
 	{
-		LL_INFOS(LOG_INV) << "unable to load inventory from: " << filename << LL_ENDL;
-		return false;
+		mDone = !readEntry(s_item);
+		return !mDone;
 	}
 
-	is_cache_obsolete = true; // Obsolete until proven current
-
-	std::string line;
-	LLPointer<LLSDParser> parser = new LLSDNotationParser();
-	while (std::getline(file, line)) 
+private:
+	bool readEntry(const LLSD& s_item)
 	{
-		LLSD s_item;
-		std::istringstream iss(line);
-		if (parser->parse(iss, s_item, line.length()) == LLSDParser::PARSE_FAILURE)
-		{
-			LL_WARNS(LOG_INV)<< "Parsing inventory cache failed" << LL_ENDL;
-			break;
-		}
-
 		if (s_item.has("inv_cache_version"))
 		{
 			S32 version = s_item["inv_cache_version"].asInteger();
-			if (version == sCurrentInvCacheVersion)
+			if (version == mCacheVersion)
 			{
 				// Cache is up to date
-				is_cache_obsolete = false;
-				continue;
-			}
-			else
-			{
-				LL_WARNS(LOG_INV)<< "Inventory cache is out of date" << LL_ENDL;
-				break;
+				mIsCacheObsolete = false;
+				return true;
 			}
+			LL_WARNS(LOG_INV)<< "Inventory cache is out of date" << LL_ENDL;
+			return false;
 		}
 		else if (s_item.has("cat_id"))
 		{
-			if (is_cache_obsolete)
-				break;
+			if (mIsCacheObsolete)
+				return false;
 
 			LLPointer<LLViewerInventoryCategory> inv_cat = new LLViewerInventoryCategory(LLUUID::null);
 			if(inv_cat->importLLSD(s_item))
 			{
-				categories.push_back(inv_cat);
+				mCategories.push_back(inv_cat);
 			}
 		}
 		else if (s_item.has("item_id"))
 		{
-			if (is_cache_obsolete)
-				break;
+			if (mIsCacheObsolete)
+				return false;
 
 			LLPointer<LLViewerInventoryItem> inv_item = new LLViewerInventoryItem;
 			if( inv_item->fromLLSD(s_item) )
@@ -3039,15 +3055,69 @@ bool LLInventoryModel::loadFromFile(const std::string& filename,
 				{
 					if (inv_item->getType() == LLAssetType::AT_UNKNOWN)
 					{
-						cats_to_update.insert(inv_item->getParentUUID());
+						mCatsToUpdate.insert(inv_item->getParentUUID());
 					}
 					else
 					{
-						items.push_back(inv_item);
+						mItems.push_back(inv_item);
 					}
 				}
 			}	
 		}
+		return true;
+	}
+
+	LLInventoryModel::cat_array_t& mCategories;
+	LLInventoryModel::item_array_t& mItems;
+	LLInventoryModel::changed_items_t& mCatsToUpdate;
+	bool& mIsCacheObsolete;
+	S32 mCacheVersion;
+	bool mDone;
+};
+
+bool LLInventoryModel::loadFromFile(const std::string& filename,
+									LLInventoryModel::cat_array_t& categories,
+									LLInventoryModel::item_array_t& items,
+									LLInventoryModel::changed_items_t& cats_to_update,
+									bool &is_cache_obsolete)
+{
+	if(filename.empty())
+	{
+		LL_ERRS(LOG_INV) << "filename is Null!" << LL_ENDL;
+		return false;
+	}
+	LL_INFOS(LOG_INV) << "loading inventory from: (" << filename << ")" << LL_ENDL;
+
+	llifstream file(filename.c_str());
+
+	if (!file.is_open())
+	{
+		LL_INFOS(LOG_INV) << "unable to load inventory from: " << filename << LL_ENDL;
+		return false;
+	}
+
+	is_cache_obsolete = true; // Obsolete until proven current
+
+	// Entries are read straight off the file one at a time; neither the
+	// file nor a line of it is buffered.  Sizes in the data are still
+	// bounded by the size of the file.
+	file.seekg(0, std::ios::end);
+	std::streamsize file_size = file.tellg();
+	file.seekg(0, std::ios::beg);
+
+	LLInventoryCacheReader reader(categories, items, cats_to_update, is_cache_obsolete,
+								  sCurrentInvCacheVersion);
+	LLPointer<LLSDParser> parser = new LLSDNotationParser();
+	S32 parse_count;
+	do
+	{
+		parse_count = parser->parse(file, reader, file_size);
+	}
+	while (parse_count > 0);
+
+	if (parse_count == LLSDParser::PARSE_FAILURE && !reader.isDone())
+	{
+		LL_WARNS(LOG_INV)<< "Parsing inventory cache failed" << LL_ENDL;
 	}
 
 	file.close();
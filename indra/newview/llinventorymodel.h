@@ -427,6 +427,9 @@ public:
 
 	// Update model after an AISv3 update received for any operation.
 	void onAISUpdateReceived(const std::string& context, const LLSD& update);
+	// Same, reading the LLSD XML response body as a stream; see AISUpdate.
+	// Returns false if the body could not be read.
+	bool onAISUpdateReceived(const std::string& context, const LLSD::Binary& body, LLSD& top_level);
 		
 	// Update model after an item is confirmed as removed from
 	// server. Works for categories or items.
@@ -58,6 +58,7 @@
 #include "llviewerregion.h"
 #include "llviewertexturelist.h"
 #include "llvolume.h"
+#include "llvolumeinstancecache.h"
 #include "llvolumemgr.h"
 #include "llvovolume.h"
 #include "llworld.h"
@@ -109,6 +110,7 @@
 //
 //   main     Main rendering thread, very sensitive to locking and other stalls
 //   repo     Overseeing worker thread associated with the LLMeshRepoThread class
+//   decode   LLMeshRepoThread::mDecodePool threads unpacking LOD and skin info bodies
 //   decom    Worker thread for mesh decomposition requests
 //   core     HTTP worker thread:  does the work but doesn't intrude here
 //   uploadN  0-N temporary mesh upload threads (0-1 in practice)
@@ -149,12 +151,17 @@
 //                             ...
 //                             onCompleted() invoked for GET
 //                               data copied
-//                               lodReceived() invoked
+//                               decodeLOD() invoked
+//                                 post to decode pool
+//                             ...
+//                             (decode pool) lodReceived() invoked
 //                                 unpack data into LLVolume
 //                                 append LoadedMesh to mLoadedQ
+//                                 write data to cache
 //                             ...
 //         notifyLoadedMeshes() invoked again
-//           scan mLoadedQ
+//           move mLoadedQ to mPublishQ
+//           scan mPublishQ until MeshPublishBudgetMS is spent
 //           notifyMeshLoaded() for LOD
 //             setMeshAssetLoaded() invoked for system volume
 //             notifyMeshLoaded() invoked for each interested object
@@ -222,9 +229,9 @@
 //     sLODPending                     mMeshMutex [4]  rw.main.mMeshMutex
 //     sLODProcessing                  Repo::mMutex    rw.any.Repo::mMutex
 //     sCacheBytesRead                 none            rw.repo.none, ro.main.none [1]
-//     sCacheBytesWritten              "
-//     sCacheReads                     "
-//     sCacheWrites                    "
+//     sCacheBytesWritten              std::atomic     rw.repo.none, rw.decode.none, ro.main.none
+//     sCacheReads                     none            rw.repo.none, ro.main.none [1]
+//     sCacheWrites                    std::atomic     rw.repo.none, rw.decode.none, ro.main.none
 //     mLoadingMeshes                  mMeshMutex [4]  rw.main.none, rw.any.mMeshMutex
 //     mSkinMap                        none            rw.main.none
 //     mDecompositionMap               none            rw.main.none
@@ -248,14 +255,15 @@
 //     sMaxConcurrentRequests   mMutex        wo.main.none, ro.repo.none, ro.main.mMutex
 //     mMeshHeader              mHeaderMutex  rw.repo.mHeaderMutex, ro.main.mHeaderMutex, ro.main.none [0]
 //     mSkinRequests            mMutex        rw.repo.mMutex, ro.repo.none [5]
-//     mSkinInfoQ               mMutex        rw.repo.mMutex, rw.main.mMutex [5] (was:  [0])
+//     mSkinInfoQ               mMutex        rw.decode.mMutex, rw.main.mMutex [5] (was:  [0])
 //     mDecompositionRequests   mMutex        rw.repo.mMutex, ro.repo.none [5]
 //     mPhysicsShapeRequests    mMutex        rw.repo.mMutex, ro.repo.none [5]
 //     mDecompositionQ          mMutex        rw.repo.mMutex, rw.main.mMutex [5] (was:  [0])
 //     mHeaderReqQ              mMutex        ro.repo.none [5], rw.repo.mMutex, rw.any.mMutex
 //     mLODReqQ                 mMutex        ro.repo.none [5], rw.repo.mMutex, rw.any.mMutex
-//     mUnavailableQ            mMutex        rw.repo.none [0], ro.main.none [5], rw.main.mMutex
-//     mLoadedQ                 mMutex        rw.repo.mMutex, ro.main.none [5], rw.main.mMutex
+//     mUnavailableQ            mMutex        rw.repo.none [0], rw.decode.mMutex, ro.main.none [5], rw.main.mMutex
+//     mLoadedQ                 mMutex        rw.decode.mMutex, ro.main.none [5], rw.main.mMutex
+//     mPublishQ                none          rw.main.none
 //     mPendingLOD              mMutex        rw.repo.mMutex, rw.any.mMutex
 //     mGetMeshCapability       mMutex        rw.main.mMutex, ro.repo.mMutex (was:  [0])
 //     mGetMesh2Capability      mMutex        rw.main.mMutex, ro.repo.mMutex (was:  [0])
@@ -382,12 +390,12 @@ U32 LLMeshRepository::sLODProcessing = 0;
 U32 LLMeshRepository::sLODPending = 0;
 
 U32 LLMeshRepository::sCacheBytesRead = 0;
-U32 LLMeshRepository::sCacheBytesWritten = 0;
+std::atomic<U32> LLMeshRepository::sCacheBytesWritten(0);
 U32 LLMeshRepository::sCacheBytesHeaders = 0;
 U32 LLMeshRepository::sCacheBytesSkins = 0;
 U32 LLMeshRepository::sCacheBytesDecomps = 0;
 U32 LLMeshRepository::sCacheReads = 0;
-U32 LLMeshRepository::sCacheWrites = 0;
+std::atomic<U32> LLMeshRepository::sCacheWrites(0);
 U32 LLMeshRepository::sMaxLockHoldoffs = 0;
 	
 LLDeadmanTimer LLMeshRepository::sQuiescentTimer(15.0, false);	// true -> gather cpu metrics
@@ -845,7 +853,8 @@ LLMeshRepoThread::LLMeshRepoThread()
   mHttpHeaders(),
   mHttpPolicyClass(LLCore::HttpRequest::DEFAULT_POLICY_ID),
   mHttpLargePolicyClass(LLCore::HttpRequest::DEFAULT_POLICY_ID),
-  mHttpPriority(0)
+  mHttpPriority(0),
+  mDecodePool(NULL)
 {
 	LLAppCoreHttp & app_core_http(LLAppViewer::instance()->getAppCoreHttp());
 
@@ -863,6 +872,11 @@ LLMeshRepoThread::LLMeshRepoThread()
 	mHttpHeaders->append(HTTP_OUT_HEADER_ACCEPT, HTTP_CONTENT_VND_LL_MESH);
 	mHttpPolicyClass = app_core_http.getPolicy(LLAppCoreHttp::AP_MESH2);
 	mHttpLargePolicyClass = app_core_http.getPolicy(LLAppCoreHttp::AP_LARGE_MESH);
+
+	// Two threads keep up with a crowd of rigged avatars arriving at once
+	// without competing with texture decode.  Override with "ThreadPoolSizes".
+	mDecodePool = new LL::ThreadPool("MeshDecode", 2);
+	mDecodePool->start();
 }
 
 
@@ -876,6 +890,10 @@ LLMeshRepoThread::~LLMeshRepoThread()
 	mHttpRequestSet.clear();
     mHttpHeaders.reset();
 
+	// let decodes in flight finish before their queues and mMutex go away
+	delete mDecodePool;
+	mDecodePool = NULL;
+
 	while (!mSkinInfoQ.empty())
     {
         delete mSkinInfoQ.front();
@@ -960,7 +978,7 @@ void LLMeshRepoThread::run()
                     // failed to load before, wait a bit
                     incomplete.push_front(req);
                 }
-                else if (!fetchMeshLOD(req.mMeshParams, req.mLOD, req.canRetry()))
+                else if (!fetchMeshLOD(req.mMeshParams, req.mLOD, req.canRetry(), req.mSkipCache))
                 {
                     if (req.canRetry())
                     {
@@ -1060,7 +1078,7 @@ void LLMeshRepoThread::run()
 					{
 						incomplete.emplace_back(req);
 					}
-					else if (!fetchMeshSkinInfo(req.mId, req.canRetry()))
+					else if (!fetchMeshSkinInfo(req.mId, req.canRetry(), req.mSkipCache))
 					{
 						if (req.canRetry())
 						{
@@ -1339,7 +1357,7 @@ LLCore::HttpHandle LLMeshRepoThread::getByteRange(const std::string & url,
 }
 
 
-bool LLMeshRepoThread::fetchMeshSkinInfo(const LLUUID& mesh_id, bool can_retry)
+bool LLMeshRepoThread::fetchMeshSkinInfo(const LLUUID& mesh_id, bool can_retry, bool skip_cache)
 {
 	
 	if (!mHeaderMutex)
@@ -1373,7 +1391,7 @@ bool LLMeshRepoThread::fetchMeshSkinInfo(const LLUUID& mesh_id, bool can_retry)
 		{
 			//check cache for mesh skin info
 			LLFileSystem file(mesh_id, LLAssetType::AT_MESH);
-			if (file.getSize() >= offset+size)
+			if (!skip_cache && file.getSize() >= offset+size)
 			{
 				U8* buffer = new(std::nothrow) U8[size];
 				if (!buffer)
@@ -1404,12 +1422,9 @@ bool LLMeshRepoThread::fetchMeshSkinInfo(const LLUUID& mesh_id, bool can_retry)
 				}
 
 				if (!zero)
-				{ //attempt to parse
-					if (skinInfoReceived(mesh_id, buffer, size))
-					{						
-						delete[] buffer;
-						return true;
-					}
+				{ //parse on the decode pool, it asks the sim if that fails
+					decodeSkinInfo(mesh_id, std::shared_ptr<U8>(buffer, std::default_delete<U8[]>()), size, -1);
+					return true;
 				}
 
 				delete[] buffer;
@@ -1776,7 +1791,7 @@ bool LLMeshRepoThread::fetchMeshHeader(const LLVolumeParams& mesh_params, bool c
 }
 
 //return false if failed to get mesh lod.
-bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool can_retry)
+bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool can_retry, bool skip_cache)
 {
 	if (!mHeaderMutex)
 	{
@@ -1809,7 +1824,7 @@ bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod,
 
 			//check cache for mesh asset
 			LLFileSystem file(mesh_id, LLAssetType::AT_MESH);
-			if (file.getSize() >= offset+size)
+			if (!skip_cache && file.getSize() >= offset+size)
 			{
 				U8* buffer = new(std::nothrow) U8[size];
 				if (!buffer)
@@ -1840,17 +1855,9 @@ bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod,
 				}
 
 				if (!zero)
-				{ //attempt to parse
-					if (lodReceived(mesh_params, lod, buffer, size) == MESH_OK)
-					{
-						delete[] buffer;
-
-						std::string mid;
-						mesh_id.toString(mid);
-						LL_DEBUGS(LOG_MESH) << "Mesh/Cache: Mesh body for ID " << mid << " - was retrieved from the cache." << LL_ENDL;
-
-						return true;
-					}
+				{ //parse on the decode pool, it asks the sim if that fails
+					decodeLOD(mesh_params, lod, std::shared_ptr<U8>(buffer, std::default_delete<U8[]>()), size, -1);
+					return true;
 				}
 
 				delete[] buffer;
@@ -1923,7 +1930,9 @@ EMeshProcessingResult LLMeshRepoThread::headerReceived(const LLVolumeParams& mes
 
 		boost::iostreams::stream<boost::iostreams::array_source> stream(result_ptr, data_size);
 
-		if (!LLSDSerialize::fromBinary(header, stream, data_size))
+		LLPointer<LLSDBinaryParser> parser = new LLSDBinaryParser;
+		parser->setUseArena(true);
+		if (!parser->parse(stream, header, data_size))
 		{
 			LL_WARNS(LOG_MESH) << "Mesh header parse error.  Not a valid mesh asset!  ID:  " << mesh_id
 							   << LL_ENDL;
@@ -2058,6 +2067,112 @@ bool LLMeshRepoThread::skinInfoReceived(const LLUUID& mesh_id, U8* data, S32 dat
 	return true;
 }
 
+// Threads:  repo
+static std::shared_ptr<U8> copy_mesh_body(const U8* data, S32 data_size)
+{
+	U8* copy = new(std::nothrow) U8[llmax(data_size, 1)];
+	if (copy && data_size > 0)
+	{
+		memcpy(copy, data, data_size);
+	}
+	return std::shared_ptr<U8>(copy, std::default_delete<U8[]>());
+}
+
+// Threads:  decode pool
+static void write_mesh_cache(const LLUUID& mesh_id, S32 offset, const U8* data, S32 size)
+{
+	// <FS:Ansariel> Fix asset caching
+	LLFileSystem file(mesh_id, LLAssetType::AT_MESH, LLFileSystem::READ_WRITE);
+
+	if (file.getSize() >= offset+size)
+	{
+		file.seek(offset);
+		file.write(data, size);
+		LLMeshRepository::sCacheBytesWritten += size;
+		++LLMeshRepository::sCacheWrites;
+	}
+}
+
+void LLMeshRepoThread::decodeLOD(const LLVolumeParams& mesh_params, S32 lod, std::shared_ptr<U8> data, S32 data_size, S32 cache_offset)
+{
+	auto decode = [this, mesh_params, lod, data, data_size, cache_offset]()
+	{
+		const LLUUID& mesh_id = mesh_params.getSculptID();
+		EMeshProcessingResult result = lodReceived(mesh_params, lod, data.get(), data_size);
+		if (cache_offset < 0)
+		{
+			if (result == MESH_OK)
+			{
+				LL_DEBUGS(LOG_MESH) << "Mesh/Cache: Mesh body for ID " << mesh_id << " - was retrieved from the cache." << LL_ENDL;
+			}
+			else
+			{ //reading from cache failed for whatever reason, fetch from sim
+				LL_DEBUGS(LOG_MESH) << "Mesh/Cache: Mesh body for ID " << mesh_id << " - failed to parse, requesting it from the simulator." << LL_ENDL;
+				LODRequest req(mesh_params, lod);
+				req.mSkipCache = true;
+				LLMutexLock lock(mMutex);
+				mLODReqQ.push(req);
+				++LLMeshRepository::sLODProcessing;
+			}
+		}
+		else if (result == MESH_OK)
+		{ // good fetch from sim, write to cache
+			write_mesh_cache(mesh_id, cache_offset, data.get(), data_size);
+		}
+		else
+		{
+			LL_WARNS(LOG_MESH) << "Error during mesh LOD processing.  ID:  " << mesh_id
+							   << ", Reason: " << result
+							   << " LOD: " << lod
+							   << " Data size: " << data_size
+							   << " Not retrying."
+							   << LL_ENDL;
+			LLMutexLock lock(mMutex);
+			mUnavailableQ.push_back(LODRequest(mesh_params, lod));
+		}
+	};
+
+	if (!mDecodePool || !mDecodePool->getQueue().postIfOpen(decode))
+	{ //shutting down
+		decode();
+	}
+}
+
+void LLMeshRepoThread::decodeSkinInfo(const LLUUID& mesh_id, std::shared_ptr<U8> data, S32 data_size, S32 cache_offset)
+{
+	auto decode = [this, mesh_id, data, data_size, cache_offset]()
+	{
+		bool result = skinInfoReceived(mesh_id, data.get(), data_size);
+		if (cache_offset < 0)
+		{
+			if (!result)
+			{ //reading from cache failed for whatever reason, fetch from sim
+				UUIDBasedRequest req(mesh_id);
+				req.mSkipCache = true;
+				LLMutexLock lock(mMutex);
+				mSkinRequests.push_back(req);
+			}
+		}
+		else if (result)
+		{ // good fetch from sim, write to cache
+			write_mesh_cache(mesh_id, cache_offset, data.get(), data_size);
+		}
+		else
+		{
+			LL_WARNS(LOG_MESH) << "Error during mesh skin info processing.  ID:  " << mesh_id
+							   << ", Unknown reason.  Not retrying."
+							   << LL_ENDL;
+			LLMutexLock lock(mMutex);
+			mSkinUnavailableQ.emplace_back(mesh_id);
+		}
+	};
+
+	if (!mDecodePool || !mDecodePool->getQueue().postIfOpen(decode))
+	{ //shutting down
+		decode();
+	}
+}
+
 bool LLMeshRepoThread::decompositionReceived(const LLUUID& mesh_id, U8* data, S32 data_size)
 {
 	LLSD decomp;
@@ -2932,30 +3047,45 @@ void LLMeshRepoThread::notifyLoadedMeshes()
 
 	if (!mLoadedQ.empty())
 	{
-		std::deque<LoadedMesh> loaded_queue;
-
 		mMutex->lock();
-		if (!mLoadedQ.empty())
+		if (mPublishQ.empty())
 		{
-			loaded_queue.swap(mLoadedQ);
-			mMutex->unlock();
+			mPublishQ.swap(mLoadedQ);
+		}
+		else
+		{
+			mPublishQ.insert(mPublishQ.end(), mLoadedQ.begin(), mLoadedQ.end());
+			mLoadedQ.clear();
+		}
+		mMutex->unlock();
+	}
 
-			update_metrics = true;
+	if (!mPublishQ.empty())
+	{
+		// Every waiting object rebuilds on notifyMeshLoaded(), so a crowd of
+		// mesh avatars arriving together is spread over several frames.
+		// Always publish at least one, a budget of zero publishes everything.
+		static LLCachedControl<F32> publish_budget_ms(gSavedSettings, "MeshPublishBudgetMS", 2.f);
+		LLTimer publish_timer;
 
-			// Process the elements free of the lock
-			for (const auto& mesh : loaded_queue)
+		update_metrics = true;
+
+		do
+		{
+			const LoadedMesh& mesh = mPublishQ.front();
+			if (mesh.mVolume->getNumVolumeFaces() > 0)
 			{
-				if (mesh.mVolume->getNumVolumeFaces() > 0)
-				{
-					gMeshRepo.notifyMeshLoaded(mesh.mMeshParams, mesh.mVolume);
-				}
-				else
-				{
-					gMeshRepo.notifyMeshUnavailable(mesh.mMeshParams,
-						LLVolumeLODGroup::getVolumeDetailFromScale(mesh.mVolume->getDetail()));
-				}
+				gMeshRepo.notifyMeshLoaded(mesh.mMeshParams, mesh.mVolume);
 			}
+			else
+			{
+				gMeshRepo.notifyMeshUnavailable(mesh.mMeshParams,
+					LLVolumeLODGroup::getVolumeDetailFromScale(mesh.mVolume->getDetail()));
+			}
+			mPublishQ.pop_front();
 		}
+		while (!mPublishQ.empty()
+			   && (publish_budget_ms <= 0.f || publish_timer.getElapsedTimeF32() * 1000.f < publish_budget_ms));
 	}
 
 	if (!mUnavailableQ.empty())
@@ -3133,6 +3263,7 @@ void LLMeshHandlerBase::onCompleted(LLCore::HttpHandle handle, LLCore::HttpRespo
 		LLCore::BufferArray * body(response->getBody());
 		S32 body_offset(0);
 		U8 * data(NULL);
+		U8 * data_copy(NULL);
 		S32 data_size(body ? body->size() : 0);
 
 		if (data_size > 0)
@@ -3185,14 +3316,17 @@ void LLMeshHandlerBase::onCompleted(LLCore::HttpHandle handle, LLCore::HttpRespo
 				goto common_exit;
 			}
 			
-			// *TODO: Try to get rid of data copying and add interfaces
-			// that support BufferArray directly.  Introduce a two-phase
-			// handler, optional first that takes a body, fallback second
-			// that requires a temporary allocation and data copy.
+			// Bodies of known length arrive in one piece and are parsed
+			// in place, anything else is copied out to a temporary.
 			body_offset = mOffset - offset;
-			data = new(std::nothrow) U8[data_size - body_offset];
+			data = (U8 *) body->contiguousData(body_offset, data_size - body_offset);
 			if (data)
 			{
+				LLMeshRepository::sBytesReceived += data_size;
+			}
+			else if ((data = new(std::nothrow) U8[data_size - body_offset]))
+			{
+				data_copy = data;
 				body->read(body_offset, (char *) data, data_size - body_offset);
 				LLMeshRepository::sBytesReceived += data_size;
 			}
@@ -3205,7 +3339,7 @@ void LLMeshHandlerBase::onCompleted(LLCore::HttpHandle handle, LLCore::HttpRespo
 
 		processData(body, body_offset, data, data_size - body_offset);
 
-		delete [] data;
+		delete [] data_copy;
 	}
 
 	// Release handler
@@ -3388,36 +3522,18 @@ void LLMeshLODHandler::processData(LLCore::BufferArray * /* body */, S32 /* body
 	if ((!MESH_LOD_PROCESS_FAILED)
 		&& ((data != NULL) == (data_size > 0))) // if we have data but no size or have size but no data, something is wrong
 	{
-		EMeshProcessingResult result = gMeshRepo.mThread->lodReceived(mMeshParams, mLOD, data, data_size);
-		if (result == MESH_OK)
-		{
-			// good fetch from sim, write to cache
-			// <FS:Ansariel> Fix asset caching
-			//LLFileSystem file(mMeshParams.getSculptID(), LLAssetType::AT_MESH, LLFileSystem::WRITE);
-			LLFileSystem file(mMeshParams.getSculptID(), LLAssetType::AT_MESH, LLFileSystem::READ_WRITE);
-
-			S32 offset = mOffset;
-			S32 size = mRequestedBytes;
-
-			if (file.getSize() >= offset+size)
-			{
-				file.seek(offset);
-				file.write(data, size);
-				LLMeshRepository::sCacheBytesWritten += size;
-				++LLMeshRepository::sCacheWrites;
-			}
-		}
-		else
+		// data belongs to the response, the decode pool gets its own copy
+		std::shared_ptr<U8> body = copy_mesh_body(data, data_size);
+		if (body)
 		{
-			LL_WARNS(LOG_MESH) << "Error during mesh LOD processing.  ID:  " << mMeshParams.getSculptID()
-							   << ", Reason: " << result
-							   << " LOD: " << mLOD
-							   << " Data size: " << data_size
-							   << " Not retrying."
-							   << LL_ENDL;
-			LLMutexLock lock(gMeshRepo.mThread->mMutex);
-			gMeshRepo.mThread->mUnavailableQ.push_back(LLMeshRepoThread::LODRequest(mMeshParams, mLOD));
+			gMeshRepo.mThread->decodeLOD(mMeshParams, mLOD, body, data_size, mOffset);
+			return;
 		}
+
+		LL_WARNS(LOG_MESH) << "Failed to allocate memory for mesh LOD.  ID:  " << mMeshParams.getSculptID()
+						   << " LOD: " << mLOD
+						   << " Data size: " << data_size
+						   << LL_ENDL;
 	}
 	else
 	{
@@ -3426,9 +3542,10 @@ void LLMeshLODHandler::processData(LLCore::BufferArray * /* body */, S32 /* body
 						   << " LOD: " << mLOD
 						   << " Data size: " << data_size
 						   << LL_ENDL;
-		LLMutexLock lock(gMeshRepo.mThread->mMutex);
-		gMeshRepo.mThread->mUnavailableQ.push_back(LLMeshRepoThread::LODRequest(mMeshParams, mLOD));
 	}
+
+	LLMutexLock lock(gMeshRepo.mThread->mMutex);
+	gMeshRepo.mThread->mUnavailableQ.push_back(LLMeshRepoThread::LODRequest(mMeshParams, mLOD));
 }
 
 LLMeshSkinInfoHandler::~LLMeshSkinInfoHandler()
@@ -3453,33 +3570,21 @@ void LLMeshSkinInfoHandler::processData(LLCore::BufferArray * /* body */, S32 /*
 										U8 * data, S32 data_size)
 {
 	if ((!MESH_SKIN_INFO_PROCESS_FAILED)
-		&& ((data != NULL) == (data_size > 0)) // if we have data but no size or have size but no data, something is wrong
-		&& gMeshRepo.mThread->skinInfoReceived(mMeshID, data, data_size))
+		&& ((data != NULL) == (data_size > 0))) // if we have data but no size or have size but no data, something is wrong
 	{
-		// good fetch from sim, write to cache
-		// <FS:Ansariel> Fix asset caching
-		//LLFileSystem file(mMeshID, LLAssetType::AT_MESH, LLFileSystem::WRITE);
-		LLFileSystem file(mMeshID, LLAssetType::AT_MESH, LLFileSystem::READ_WRITE);
-
-		S32 offset = mOffset;
-		S32 size = mRequestedBytes;
-
-		if (file.getSize() >= offset+size)
+		std::shared_ptr<U8> body = copy_mesh_body(data, data_size);
+		if (body)
 		{
-			LLMeshRepository::sCacheBytesWritten += size;
-			++LLMeshRepository::sCacheWrites;
-			file.seek(offset);
-			file.write(data, size);
+			gMeshRepo.mThread->decodeSkinInfo(mMeshID, body, data_size, mOffset);
+			return;
 		}
 	}
-	else
-	{
-		LL_WARNS(LOG_MESH) << "Error during mesh skin info processing.  ID:  " << mMeshID
-						   << ", Unknown reason.  Not retrying."
-						   << LL_ENDL;
-		LLMutexLock lock(gMeshRepo.mThread->mMutex);
-		gMeshRepo.mThread->mSkinUnavailableQ.emplace_back(mMeshID);
-	}
+
+	LL_WARNS(LOG_MESH) << "Error during mesh skin info processing.  ID:  " << mMeshID
+					   << ", Unknown reason.  Not retrying."
+					   << LL_ENDL;
+	LLMutexLock lock(gMeshRepo.mThread->mMutex);
+	gMeshRepo.mThread->mSkinUnavailableQ.emplace_back(mMeshID);
 }
 
 LLMeshDecompositionHandler::~LLMeshDecompositionHandler()
@@ -4122,8 +4227,12 @@ void LLMeshRepository::notifyMeshLoaded(const LLVolumeParams& mesh_params, LLVol
 		{ //update system volume
 			LLVolume* sys_volume = LLPrimitive::getVolumeManager()->refVolume(mesh_params, detail);
 			if (sys_volume)
-			{
-				sys_volume->copyVolumeFaces(volume);
+			{ //the loaded volume is dropped after this, take its faces rather than copying them
+				if (LLVolumeInstanceCache::instanceExists())
+				{ //shared buffers built from the placeholder faces no longer match
+					LLVolumeInstanceCache::getInstance()->purgeVolume(sys_volume);
+				}
+				sys_volume->moveVolumeFaces(volume);
 				sys_volume->setMeshAssetLoaded(TRUE);
 				LLPrimitive::getVolumeManager()->unrefVolume(sys_volume);
 			}
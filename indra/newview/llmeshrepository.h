@@ -27,6 +27,8 @@
 #ifndef LL_MESH_REPOSITORY_H
 #define LL_MESH_REPOSITORY_H
 
+#include <atomic>
+#include <memory>
 #include <unordered_map>
 #include "llassettype.h"
 #include "llmodel.h"
@@ -40,6 +42,7 @@
 #include "httpheaders.h"
 #include "httphandler.h"
 #include "llthread.h"
+#include "threadpool.h"
 
 #define LLCONVEXDECOMPINTER_STATIC 1
 
@@ -235,9 +238,10 @@ public:
 		LLVolumeParams  mMeshParams;
 		S32 mLOD;
 		F32 mScore;
+		bool mSkipCache; // cached copy didn't parse, go straight to the simulator
 
 		LODRequest(const LLVolumeParams&  mesh_params, S32 lod)
-			: RequestStats(), mMeshParams(mesh_params), mLOD(lod), mScore(0.f)
+			: RequestStats(), mMeshParams(mesh_params), mLOD(lod), mScore(0.f), mSkipCache(false)
 		{
 		}
 	};
@@ -254,9 +258,10 @@ public:
 	{
 	public:
 		LLUUID mId;
+		bool mSkipCache; // cached copy didn't parse, go straight to the simulator
 
 		UUIDBasedRequest(const LLUUID& id)
-			: RequestStats(), mId(id)
+			: RequestStats(), mId(id), mSkipCache(false)
 		{
         }
 
@@ -310,6 +315,10 @@ public:
 	//queue of successfully loaded meshes
 	std::deque<LoadedMesh> mLoadedQ;
 
+	//loaded meshes taken off mLoadedQ that notifyLoadedMeshes() ran out of
+	//frame time for, main thread only
+	std::deque<LoadedMesh> mPublishQ;
+
 	//map of pending header requests and currently desired LODs
 	typedef boost::unordered_map<LLUUID, std::vector<S32> > pending_lod_map;
 	pending_lod_map mPendingLOD;
@@ -329,6 +338,11 @@ public:
 
 	std::string mGetMeshCapability;
 
+	// Unpacks LOD and skin info bodies (unzip, LLSD parse, cacheOptimize())
+	// off the repo thread so a large rigged mesh doesn't hold up request
+	// dispatch and HTTP completions in run().  See decodeLOD().
+	LL::ThreadPool* mDecodePool;
+
 	LLMeshRepoThread();
 	~LLMeshRepoThread();
 
@@ -338,10 +352,20 @@ public:
 	void loadMeshLOD(const LLVolumeParams& mesh_params, S32 lod);
 
 	bool fetchMeshHeader(const LLVolumeParams& mesh_params, bool can_retry = true);
-	bool fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool can_retry = true);
+	bool fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool can_retry = true, bool skip_cache = false);
 	EMeshProcessingResult headerReceived(const LLVolumeParams& mesh_params, U8* data, std::streamsize data_size);
 	EMeshProcessingResult lodReceived(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size);
 	bool skinInfoReceived(const LLUUID& mesh_id, U8* data, S32 data_size);
+
+	// Hand a body to mDecodePool for lodReceived()/skinInfoReceived(), or
+	// decode it right here once the pool has shut down.  A body read from the
+	// cache (cache_offset < 0) that fails to parse is requested again from the
+	// simulator; a body from the simulator is written to the cache at
+	// cache_offset once it parses and is marked unavailable otherwise.
+	//
+	// Threads:  repo thread
+	void decodeLOD(const LLVolumeParams& mesh_params, S32 lod, std::shared_ptr<U8> data, S32 data_size, S32 cache_offset);
+	void decodeSkinInfo(const LLUUID& mesh_id, std::shared_ptr<U8> data, S32 data_size, S32 cache_offset);
 	bool decompositionReceived(const LLUUID& mesh_id, U8* data, S32 data_size);
 	EMeshProcessingResult physicsShapeReceived(const LLUUID& mesh_id, U8* data, S32 data_size);
 	bool hasPhysicsShapeInHeader(const LLUUID& mesh_id);
@@ -355,7 +379,7 @@ public:
 
 	//send request for skin info, returns true if header info exists 
 	//  (should hold onto mesh_id and try again later if header info does not exist)
-	bool fetchMeshSkinInfo(const LLUUID& mesh_id, bool can_retry = true);
+	bool fetchMeshSkinInfo(const LLUUID& mesh_id, bool can_retry = true, bool skip_cache = false);
 
 	//send request for decomposition, returns true if header info exists 
 	//  (should hold onto mesh_id and try again later if header info does not exist)
@@ -558,12 +582,12 @@ public:
 	static U32 sLODPending;
 	static U32 sLODProcessing;
 	static U32 sCacheBytesRead;
-	static U32 sCacheBytesWritten;
+	static std::atomic<U32> sCacheBytesWritten;	// also written by the decode pool
     static U32 sCacheBytesHeaders;
     static U32 sCacheBytesSkins;
     static U32 sCacheBytesDecomps;
 	static U32 sCacheReads;						
-	static U32 sCacheWrites;
+	static std::atomic<U32> sCacheWrites;
 	static U32 sMaxLockHoldoffs;				// Maximum sequential locking failures
 	
 	static LLDeadmanTimer sQuiescentTimer;		// Time-to-complete-mesh-downloads after significant events
@@ -587,7 +611,7 @@ public:
 	S32 loadMesh(LLVOVolume* volume, const LLVolumeParams& mesh_params, S32 detail = 0, S32 last_lod = -1);
 	
 	void notifyLoadedMeshes();
-	void notifyMeshLoaded(const LLVolumeParams& mesh_params, LLVolume* volume);
+	void notifyMeshLoaded(const LLVolumeParams& mesh_params, LLVolume* volume); // moves volume's faces to the system volume
 	void notifyMeshUnavailable(const LLVolumeParams& mesh_params, S32 lod);
 	void notifySkinInfoReceived(LLMeshSkinInfo* info);
 	void notifySkinInfoUnavailable(const LLUUID& info);
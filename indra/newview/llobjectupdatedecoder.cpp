@@ -0,0 +1,262 @@
+/**
+ * @file llobjectupdatedecoder.cpp
+ * @brief Off-main-thread header unpack stage for cacheable object updates
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llobjectupdatedecoder.h"
+
+#include "lldatapacker.h"
+#include "llquaternion.h"
+#include "lltimer.h"
+#include "llviewerobject.h"
+#include "llviewerregion.h"
+#include "llviewerstats.h"
+#include "llviewerstatsrecorder.h"
+#include "llworld.h"
+
+#include <thread>
+
+bool LLObjectUpdateDecoder::sEnabled = true;
+
+static LLTrace::BlockTimerStatHandle FTM_OBJECT_UPDATE_APPLY("Apply Decoded Object Updates");
+static LLTrace::BlockTimerStatHandle FTM_OBJECT_UPDATE_FLUSH("Flush Object Update Decoder");
+
+LLObjectUpdateDecoder::LLObjectUpdateDecoder()
+	// Decoding is cheap per block but there can be tens of thousands of them
+	// right after a teleport; two threads keep up with any sim we've seen.
+	// Override with "ThreadPoolSizes".
+	: LL::ThreadPool("ObjectUpdateDecode", 2)
+{
+	LL::ThreadPool::start();
+}
+
+LLObjectUpdateDecoder::~LLObjectUpdateDecoder()
+{
+	LL::ThreadPool::close();
+	mPending.clear();
+	mBuilding.reset();
+}
+
+void LLObjectUpdateDecoder::addCompressedBlock(U64 region_handle, U32 flags, const U8* data, S32 size)
+{
+	if (mBuilding && mBuilding->mRegionHandle != region_handle)
+	{
+		submit();
+	}
+	if (!mBuilding)
+	{
+		mBuilding = std::make_shared<Batch>(region_handle);
+	}
+
+	LLDecodedObjectUpdate update;
+	update.mLocalID = 0;
+	update.mCRC = 0;
+	update.mFlags = flags;
+	update.mParentID = 0;
+	update.mPCode = 0;
+	update.mOffset = (S32)mBuilding->mData.size();
+	update.mSize = size;
+
+	mBuilding->mData.insert(mBuilding->mData.end(), data, data + size);
+	mBuilding->mUpdates.push_back(update);
+}
+
+void LLObjectUpdateDecoder::submit()
+{
+	if (!mBuilding)
+	{
+		return;
+	}
+
+	batch_ptr_t batch = mBuilding;
+	mBuilding.reset();
+	mPending.push_back(batch);
+
+	// If the pool is already shutting down the batch simply stays queued and
+	// gets decoded inline by the next flush.
+	getQueue().postIfOpen([batch]()
+		{
+			decodeBatch(batch);
+		});
+}
+
+// static
+bool LLObjectUpdateDecoder::decodeBatch(const batch_ptr_t& batch)
+{
+	S32 expected = BATCH_QUEUED;
+	if (!batch->mState.compare_exchange_strong(expected, BATCH_DECODING))
+	{
+		// someone else got here first
+		return false;
+	}
+
+	LLTimer decode_timer;
+	LLVector3 pos;
+	LLVector3 scale;
+	LLQuaternion rot;
+
+	for (LLDecodedObjectUpdate& update : batch->mUpdates)
+	{
+		LLDataPackerBinaryBuffer dp(&batch->mData[update.mOffset], update.mSize);
+
+		// Same header fields, in the same order, processObjectUpdate() used
+		// to read inline; the body after the extents is left for the cache.
+		dp.unpackUUID(update.mFullID, "ID");
+		dp.unpackU32(update.mLocalID, "LocalID");
+		dp.unpackU8(update.mPCode, "PCode");
+		if (update.mPCode == 0)
+		{
+			// reported on the main thread when the batch is applied
+			continue;
+		}
+
+		LLViewerObject::unpackU32(&dp, update.mCRC, "CRC");
+		update.mParentID = LLViewerObject::extractSpatialExtents(&dp, pos, scale, rot);
+		update.mPos = pos;
+		update.mScale = scale;
+	}
+
+	batch->mDecodeTime = decode_timer.getElapsedTimeF32();
+	batch->mState.store(BATCH_DECODED, std::memory_order_release);
+	return true;
+}
+
+void LLObjectUpdateDecoder::waitForBatch(const batch_ptr_t& batch)
+{
+	if (decodeBatch(batch))
+	{
+		return;
+	}
+
+	// A worker owns it; it is at most one batch of work away from done.
+	while (batch->mState.load(std::memory_order_acquire) != BATCH_DECODED)
+	{
+		std::this_thread::yield();
+	}
+}
+
+void LLObjectUpdateDecoder::applyBatch(const batch_ptr_t& batch)
+{
+	LL_RECORD_BLOCK_TIME(FTM_OBJECT_UPDATE_APPLY);
+
+	record(LLStatViewer::OBJECT_UPDATE_DECODE_TIME, F64Seconds(batch->mDecodeTime));
+
+	LLViewerRegion* regionp = LLWorld::getInstance()->getRegionFromHandle(batch->mRegionHandle);
+	if (!regionp)
+	{
+		// region went away while the batch was in flight
+		return;
+	}
+
+	LLTimer apply_timer;
+	LLViewerStatsRecorder& recorder = LLViewerStatsRecorder::instance();
+
+	for (LLDecodedObjectUpdate& update : batch->mUpdates)
+	{
+		if (update.mPCode == 0)
+		{
+			// object creation will fail, LLViewerObject::createObject()
+			LL_WARNS() << "Received object " << update.mFullID
+				<< " with 0 PCode. Local id: " << update.mLocalID
+				<< " Flags: " << update.mFlags
+				<< " Region: " << regionp->getName()
+				<< " Region id: " << regionp->getRegionID() << LL_ENDL;
+			recorder.objectUpdateFailure(update.mLocalID, OUT_FULL_COMPRESSED, 0);
+			continue;
+		}
+
+		LLDataPackerBinaryBuffer dp(&batch->mData[update.mOffset], update.mSize);
+		regionp->cacheFullUpdate(dp, update.mFlags, &update);
+	}
+
+	record(LLStatViewer::OBJECT_UPDATE_APPLY_TIME, F64Seconds(apply_timer.getElapsedTimeF32()));
+}
+
+void LLObjectUpdateDecoder::applyPending(F32 max_time)
+{
+	submit();
+
+	LLTimer timer;
+	while (!mPending.empty())
+	{
+		batch_ptr_t batch = mPending.front();
+		if (batch->mState.load(std::memory_order_acquire) != BATCH_DECODED)
+		{
+			if (!getQueue().isClosed())
+			{
+				// workers are still on it, try again next frame
+				break;
+			}
+			waitForBatch(batch);
+		}
+
+		mPending.pop_front();
+		applyBatch(batch);
+
+		if (timer.getElapsedTimeF32() > max_time)
+		{
+			break;
+		}
+	}
+}
+
+void LLObjectUpdateDecoder::flushRegion(U64 region_handle)
+{
+	if (mBuilding && mBuilding->mRegionHandle == region_handle)
+	{
+		submit();
+	}
+
+	batch_list_t::iterator iter = mPending.begin();
+	while (iter != mPending.end())
+	{
+		if ((*iter)->mRegionHandle != region_handle)
+		{
+			++iter;
+			continue;
+		}
+
+		LL_RECORD_BLOCK_TIME(FTM_OBJECT_UPDATE_FLUSH);
+		batch_ptr_t batch = *iter;
+		iter = mPending.erase(iter);
+		waitForBatch(batch);
+		applyBatch(batch);
+	}
+}
+
+void LLObjectUpdateDecoder::flushAll()
+{
+	submit();
+
+	while (!mPending.empty())
+	{
+		LL_RECORD_BLOCK_TIME(FTM_OBJECT_UPDATE_FLUSH);
+		batch_ptr_t batch = mPending.front();
+		mPending.pop_front();
+		waitForBatch(batch);
+		applyBatch(batch);
+	}
+}
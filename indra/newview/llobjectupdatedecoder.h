@@ -0,0 +1,139 @@
+/**
+ * @file llobjectupdatedecoder.h
+ * @brief Off-main-thread header unpack stage for cacheable object updates
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLOBJECTUPDATEDECODER_H
+#define LL_LLOBJECTUPDATEDECODER_H
+
+#include "llsingleton.h"
+#include "lluuid.h"
+#include "v3math.h"
+#include "threadpool.h"
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <vector>
+
+// One ObjectUpdateCompressed block that was headed for the object cache,
+// with the header fields LLViewerRegion::cacheFullUpdate() and
+// decodeBoundingInfo() need already unpacked.  The rest of the block stays
+// raw and is stored in the cache entry as it always was.
+struct LLDecodedObjectUpdate
+{
+	LLUUID		mFullID;
+	U32			mLocalID;
+	U32			mCRC;
+	U32			mFlags;
+	U32			mParentID;
+	LLPCode		mPCode;
+	LLVector3	mPos;
+	LLVector3	mScale;
+	S32			mOffset;	// start of the raw block in the owning batch
+	S32			mSize;
+};
+
+// LLObjectUpdateDecoder moves the header unpacking of cacheable compressed
+// object updates off the main thread.  processObjectUpdate() copies the raw
+// blocks of a message into a batch, the "ObjectUpdateDecode" thread pool
+// unpacks the ID, local ID, PCode, CRC, parent and spatial extents of every
+// block, and the finished entries are handed to the region cache from idle
+// within a per-frame time budget.
+//
+// Only those header fields are read off the main thread.  The object body
+// (shape, texture entries, extra parameters) is not touched here: it is
+// cached as raw bytes and unpacked by LLViewerObject::processUpdateMessage()
+// on the main thread when the object is created from the cache, since that
+// writes straight into live objects.
+//
+// Ordering: any update for a region that does not go through the pipeline
+// (terse, full, cache probe or kill) must call flushRegion() first, so the
+// cache never sees those updates out of order with respect to pending ones.
+class LLObjectUpdateDecoder : public LLSimpleton<LLObjectUpdateDecoder>, LL::ThreadPool
+{
+	LOG_CLASS(LLObjectUpdateDecoder);
+public:
+	// LL::ThreadPool is an LLInstanceTracker and has its own getInstance()
+	using LLSimpleton<LLObjectUpdateDecoder>::getInstance;
+	using LLSimpleton<LLObjectUpdateDecoder>::instanceExists;
+
+	// follows gSavedSettings "ObjectUpdateThreadedDecode"
+	static bool sEnabled;
+
+	LLObjectUpdateDecoder();
+	~LLObjectUpdateDecoder();
+
+	static bool isEnabled() { return sEnabled && instanceExists(); }
+
+	// main thread: add one cacheable compressed block to the batch being built
+	void addCompressedBlock(U64 region_handle, U32 flags, const U8* data, S32 size);
+
+	// main thread: hand the batch being built to the worker threads
+	void submit();
+
+	// main thread: apply decoded batches, oldest first, until max_time is used up
+	void applyPending(F32 max_time);
+
+	// main thread: decode (if needed) and apply every pending batch for a region
+	void flushRegion(U64 region_handle);
+
+	// main thread: decode and apply everything still pending
+	void flushAll();
+
+	S32 getPendingCount() const { return (S32)mPending.size(); }
+
+private:
+	enum EBatchState
+	{
+		BATCH_QUEUED = 0,
+		BATCH_DECODING,
+		BATCH_DECODED
+	};
+
+	struct Batch
+	{
+		Batch(U64 region_handle) : mRegionHandle(region_handle), mState(BATCH_QUEUED), mDecodeTime(0.f) {}
+
+		U64									mRegionHandle;
+		std::vector<U8>						mData;
+		std::vector<LLDecodedObjectUpdate>	mUpdates;
+		std::atomic<S32>					mState;
+		F32									mDecodeTime;	// seconds, written by the decoding thread
+	};
+	typedef std::shared_ptr<Batch> batch_ptr_t;
+	typedef std::list<batch_ptr_t> batch_list_t;
+
+	// any thread: decode a batch if nobody else has claimed it
+	static bool decodeBatch(const batch_ptr_t& batch);
+	// main thread: make sure a batch is decoded, decoding inline or waiting as needed
+	void waitForBatch(const batch_ptr_t& batch);
+	// main thread: apply a decoded batch to its region
+	void applyBatch(const batch_ptr_t& batch);
+
+	batch_ptr_t		mBuilding;
+	batch_list_t	mPending;
+};
+
+#endif // LL_LLOBJECTUPDATEDECODER_H
@@ -0,0 +1,160 @@
+/**
+ * @file llparallelcull.cpp
+ * @brief Culls the spatial partitions of LLPipeline::updateCull() on a thread pool
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llparallelcull.h"
+
+#include "llspatialpartition.h"
+#include "llviewercontrol.h"
+#include "pipeline.h"
+
+#include <atomic>
+#include <thread>
+
+static LLTrace::BlockTimerStatHandle FTM_PARALLEL_CULL("Parallel Cull");
+
+// The partitions of one cull() call, handed out in order to whoever asks
+// next.  It outlives cull() if a worker only gets to it afterwards, but by
+// then there is nothing left for it to take.
+struct LLCullBatch
+{
+	LLCullBatch(const std::vector<LLSpatialPartition*>& parts, LLCamera& camera,
+				std::vector<std::unique_ptr<LLCullFragment>>& fragments)
+		: mParts(parts), mCamera(camera), mFragments(fragments), mNext(0), mDone(0), mNextFragment(0) {}
+
+	void run()
+	{
+		LLCullFragment* fragment = NULL;
+		const U32 count = (U32)mParts.size();
+		for (U32 i = mNext++; i < count; i = mNext++)
+		{
+			if (!fragment)
+			{ //at most one fragment per thread that gets a partition
+				fragment = mFragments[mNextFragment++].get();
+			}
+			mParts[i]->cull(mCamera, *fragment);
+			mDone++;
+		}
+	}
+
+	std::vector<LLSpatialPartition*>	mParts;
+	LLCamera&							mCamera;
+	std::vector<std::unique_ptr<LLCullFragment>>& mFragments;
+	std::atomic<U32>					mNext;
+	std::atomic<U32>					mDone;
+	std::atomic<U32>					mNextFragment;
+};
+
+LLParallelCull::LLParallelCull()
+	// Each task is one partition's octree; four threads cover the partitions
+	// of a full set of neighbouring regions.  Override with "ThreadPoolSizes".
+	: LL::ThreadPool("Cull", 4)
+{
+	LL::ThreadPool::start();
+
+	for (size_t i = 0; i <= getWidth(); ++i)
+	{
+		mFragments.push_back(std::make_unique<LLCullFragment>());
+	}
+}
+
+LLParallelCull::~LLParallelCull()
+{
+	LL::ThreadPool::close();
+}
+
+//static
+bool LLParallelCull::isEnabled()
+{
+	static LLCachedControl<bool> parallel_cull(gSavedSettings, "RenderParallelCull", true);
+	return parallel_cull && instanceExists();
+}
+
+void LLParallelCull::cull(const std::vector<LLSpatialPartition*>& parts, LLCamera& camera)
+{
+	if (parts.empty())
+	{
+		return;
+	}
+
+	LL_RECORD_BLOCK_TIME(FTM_PARALLEL_CULL);
+
+	//bounds must be current before anyone reads them
+	for (LLSpatialPartition* part : parts)
+	{
+		((LLSpatialGroup*) part->mOctree->getListener(0))->rebound();
+	}
+
+	for (auto& fragment : mFragments)
+	{
+		fragment->clear();
+	}
+
+	std::shared_ptr<LLCullBatch> batch = std::make_shared<LLCullBatch>(parts, camera, mFragments);
+
+	const U32 count = (U32)parts.size();
+	size_t helpers = llmin(getWidth(), (size_t)count - 1);
+	for (size_t i = 0; i < helpers; ++i)
+	{
+		// if the pool is shutting down the main thread does it all
+		getQueue().postIfOpen([batch]()
+			{
+				batch->run();
+			});
+	}
+
+	batch->run();
+
+	// the remaining partitions are already being culled by workers
+	while (batch->mDone.load() < count)
+	{
+		std::this_thread::yield();
+	}
+
+	const U32 used = batch->mNextFragment.load();
+
+	// queries first: near the camera doOcclusion() clears OCCLUDED below a
+	// group, which the serial cull does before it reaches the deferred subtrees
+	for (U32 i = 0; i < used; ++i)
+	{
+		for (LLSpatialGroup* group : mFragments[i]->mOcclusionGroups)
+		{
+			group->doOcclusion(&camera);
+		}
+	}
+
+	for (U32 i = 0; i < used; ++i)
+	{
+		LLCullFragment* fragment = mFragments[i].get();
+		gPipeline.markNotCulled(*fragment, camera);
+
+		for (const LLCullFragment::Deferred& deferred : fragment->mDeferred)
+		{
+			deferred.mGroup->getSpatialPartition()->cullDeferred(camera, deferred.mGroup, deferred.mRes);
+		}
+	}
+}
@@ -0,0 +1,74 @@
+/**
+ * @file llparallelcull.h
+ * @brief Culls the spatial partitions of LLPipeline::updateCull() on a thread pool
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLPARALLELCULL_H
+#define LL_LLPARALLELCULL_H
+
+#include "llsingleton.h"
+#include "threadpool.h"
+
+#include <memory>
+#include <vector>
+
+class LLCamera;
+class LLCullFragment;
+class LLSpatialPartition;
+
+// LLParallelCull culls the spatial partitions of LLPipeline::updateCull() on
+// the "Cull" thread pool, one partition per task.  Each thread walks its
+// octrees with the usual culler but collects what it finds in its own
+// LLCullFragment instead of LLPipeline::sCull.  The main thread then merges
+// the fragments into sCull; the order groups arrive in does not matter, as
+// the render maps and alpha groups built from them are sorted in stateSort().
+//
+// GL work stays on the main thread.  Occlusion queries for the groups the
+// workers found are issued after they finish, and subtrees whose occlusion
+// state depends on query results (pending or occluded) are skipped by the
+// workers and culled on the main thread the serial way.
+//
+// "RenderParallelCull" switches between this and the serial cull.
+class LLParallelCull : public LLSimpleton<LLParallelCull>, LL::ThreadPool
+{
+	LOG_CLASS(LLParallelCull);
+public:
+	// LL::ThreadPool is an LLInstanceTracker and has its own getInstance()
+	using LLSimpleton<LLParallelCull>::getInstance;
+	using LLSimpleton<LLParallelCull>::instanceExists;
+
+	LLParallelCull();
+	~LLParallelCull();
+
+	static bool isEnabled();
+
+	// main thread: cull each partition against camera into LLPipeline::sCull
+	void cull(const std::vector<LLSpatialPartition*>& parts, LLCamera& camera);
+
+private:
+	// one per thread that can take part in a cull, the main thread included
+	std::vector<std::unique_ptr<LLCullFragment>> mFragments;
+};
+
+#endif // LL_LLPARALLELCULL_H
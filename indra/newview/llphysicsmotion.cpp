@@ -454,8 +454,9 @@ F32 LLPhysicsMotion::calculateAcceleration_local(const F32 velocity_local, const
 bool LLPhysicsMotionController::onUpdate(F32 time, U8* joint_mask)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
-        // Skip if disabled globally.
-        if (!gSavedSettings.getbool("AvatarPhysics"))
+        // Skip if disabled globally.  Cached, this can run on an animation worker.
+        static LLCachedControl<bool> avatar_physics(gSavedSettings, "AvatarPhysics", true);
+        if (!avatar_physics)
         {
                 return true;
         }
@@ -269,6 +269,107 @@ void LLSkinningUtil::getPerVertexSkinMatrix(
     (void)valid_weights;
 }
 
+void LLSkinningUtil::applyBindShapeMatrix(LLMatrix4a* mat, S32 count, const LLMeshSkinInfo* skin)
+{
+    const LLMatrix4a& bind_shape = skin->mBindShapeMatrix;
+    for (S32 j = 0; j < count; ++j)
+    {
+        matMul(bind_shape, mat[j], mat[j]);
+    }
+}
+
+void LLSkinningUtil::skinPositions(const LLVolumeFace& src_face, const LLMatrix4a* mat, LLVector4a* dst, LLVector4a* extents)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+
+    const LLVector4a* src = src_face.mPositions;
+    const U8* idx = src_face.mJointIndices;
+    const U16* wght = src_face.mJointWeights;
+    const S32 count = src_face.mNumVertices;
+
+    const __m128i zero = _mm_setzero_si128();
+    const LLVector4a to_float(1.f / 65535.f);
+
+    LLVector4a min, max;
+    min.splat(F32_MAX);
+    max.setSub(LLVector4a::getZero(), min);
+
+    for (S32 i = 0; i < count; ++i, idx += 4, wght += 4)
+    {
+        LLVector4a& out = dst[i];
+
+        if (wght[0] == 0xFFFF)
+        {   // one influence, the common case on bodies
+            mat[idx[0]].affineTransform(src[i], out);
+        }
+        else
+        {
+            // four U16 weights to four floats in one go
+            __m128i w16 = _mm_loadl_epi64((const __m128i*) wght);
+            LLVector4a w(_mm_cvtepi32_ps(_mm_unpacklo_epi16(w16, zero)));
+            w.mul(to_float);
+
+            // transform by each joint and blend the results, cheaper than
+            // blending the matrices when most vertices have one or two joints
+            LLVector4a t, s;
+            mat[idx[0]].affineTransform(src[i], t);
+            s.splat<0>(w);
+            out.setMul(t, s);
+
+            mat[idx[1]].affineTransform(src[i], t);
+            s.splat<1>(w);
+            t.mul(s);
+            out.add(t);
+
+            if (wght[2])
+            {
+                mat[idx[2]].affineTransform(src[i], t);
+                s.splat<2>(w);
+                t.mul(s);
+                out.add(t);
+
+                if (wght[3])
+                {
+                    mat[idx[3]].affineTransform(src[i], t);
+                    s.splat<3>(w);
+                    t.mul(s);
+                    out.add(t);
+                }
+            }
+        }
+
+        min.setMin(min, out);
+        max.setMax(max, out);
+    }
+
+    extents[0] = min;
+    extents[1] = max;
+}
+
+void LLSkinningUtil::skinExtents(const LLVolumeFace& src_face, const LLMatrix4a* mat, LLVector4a* extents)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+
+    LLVector4a min, max;
+    min.splat(F32_MAX);
+    max.setSub(LLVector4a::getZero(), min);
+
+    for (S32 j = 0; j < src_face.mNumPackedJoints; ++j)
+    {
+        const LLVector4a* joint_extents = src_face.mJointExtents + j * 2;
+        if (joint_extents[0].lessEqual(joint_extents[1]).areAllSet(LLVector4Logical::MASK_XYZ))
+        {   // joint influences at least one vertex
+            LLVector4a box[2];
+            matMulBoundBox(mat[j], joint_extents, box);
+            min.setMin(min, box[0]);
+            max.setMax(max, box[1]);
+        }
+    }
+
+    extents[0] = min;
+    extents[1] = max;
+}
+
 void LLSkinningUtil::initJointNums(LLMeshSkinInfo* skin, LLVOAvatar *avatar)
 {
     if (!skin->mJointNumsInitialized)
@@ -311,94 +412,86 @@ void LLSkinningUtil::initJointNums(LLMeshSkinInfo* skin, LLVOAvatar *avatar)
 
 static LLTrace::BlockTimerStatHandle FTM_FACE_RIGGING_INFO("Face Rigging Info");
 
-void LLSkinningUtil::updateRiggingInfo(const LLMeshSkinInfo* skin, LLVOAvatar *avatar, LLVolumeFace& vol_face)
+void LLSkinningUtil::updateRiggingInfo(const LLMeshSkinInfo* skin, LLVOAvatar *avatar, const LLVolume* volume, S32 lod, LLJointRiggingInfoTab& rig_info_tab)
 {
-    LL_RECORD_BLOCK_TIME(FTM_FACE_RIGGING_INFO);
+    S32 num_joints = getMeshJointCount(skin);
+    if (num_joints <= 0)
+    {
+        return;
+    }
 
-    if (vol_face.mJointRiggingInfoTab.needsUpdate())
+    if (lod > skin->mRiggingInfoLOD)
     {
-        S32 num_verts = vol_face.mNumVertices;
-        S32 num_joints = skin->mJointNames.size();
-        if (num_verts > 0 && vol_face.mWeights && num_joints > 0)
+        // Only the asset is needed here, so this runs once per mesh and LOD
+        // no matter how many objects wear it.
+        LL_RECORD_BLOCK_TIME(FTM_FACE_RIGGING_INFO);
+
+        LLMeshSkinInfo::rigging_info_list_t rig_info(num_joints);
+
+        LLMatrix4a to_joint[LL_MAX_JOINTS_PER_MESH_OBJECT];
+        for (S32 j = 0; j < num_joints; ++j)
         {
-            initJointNums(const_cast<LLMeshSkinInfo*>(skin), avatar);
-            if (vol_face.mJointRiggingInfoTab.size()==0)
+            matMul(skin->mBindShapeMatrix, skin->mInvBindMatrix[j], to_joint[j]);
+        }
+
+        bool have_weights = false;
+        for (S32 f = 0; f < volume->getNumVolumeFaces(); ++f)
+        {
+            const LLVolumeFace& vol_face = volume->getVolumeFace(f);
+            if (vol_face.mNumVertices <= 0 || !vol_face.mWeights)
+            {
+                continue;
+            }
+
+            vol_face.packSkinWeights(num_joints);
+            have_weights = true;
+
+            const U8* idx = vol_face.mJointIndices;
+            const U16* wght = vol_face.mJointWeights;
+            for (S32 i = 0; i < vol_face.mNumVertices; ++i, idx += 4, wght += 4)
             {
-                //std::set<S32> active_joints;
-                //S32 active_verts = 0;
-                vol_face.mJointRiggingInfoTab.resize(LL_CHARACTER_MAX_ANIMATED_JOINTS);
-                LLJointRiggingInfoTab &rig_info_tab = vol_face.mJointRiggingInfoTab;
-                for (S32 i=0; i<vol_face.mNumVertices; i++)
+                const LLVector4a& pos = vol_face.mPositions[i];
+                for (U32 k = 0; k < 4 && wght[k] > 0; ++k)
                 {
-                    LLVector4a& pos = vol_face.mPositions[i];
-                    F32 *weights = vol_face.mWeights[i].getF32ptr();
-                    LLVector4 wght;
-                    S32 idx[4];
-                    F32 scale = 0.0f;
-                    // FIXME unpacking of weights should be pulled into a common function and optimized if possible.
-                    for (U32 k = 0; k < 4; k++)
-                    {
-                        F32 w = weights[k];
-                        idx[k] = llclamp((S32) floorf(w), (S32)0, (S32)LL_CHARACTER_MAX_ANIMATED_JOINTS-1);
-                        wght[k] = w - idx[k];
-                        scale += wght[k];
-                    }
-                    if (scale > 0.0f)
-                    {
-                        for (U32 k=0; k<4; ++k)
-                        {
-                            wght[k] /= scale;
-                        }
-                    }
-                    for (U32 k=0; k<4; ++k)
-                    {
-						S32 joint_index = idx[k];
-                        if (wght[k] > 0.0f && num_joints > joint_index)
-                        {
-                            S32 joint_num = skin->mJointNums[joint_index];
-                            if (joint_num >= 0 && joint_num < LL_CHARACTER_MAX_ANIMATED_JOINTS)
-                            {
-                                rig_info_tab[joint_num].setIsRiggedTo(true);
-
-                                // FIXME could precompute these matMuls.
-                                const LLMatrix4a& bind_shape = skin->mBindShapeMatrix;
-                                const LLMatrix4a& inv_bind = skin->mInvBindMatrix[joint_index];
-                                LLMatrix4a mat;
-                                LLVector4a pos_joint_space;
-
-                                matMul(bind_shape, inv_bind, mat);
-
-                                mat.affineTransform(pos, pos_joint_space);
-                                pos_joint_space.mul(wght[k]);
-
-                                LLVector4a *extents = rig_info_tab[joint_num].getRiggedExtents();
-                                update_min_max(extents[0], extents[1], pos_joint_space);
-                            }
-                        }
-                    }
+                    LLJointRiggingInfo& info = rig_info[idx[k]];
+                    info.setIsRiggedTo(true);
+
+                    LLVector4a pos_joint_space;
+                    to_joint[idx[k]].affineTransform(pos, pos_joint_space);
+                    pos_joint_space.mul(wght[k] * (1.f / 65535.f));
+
+                    LLVector4a* extents = info.getRiggedExtents();
+                    update_min_max(extents[0], extents[1], pos_joint_space);
                 }
-                //LL_DEBUGS("RigSpammish") << "built rigging info for vf " << &vol_face 
-                //                         << " num_verts " << vol_face.mNumVertices
-                //                         << " active joints " << active_joints.size()
-                //                         << " active verts " << active_verts
-                //                         << LL_ENDL; 
-                vol_face.mJointRiggingInfoTab.setNeedsUpdate(false);
             }
         }
 
-#if DEBUG_SKINNING
-        if (vol_face.mJointRiggingInfoTab.size()!=0)
+        if (have_weights)
         {
-            LL_DEBUGS("RigSpammish") << "we have rigging info for vf " << &vol_face 
-                                     << " num_verts " << vol_face.mNumVertices << LL_ENDL; 
+            skin->mJointRiggingInfo.swap(rig_info);
+            skin->mRiggingInfoLOD = lod;
         }
-        else
+    }
+
+    if (skin->mJointRiggingInfo.empty())
+    {
+        return;
+    }
+
+    initJointNums(const_cast<LLMeshSkinInfo*>(skin), avatar);
+
+    if (rig_info_tab.size() == 0)
+    {
+        rig_info_tab.resize(LL_CHARACTER_MAX_ANIMATED_JOINTS);
+    }
+    for (S32 j = 0; j < (S32)skin->mJointRiggingInfo.size(); ++j)
+    {
+        const LLJointRiggingInfo& info = skin->mJointRiggingInfo[j];
+        S32 joint_num = skin->mJointNums[j];
+        if (info.isRiggedTo() && joint_num >= 0 && joint_num < LL_CHARACTER_MAX_ANIMATED_JOINTS)
         {
-            LL_DEBUGS("RigSpammish") << "no rigging info for vf " << &vol_face 
-                                     << " num_verts " << vol_face.mNumVertices << LL_ENDL; 
+            rig_info_tab[joint_num].merge(info);
         }
-#endif
-
     }
 }
 
@@ -34,6 +34,7 @@
 
 class LLVOAvatar;
 class LLMeshSkinInfo;
+class LLVolume;
 class LLVolumeFace;
 class LLJointRiggingInfoTab;
 
@@ -65,8 +66,26 @@ namespace LLSkinningUtil
         final_mat.add(src[3]);
     }
 
+    // Fold the bind shape matrix into a palette from initSkinningMatrixPalette(),
+    // so each entry takes a vertex straight from mesh space to avatar space.
+    void applyBindShapeMatrix(LLMatrix4a* mat, S32 count, const LLMeshSkinInfo* skin);
+
+    // CPU skinning of src_face's positions into dst with the packed weights
+    // of LLVolumeFace::packSkinWeights() and a palette from
+    // applyBindShapeMatrix(); extents receives the bounds of dst.
+    void skinPositions(const LLVolumeFace& src_face, const LLMatrix4a* mat, LLVector4a* dst, LLVector4a* extents);
+
+    // Bounds of the skinned face without touching its vertices: the union of
+    // each influencing joint's vertex box moved by that joint's matrix.
+    // Every skinned vertex is a weighted mean of its joints' transforms of
+    // it, so the result contains all of them.
+    void skinExtents(const LLVolumeFace& src_face, const LLMatrix4a* mat, LLVector4a* extents);
+
     void initJointNums(LLMeshSkinInfo* skin, LLVOAvatar *avatar);
-    void updateRiggingInfo(const LLMeshSkinInfo* skin, LLVOAvatar *avatar, LLVolumeFace& vol_face);
+    // merge the per joint rigging info of skin into rig_info_tab, keyed by
+    // avatar joint num; the info is computed from volume only when lod is
+    // higher than the one cached on skin
+    void updateRiggingInfo(const LLMeshSkinInfo* skin, LLVOAvatar *avatar, const LLVolume* volume, S32 lod, LLJointRiggingInfoTab& rig_info_tab);
 	LLQuaternion getUnscaledQuaternion(const LLMatrix4& mat4);
 };
 
@@ -478,6 +478,11 @@ void LLSpatialGroup::shift(const LLVector4a &offset)
 		setState(GEOM_DIRTY);
 		gPipeline.markRebuild(this, true);
 	}
+	else if (hasState(HAS_INSTANCES))
+	{ //instance transforms include the region offset
+		setState(GEOM_DIRTY);
+		gPipeline.markRebuild(this, true);
+	}
 }
 
 class LLSpatialSetState : public OctreeTraveler
@@ -1045,7 +1050,7 @@ void LLSpatialPartition::shift(const LLVector4a &offset)
 class LLOctreeCull : public LLViewerOctreeCull
 {
 public:
-	LLOctreeCull(LLCamera* camera) : LLViewerOctreeCull(camera) {}
+	LLOctreeCull(LLCamera* camera, LLCullFragment* fragment = NULL) : LLViewerOctreeCull(camera), mFragment(fragment) {}
 
 	virtual bool earlyFail(LLViewerOctreeGroup* base_group)
 	{
@@ -1055,6 +1060,24 @@ public:
         }
 
 		LLSpatialGroup* group = (LLSpatialGroup*)base_group;
+
+		if (mFragment)
+		{ //off the main thread: checkOcclusion() reads GL query results and
+		  //markOccluder() writes sCull, leave any subtree that needs them for later
+			if (LLPipeline::sUseOcclusion > 1 &&
+				group->isOcclusionState(LLSpatialGroup::QUERY_PENDING | LLSpatialGroup::OCCLUDED))
+			{
+				LLCullFragment::Deferred deferred = { group, mRes };
+				mFragment->mDeferred.push_back(deferred);
+				return true;
+			}
+
+			//markOccluder() does nothing without occlusion queries
+			return group->getOctreeNode()->getParent() &&
+				LLPipeline::sUseOcclusion &&
+				group->isOcclusionState(LLSpatialGroup::OCCLUDED);
+		}
+
 		group->checkOcclusion();
 
 		if (group->getOctreeNode()->getParent() &&	//never occlusion cull the root node
@@ -1091,20 +1114,47 @@ public:
 	virtual void processGroup(LLViewerOctreeGroup* base_group)
 	{
 		LLSpatialGroup* group = (LLSpatialGroup*)base_group;
-		if (group->needsUpdate() ||
-			group->getVisible(LLViewerCamera::sCurCameraID) < LLDrawable::getCurrentFrame() - 1)
+		bool do_occlusion = group->needsUpdate() ||
+			group->getVisible(LLViewerCamera::sCurCameraID) < LLDrawable::getCurrentFrame() - 1;
+
+		if (mFragment)
+		{ //issuing queries and the rest of markNotCulled() wait for the main thread
+			if (do_occlusion)
+			{
+				mFragment->mOcclusionGroups.push_back(group);
+			}
+
+			if (!group->isEmpty())
+			{
+				group->setVisible();
+				if (!group->getSpatialPartition()->mRenderByGroup)
+				{
+					mFragment->mResult.pushDrawableGroup(group);
+				}
+				else
+				{
+					mFragment->mResult.pushVisibleGroup(group);
+				}
+			}
+			return;
+		}
+
+		if (do_occlusion)
 		{
 			group->doOcclusion(mCamera);
 		}
 		gPipeline.markNotCulled(group, *mCamera);
 	}
+
+protected:
+	LLCullFragment* mFragment;
 };
 
 class LLOctreeCullNoFarClip : public LLOctreeCull
 {
 public: 
-	LLOctreeCullNoFarClip(LLCamera* camera) 
-		: LLOctreeCull(camera) { }
+	LLOctreeCullNoFarClip(LLCamera* camera, LLCullFragment* fragment = NULL) 
+		: LLOctreeCull(camera, fragment) { }
 
 	virtual S32 frustumCheck(const LLViewerOctreeGroup* group)
 	{
@@ -1121,8 +1171,8 @@ public:
 class LLOctreeCullShadow : public LLOctreeCull
 {
 public:
-	LLOctreeCullShadow(LLCamera* camera)
-		: LLOctreeCull(camera) { }
+	LLOctreeCullShadow(LLCamera* camera, LLCullFragment* fragment = NULL)
+		: LLOctreeCull(camera, fragment) { }
 
 	virtual S32 frustumCheck(const LLViewerOctreeGroup* group)
 	{
@@ -1511,6 +1561,52 @@ S32 LLSpatialPartition::cull(LLCamera &camera, bool do_occlusion)
 	return 0;
 }
 
+void LLSpatialPartition::cull(LLCamera& camera, LLCullFragment& fragment)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_SPATIAL;
+
+    //same culler as cull(camera) uses
+    if (LLPipeline::sShadowRender)
+    {
+        LLOctreeCullShadow culler(&camera, &fragment);
+        culler.traverse(mOctree);
+    }
+    else if (mInfiniteFarClip || !LLPipeline::sUseFarClip)
+    {
+        LLOctreeCullNoFarClip culler(&camera, &fragment);
+        culler.traverse(mOctree);
+    }
+    else
+    {
+        LLOctreeCull culler(&camera, &fragment);
+        culler.traverse(mOctree);
+    }
+}
+
+void LLSpatialPartition::cullDeferred(LLCamera& camera, LLSpatialGroup* group, S32 res)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_SPATIAL;
+
+    if (LLPipeline::sShadowRender)
+    {
+        LLOctreeCullShadow culler(&camera);
+        culler.setRes(res);
+        culler.traverse(group->getOctreeNode());
+    }
+    else if (mInfiniteFarClip || !LLPipeline::sUseFarClip)
+    {
+        LLOctreeCullNoFarClip culler(&camera);
+        culler.setRes(res);
+        culler.traverse(group->getOctreeNode());
+    }
+    else
+    {
+        LLOctreeCull culler(&camera);
+        culler.setRes(res);
+        culler.traverse(group->getOctreeNode());
+    }
+}
+
 void pushVerts(LLDrawInfo* params, U32 mask)
 {
 	LLRenderPass::applyModelMatrix(*params);
@@ -4060,6 +4156,24 @@ U64 LLDrawInfo::getSkinHash()
     return mSkinInfo ? mSkinInfo->mHash : 0;
 }
 
+bool LLDrawInfo::sharesBatchState(const LLDrawInfo& rhs) const
+{
+	return mVertexBuffer.get() == rhs.mVertexBuffer.get() &&
+		mDrawMode == rhs.mDrawMode &&
+		mTexture.get() == rhs.mTexture.get() &&
+		mTextureList == rhs.mTextureList &&
+		mTextureMatrix == rhs.mTextureMatrix &&
+		mModelMatrix == rhs.mModelMatrix &&
+		mMaterial.get() == rhs.mMaterial.get() &&
+		mFullbright == rhs.mFullbright &&
+		mBump == rhs.mBump &&
+		mShiny == rhs.mShiny &&
+		mSelected == rhs.mSelected &&
+		mAlphaMaskCutoff == rhs.mAlphaMaskCutoff &&
+		mAvatar.get() == rhs.mAvatar.get() &&
+		mSkinInfo == rhs.mSkinInfo;
+}
+
 LLVertexBuffer* LLGeometryManager::createVertexBuffer(U32 type_mask, U32 usage)
 {
 	return new LLVertexBuffer(type_mask, usage);
@@ -4151,6 +4265,13 @@ void LLCullResult::clear()
 	}
 }
 
+void LLCullFragment::clear()
+{
+	mResult.clear();
+	mOcclusionGroups.clear();
+	mDeferred.clear();
+}
+
 LLCullResult::sg_iterator LLCullResult::beginVisibleGroups()
 {
 	return &mVisibleGroups[0];
@@ -45,6 +45,7 @@
 //<FS:Beq> needed to resolve render_hull dep
 #include "llmodel.h"
 //</FS:Beq>
+#include <functional>
 #include <queue>
 #include <unordered_map>
 
@@ -53,6 +54,7 @@
 
 class LLViewerOctreePartition;
 class LLSpatialPartition;
+class LLCullFragment;
 class LLSpatialBridge;
 class LLSpatialGroup;
 class LLViewerRegion;
@@ -96,6 +98,11 @@ public:
     // return mSkinHash->mHash, or 0 if mSkinHash is null
     U64 getSkinHash();
 
+	// true if rhs can be drawn with the GL state set up for this draw info
+	// (same buffer, textures, matrices, material and skin), so the two can
+	// be submitted as one draw call
+	bool sharesBatchState(const LLDrawInfo& rhs) const;
+
 	LLVector4a mExtents[2];
 	
 	LLPointer<LLVertexBuffer> mVertexBuffer;
@@ -211,6 +218,32 @@ public:
 						&& (lhs.isNull() || (rhs.notNull() && lhs->mDistance > rhs->mDistance));
 		}
 	};
+
+	struct CompareBatchState
+	{ //sort a render map so draw infos that share GL state end up next to each other
+		bool operator()(const LLDrawInfo* lhs, const LLDrawInfo* rhs) const
+		{
+			// sort NULL down to the end
+			if (lhs == rhs || !lhs)
+			{
+				return false;
+			}
+			if (!rhs)
+			{
+				return true;
+			}
+			// unrelated pointers only have a total order through std::less
+			std::less<const void*> less;
+			if (lhs->mAvatar.get() != rhs->mAvatar.get()) return less(lhs->mAvatar.get(), rhs->mAvatar.get());
+			if (lhs->mSkinInfo != rhs->mSkinInfo) return less(lhs->mSkinInfo, rhs->mSkinInfo);
+			if (lhs->mTexture.get() != rhs->mTexture.get()) return less(lhs->mTexture.get(), rhs->mTexture.get());
+			if (lhs->mMaterial.get() != rhs->mMaterial.get()) return less(lhs->mMaterial.get(), rhs->mMaterial.get());
+			if (lhs->mVertexBuffer.get() != rhs->mVertexBuffer.get()) return less(lhs->mVertexBuffer.get(), rhs->mVertexBuffer.get());
+			if (lhs->mModelMatrix != rhs->mModelMatrix) return less(lhs->mModelMatrix, rhs->mModelMatrix);
+			if (lhs->mTextureMatrix != rhs->mTextureMatrix) return less(lhs->mTextureMatrix, rhs->mTextureMatrix);
+			return lhs->mOffset < rhs->mOffset;
+		}
+	};
 };
 
 LL_ALIGN_PREFIX(64)
@@ -290,6 +323,7 @@ public:
 		NEW_DRAWINFO			= (MESH_DIRTY << 1),
 		IN_BUILD_Q1				= (NEW_DRAWINFO << 1),
 		IN_BUILD_Q2				= (IN_BUILD_Q1 << 1),
+		HAS_INSTANCES			= (IN_BUILD_Q2 << 1), //some faces draw from shared geometry in agent space
 		STATE_MASK				= 0x0000FFFF,
 	} eSpatialState;
 
@@ -419,6 +453,12 @@ public:
 	bool visibleObjectsInFrustum(LLCamera& camera);
 	/*virtual*/ S32 cull(LLCamera &camera, bool do_occlusion=false); // Cull on arbitrary frustum
 	S32 cull(LLCamera &camera, std::vector<LLDrawable *>* results, bool for_select); // Cull on arbitrary frustum
+
+	// Cull into fragment without touching GL or pipeline state, so it may run on
+	// another thread.  Call rebound() on the root group first, from the main thread.
+	void cull(LLCamera& camera, LLCullFragment& fragment);
+	// Main thread: cull the subtree at group that cull(camera, fragment) left for later
+	void cullDeferred(LLCamera& camera, LLSpatialGroup* group, S32 res);
 	
 	bool isVisible(const LLVector3& v);
 	bool isHUDPartition() ;
@@ -585,6 +625,25 @@ private:
 
 };
 
+//what one thread of LLParallelCull found in the partitions it culled,
+//merged into LLPipeline::sCull on the main thread
+class LLCullFragment
+{
+public:
+	//a subtree waiting on occlusion query results, culled on the main thread
+	struct Deferred
+	{
+		LLSpatialGroup* mGroup;
+		S32 mRes;
+	};
+
+	void clear();
+
+	LLCullResult mResult;	//visible and drawable groups only
+	std::vector<LLSpatialGroup*> mOcclusionGroups; //groups to doOcclusion() on
+	std::vector<Deferred> mDeferred;
+};
+
 
 //spatial partition for water (implemented in LLVOWater.cpp)
 class LLWaterPartition : public LLSpatialPartition
@@ -57,11 +57,13 @@
 #include "llexperiencecache.h"
 #include "lllandmark.h"
 #include "llcachename.h"
+#include "llcorehttputil.h"
 #include "lldir.h"
 #include "lldonotdisturbnotificationstorage.h"
 #include "llerrorcontrol.h"
 #include "llfloaterreg.h"
 #include "llfocusmgr.h"
+#include "llframetimer.h"
 #include "llfloatergridstatus.h"
 #include "llfloaterimsession.h"
 #include "lllocationhistory.h"
@@ -281,6 +283,7 @@ bool first_run_dialog_callback(const LLSD& notification, const LLSD& response);
 void set_startup_status(const F32 frac, const std::string& string, const std::string& msg);
 bool login_alert_status(const LLSD& notification, const LLSD& response);
 void use_circuit_callback(void**, S32 result);
+bool is_offline_replay();
 void register_viewer_callbacks(LLMessageSystem* msg);
 void asset_callback_nothing(const LLUUID&, LLAssetType::EType, void*, S32);
 bool callback_choose_gender(const LLSD& notification, const LLSD& response);
@@ -617,6 +620,23 @@ bool idle_startup()
 			F32 dropPercent = gSavedSettings.getF32("PacketDropPercentage");
 			msg->mPacketRing.setDropPercentage(dropPercent);
 
+			std::string record_file = gSavedSettings.getString("PacketRecordFile");
+			if (!record_file.empty())
+			{
+				msg->mPacketRing.startRecording(record_file);
+				LLCoreHttpUtil::HttpRecording::startRecording(record_file + ".http");
+			}
+
+			// An offline replay stands in for the grid from the login on:
+			// nothing is sent, HTTP requests are answered from the recording
+			// and frames take a fixed time so every run sees the same load
+			if (is_offline_replay())
+			{
+				msg->mPacketRing.setOffline(true);
+				LLCoreHttpUtil::HttpRecording::startReplay(gSavedSettings.getString("PacketReplayFile") + ".http");
+				LLFrameTimer::setFixedFrameStep(gSavedSettings.getF32("PacketReplayFrameStep"));
+			}
+
             F32 inBandwidth = gSavedSettings.getF32("InBandwidth"); 
             F32 outBandwidth = gSavedSettings.getF32("OutBandwidth"); 
 			if (inBandwidth != 0.f)
@@ -1666,6 +1686,14 @@ bool idle_startup()
 		gUseCircuitCallbackCalled = false;
 
 		msg->enableCircuit(gFirstSim, true);
+		if (is_offline_replay())
+		{
+			// the recorded simulators keep their recorded addresses, which
+			// the replayed login reply and capabilities handed out
+			msg->mPacketRing.startReplay(gSavedSettings.getString("PacketReplayFile"),
+										 gSavedSettings.getF32("PacketReplaySpeed"),
+										 LLHost());
+		}
 		// now, use the circuit info to tell simulator about us!
 		LL_INFOS("AppInit") << "viewer: UserLoginLocationReply() Enabling " << gFirstSim << " with code " << msg->mOurCircuitCode << LL_ENDL;
 		msg->newMessageFast(_PREHASH_UseCircuitCode);
@@ -2415,6 +2443,16 @@ bool idle_startup()
 			gAgentPilot.startPlayback();
 		}
 
+		// Replay a packet recording into this session, as if the current
+		// region had sent it
+		std::string replay_file = gSavedSettings.getString("PacketReplayFile");
+		if (!replay_file.empty() && gAgent.getRegion() && !is_offline_replay())
+		{
+			gMessageSystem->mPacketRing.startReplay(replay_file,
+													gSavedSettings.getF32("PacketReplaySpeed"),
+													gAgent.getRegion()->getHost());
+		}
+
 		show_debug_menus(); // Debug menu visiblity and First Use trigger
 		
 		// If we've got a startup URL, dispatch it
@@ -2616,6 +2654,11 @@ bool login_alert_status(const LLSD& notification, const LLSD& response)
 }
 
 
+bool is_offline_replay()
+{
+	return !gSavedSettings.getString("PacketReplayFile").empty() && gSavedSettings.getbool("PacketReplayOffline");
+}
+
 void use_circuit_callback(void**, S32 result)
 {
 	// bail if we're quitting.
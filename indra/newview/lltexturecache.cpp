@@ -34,23 +34,23 @@
 #include "llimagej2c.h" // for version control
 #include "lllfsthread.h"
 #include "llviewercontrol.h"
+#include "workqueue.h"
 
 // Included to allow LLTextureCache::purgeTextures() to pause watchdog timeout
 #include "llappviewer.h" 
 #include "llmemory.h"
 
 // Cache organization:
-// cache/texture.entries
-//  Unordered array of Entry structs
+// cache/texture.index
+//  Journal of the LLTextureCacheIndex entries, see lltexturecacheindex.h
 // cache/texture.cache
-//  First TEXTURE_CACHE_ENTRY_SIZE bytes of each texture in texture.entries in same order
+//  First TEXTURE_CACHE_ENTRY_SIZE bytes of each texture, indexed by the entry slot
 // cache/textures/[0-F]/UUID.texture
 //  Actual texture body files
 
 //note: there is no good to define 1024 for TEXTURE_CACHE_ENTRY_SIZE while FIRST_PACKET_SIZE is 600 on sim side.
 const S32 TEXTURE_CACHE_ENTRY_SIZE = FIRST_PACKET_SIZE;//1024;
 const F32 TEXTURE_CACHE_PURGE_AMOUNT = .20f; // % amount to reduce the cache by when it exceeds its limit
-const F32 TEXTURE_CACHE_LRU_SIZE = .10f; // % amount for LRU list (low overhead to regenerate)
 const S32 TEXTURE_FAST_CACHE_ENTRY_OVERHEAD = sizeof(S32) * 4; //w, h, c, level
 const S32 TEXTURE_FAST_CACHE_DATA_SIZE = 16 * 16 * 4;
 const S32 TEXTURE_FAST_CACHE_ENTRY_SIZE = TEXTURE_FAST_CACHE_DATA_SIZE + TEXTURE_FAST_CACHE_ENTRY_OVERHEAD;
@@ -832,27 +832,24 @@ void LLTextureCacheWorker::endWork(S32 param, bool aborted)
 LLTextureCache::LLTextureCache(bool threaded)
 	: LLWorkerThread("TextureCache", threaded),
 	  mWorkersMutex(),
-	  mHeaderMutex(),
+	  mPurgeMutex(),
 	  mListMutex(),
 	  mFastCacheMutex(),
-	  mHeaderAPRFile(NULL),
 	  mReadOnly(true), //do not allow to change the texture cache until setReadOnly() is called.
-	  mTexturesSizeTotal(0),
+	  mIndex(std::make_shared<LLTextureCacheIndex>()),
 	  mDoPurge(false),
 	  mFastCachep(NULL),
 	  mFastCachePoolp(NULL),
 	  mFastCachePadBuffer(NULL)
 {
-    mHeaderAPRFilePoolp = new LLVolatileAPRPool(); // is_local = true, because this pool is for headers, headers are under own mutex
 }
 
 LLTextureCache::~LLTextureCache()
 {
 	clearDeleteList() ;
-	writeUpdatedEntries() ;
+	mIndex->flush() ;
 	delete mFastCachep;
 	delete mFastCachePoolp;
-	delete mHeaderAPRFilePoolp;
 	ll_aligned_free_16(mFastCachePadBuffer);
 }
 
@@ -902,7 +899,12 @@ size_t LLTextureCache::update(F32 max_time_ms)
 	if(!res && timer.getElapsedTimeF32() > MAX_TIME_INTERVAL)
 	{
 		timer.reset() ;
-		writeUpdatedEntries() ;
+		mIndex->flush() ;
+	}
+
+	if (mIndex->needsCompaction())
+	{
+		compactIndex();
 	}
 
 	return res;
@@ -930,10 +932,7 @@ std::string LLTextureCache::getTextureFileName(const LLUUID& id)
 //debug
 bool LLTextureCache::isInCache(const LLUUID& id)
 {
-	LLMutexLock lock(&mHeaderMutex);
-	id_map_t::const_iterator iter = mHeaderIDMap.find(id);
-	
-	return (iter != mHeaderIDMap.end()) ;
+	return mIndex->contains(id);
 }
 
 //debug
@@ -978,7 +977,7 @@ bool LLTextureCache::isInLocal(const LLUUID& id)
 //////////////////////////////////////////////////////////////////////////////
 
 //static
-F32 LLTextureCache::sHeaderCacheVersion = 1.71f;
+F32 LLTextureCache::sHeaderCacheVersion = 1.72f;
 U32 LLTextureCache::sCacheMaxEntries = 1024 * 1024; //~1 million textures.
 S64 LLTextureCache::sCacheMaxTexturesSize = 0; // no limit
 std::string LLTextureCache::sHeaderCacheEncoderVersion = LLImageJ2C::getEngineInfo();
@@ -990,6 +989,7 @@ U32 LLTextureCache::sHeaderCacheAddressSize = 32;
 #endif
 
 const char* entries_filename = "texture.entries";
+const char* index_filename = "texture.index";
 const char* cache_filename = "texture.cache";
 const char* old_textures_dirname = "textures";
 //change the location of the texture cache to prevent from being deleted by old version viewers.
@@ -1000,7 +1000,7 @@ void LLTextureCache::setDirNames(ELLPath location)
 {
 	std::string delem = gDirUtilp->getDirDelimiter();
 
-	mHeaderEntriesFileName = gDirUtilp->getExpandedFilename(location, textures_dirname, entries_filename);
+	mIndexFileName = gDirUtilp->getExpandedFilename(location, textures_dirname, index_filename);
 	mHeaderDataFileName = gDirUtilp->getExpandedFilename(location, textures_dirname, cache_filename);
 	mTexturesDirName = gDirUtilp->getExpandedFilename(location, textures_dirname);
 	mFastCacheFileName =  gDirUtilp->getExpandedFilename(location, textures_dirname, fast_cache_filename);
@@ -1008,12 +1008,11 @@ void LLTextureCache::setDirNames(ELLPath location)
 
 void LLTextureCache::purgeCache(ELLPath location, bool remove_dir)
 {
-	LLMutexLock lock(&mHeaderMutex);
+	LLMutexLock lock(&mPurgeMutex);
 
 	if (!mReadOnly)
 	{
 		setDirNames(location);
-		llassert_always(mHeaderAPRFile == NULL);
 
 		//remove the legacy cache if exists
 		std::string texture_dir = mTexturesDirName ;
@@ -1021,11 +1020,10 @@ void LLTextureCache::purgeCache(ELLPath location, bool remove_dir)
 		if(LLFile::isdir(mTexturesDirName))
 		{
 			std::string file_name = gDirUtilp->getExpandedFilename(location, entries_filename);
-			// mHeaderAPRFilePoolp because we are under header mutex, and can be in main thread
-			LLAPRFile::remove(file_name, mHeaderAPRFilePoolp);
+			LLFile::remove(file_name, ENOENT);
 
 			file_name = gDirUtilp->getExpandedFilename(location, cache_filename);
-			LLAPRFile::remove(file_name, mHeaderAPRFilePoolp);
+			LLFile::remove(file_name, ENOENT);
 
 			purgeAllTextures(true);
 		}
@@ -1040,6 +1038,7 @@ void LLTextureCache::purgeCache(ELLPath location, bool remove_dir)
 void LLTextureCache::setReadOnly(bool read_only)
 {
 	mReadOnly = read_only ;
+	mIndex->setReadOnly(read_only);
 }
 
 // Called in the main thread.
@@ -1088,7 +1087,7 @@ S64 LLTextureCache::initCache(ELLPath location, S64 max_size, bool texture_cache
 		}
 	}
 	readHeaderCache();
-	purgeTextures(true); // calc mTexturesSize and make some room in the texture cache if we need it
+	purgeTextures(true); // make some room in the texture cache if we need it
 
 	llassert_always(getPending() == 0) ; //should not start accessing the texture cache before initialized.
 	openFastCache(true);
@@ -1097,231 +1096,14 @@ S64 LLTextureCache::initCache(ELLPath location, S64 max_size, bool texture_cache
 }
 
 //----------------------------------------------------------------------------
-// mHeaderMutex must be locked for the following functions!
-
-LLAPRFile* LLTextureCache::openHeaderEntriesFile(bool readonly, S32 offset)
-{
-	llassert_always(mHeaderAPRFile == NULL);
-	apr_int32_t flags = readonly ? APR_READ|APR_BINARY : APR_READ|APR_WRITE|APR_BINARY;
-	mHeaderAPRFile = new LLAPRFile(mHeaderEntriesFileName, flags, mHeaderAPRFilePoolp);
-	if(offset > 0)
-	{
-		mHeaderAPRFile->seek(APR_SET, offset);
-	}
-	return mHeaderAPRFile;
-}
-
-void LLTextureCache::closeHeaderEntriesFile()
-{
-	if(!mHeaderAPRFile)
-	{
-		return ;
-	}
-
-	delete mHeaderAPRFile;
-	mHeaderAPRFile = NULL;
-}
-
-void LLTextureCache::readEntriesHeader()
-{
-	// mHeaderEntriesInfo initializes to default values so safe not to read it
-	llassert_always(mHeaderAPRFile == NULL);
-	if (LLAPRFile::isExist(mHeaderEntriesFileName, mHeaderAPRFilePoolp))
-	{
-		LLAPRFile::readEx(mHeaderEntriesFileName, (U8*)&mHeaderEntriesInfo, 0, sizeof(EntriesInfo),
-						  mHeaderAPRFilePoolp);
-	}
-	else //create an empty entries header.
-	{
-		setEntriesHeader();
-		writeEntriesHeader() ;
-	}
-}
 
-void LLTextureCache::setEntriesHeader()
+// The journal is only valid for the cache format, address size and encoder it was written with
+std::string LLTextureCache::getIndexHeader()
 {
-	if (sHeaderEncoderStringSize < sHeaderCacheEncoderVersion.size() + 1)
-	{
-		// For simplicity we use predefined size of header, so if version string
-		// doesn't fit, either getEngineInfo() returned malformed string or 
-		// sHeaderEncoderStringSize need to be increased.
-		// Also take into accout that c_str() returns additional null character
-		LL_ERRS() << "Version string doesn't fit in header" << LL_ENDL;
-	}
-
-	mHeaderEntriesInfo.mVersion = sHeaderCacheVersion;
-	mHeaderEntriesInfo.mAdressSize = sHeaderCacheAddressSize;
-	strcpy(mHeaderEntriesInfo.mEncoderVersion, sHeaderCacheEncoderVersion.c_str());
-	mHeaderEntriesInfo.mEntries = 0;
-}
-
-void LLTextureCache::writeEntriesHeader()
-{
-	llassert_always(mHeaderAPRFile == NULL);
-	if (!mReadOnly)
-	{
-		LLAPRFile::writeEx(mHeaderEntriesFileName, (U8*)&mHeaderEntriesInfo, 0, sizeof(EntriesInfo),
-						   mHeaderAPRFilePoolp);
-	}
+	return llformat("%.2f %u ", sHeaderCacheVersion, sHeaderCacheAddressSize) + sHeaderCacheEncoderVersion;
 }
 
-//mHeaderMutex is locked before calling this.
-S32 LLTextureCache::openAndReadEntry(const LLUUID& id, Entry& entry, bool create)
-{
-	S32 idx = -1;
-	
-	id_map_t::iterator iter1 = mHeaderIDMap.find(id);
-	if (iter1 != mHeaderIDMap.end())
-	{
-		idx = iter1->second;
-	}
-
-	if (idx < 0)
-	{
-		if (create && !mReadOnly)
-		{
-			if (mHeaderEntriesInfo.mEntries < sCacheMaxEntries)
-			{
-				// Add an entry to the end of the list
-				idx = mHeaderEntriesInfo.mEntries++;
-
-			}
-			else if (!mFreeList.empty())
-			{
-				idx = *(mFreeList.begin());
-				mFreeList.erase(mFreeList.begin());
-			}
-			else
-			{
-				// Look for a still valid entry in the LRU
-				for (std::set<LLUUID>::iterator iter2 = mLRU.begin(); iter2 != mLRU.end();)
-				{
-					std::set<LLUUID>::iterator curiter2 = iter2++;
-					LLUUID oldid = *curiter2;
-					// Erase entry from LRU regardless
-					mLRU.erase(curiter2);
-					// Look up entry and use it if it is valid
-					id_map_t::iterator iter3 = mHeaderIDMap.find(oldid);
-					if (iter3 != mHeaderIDMap.end() && iter3->second >= 0)
-					{
-						idx = iter3->second;
-						removeCachedTexture(oldid) ;//remove the existing cached texture to release the entry index.
-						break;
-					}
-				}
-				// if (idx < 0) at this point, we will rebuild the LRU 
-				//  and retry if called from setHeaderCacheEntry(),
-				//  otherwise this shouldn't happen and will trigger an error
-			}
-			if (idx >= 0)
-			{
-				entry.mID = id ;
-				entry.mImageSize = -1 ; //mark it is a brand-new entry.					
-				entry.mBodySize = 0 ;
-			}
-		}
-	}
-	else
-	{
-		// Remove this entry from the LRU if it exists
-		mLRU.erase(id);
-		// Read the entry
-		idx_entry_map_t::iterator iter = mUpdatedEntryMap.find(idx) ;
-		if(iter != mUpdatedEntryMap.end())
-		{
-			entry = iter->second ;
-		}
-		else
-		{
-			readEntryFromHeaderImmediately(idx, entry) ;
-		}
-		if(entry.mImageSize <= entry.mBodySize)//it happens on 64-bit systems, do not know why
-		{
-			LL_WARNS() << "corrupted entry: " << id << " entry image size: " << entry.mImageSize << " entry body size: " << entry.mBodySize << LL_ENDL ;
-
-			//erase this entry and the cached texture from the cache.
-			std::string tex_filename = getTextureFileName(id);
-			removeEntry(idx, entry, tex_filename) ;
-			mUpdatedEntryMap.erase(idx) ;
-			idx = -1 ;
-		}
-	}
-	return idx;
-}
-
-//mHeaderMutex is locked before calling this.
-void LLTextureCache::writeEntryToHeaderImmediately(S32& idx, Entry& entry, bool write_header)
-{	
-	LLAPRFile* aprfile ;
-	S32 bytes_written ;
-	S32 offset = sizeof(EntriesInfo) + idx * sizeof(Entry);
-	if(write_header)
-	{
-		aprfile = openHeaderEntriesFile(false, 0);		
-		bytes_written = aprfile->write((U8*)&mHeaderEntriesInfo, sizeof(EntriesInfo)) ;
-		if(bytes_written != sizeof(EntriesInfo))
-		{
-			clearCorruptedCache() ; //clear the cache.
-			idx = -1 ;//mark the idx invalid.
-			return ;
-		}
-
-		mHeaderAPRFile->seek(APR_SET, offset);
-	}
-	else
-	{
-		aprfile = openHeaderEntriesFile(false, offset);
-	}
-	bytes_written = aprfile->write((void*)&entry, (S32)sizeof(Entry));
-	if(bytes_written != sizeof(Entry))
-	{
-		clearCorruptedCache() ; //clear the cache.
-		idx = -1 ;//mark the idx invalid.
-
-		return ;
-	}
-
-	closeHeaderEntriesFile();
-	mUpdatedEntryMap.erase(idx) ;
-}
-
-//mHeaderMutex is locked before calling this.
-void LLTextureCache::readEntryFromHeaderImmediately(S32& idx, Entry& entry)
-{
-	S32 offset = sizeof(EntriesInfo) + idx * sizeof(Entry);
-	LLAPRFile* aprfile = openHeaderEntriesFile(true, offset);
-	S32 bytes_read = aprfile->read((void*)&entry, (S32)sizeof(Entry));
-	closeHeaderEntriesFile();
-
-	if(bytes_read != sizeof(Entry))
-	{
-		clearCorruptedCache() ; //clear the cache.
-		idx = -1 ;//mark the idx invalid.
-	}
-}
-
-//mHeaderMutex is locked before calling this.
-//update an existing entry time stamp, delay writing.
-void LLTextureCache::updateEntryTimeStamp(S32 idx, Entry& entry)
-{
-	static const U32 MAX_ENTRIES_WITHOUT_TIME_STAMP = (U32)(LLTextureCache::sCacheMaxEntries * 0.75f) ;
-
-	if(mHeaderEntriesInfo.mEntries < MAX_ENTRIES_WITHOUT_TIME_STAMP)
-	{
-		return ; //there are enough empty entry index space, no need to stamp time.
-	}
-
-	if (idx >= 0)
-	{
-		if (!mReadOnly)
-		{
-			entry.mTime = time(NULL);			
-			mUpdatedEntryMap[idx] = entry ;
-		}
-	}
-}
-
-//update an existing entry, write to header file immediately.
+//update an existing entry, the index journals it immediately.
 bool LLTextureCache::updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32 new_data_size)
 {
 	S32 new_body_size = llmax(0, new_data_size - TEXTURE_CACHE_ENTRY_SIZE) ;
@@ -1330,286 +1112,93 @@ bool LLTextureCache::updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32
 	{
 		return true ; //nothing changed.
 	}
-	else 
-	{
-		bool purge = false ;
 
-		lockHeaders() ;
+	mIndex->update(entry, new_image_size, new_body_size);
 
-		bool update_header = false ;
-		if(entry.mImageSize < 0) //is a brand-new entry
-		{
-			mHeaderIDMap[entry.mID] = idx;
-			mTexturesSizeMap[entry.mID] = new_body_size ;
-			mTexturesSizeTotal += new_body_size ;
-			
-			// Update Header
-			update_header = true ;
-		}				
-		else if (entry.mBodySize != new_body_size)
-		{
-			//already in mHeaderIDMap.
-			mTexturesSizeMap[entry.mID] = new_body_size ;
-			mTexturesSizeTotal -= entry.mBodySize ;
-			mTexturesSizeTotal += new_body_size ;
-		}
-		entry.mTime = time(NULL);
-		entry.mImageSize = new_image_size ; 
-		entry.mBodySize = new_body_size ;
-		
-		writeEntryToHeaderImmediately(idx, entry, update_header) ;
-	
-		if (mTexturesSizeTotal > sCacheMaxTexturesSize)
-		{
-			purge = true;
-		}
-		
-		unlockHeaders() ;
-
-		if (purge)
-		{
-			mDoPurge = true;
-		}
+	if (mIndex->getBodySizeTotal() > sCacheMaxTexturesSize)
+	{
+		mDoPurge = true;
 	}
 
 	return false ;
 }
 
-U32 LLTextureCache::openAndReadEntries(std::vector<Entry>& entries)
+// Posts a rewrite of the index journal to the general thread pool
+void LLTextureCache::compactIndex()
 {
-	U32 num_entries = mHeaderEntriesInfo.mEntries;
-
-	mHeaderIDMap.clear();
-	mTexturesSizeMap.clear();
-	mFreeList.clear();
-	mTexturesSizeTotal = 0;
-
-	LLAPRFile* aprfile = NULL; 
-	if(mUpdatedEntryMap.empty())
-	{
-		aprfile = openHeaderEntriesFile(true, (S32)sizeof(EntriesInfo));
-	}
-	else //update the header file first.
-	{
-		aprfile = openHeaderEntriesFile(false, 0);
-		updatedHeaderEntriesFile() ;
-		if(!aprfile)
-		{
-			return 0;
-		}
-		aprfile->seek(APR_SET, (S32)sizeof(EntriesInfo));
-	}
-	for (U32 idx=0; idx<num_entries; idx++)
-	{
-		Entry entry;
-		S32 bytes_read = aprfile->read((void*)(&entry), (S32)sizeof(Entry));
-		if (bytes_read < sizeof(Entry))
-		{
-			LL_WARNS() << "Corrupted header entries, failed at " << idx << " / " << num_entries << LL_ENDL;
-			closeHeaderEntriesFile();
-			purgeAllTextures(false);
-			return 0;
-		}
-		entries.push_back(entry);
-// 		LL_INFOS() << "ENTRY: " << entry.mTime << " TEX: " << entry.mID << " IDX: " << idx << " Size: " << entry.mImageSize << LL_ENDL;
-		if(entry.mImageSize > entry.mBodySize)
-		{
-			mHeaderIDMap[entry.mID] = idx;
-			mTexturesSizeMap[entry.mID] = entry.mBodySize;
-			mTexturesSizeTotal += entry.mBodySize;
-		}
-		else
-		{
-			mFreeList.insert(idx);
-		}
-	}
-	closeHeaderEntriesFile();
-	return num_entries;
-}
-
-void LLTextureCache::writeEntriesAndClose(const std::vector<Entry>& entries)
-{
-	size_t num_entries = entries.size();
-	llassert_always(num_entries == mHeaderEntriesInfo.mEntries);
-	
-	if (!mReadOnly)
+	if (mReadOnly)
 	{
-		LLAPRFile* aprfile = openHeaderEntriesFile(false, (S32)sizeof(EntriesInfo));
-		for (S32 idx=0; idx<num_entries; idx++)
-		{
-			S32 bytes_written = aprfile->write((void*)(&entries[idx]), (S32)sizeof(Entry));
-			if(bytes_written != sizeof(Entry))
-			{
-				clearCorruptedCache() ; //clear the cache.
-				return ;
-			}
-		}
-		closeHeaderEntriesFile();
+		return;
 	}
-}
 
-void LLTextureCache::writeUpdatedEntries()
-{
-	lockHeaders() ;
-	if (!mReadOnly && !mUpdatedEntryMap.empty())
+	LL::WorkQueue::ptr_t general_queue = LL::WorkQueue::getInstance("General");
+	if (!general_queue || !mIndex->startCompaction())
 	{
-		openHeaderEntriesFile(false, 0);
-		updatedHeaderEntriesFile() ;
-		closeHeaderEntriesFile();
+		return;
 	}
-	unlockHeaders() ;
-}
 
-//mHeaderMutex is locked and mHeaderAPRFile is created before calling this.
-void LLTextureCache::updatedHeaderEntriesFile()
-{
-	if (!mReadOnly && !mUpdatedEntryMap.empty() && mHeaderAPRFile)
-	{
-		//entriesInfo
-		mHeaderAPRFile->seek(APR_SET, 0);
-		S32 bytes_written = mHeaderAPRFile->write((U8*)&mHeaderEntriesInfo, sizeof(EntriesInfo)) ;
-		if(bytes_written != sizeof(EntriesInfo))
+	// the index outlives the cache until the work is done
+	std::shared_ptr<LLTextureCacheIndex> index = mIndex;
+	general_queue->postIfOpen(
+		[index]() // Work done on general queue
 		{
-			clearCorruptedCache() ; //clear the cache.
-			return ;
-		}
-		
-		//write each updated entry
-		S32 entry_size = (S32)sizeof(Entry) ;
-		S32 prev_idx = -1 ;
-		S32 delta_idx ;
-		for (idx_entry_map_t::iterator iter = mUpdatedEntryMap.begin(); iter != mUpdatedEntryMap.end(); ++iter)
-		{
-			delta_idx = iter->first - prev_idx - 1;
-			prev_idx = iter->first ;
-			if(delta_idx)
-			{
-				mHeaderAPRFile->seek(APR_CUR, delta_idx * entry_size);
-			}
-			
-			bytes_written = mHeaderAPRFile->write((void*)(&iter->second), entry_size);
-			if(bytes_written != entry_size)
-			{
-				clearCorruptedCache() ; //clear the cache.
-				return ;
-			}
-		}
-		mUpdatedEntryMap.clear() ;
-	}
+			index->compact();
+		});
+	// If the queue is already closed the claim is kept: we are shutting
+	// down and the journal gets compacted on the next load.
 }
+
 //----------------------------------------------------------------------------
 
-// Called from either the main thread or the worker thread
+// Called in the main thread
 void LLTextureCache::readHeaderCache()
 {
-	mHeaderMutex.lock();
+	LLMutexLock lock(&mPurgeMutex);
 
-	mLRU.clear(); // always clear the LRU
+	mPurgeEntryList.clear();
+	mIndex->setReadOnly(mReadOnly);
 
-	readEntriesHeader();
-	
-	if (mHeaderEntriesInfo.mVersion != sHeaderCacheVersion
-		|| mHeaderEntriesInfo.mAdressSize != sHeaderCacheAddressSize
-		|| strcmp(mHeaderEntriesInfo.mEncoderVersion, sHeaderCacheEncoderVersion.c_str()) != 0)
+	if (!mReadOnly)
 	{
+		// the header entries file the index journal replaced
+		LLFile::remove(mTexturesDirName + gDirUtilp->getDirDelimiter() + entries_filename, ENOENT);
+	}
+
+	entry_list_t dropped;
+	if (!mIndex->load(mIndexFileName, getIndexHeader(), sCacheMaxEntries, dropped))
+	{
+		mIndex->clear();
 		if (!mReadOnly)
 		{
 			LL_INFOS() << "Texture Cache version mismatch, Purging." << LL_ENDL;
 			purgeAllTextures(false);
 		}
 	}
-	else
+	else if (!dropped.empty() && !mReadOnly)
 	{
-		std::vector<Entry> entries;
-		U32 num_entries = openAndReadEntries(entries);
-		if (num_entries)
+		// Special case: cache size was reduced, need to remove entries
+		LL_INFOS() << "Texture Cache Entries: " << mIndex->getEntryCount() << " Max: " << sCacheMaxEntries << " Purging: " << dropped.size() << LL_ENDL;
+
+		LLTimer timer;
+		for (entry_list_t::iterator iter = dropped.begin(); iter != dropped.end(); ++iter)
 		{
-			U32 empty_entries = 0;
-			typedef std::pair<U32, S32> lru_data_t;
-			std::set<lru_data_t> lru;
-			std::set<U32> purge_list;
-			for (U32 i=0; i<num_entries; i++)
-			{
-				Entry& entry = entries[i];
-				if (entry.mImageSize <= 0)
-				{
-					// This will be in the Free List, don't put it in the LRU
-					++empty_entries;
-				}
-				else
-				{
-					lru.insert(std::make_pair(entry.mTime, i));
-					if (entry.mBodySize > 0)
-					{
-						if (entry.mBodySize > entry.mImageSize)
-						{
-							// Shouldn't happen, failsafe only
-							LL_WARNS() << "Bad entry: " << i << ": " << entry.mID << ": BodySize: " << entry.mBodySize << LL_ENDL;
-							purge_list.insert(i);
-						}
-					}
-				}
-			}
-			if (num_entries - empty_entries > sCacheMaxEntries)
-			{
-				// Special case: cache size was reduced, need to remove entries
-				U32 entries_to_purge = (num_entries - empty_entries) - sCacheMaxEntries;
-				LL_INFOS() << "Texture Cache Entries: " << num_entries << " Max: " << sCacheMaxEntries << " Empty: " << empty_entries << " Purging: " << entries_to_purge << LL_ENDL;
-				// We can exit the following loop with the given condition, since if we'd reach the end of the lru set we'd have:
-				// purge_list.size() = lru.size() = num_entries - empty_entries = entries_to_purge + sCacheMaxEntries >= entries_to_purge
-				// So, it's certain that iter will never reach lru.end() first.
-				std::set<lru_data_t>::iterator iter = lru.begin();
-				while (purge_list.size() < entries_to_purge)
-				{
-					purge_list.insert(iter->second);
-					++iter;
-				}
-			}
+			removeEntry(*iter);
 
+			//make sure that pruning entries doesn't take too much time
+			if (timer.getElapsedTimeF32() > TEXTURE_PRUNING_MAX_TIME)
 			{
-				S32 lru_entries = (S32)((F32)sCacheMaxEntries * TEXTURE_CACHE_LRU_SIZE);
-				for (std::set<lru_data_t>::iterator iter = lru.begin(); iter != lru.end(); ++iter)
-				{
-					mLRU.insert(entries[iter->second].mID);
-// 					LL_INFOS() << "LRU: " << iter->first << " : " << iter->second << LL_ENDL;
-					if (--lru_entries <= 0)
-						break;
-				}
-			}
-			
-			if (purge_list.size() > 0)
-			{
-				LLTimer timer;
-				for (std::set<U32>::iterator iter = purge_list.begin(); iter != purge_list.end(); ++iter)
-				{
-					std::string tex_filename = getTextureFileName(entries[*iter].mID);
-					removeEntry((S32)*iter, entries[*iter], tex_filename);
-
-					//make sure that pruning entries doesn't take too much time
-					if (timer.getElapsedTimeF32() > TEXTURE_PRUNING_MAX_TIME)
-					{
-						break;
-					}
-				}
-				writeEntriesAndClose(entries);
-			}
-			else
-			{
-				//entries are not changed, nothing here.
+				break;
 			}
 		}
 	}
-	mHeaderMutex.unlock();
 }
 
 //////////////////////////////////////////////////////////////////////////////
 
-//the header mutex is locked before calling this.
 void LLTextureCache::clearCorruptedCache()
 {
 	LL_WARNS() << "the texture cache is corrupted, need to be cleared." << LL_ENDL ;
 
-	closeHeaderEntriesFile();//close possible file handler
 	purgeAllTextures(false) ; //clear the cache.
 
 	if (!mReadOnly) //regenerate the directory tree if not exists.
@@ -1653,16 +1242,9 @@ void LLTextureCache::purgeAllTextures(bool purge_directories)
 			LLFile::rmdir(mTexturesDirName);
 		}
 	}
-	mHeaderIDMap.clear();
-	mTexturesSizeMap.clear();
-	mTexturesSizeTotal = 0;
-	mFreeList.clear();
-	mTexturesSizeTotal = 0;
-	mUpdatedEntryMap.clear();
 
-	// Info with 0 entries
-	setEntriesHeader();
-	writeEntriesHeader();
+	// Empty index, and a fresh journal if the directory is still there
+	mIndex->clear();
 
 	LL_INFOS() << "The entire texture cache is cleared." << LL_ENDL ;
 }
@@ -1680,40 +1262,30 @@ void LLTextureCache::purgeTexturesLazy(F32 time_limit_sec)
 	}
 
 	// time_limit doesn't account for lock time
-	LLMutexLock lock(&mHeaderMutex);
+	LLMutexLock lock(&mPurgeMutex);
 
 	if (mPurgeEntryList.empty())
 	{
-		// Read the entries list and form list of textures to purge
-		std::vector<Entry> entries;
-		U32 num_entries = openAndReadEntries(entries);
-		if (!num_entries)
+		// Snapshot the index and form list of textures to purge
+		entry_list_t entries;
+		mIndex->getEntries(entries);
+		if (entries.empty())
 		{
 			return; // nothing to purge
 		}
 
-		// Use mTexturesSizeMap to collect UUIDs of textures with bodies
+		// Collect textures with bodies
 		typedef std::set<std::pair<U32, S32> > time_idx_set_t;
 		std::set<std::pair<U32, S32> > time_idx_set;
-		for (size_map_t::iterator iter1 = mTexturesSizeMap.begin();
-			iter1 != mTexturesSizeMap.end(); ++iter1)
+		for (S32 i = 0; i < (S32)entries.size(); ++i)
 		{
-			if (iter1->second > 0)
+			if (entries[i].mBodySize > 0)
 			{
-				id_map_t::iterator iter2 = mHeaderIDMap.find(iter1->first);
-				if (iter2 != mHeaderIDMap.end())
-				{
-					S32 idx = iter2->second;
-					time_idx_set.insert(std::make_pair(entries[idx].mTime, idx));
-				}
-				else
-				{
-					LL_ERRS("TextureCache") << "mTexturesSizeMap / mHeaderIDMap corrupted." << LL_ENDL;
-				}
+				time_idx_set.insert(std::make_pair(entries[i].mTime, i));
 			}
 		}
 
-		S64 cache_size = mTexturesSizeTotal;
+		S64 cache_size = mIndex->getBodySizeTotal();
 		S64 purged_cache_size = (llmax(cache_size, sCacheMaxTexturesSize) * (S64)((1.f - TEXTURE_CACHE_PURGE_AMOUNT) * 100)) / 100;
 		for (time_idx_set_t::iterator iter = time_idx_set.begin();
 			iter != time_idx_set.end(); ++iter)
@@ -1722,7 +1294,7 @@ void LLTextureCache::purgeTexturesLazy(F32 time_limit_sec)
 			if (cache_size >= purged_cache_size)
 			{
 				cache_size -= entries[idx].mBodySize;
-				mPurgeEntryList.push_back(std::pair<S32, Entry>(idx, entries[idx]));
+				mPurgeEntryList.push_back(entries[idx]);
 			}
 			else
 			{
@@ -1737,16 +1309,14 @@ void LLTextureCache::purgeTexturesLazy(F32 time_limit_sec)
 		LLTimer timer;
 		while (!mPurgeEntryList.empty() && timer.getElapsedTimeF32() < time_limit_sec)
 		{
-			S32 idx = mPurgeEntryList.back().first;
-			Entry entry = mPurgeEntryList.back().second;
+			Entry entry = mPurgeEntryList.back();
 			mPurgeEntryList.pop_back();
 			// make sure record is still valid
-			id_map_t::iterator iter_header = mHeaderIDMap.find(entry.mID);
-			if (iter_header != mHeaderIDMap.end() && iter_header->second == idx)
+			Entry current;
+			if (mIndex->find(entry.mID, current, false) == entry.mIndex
+				&& mIndex->remove(entry.mID, current))
 			{
-				std::string tex_filename = getTextureFileName(entry.mID);
-				removeEntry(idx, entry, tex_filename);
-				writeEntryToHeaderImmediately(idx, entry);
+				removeEntry(current);
 			}
 		}
 	}
@@ -1765,37 +1335,27 @@ void LLTextureCache::purgeTextures(bool validate)
 		LLAppViewer::instance()->pauseMainloopTimeout();
 	}
 	
-	LLMutexLock lock(&mHeaderMutex);
+	LLMutexLock lock(&mPurgeMutex);
 
 	LL_INFOS() << "TEXTURE CACHE: Purging." << LL_ENDL;
 
-	// Read the entries list
-	std::vector<Entry> entries;
-	U32 num_entries = openAndReadEntries(entries);
+	// Snapshot the index
+	entry_list_t entries;
+	mIndex->getEntries(entries);
+	U32 num_entries = (U32)entries.size();
 	if (!num_entries)
 	{
 		return; // nothing to purge
 	}
 	
-	// Use mTexturesSizeMap to collect UUIDs of textures with bodies
+	// Collect textures with bodies
 	typedef std::set<std::pair<U32,S32> > time_idx_set_t;
 	std::set<std::pair<U32,S32> > time_idx_set;
-	for (size_map_t::iterator iter1 = mTexturesSizeMap.begin();
-		 iter1 != mTexturesSizeMap.end(); ++iter1)
+	for (S32 i = 0; i < (S32)num_entries; ++i)
 	{
-		if (iter1->second > 0)
+		if (entries[i].mBodySize > 0)
 		{
-			id_map_t::iterator iter2 = mHeaderIDMap.find(iter1->first);
-			if (iter2 != mHeaderIDMap.end())
-			{
-				S32 idx = iter2->second;
-				time_idx_set.insert(std::make_pair(entries[idx].mTime, idx));
-// 				LL_INFOS() << "TIME: " << entries[idx].mTime << " TEX: " << entries[idx].mID << " IDX: " << idx << " Size: " << entries[idx].mImageSize << LL_ENDL;
-			}
-			else
-			{
-				LL_ERRS() << "mTexturesSizeMap / mHeaderIDMap corrupted." << LL_ENDL ;
-			}
+			time_idx_set.insert(std::make_pair(entries[i].mTime, i));
 		}
 	}
 	
@@ -1809,7 +1369,7 @@ void LLTextureCache::purgeTextures(bool validate)
 		LL_DEBUGS("TextureCache") << "TEXTURE CACHE: Validating: " << validate_idx << LL_ENDL;
 	}
 
-	S64 cache_size = mTexturesSizeTotal;
+	S64 cache_size = mIndex->getBodySizeTotal();
 	S64 purged_cache_size = (llmax(cache_size, sCacheMaxTexturesSize) * (S64)((1.f - TEXTURE_CACHE_PURGE_AMOUNT) * 100)) / 100;
 	S32 purge_count = 0;
 	for (time_idx_set_t::iterator iter = time_idx_set.begin();
@@ -1830,8 +1390,8 @@ void LLTextureCache::purgeTextures(bool validate)
 			{
 				std::string filename = getTextureFileName(entries[idx].mID);
 				LL_DEBUGS("TextureCache") << "Validating: " << filename << "Size: " << entries[idx].mBodySize << LL_ENDL;
-				// mHeaderAPRFilePoolp because this is under header mutex in main thread
-				S32 bodysize = LLAPRFile::size(filename, mHeaderAPRFilePoolp);
+				llstat stat_data;
+				S32 bodysize = LLFile::stat(filename, &stat_data) == 0 ? (S32)stat_data.st_size : 0;
 				if (bodysize != entries[idx].mBodySize)
 				{
 					LL_WARNS("TextureCache") << "TEXTURE CACHE BODY HAS BAD SIZE: " << bodysize << " != " << entries[idx].mBodySize << filename << LL_ENDL;
@@ -1847,24 +1407,23 @@ void LLTextureCache::purgeTextures(bool validate)
 		if (purge_entry)
 		{
 			purge_count++;
-            std::string filename = getTextureFileName(entries[idx].mID);
-	 		LL_DEBUGS("TextureCache") << "PURGING: " << filename << LL_ENDL;
+	 		LL_DEBUGS("TextureCache") << "PURGING: " << getTextureFileName(entries[idx].mID) << LL_ENDL;
 			cache_size -= entries[idx].mBodySize;
-			removeEntry(idx, entries[idx], filename) ;			
+			Entry removed;
+			if (mIndex->remove(entries[idx].mID, removed))
+			{
+				removeEntry(removed);
+			}
 		}
 	}
 
-	LL_DEBUGS("TextureCache") << "TEXTURE CACHE: Writing Entries: " << num_entries << LL_ENDL;
-
-	writeEntriesAndClose(entries);
-	
 	// *FIX:Mani - watchdog back on.
 	LLAppViewer::instance()->resumeMainloopTimeout();
 	
 	LL_INFOS("TextureCache") << "TEXTURE CACHE:"
 			<< " PURGED: " << purge_count
 			<< " ENTRIES: " << num_entries
-			<< " CACHE SIZE: " << mTexturesSizeTotal / (1024 * 1024) << " MB"
+			<< " CACHE SIZE: " << mIndex->getBodySizeTotal() / (1024 * 1024) << " MB"
 			<< LL_ENDL;
 }
 
@@ -1896,32 +1455,20 @@ LLTextureCacheWorker* LLTextureCache::getWriter(handle_t handle)
 //////////////////////////////////////////////////////////////////////////////
 // Called from work thread
 
-// Reads imagesize from the header, updates timestamp
+// Reads imagesize from the index, updates timestamp
 S32 LLTextureCache::getHeaderCacheEntry(const LLUUID& id, Entry& entry)
 {
-	LLMutexLock lock(&mHeaderMutex);	
-	S32 idx = openAndReadEntry(id, entry, false);
-	if (idx >= 0)
-	{		
-		updateEntryTimeStamp(idx, entry); // updates time
-	}
-	return idx;
+	return mIndex->find(id, entry, true);
 }
 
-// Writes imagesize to the header, updates timestamp
+// Writes imagesize to the index, updates timestamp
 S32 LLTextureCache::setHeaderCacheEntry(const LLUUID& id, Entry& entry, S32 imagesize, S32 datasize)
 {
-	mHeaderMutex.lock();
-	S32 idx = openAndReadEntry(id, entry, true); // read or create
-	mHeaderMutex.unlock();
-
-	if(idx < 0) // retry once
+	Entry evicted;
+	S32 idx = mIndex->allocate(id, entry, evicted);
+	if (evicted.mIndex >= 0)
 	{
-		readHeaderCache(); // We couldn't write an entry, so refresh the LRU
-
-		mHeaderMutex.lock();
-		idx = openAndReadEntry(id, entry, true);
-		mHeaderMutex.unlock();
+		removeEntry(evicted); // the least recently used texture gave up its slot
 	}
 
 	if (idx >= 0)
@@ -2030,18 +1577,13 @@ LLTextureCache::handle_t LLTextureCache::writeToCache(const LLUUID& id, U32 prio
 //called in the main thread
 LLPointer<LLImageRaw> LLTextureCache::readFromFastCache(const LLUUID& id, S32& discardlevel)
 {
-	U32 offset;
+	Entry entry;
+	S32 idx = mIndex->find(id, entry, false);
+	if (idx < 0)
 	{
-		LLMutexLock lock(&mHeaderMutex);
-		id_map_t::const_iterator iter = mHeaderIDMap.find(id);
-		if(iter == mHeaderIDMap.end())
-		{
-			return NULL; //not in the cache
-		}
-
-		offset = iter->second;
+		return NULL; //not in the cache
 	}
-	offset *= TEXTURE_FAST_CACHE_ENTRY_SIZE;
+	U32 offset = (U32)idx * TEXTURE_FAST_CACHE_ENTRY_SIZE;
 
 	U8* data;
 	S32 head[4];
@@ -2245,54 +1787,20 @@ void LLTextureCache::addCompleted(Responder* responder, bool success)
 
 //////////////////////////////////////////////////////////////////////////////
 
-//called after mHeaderMutex is locked.
-void LLTextureCache::removeCachedTexture(const LLUUID& id)
+// Deletes the body file of an entry that has already left the index.
+void LLTextureCache::removeEntry(const Entry& entry)
 {
-	if(mTexturesSizeMap.find(id) != mTexturesSizeMap.end())
-	{
-		mTexturesSizeTotal -= mTexturesSizeMap[id] ;
-		mTexturesSizeMap.erase(id);
-	}
-	mHeaderIDMap.erase(id);
-	// We are inside header's mutex so mHeaderAPRFilePoolp is safe to use,
-	// but getLocalAPRFilePool() is not safe, it might be in use by worker
-	LLAPRFile::remove(getTextureFileName(id), mHeaderAPRFilePoolp);
-}
-
-//called after mHeaderMutex is locked.
-void LLTextureCache::removeEntry(S32 idx, Entry& entry, std::string& filename)
-{
- 	bool file_maybe_exists = true;	// Always attempt to remove when idx is invalid.
-
-	if(idx >= 0) //valid entry
+	std::string filename = getTextureFileName(entry.mID);
+	if (entry.mBodySize == 0)	// Always attempt to remove when mBodySize > 0.
 	{
-		if (entry.mBodySize == 0)	// Always attempt to remove when mBodySize > 0.
+		// Sanity check. Shouldn't exist when body size is 0.
+		if (!LLFile::isfile(filename))
 		{
-		  // Sanity check. Shouldn't exist when body size is 0.
-		  // We are inside header's mutex so mHeaderAPRFilePoolp is safe to use,
-		  // but getLocalAPRFilePool() is not safe, it might be in use by worker
-		  if (LLAPRFile::isExist(filename, mHeaderAPRFilePoolp))
-		  {
-			  LL_WARNS("TextureCache") << "Entry has body size of zero but file " << filename << " exists. Deleting this file, too." << LL_ENDL;
-		  }
-		  else
-		  {
-			  file_maybe_exists = false;
-		  }
+			return;
 		}
-		mTexturesSizeTotal -= entry.mBodySize;
-
-		entry.mImageSize = -1;
-		entry.mBodySize = 0;
-		mHeaderIDMap.erase(entry.mID);
-		mTexturesSizeMap.erase(entry.mID);		
-		mFreeList.insert(idx);	
-	}
-
-	if (file_maybe_exists)
-	{
-		LLAPRFile::remove(filename, mHeaderAPRFilePoolp);		
+		LL_WARNS("TextureCache") << "Entry has body size of zero but file " << filename << " exists. Deleting this file, too." << LL_ENDL;
 	}
+	LLFile::remove(filename, ENOENT);
 }
 
 bool LLTextureCache::removeFromCache(const LLUUID& id)
@@ -2301,19 +1809,17 @@ bool LLTextureCache::removeFromCache(const LLUUID& id)
 	bool ret = false ;
 	if (!mReadOnly)
 	{
-		lockHeaders() ;
-
 		Entry entry;
-		S32 idx = openAndReadEntry(id, entry, false);
-		std::string tex_filename = getTextureFileName(id);
-		removeEntry(idx, entry, tex_filename) ;
-		if (idx >= 0)
-		{			
-			writeEntryToHeaderImmediately(idx, entry);					
+		if (mIndex->remove(id, entry))
+		{
+			removeEntry(entry);
 			ret = true;
 		}
-
-		unlockHeaders() ;
+		else
+		{
+			// Always attempt to remove a stray body
+			LLFile::remove(getTextureFileName(id), ENOENT);
+		}
 	}
 	return ret ;
 }
@@ -32,8 +32,11 @@
 #include "llstring.h"
 #include "lluuid.h"
 
+#include "lltexturecacheindex.h"
 #include "llworkerthread.h"
 
+#include <memory>
+
 class LLImageFormatted;
 class LLTextureCacheWorker;
 class LLImageRaw;
@@ -46,41 +49,7 @@ class LLTextureCache : public LLWorkerThread
 
 private:
 
-#if LL_WINDOWS
-#pragma pack(push,1)
-#endif
-
-	// Entries
-	static const U32 sHeaderEncoderStringSize = 32;
-	struct EntriesInfo
-	{
-		EntriesInfo() : mVersion(0.f), mAdressSize(0), mEntries(0) { memset(mEncoderVersion, 0, sHeaderEncoderStringSize); }
-		F32 mVersion;
-		U32 mAdressSize;
-		char mEncoderVersion[sHeaderEncoderStringSize];
-		U32 mEntries;
-	};
-	struct Entry
-	{
-        	Entry() :
-		        mBodySize(0),
-			mImageSize(0),
-			mTime(0)
-		{
-		}
-		Entry(const LLUUID& id, S32 imagesize, S32 bodysize, U32 time) :
-			mID(id), mImageSize(imagesize), mBodySize(bodysize), mTime(time) {}
-		void init(const LLUUID& id, U32 time) { mID = id, mImageSize = 0; mBodySize = 0; mTime = time; }
-		Entry& operator=(const Entry& entry) {mID = entry.mID, mImageSize = entry.mImageSize; mBodySize = entry.mBodySize; mTime = entry.mTime; return *this;}
-		LLUUID mID; // 16 bytes
-		S32 mImageSize; // total size of image if known
-		S32 mBodySize; // size of body file in body cache
-		time_t mTime; // seconds since 1/1/1970
-	};
-
-#if LL_WINDOWS
-#pragma pack(pop)
-#endif
+	typedef LLTextureCacheIndex::Entry Entry;
 
 public:
 
@@ -142,9 +111,9 @@ public:
 	// debug
 	size_t getNumReads() { return mReaders.size(); }
 	size_t getNumWrites() { return mWriters.size(); }
-	S64Bytes getUsage() { return S64Bytes(mTexturesSizeTotal); }
+	S64Bytes getUsage() { return S64Bytes(mIndex.getBodySizeTotal()); }
 	S64Bytes getMaxUsage() { return S64Bytes(sCacheMaxTexturesSize); }
-	U32 getEntries() { return mHeaderEntriesInfo.mEntries; }
+	U32 getEntries() { return mIndex.getEntryCount(); }
 	U32 getMaxEntries() { return sCacheMaxEntries; };
 	bool isInCache(const LLUUID& id) ;
 	bool isInLocal(const LLUUID& id) ; //not thread safe at the moment
@@ -160,31 +129,17 @@ protected:
 
 private:
 	void setDirNames(ELLPath location);
+	std::string getIndexHeader();
 	void readHeaderCache();
 	void clearCorruptedCache();
 	void purgeAllTextures(bool purge_directories);
 	void purgeTexturesLazy(F32 time_limit_sec);
 	void purgeTextures(bool validate);
-	LLAPRFile* openHeaderEntriesFile(bool readonly, S32 offset);
-	void closeHeaderEntriesFile();
-	void readEntriesHeader();
-	void setEntriesHeader();
-	void writeEntriesHeader();
-	S32 openAndReadEntry(const LLUUID& id, Entry& entry, bool create);
+	void compactIndex();
 	bool updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32 new_body_size);
-	void updateEntryTimeStamp(S32 idx, Entry& entry) ;
-	U32 openAndReadEntries(std::vector<Entry>& entries);
-	void writeEntriesAndClose(const std::vector<Entry>& entries);
-	void readEntryFromHeaderImmediately(S32& idx, Entry& entry) ;
-	void writeEntryToHeaderImmediately(S32& idx, Entry& entry, bool write_header = false) ;
-	void removeEntry(S32 idx, Entry& entry, std::string& filename);
-	void removeCachedTexture(const LLUUID& id) ;
+	void removeEntry(const Entry& entry);
 	S32 getHeaderCacheEntry(const LLUUID& id, Entry& entry);
 	S32 setHeaderCacheEntry(const LLUUID& id, Entry& entry, S32 imagesize, S32 datasize);
-	void writeUpdatedEntries() ;
-	void updatedHeaderEntriesFile() ;
-	void lockHeaders() { mHeaderMutex.lock(); }
-	void unlockHeaders() { mHeaderMutex.unlock(); }
 	
 	void openFastCache(bool first_time = false);
 	void closeFastCache(bool forced = false);
@@ -193,16 +148,10 @@ private:
 private:
 	// Internal
 	LLMutex mWorkersMutex;
-	LLMutex mHeaderMutex;
+	LLMutex mPurgeMutex;
 	LLMutex mListMutex;
 	LLMutex mFastCacheMutex;
-	LLAPRFile* mHeaderAPRFile;
 	LLVolatileAPRPool* mFastCachePoolp;
-
-	// mLocalAPRFilePoolp is not thread safe and is meant only for workers
-	// howhever mHeaderEntriesFileName is accessed not from workers' threads
-	// so it needs own pool (not thread safe by itself, relies onto header's mutex)
-	LLVolatileAPRPool*   mHeaderAPRFilePoolp;
 	
 	typedef std::map<handle_t, LLTextureCacheWorker*> handle_map_t;
 	handle_map_t mReaders;
@@ -217,14 +166,10 @@ private:
 	bool mReadOnly;
 	
 	// HEADERS (Include first mip)
-	std::string mHeaderEntriesFileName;
+	std::string mIndexFileName;
 	std::string mHeaderDataFileName;
 	std::string mFastCacheFileName;
-	EntriesInfo mHeaderEntriesInfo;
-	std::set<S32> mFreeList; // deleted entries
-	std::set<LLUUID> mLRU;
-	typedef std::map<LLUUID, S32> id_map_t;
-	id_map_t mHeaderIDMap;
+	std::shared_ptr<LLTextureCacheIndex> mIndex; // shared with journal compaction on the General pool
 
 	LLAPRFile*   mFastCachep;
 	LLFrameTimer mFastCacheTimer;
@@ -232,15 +177,10 @@ private:
 
 	// BODIES (TEXTURES minus headers)
 	std::string mTexturesDirName;
-	typedef std::map<LLUUID,S32> size_map_t;
-	size_map_t mTexturesSizeMap;
-	S64 mTexturesSizeTotal;
 	LLAtomicBool mDoPurge;
 
-	typedef std::map<S32, Entry> idx_entry_map_t;
-	idx_entry_map_t mUpdatedEntryMap;
-	typedef std::vector<std::pair<S32, Entry> > idx_entry_vector_t;
-	idx_entry_vector_t mPurgeEntryList;
+	typedef std::vector<Entry> entry_list_t;
+	entry_list_t mPurgeEntryList; // protected by mPurgeMutex
 
 	// Statics
 	static F32 sHeaderCacheVersion;
@@ -0,0 +1,702 @@
+/**
+ * @file lltexturecacheindex.cpp
+ * @brief Sharded, journaled index of the texture cache entries
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "lltexturecacheindex.h"
+
+#include <algorithm>
+#include <map>
+
+// Journal layout: magic, header length, header, then records of
+// U8 op, 16 byte id, S32 slot, S32 image size, S32 body size, U32 time.
+static const U32 JOURNAL_MAGIC = 0x58494354; // "TCIX"
+static const S32 JOURNAL_RECORD_SIZE = 1 + UUID_BYTES + 4 * sizeof(S32);
+
+// Don't journal access times more often than this per entry
+static const U32 TOUCH_THRESHOLD = 60; // seconds
+
+// Rewrite the journal once it holds this many more records than the index
+static const U32 JOURNAL_COMPACT_SLACK = 10000;
+
+// Share of the entries considered each time the eviction list is rebuilt
+static const F32 EVICTION_LIST_SIZE = .10f;
+
+namespace
+{
+	void append_record(std::vector<U8>& records, U8 op, const LLTextureCacheIndex::Entry& entry)
+	{
+		size_t offset = records.size();
+		records.resize(offset + JOURNAL_RECORD_SIZE);
+		U8* data = &records[offset];
+
+		*data++ = op;
+		memcpy(data, entry.mID.mData, UUID_BYTES);
+		data += UUID_BYTES;
+		memcpy(data, &entry.mIndex, sizeof(S32));
+		data += sizeof(S32);
+		memcpy(data, &entry.mImageSize, sizeof(S32));
+		data += sizeof(S32);
+		memcpy(data, &entry.mBodySize, sizeof(S32));
+		data += sizeof(S32);
+		memcpy(data, &entry.mTime, sizeof(U32));
+	}
+
+	U8 read_record(const U8* data, LLTextureCacheIndex::Entry& entry)
+	{
+		U8 op = *data++;
+		memcpy(entry.mID.mData, data, UUID_BYTES);
+		data += UUID_BYTES;
+		memcpy(&entry.mIndex, data, sizeof(S32));
+		data += sizeof(S32);
+		memcpy(&entry.mImageSize, data, sizeof(S32));
+		data += sizeof(S32);
+		memcpy(&entry.mBodySize, data, sizeof(S32));
+		data += sizeof(S32);
+		memcpy(&entry.mTime, data, sizeof(U32));
+		return op;
+	}
+}
+
+LLTextureCacheIndex::LLTextureCacheIndex()
+	: mNextSlot(0),
+	  mMaxEntries(0),
+	  mJournalFile(NULL),
+	  mJournalRecords(0),
+	  mBodySizeTotal(0),
+	  mEntryCount(0),
+	  mReadOnly(true),
+	  mCompactionPending(false)
+{
+}
+
+LLTextureCacheIndex::~LLTextureCacheIndex()
+{
+	flush();
+
+	LLMutexLock lock(&mJournalMutex);
+	if (mJournalFile)
+	{
+		LLFile::close(mJournalFile);
+		mJournalFile = NULL;
+	}
+}
+
+bool LLTextureCacheIndex::load(const std::string& filename, const std::string& header, U32 max_entries, entry_list_t& dropped)
+{
+	{
+		LLMutexLock lock(&mJournalMutex);
+		mJournalFilename = filename;
+		mJournalHeader = header;
+		if (mJournalFile)
+		{
+			LLFile::close(mJournalFile);
+			mJournalFile = NULL;
+		}
+	}
+	{
+		LLMutexLock lock(&mSlotMutex);
+		mMaxEntries = max_entries;
+	}
+
+	// Replay into a plain map first, the shards are filled once it checks out
+	entry_map_t entries;
+	bool success = false;
+	bool needs_rewrite = false;
+	U32 num_records = 0;
+
+	LLFILE* file = LLFile::fopen(filename, "rb");
+	if (file)
+	{
+		U32 magic = 0;
+		U32 header_size = 0;
+		success = fread(&magic, sizeof(U32), 1, file) == 1
+			&& fread(&header_size, sizeof(U32), 1, file) == 1
+			&& magic == JOURNAL_MAGIC
+			&& header_size == header.size();
+		if (success)
+		{
+			std::string file_header(header_size, '\0');
+			success = (header_size == 0 || fread(&file_header[0], 1, header_size, file) == header_size)
+				&& file_header == header;
+		}
+
+		U8 data[JOURNAL_RECORD_SIZE];
+		while (success)
+		{
+			size_t bytes_read = fread(data, 1, JOURNAL_RECORD_SIZE, file);
+			if (bytes_read != JOURNAL_RECORD_SIZE)
+			{
+				// a record torn by a crash is dropped, and the journal rewritten
+				needs_rewrite = bytes_read != 0;
+				break;
+			}
+			++num_records;
+
+			Entry entry;
+			switch (read_record(data, entry))
+			{
+			case JOURNAL_ADD:
+				entries[entry.mID] = entry;
+				break;
+			case JOURNAL_TOUCH:
+				{
+					entry_map_t::iterator iter = entries.find(entry.mID);
+					if (iter != entries.end())
+					{
+						iter->second.mTime = entry.mTime;
+					}
+				}
+				break;
+			case JOURNAL_REMOVE:
+				entries.erase(entry.mID);
+				break;
+			default:
+				LL_WARNS() << "Corrupted texture cache journal at record " << num_records << LL_ENDL;
+				success = false;
+				break;
+			}
+		}
+		LLFile::close(file);
+	}
+
+	if (!success)
+	{
+		return false;
+	}
+
+	// A slot claimed by two entries holds the data of only one of them, and
+	// there is no telling which, so both go.
+	std::map<S32, U32> slot_users;
+	for (entry_map_t::iterator iter = entries.begin(); iter != entries.end(); ++iter)
+	{
+		++slot_users[iter->second.mIndex];
+	}
+
+	std::set<S32> used_slots;
+	S32 next_slot = 0;
+	for (entry_map_t::iterator iter = entries.begin(); iter != entries.end();)
+	{
+		Entry& entry = iter->second;
+		if (entry.mIndex < 0 || entry.mImageSize <= entry.mBodySize || entry.mIndex >= (S32)max_entries
+			|| slot_users[entry.mIndex] > 1)
+		{
+			// out of range after the cache size was reduced, or corrupted
+			dropped.push_back(entry);
+			iter = entries.erase(iter);
+			needs_rewrite = true;
+			continue;
+		}
+		used_slots.insert(entry.mIndex);
+		next_slot = llmax(next_slot, entry.mIndex + 1);
+		++iter;
+	}
+
+	{
+		LLMutexLock lock(&mSlotMutex);
+		mNextSlot = next_slot;
+		mFreeSlots.clear();
+		mEvictionList.clear();
+		for (S32 idx = 0; idx < next_slot; ++idx)
+		{
+			if (used_slots.find(idx) == used_slots.end())
+			{
+				mFreeSlots.insert(idx);
+			}
+		}
+	}
+
+	S64 body_size_total = 0;
+	for (S32 i = 0; i < SHARD_COUNT; ++i)
+	{
+		LLMutexLock lock(&mShards[i].mMutex);
+		mShards[i].mEntries.clear();
+		mShards[i].mTouched.clear();
+	}
+	for (entry_map_t::iterator iter = entries.begin(); iter != entries.end(); ++iter)
+	{
+		Shard& shard = getShard(iter->first);
+		LLMutexLock lock(&shard.mMutex);
+		shard.mEntries[iter->first] = iter->second;
+		body_size_total += iter->second.mBodySize;
+	}
+	mBodySizeTotal = body_size_total;
+	mEntryCount = (U32)entries.size();
+	mJournalRecords = num_records;
+
+	if (!mReadOnly)
+	{
+		if (needs_rewrite || needsCompaction())
+		{
+			compact();
+		}
+		else
+		{
+			LLMutexLock lock(&mJournalMutex);
+			openJournal(false);
+		}
+	}
+
+	return true;
+}
+
+void LLTextureCacheIndex::clear()
+{
+	{
+		LLMutexLock lock(&mSlotMutex);
+		mNextSlot = 0;
+		mFreeSlots.clear();
+		mEvictionList.clear();
+	}
+	for (S32 i = 0; i < SHARD_COUNT; ++i)
+	{
+		LLMutexLock lock(&mShards[i].mMutex);
+		mShards[i].mEntries.clear();
+		mShards[i].mTouched.clear();
+	}
+	mBodySizeTotal = 0;
+	mEntryCount = 0;
+
+	LLMutexLock lock(&mJournalMutex);
+	if (!mReadOnly && !mJournalFilename.empty())
+	{
+		openJournal(true);
+	}
+}
+
+S32 LLTextureCacheIndex::find(const LLUUID& id, Entry& entry, bool touch)
+{
+	Shard& shard = getShard(id);
+	LLMutexLock lock(&shard.mMutex);
+
+	entry_map_t::iterator iter = shard.mEntries.find(id);
+	if (iter == shard.mEntries.end())
+	{
+		return -1;
+	}
+
+	if (touch && !mReadOnly)
+	{
+		U32 now = (U32)time(NULL);
+		if (now - iter->second.mTime > TOUCH_THRESHOLD)
+		{
+			shard.mTouched.push_back(id);
+		}
+		iter->second.mTime = now;
+	}
+
+	entry = iter->second;
+	return entry.mIndex;
+}
+
+bool LLTextureCacheIndex::contains(const LLUUID& id)
+{
+	Shard& shard = getShard(id);
+	LLMutexLock lock(&shard.mMutex);
+	return shard.mEntries.find(id) != shard.mEntries.end();
+}
+
+S32 LLTextureCacheIndex::allocate(const LLUUID& id, Entry& entry, Entry& evicted)
+{
+	evicted.mIndex = -1;
+	if (mReadOnly)
+	{
+		return -1;
+	}
+
+	S32 idx = -1;
+	{
+		LLMutexLock lock(&mSlotMutex);
+		if (mNextSlot < (S32)mMaxEntries)
+		{
+			// Add an entry to the end of the list
+			idx = mNextSlot++;
+		}
+		else if (!mFreeSlots.empty())
+		{
+			idx = *mFreeSlots.begin();
+			mFreeSlots.erase(mFreeSlots.begin());
+		}
+		else
+		{
+			idx = evictOldest(evicted);
+		}
+	}
+
+	if (idx >= 0)
+	{
+		entry.mID = id;
+		entry.mIndex = idx;
+		entry.mImageSize = -1; //mark it is a brand-new entry.
+		entry.mBodySize = 0;
+		entry.mTime = (U32)time(NULL);
+	}
+	return idx;
+}
+
+// mSlotMutex is locked before calling this.
+S32 LLTextureCacheIndex::evictOldest(Entry& evicted)
+{
+	if (mEvictionList.empty())
+	{
+		// Oldest share of the entries, kept newest first so the back is the oldest
+		typedef std::pair<U32, LLUUID> lru_data_t;
+		std::vector<lru_data_t> lru;
+		lru.reserve(mEntryCount);
+		for (S32 i = 0; i < SHARD_COUNT; ++i)
+		{
+			LLMutexLock lock(&mShards[i].mMutex);
+			for (entry_map_t::iterator iter = mShards[i].mEntries.begin(); iter != mShards[i].mEntries.end(); ++iter)
+			{
+				lru.push_back(std::make_pair(iter->second.mTime, iter->first));
+			}
+		}
+
+		size_t lru_entries = llclamp((size_t)((F32)mMaxEntries * EVICTION_LIST_SIZE), (size_t)1, lru.size());
+		std::partial_sort(lru.begin(), lru.begin() + lru_entries, lru.end());
+		mEvictionList.reserve(lru_entries);
+		for (size_t i = lru_entries; i > 0; --i)
+		{
+			mEvictionList.push_back(lru[i - 1].second);
+		}
+	}
+
+	while (!mEvictionList.empty())
+	{
+		LLUUID id = mEvictionList.back();
+		mEvictionList.pop_back();
+
+		Shard& shard = getShard(id);
+		{
+			LLMutexLock lock(&shard.mMutex);
+			entry_map_t::iterator iter = shard.mEntries.find(id);
+			if (iter == shard.mEntries.end())
+			{
+				continue; // already gone
+			}
+			evicted = iter->second;
+			shard.mEntries.erase(iter);
+			appendJournal(JOURNAL_REMOVE, evicted);
+		}
+
+		mBodySizeTotal -= evicted.mBodySize;
+		--mEntryCount;
+		return evicted.mIndex;
+	}
+
+	return -1;
+}
+
+void LLTextureCacheIndex::freeSlot(S32 idx)
+{
+	if (idx >= 0)
+	{
+		mFreeSlots.insert(idx);
+	}
+}
+
+void LLTextureCacheIndex::update(Entry& entry, S32 image_size, S32 body_size)
+{
+	bool is_new = entry.mImageSize < 0;
+	entry.mImageSize = image_size;
+	entry.mBodySize = body_size;
+	entry.mTime = (U32)time(NULL);
+
+	S32 stale_slot = -1;
+	{
+		Shard& shard = getShard(entry.mID);
+		LLMutexLock lock(&shard.mMutex);
+
+		entry_map_t::iterator iter = shard.mEntries.find(entry.mID);
+		if (iter == shard.mEntries.end())
+		{
+			if (!is_new)
+			{
+				// evicted or removed since it was looked up, its slot may
+				// already belong to another texture
+				return;
+			}
+			shard.mEntries[entry.mID] = entry;
+			mBodySizeTotal += body_size;
+			++mEntryCount;
+		}
+		else
+		{
+			if (iter->second.mIndex != entry.mIndex)
+			{
+				if (!is_new)
+				{
+					return; // re-created in another slot since it was looked up
+				}
+				// two writers raced to create the same texture
+				stale_slot = iter->second.mIndex;
+			}
+			mBodySizeTotal += body_size - iter->second.mBodySize;
+			iter->second = entry;
+		}
+
+		// journaled under the shard lock so records for one id are written
+		// in the order they were applied
+		appendJournal(JOURNAL_ADD, entry);
+	}
+
+	if (stale_slot >= 0)
+	{
+		LLMutexLock lock(&mSlotMutex);
+		freeSlot(stale_slot);
+	}
+}
+
+bool LLTextureCacheIndex::remove(const LLUUID& id, Entry& removed)
+{
+	{
+		Shard& shard = getShard(id);
+		LLMutexLock lock(&shard.mMutex);
+
+		entry_map_t::iterator iter = shard.mEntries.find(id);
+		if (iter == shard.mEntries.end())
+		{
+			return false;
+		}
+		removed = iter->second;
+		shard.mEntries.erase(iter);
+		appendJournal(JOURNAL_REMOVE, removed);
+	}
+
+	mBodySizeTotal -= removed.mBodySize;
+	--mEntryCount;
+
+	{
+		LLMutexLock lock(&mSlotMutex);
+		freeSlot(removed.mIndex);
+	}
+
+	return true;
+}
+
+void LLTextureCacheIndex::getEntries(entry_list_t& entries)
+{
+	entries.reserve(entries.size() + mEntryCount);
+	for (S32 i = 0; i < SHARD_COUNT; ++i)
+	{
+		LLMutexLock lock(&mShards[i].mMutex);
+		for (entry_map_t::iterator iter = mShards[i].mEntries.begin(); iter != mShards[i].mEntries.end(); ++iter)
+		{
+			entries.push_back(iter->second);
+		}
+	}
+}
+
+U32 LLTextureCacheIndex::getSlotCount()
+{
+	LLMutexLock lock(&mSlotMutex);
+	return (U32)mNextSlot;
+}
+
+void LLTextureCacheIndex::flush()
+{
+	if (mReadOnly)
+	{
+		return;
+	}
+
+	for (S32 i = 0; i < SHARD_COUNT; ++i)
+	{
+		Shard& shard = mShards[i];
+		LLMutexLock lock(&shard.mMutex);
+		std::vector<U8> records;
+		for (std::vector<LLUUID>::iterator iter = shard.mTouched.begin(); iter != shard.mTouched.end(); ++iter)
+		{
+			entry_map_t::iterator found = shard.mEntries.find(*iter);
+			if (found != shard.mEntries.end())
+			{
+				append_record(records, JOURNAL_TOUCH, found->second);
+			}
+		}
+		shard.mTouched.clear();
+
+		if (!records.empty())
+		{
+			mJournalRecords += (U32)(records.size() / JOURNAL_RECORD_SIZE);
+			writeJournal(records);
+		}
+	}
+}
+
+bool LLTextureCacheIndex::needsCompaction() const
+{
+	return mJournalRecords > mEntryCount + JOURNAL_COMPACT_SLACK;
+}
+
+void LLTextureCacheIndex::compact()
+{
+	if (mReadOnly)
+	{
+		mCompactionPending = false;
+		return;
+	}
+
+	// Records are appended under their shard lock, so holding every shard
+	// (in order, before the journal lock like appends do) keeps the index
+	// and the journal in step while the snapshot replaces the journal.
+	for (S32 i = 0; i < SHARD_COUNT; ++i)
+	{
+		mShards[i].mMutex.lock();
+	}
+
+	compactLocked();
+
+	for (S32 i = SHARD_COUNT - 1; i >= 0; --i)
+	{
+		mShards[i].mMutex.unlock();
+	}
+	mCompactionPending = false;
+}
+
+bool LLTextureCacheIndex::startCompaction()
+{
+	bool expected = false;
+	return mCompactionPending.compare_exchange_strong(expected, true);
+}
+
+// Every shard mutex is locked before calling this.
+void LLTextureCacheIndex::compactLocked()
+{
+	LLMutexLock lock(&mJournalMutex);
+	if (mJournalFilename.empty())
+	{
+		return;
+	}
+
+	std::vector<U8> records;
+	records.reserve(mEntryCount * JOURNAL_RECORD_SIZE);
+	for (S32 i = 0; i < SHARD_COUNT; ++i)
+	{
+		for (entry_map_t::iterator iter = mShards[i].mEntries.begin(); iter != mShards[i].mEntries.end(); ++iter)
+		{
+			append_record(records, JOURNAL_ADD, iter->second);
+		}
+	}
+
+	std::string temp_filename = mJournalFilename + ".tmp";
+	LLFILE* file = LLFile::fopen(temp_filename, "wb");
+	bool success = file != NULL;
+	if (success)
+	{
+		U32 header_size = (U32)mJournalHeader.size();
+		success = fwrite(&JOURNAL_MAGIC, sizeof(U32), 1, file) == 1
+			&& fwrite(&header_size, sizeof(U32), 1, file) == 1
+			&& fwrite(mJournalHeader.data(), 1, header_size, file) == header_size
+			&& fwrite(records.data(), 1, records.size(), file) == records.size();
+		success = (LLFile::close(file) == 0) && success;
+	}
+
+	if (mJournalFile)
+	{
+		LLFile::close(mJournalFile);
+		mJournalFile = NULL;
+	}
+
+	if (success)
+	{
+		LLFile::remove(mJournalFilename, ENOENT);
+		success = LLFile::rename(temp_filename, mJournalFilename) == 0;
+	}
+
+	if (success)
+	{
+		mJournalRecords = (U32)(records.size() / JOURNAL_RECORD_SIZE);
+		openJournal(false);
+	}
+	else
+	{
+		LL_WARNS() << "Failed to compact texture cache journal " << mJournalFilename << LL_ENDL;
+		LLFile::remove(temp_filename, ENOENT);
+		// Start over rather than append to a journal we can't vouch for
+		openJournal(true);
+		for (S32 offset = 0; offset < (S32)records.size() && mJournalFile; offset += JOURNAL_RECORD_SIZE)
+		{
+			fwrite(&records[offset], 1, JOURNAL_RECORD_SIZE, mJournalFile);
+		}
+		mJournalRecords = (U32)(records.size() / JOURNAL_RECORD_SIZE);
+	}
+}
+
+void LLTextureCacheIndex::appendJournal(EJournalOp op, const Entry& entry)
+{
+	if (mReadOnly)
+	{
+		return;
+	}
+
+	std::vector<U8> records;
+	append_record(records, op, entry);
+	++mJournalRecords;
+	writeJournal(records);
+}
+
+void LLTextureCacheIndex::writeJournal(const std::vector<U8>& records)
+{
+	LLMutexLock lock(&mJournalMutex);
+	if (!mJournalFile)
+	{
+		return;
+	}
+
+	if (fwrite(records.data(), 1, records.size(), mJournalFile) != records.size()
+		|| fflush(mJournalFile) != 0)
+	{
+		LL_WARNS() << "Failed to write texture cache journal " << mJournalFilename << LL_ENDL;
+	}
+}
+
+// mJournalMutex is locked before calling this.
+bool LLTextureCacheIndex::openJournal(bool truncate)
+{
+	if (mJournalFile)
+	{
+		LLFile::close(mJournalFile);
+		mJournalFile = NULL;
+	}
+
+	mJournalFile = LLFile::fopen(mJournalFilename, truncate ? "wb" : "ab");
+	if (!mJournalFile)
+	{
+		LL_WARNS() << "Unable to open texture cache journal " << mJournalFilename << LL_ENDL;
+		return false;
+	}
+
+	if (truncate)
+	{
+		U32 header_size = (U32)mJournalHeader.size();
+		fwrite(&JOURNAL_MAGIC, sizeof(U32), 1, mJournalFile);
+		fwrite(&header_size, sizeof(U32), 1, mJournalFile);
+		fwrite(mJournalHeader.data(), 1, header_size, mJournalFile);
+		fflush(mJournalFile);
+		mJournalRecords = 0;
+	}
+	return true;
+}
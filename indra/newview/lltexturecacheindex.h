@@ -0,0 +1,167 @@
+/**
+ * @file lltexturecacheindex.h
+ * @brief Sharded, journaled index of the texture cache entries
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLTEXTURECACHEINDEX_H
+#define LL_LLTEXTURECACHEINDEX_H
+
+#include "llfile.h"
+#include "llmutex.h"
+#include "lluuid.h"
+
+#include <atomic>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+// LLTextureCacheIndex maps texture ids to their slot in texture.cache and
+// FastCache.cache, along with the image and body sizes and the last access
+// time.
+//
+// Lookups only lock the shard the id hashes to, so the texture cache thread,
+// the fetch thread and the main thread no longer queue up behind each other
+// or behind file I/O. Slot allocation has its own lock and is only taken
+// when an entry is created or removed.
+//
+// The index is persisted as an append-only journal: creations and removals
+// are written as they happen, under the lock of the shard they change, and
+// access times are batched until flush(). The
+// journal is rewritten from the in-memory index by compact(), which is safe
+// to run on another thread while the index is in use.
+class LLTextureCacheIndex
+{
+	LOG_CLASS(LLTextureCacheIndex);
+public:
+	struct Entry
+	{
+		Entry() : mIndex(-1), mImageSize(0), mBodySize(0), mTime(0) {}
+
+		LLUUID	mID;
+		S32		mIndex;		// slot in the header and fast cache files
+		S32		mImageSize;	// total size of image if known, -1 for a slot that is not committed yet
+		S32		mBodySize;	// size of body file in body cache
+		U32		mTime;		// seconds since 1/1/1970
+	};
+	typedef std::vector<Entry> entry_list_t;
+
+	LLTextureCacheIndex();
+	~LLTextureCacheIndex();
+
+	// Replays the journal. header identifies the cache format and is written
+	// at the start of the journal; a journal that starts with anything else
+	// is rejected and the caller should clear the cache. Entries in slots at
+	// or above max_entries, and entries sharing a slot, are returned in
+	// dropped so their files can go.
+	bool load(const std::string& filename, const std::string& header, U32 max_entries, entry_list_t& dropped);
+
+	// Forgets every entry and starts an empty journal.
+	void clear();
+
+	void setReadOnly(bool read_only) { mReadOnly = read_only; }
+
+	// Any thread. Returns the slot, or -1 if the id is not cached. Touching
+	// updates the access time without writing the journal.
+	S32 find(const LLUUID& id, Entry& entry, bool touch);
+	bool contains(const LLUUID& id);
+
+	// Any thread. Reserves a slot for a new entry. When every slot is in use
+	// the least recently used entry is evicted and returned in evicted (with
+	// mIndex set) so the caller can delete its body file.
+	S32 allocate(const LLUUID& id, Entry& entry, Entry& evicted);
+
+	// Any thread. Commits an allocated or existing entry with new sizes. An
+	// existing entry that was evicted since it was looked up is left out.
+	void update(Entry& entry, S32 image_size, S32 body_size);
+
+	// Any thread. Returns false if the id was not cached.
+	bool remove(const LLUUID& id, Entry& removed);
+
+	// Any thread. Snapshot of all committed entries, in no particular order.
+	void getEntries(entry_list_t& entries);
+
+	// Writes batched access times to the journal.
+	void flush();
+	bool needsCompaction() const;
+	// Any thread. Claims the next compact() run, false if one is pending.
+	bool startCompaction();
+	// Rewrites the journal and releases the claim.
+	void compact();
+
+	S64 getBodySizeTotal() const	{ return mBodySizeTotal; }
+	U32 getEntryCount() const		{ return mEntryCount; }
+	U32 getSlotCount();
+
+private:
+	enum { SHARD_COUNT = 16 };
+
+	enum EJournalOp
+	{
+		JOURNAL_ADD = 1,
+		JOURNAL_TOUCH = 2,
+		JOURNAL_REMOVE = 3
+	};
+
+	typedef std::unordered_map<LLUUID, Entry> entry_map_t;
+	struct Shard
+	{
+		LLMutex				mMutex;
+		entry_map_t			mEntries;
+		std::vector<LLUUID>	mTouched;	// access times not journaled yet
+	};
+
+	Shard& getShard(const LLUUID& id) { return mShards[id.mData[0] % SHARD_COUNT]; }
+
+	// mSlotMutex must be held
+	S32 evictOldest(Entry& evicted);
+	void freeSlot(S32 idx);
+
+	// the shard lock of the entry must be held, so records for an id are
+	// journaled in the order they were applied
+	void appendJournal(EJournalOp op, const Entry& entry);
+	void compactLocked();
+	void writeJournal(const std::vector<U8>& records);
+	bool openJournal(bool truncate);
+
+	Shard					mShards[SHARD_COUNT];
+
+	LLMutex					mSlotMutex;
+	S32						mNextSlot;		// slots [0, mNextSlot) have been handed out at least once
+	U32						mMaxEntries;
+	std::set<S32>			mFreeSlots;
+	std::vector<LLUUID>		mEvictionList;	// oldest entry at the back, rebuilt when used up
+
+	LLMutex					mJournalMutex;
+	std::string				mJournalFilename;
+	std::string				mJournalHeader;
+	LLFILE*					mJournalFile;
+	std::atomic<U32>		mJournalRecords;
+
+	std::atomic<S64>		mBodySizeTotal;
+	std::atomic<U32>		mEntryCount;
+	std::atomic<bool>		mReadOnly;
+	std::atomic<bool>		mCompactionPending;
+};
+
+#endif // LL_LLTEXTURECACHEINDEX_H
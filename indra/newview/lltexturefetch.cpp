@@ -1806,7 +1806,20 @@ bool LLTextureFetchWorker::doWork(S32 param)
 				mRequestedOffset += src_offset;
 			}
 
-			U8 * buffer = (U8 *)ll_aligned_malloc_16(total_size);
+			// The first response for an image usually arrives in a single
+			// preallocated block which the image can take over as is.
+			U8 * buffer = nullptr;
+			size_t detached_size(0);
+			if (cur_size == 0 && src_offset == 0)
+			{
+				buffer = (U8 *)mHttpBufferArray->detachData(&detached_size);
+				llassert(! buffer || detached_size == total_size);
+			}
+			const bool detached(buffer != nullptr);
+			if (!detached)
+			{
+				buffer = (U8 *)ll_aligned_malloc_16(total_size);
+			}
 			if (!buffer)
 			{
 				// abort. If we have no space for packet, we have not enough space to decode image
@@ -1836,12 +1849,15 @@ bool LLTextureFetchWorker::doWork(S32 param)
 				mFileSize = total_size + 1 ; //flag the file is not fully loaded.
 			}
 
-			if (cur_size > 0)
+			if (!detached)
 			{
-				// Copy previously collected data into buffer
-				memcpy(buffer, mFormattedImage->getData(), cur_size);
+				if (cur_size > 0)
+				{
+					// Copy previously collected data into buffer
+					memcpy(buffer, mFormattedImage->getData(), cur_size);
+				}
+				mHttpBufferArray->read(src_offset, (char *) buffer + cur_size, append_size);
 			}
-			mHttpBufferArray->read(src_offset, (char *) buffer + cur_size, append_size);
 
 			// NOTE: setData releases current data and owns new data (buffer)
 			mFormattedImage->setData(buffer, total_size);
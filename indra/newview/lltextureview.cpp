@@ -631,7 +631,7 @@ void LLGLTexMemBar::draw()
 	text = llformat("Mesh: Reqs(Tot/Htp/Big): %u/%u/%u Rtr/Err: %u/%u Cread/Cwrite: %u/%u Low/At/High: %d/%d/%d",
 					LLMeshRepository::sMeshRequestCount, LLMeshRepository::sHTTPRequestCount, LLMeshRepository::sHTTPLargeRequestCount,
 					LLMeshRepository::sHTTPRetryCount, LLMeshRepository::sHTTPErrorCount,
-					LLMeshRepository::sCacheReads, LLMeshRepository::sCacheWrites,
+					LLMeshRepository::sCacheReads, LLMeshRepository::sCacheWrites.load(),
 					LLMeshRepoThread::sRequestLowWater, LLMeshRepoThread::sRequestWaterLevel, LLMeshRepoThread::sRequestHighWater);
 	LLFontGL::getFontMonospace()->renderUTF8(text, 0, 0, v_offset + line_height*2,
 											 text_color, LLFontGL::LEFT, LLFontGL::TOP);
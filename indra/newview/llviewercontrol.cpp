@@ -824,6 +824,7 @@ void settings_setup_listeners()
 	setting_setup_signal_listener(gSavedSettings, "RenderVBOMappingDisable", handleResetVertexBuffersChanged);
 	setting_setup_signal_listener(gSavedSettings, "RenderUseStreamVBO", handleResetVertexBuffersChanged);
 	setting_setup_signal_listener(gSavedSettings, "RenderPreferStreamDraw", handleResetVertexBuffersChanged);
+	setting_setup_signal_listener(gSavedSettings, "RenderStreamRing", handleResetVertexBuffersChanged);
 	setting_setup_signal_listener(gSavedSettings, "WLSkyDetail", handleWLSkyDetailChanged);
 	setting_setup_signal_listener(gSavedSettings, "JoystickAxis0", handleJoystickChanged);
 	setting_setup_signal_listener(gSavedSettings, "JoystickAxis1", handleJoystickChanged);
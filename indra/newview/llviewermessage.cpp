@@ -75,6 +75,7 @@
 #include "llmarketplacefunctions.h"
 #include "llnotifications.h"
 #include "llnotificationsutil.h"
+#include "llobjectupdatedecoder.h"
 #include "llpanelgrouplandmoney.h"
 #include "llrecentpeople.h"
 #include "llscriptfloater.h"
@@ -3773,6 +3774,12 @@ void process_kill_object(LLMessageSystem *mesgsys, void **user_data)
 		regionp = LLWorld::getInstance()->getRegion(host);
 	}
 
+	if (regionp && LLObjectUpdateDecoder::instanceExists())
+	{
+		// kills must not overtake full updates still being decoded
+		LLObjectUpdateDecoder::getInstance()->flushRegion(regionp->getHandle());
+	}
+
 	bool delete_object = LLViewerRegion::sVOCacheCullingEnabled;
 	S32	num_objects = mesgsys->getNumberOfBlocksFast(_PREHASH_ObjectData);
 	for (S32 i = 0; i < num_objects; ++i)
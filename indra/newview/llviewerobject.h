@@ -604,6 +604,9 @@ public:
 	static void unpackU32(LLDataPackerBinaryBuffer* dp, U32& value, std::string name);
 	static void unpackU8(LLDataPackerBinaryBuffer* dp, U8& value, std::string name);
 	static U32 unpackParentID(LLDataPackerBinaryBuffer* dp, U32& parent_id);
+private:
+	// offset of a field in a compressed update, thread safe once initObjectDataMap() ran
+	static U32 getObjectDataOffset(const std::string& name);
 
 public:
 	//counter-translation
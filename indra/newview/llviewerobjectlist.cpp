@@ -33,6 +33,7 @@
 #include "llrender.h"
 #include "llwindow.h"		// decBusyCount()
 
+#include "llavataranimationupdater.h"
 #include "llviewercontrol.h"
 #include "llface.h"
 #include "llvoavatar.h"
@@ -82,6 +83,7 @@
 #include "llappviewer.h"
 #include "llfloaterperms.h"
 #include "llvocache.h"
+#include "llobjectupdatedecoder.h"
 #include "llcorehttputil.h"
 #include "llstartup.h"
 #include <algorithm>
@@ -516,10 +518,23 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 		return;
 	}
 
+	// anything not going through the pipeline, including everything once it
+	// was just turned off, has to wait for the batches queued before it
+	if (LLObjectUpdateDecoder::instanceExists() &&
+		(!LLObjectUpdateDecoder::isEnabled() || !compressed || update_type == OUT_TERSE_IMPROVED))
+	{
+		LLObjectUpdateDecoder::getInstance()->flushRegion(region_handle);
+	}
+
 	U8 compressed_dpbuffer[2048];
 	LLDataPackerBinaryBuffer compressed_dp(compressed_dpbuffer, 2048);
 	LLViewerStatsRecorder& recorder = LLViewerStatsRecorder::instance();
 
+	// Cacheable full updates are unpacked on the decoder threads; everything
+	// else has to see the cache as if those had been applied in order.
+	LLObjectUpdateDecoder* decoder = LLObjectUpdateDecoder::isEnabled() ? LLObjectUpdateDecoder::getInstance() : NULL;
+	bool pipelined = decoder && compressed && update_type != OUT_TERSE_IMPROVED;
+
 	for (i = 0; i < num_objects; i++)
 	{
 		// timer is unused?
@@ -543,6 +558,17 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 				U32 flags = 0;
 				mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_UpdateFlags, flags, i);
 
+				if (pipelined)
+				{
+					if ((flags & FLAGS_TEMPORARY_ON_REZ) == 0)
+					{
+						//send to object cache by way of the decoder threads
+						decoder->addCompressedBlock(region_handle, flags, compressed_dpbuffer, uncompressed_length);
+						continue;
+					}
+					decoder->flushRegion(region_handle);
+				}
+
                     compressed_dp.unpackUUID(fullid, "ID");
                     compressed_dp.unpackU32(local_id, "LocalID");
                     compressed_dp.unpackU8(pcode, "PCode");
@@ -771,6 +797,11 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 		objectp->setLastUpdateType(update_type);
 	}
 
+	if (pipelined)
+	{
+		decoder->submit();
+	}
+
 	recorder.log(0.2f);
 
 	LLVOAvatar::cullAvatarsByPixelArea();
@@ -801,6 +832,12 @@ void LLViewerObjectList::processCachedObjectUpdate(LLMessageSystem *mesgsys,
 		return;
 	}
 
+	if (LLObjectUpdateDecoder::instanceExists())
+	{
+		// probeCache() must see every full update that arrived before this
+		LLObjectUpdateDecoder::getInstance()->flushRegion(region_handle);
+	}
+
 	LLViewerStatsRecorder& recorder = LLViewerStatsRecorder::instance();
 
 	for (S32 i = 0; i < num_objects; i++)
@@ -965,6 +1002,22 @@ void LLViewerObjectList::update(LLAgent &agent)
 	//clear avatar LOD change counter
 	LLVOAvatar::sNumLODChangesThisFrame = 0;
 
+	//hand cacheable updates decoded off the main thread to their regions
+	if (LLObjectUpdateDecoder::instanceExists())
+	{
+		static LLCachedControl<bool> threaded_decode(gSavedSettings, "ObjectUpdateThreadedDecode", true);
+		static LLCachedControl<F32> apply_budget(gSavedSettings, "ObjectUpdateApplyBudgetMs", 2.f);
+		LLObjectUpdateDecoder::sEnabled = threaded_decode;
+		if (LLObjectUpdateDecoder::sEnabled)
+		{
+			LLObjectUpdateDecoder::getInstance()->applyPending(llmax((F32)apply_budget, 0.f) * 0.001f);
+		}
+		else
+		{
+			LLObjectUpdateDecoder::getInstance()->flushAll();
+		}
+	}
+
 	const F64 frame_time = LLFrameTimer::getElapsedSeconds();
 	
 	LLViewerObject *objectp = NULL;	
@@ -1013,6 +1066,11 @@ void LLViewerObjectList::update(LLAgent &agent)
 				objectp->idleUpdate(agent, frame_time);
 			}
 		}
+
+		if (LLAvatarAnimationUpdater::instanceExists())
+		{
+			LLAvatarAnimationUpdater::getInstance()->update();
+		}
 	}
 	else
 	{
@@ -1024,6 +1082,13 @@ void LLViewerObjectList::update(LLAgent &agent)
                 objectp->idleUpdate(agent, frame_time);
 		}
 
+		//animate the avatars idleUpdate() left to the worker pool, flexible
+		//attachments follow their joints
+		if (LLAvatarAnimationUpdater::instanceExists())
+		{
+			LLAvatarAnimationUpdater::getInstance()->update();
+		}
+
 		//update flexible objects
 		LLVolumeImplFlexible::updateClass();
 
@@ -373,6 +373,9 @@ public:
 	
 	virtual void traverse(const OctreeNode* n);
 
+	//pick up a traversal stopped at a node, with the frustum state it had there
+	void setRes(S32 res) { mRes = res; }
+
 protected:
 	virtual bool earlyFail(LLViewerOctreeGroup* group);	
 	
@@ -33,6 +33,7 @@
 #include "llaisapi.h"
 #include "llavatarnamecache.h"		// name lookup cap url
 #include "llfloaterreg.h"
+#include "llobjectupdatedecoder.h"
 #include "llmath.h"
 #include "llregionflags.h"
 #include "llregionhandle.h"
@@ -2388,7 +2389,7 @@ void LLViewerRegion::findOrphans(U32 parent_id)
 	}
 }
 
-void LLViewerRegion::decodeBoundingInfo(LLVOCacheEntry* entry)
+void LLViewerRegion::decodeBoundingInfo(LLVOCacheEntry* entry, const LLDecodedObjectUpdate* decoded)
 {
 	if(!sVOCacheCullingEnabled)
 	{
@@ -2448,7 +2449,18 @@ void LLViewerRegion::decodeBoundingInfo(LLVOCacheEntry* entry)
 	LLQuaternion rot;
 
 	//decode spatial info and parent info
-	U32 parent_id = entry->getDP() ? LLViewerObject::extractSpatialExtents(entry->getDP(), pos, scale, rot) : entry->getParentID();
+	U32 parent_id;
+	if (decoded)
+	{
+		//already extracted by LLObjectUpdateDecoder
+		parent_id = decoded->mParentID;
+		pos = decoded->mPos;
+		scale = decoded->mScale;
+	}
+	else
+	{
+		parent_id = entry->getDP() ? LLViewerObject::extractSpatialExtents(entry->getDP(), pos, scale, rot) : entry->getParentID();
+	}
 	
 	U32 old_parent_id = entry->getParentID();
 	bool same_old_parent = false;
@@ -2557,14 +2569,22 @@ void LLViewerRegion::decodeBoundingInfo(LLVOCacheEntry* entry)
 	return ;
 }
 
-LLViewerRegion::eCacheUpdateResult LLViewerRegion::cacheFullUpdate(LLDataPackerBinaryBuffer &dp, U32 flags)
+LLViewerRegion::eCacheUpdateResult LLViewerRegion::cacheFullUpdate(LLDataPackerBinaryBuffer &dp, U32 flags, const LLDecodedObjectUpdate* decoded)
 {
 	eCacheUpdateResult result;
 	U32 crc;
 	U32 local_id;
 
-	LLViewerObject::unpackU32(&dp, local_id, "LocalID");
-	LLViewerObject::unpackU32(&dp, crc, "CRC");
+	if (decoded)
+	{
+		local_id = decoded->mLocalID;
+		crc = decoded->mCRC;
+	}
+	else
+	{
+		LLViewerObject::unpackU32(&dp, local_id, "LocalID");
+		LLViewerObject::unpackU32(&dp, crc, "CRC");
+	}
 
 	LLVOCacheEntry* entry = getCacheEntry(local_id, false);
 
@@ -2601,7 +2621,7 @@ LLViewerRegion::eCacheUpdateResult LLViewerRegion::cacheFullUpdate(LLDataPackerB
 
 // [SL:KB] - Patch: World-Derender | Checked: 2014-08-10 (Catznip-3.7)
 		if (fUpdateObj)
-			decodeBoundingInfo(entry);
+			decodeBoundingInfo(entry, decoded);
 // [/SL:KB]
 	}
 	else
@@ -2617,7 +2637,7 @@ LLViewerRegion::eCacheUpdateResult LLViewerRegion::cacheFullUpdate(LLDataPackerB
 		
 		mImpl->mCacheMap[local_id] = entry;
 		
-		decodeBoundingInfo(entry);
+		decodeBoundingInfo(entry, decoded);
 	}
 	entry->setUpdateFlags(flags);
 
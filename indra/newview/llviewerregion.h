@@ -71,6 +71,7 @@ class LLDrawable;
 class LLViewerRegionImpl;
 class LLViewerOctreeGroup;
 class LLVOCachePartition;
+struct LLDecodedObjectUpdate;
 
 class LLViewerRegion: public LLCapabilityProvider // implements this interface
 {
@@ -348,8 +349,9 @@ public:
 		CACHE_UPDATE_REPLACED
 	} eCacheUpdateResult;
 
-	// handle a full update message
-	eCacheUpdateResult cacheFullUpdate(LLDataPackerBinaryBuffer &dp, U32 flags);
+	// handle a full update message; decoded carries fields already unpacked
+	// off the main thread by LLObjectUpdateDecoder, if any
+	eCacheUpdateResult cacheFullUpdate(LLDataPackerBinaryBuffer &dp, U32 flags, const LLDecodedObjectUpdate* decoded = NULL);
 	eCacheUpdateResult cacheFullUpdate(LLViewerObject* objectp, LLDataPackerBinaryBuffer &dp, U32 flags);	
 	LLVOCacheEntry* getCacheEntryForOctree(U32 local_id);
 	LLVOCacheEntry* getCacheEntry(U32 local_id, bool valid = true);
@@ -415,7 +417,7 @@ private:
 	void updateVisibleEntries(F32 max_time); //update visible entries
 
 	void addCacheMiss(U32 id, LLViewerRegion::eCacheMissType miss_type);
-	void decodeBoundingInfo(LLVOCacheEntry* entry);
+	void decodeBoundingInfo(LLVOCacheEntry* entry, const LLDecodedObjectUpdate* decoded = NULL);
 	bool isNonCacheableObjectCreated(U32 local_id);	
 
 public:
@@ -452,6 +452,11 @@ void LLViewerShaderMgr::setShaders()
     // Make sure the compiled shader map is cleared before we recompile shaders.
     mVertexShaderObjects.clear();
     mFragmentShaderObjects.clear();
+    mVertexShaderHashes.clear();
+    mFragmentShaderHashes.clear();
+
+    initShaderCache(gSavedSettings.getbool("RenderShaderCache"),
+                    gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "shader_cache"));
     
     initAttribsAndUniforms();
     gPipeline.releaseGLBuffers();
@@ -734,6 +739,8 @@ void LLViewerShaderMgr::setShaders()
     }
     gPipeline.createGLBuffers();
 
+    logShaderCacheStats();
+
     reentrance = false;
 }
 
@@ -208,6 +208,9 @@ LLTrace::EventStatHandle<F64Seconds >	AVATAR_EDIT_TIME("avataredittime", "Second
 
 LLTrace::EventStatHandle<LLUnit<F32, LLUnits::Percent> > OBJECT_CACHE_HIT_RATE("object_cache_hits");
 
+LLTrace::EventStatHandle<F64Milliseconds >	OBJECT_UPDATE_DECODE_TIME("objectupdatedecodetime", "Time spent unpacking the headers of a batch of cacheable object updates on the decoder threads"),
+											OBJECT_UPDATE_APPLY_TIME("objectupdateapplytime", "Time spent applying a decoded batch of object updates on the main thread");
+
 LLTrace::EventStatHandle<F64Seconds >	TEXTURE_FETCH_TIME("texture_fetch_time");
 }
 
@@ -241,6 +241,9 @@ extern LLTrace::EventStatHandle<F64Seconds >	AVATAR_EDIT_TIME,
 
 extern LLTrace::EventStatHandle<LLUnit<F32, LLUnits::Percent> > OBJECT_CACHE_HIT_RATE;
 
+extern LLTrace::EventStatHandle<F64Milliseconds >	OBJECT_UPDATE_DECODE_TIME,
+													OBJECT_UPDATE_APPLY_TIME;
+
 }
 
 class LLViewerStats : public LLSingleton<LLViewerStats>
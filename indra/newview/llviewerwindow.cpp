@@ -208,6 +208,7 @@
 #include "llfloaterimnearbychat.h"
 #include "llagentui.h"
 #include "llwearablelist.h"
+#include "llvolumeinstancecache.h"
 
 #include "llviewereventrecorder.h"
 
@@ -723,6 +724,16 @@ public:
 			addText(xpos, ypos, llformat("%d Vertex Buffer Sets", LLVertexBuffer::sSetCount));
 			ypos += y_inc;
 
+			addText(xpos, ypos, llformat("%d Draw Calls (%d ranges merged)", LLVertexBuffer::sDrawCount, LLVertexBuffer::sMergedDrawCount));
+			ypos += y_inc;
+
+			if (LLVolumeInstanceCache::instanceExists())
+			{
+				LLVolumeInstanceCache* instances = LLVolumeInstanceCache::getInstance();
+				addText(xpos, ypos, llformat("%d Shared Volume Buffers (%d KB)", instances->getNumBuffers(), instances->getBytes() / 1024));
+				ypos += y_inc;
+			}
+
 			addText(xpos, ypos, llformat("%d Texture Binds", LLImageGL::sBindCount));
 			ypos += y_inc;
 
@@ -786,7 +797,7 @@ public:
 				addText(xpos, ypos, llformat("%d/%d Mesh LOD Pending/Processing", LLMeshRepository::sLODPending, LLMeshRepository::sLODProcessing));
 				ypos += y_inc;
 
-				addText(xpos, ypos, llformat("%.3f/%.3f MB Mesh Cache Read/Write ", LLMeshRepository::sCacheBytesRead/(1024.f*1024.f), LLMeshRepository::sCacheBytesWritten/(1024.f*1024.f)));
+				addText(xpos, ypos, llformat("%.3f/%.3f MB Mesh Cache Read/Write ", LLMeshRepository::sCacheBytesRead/(1024.f*1024.f), LLMeshRepository::sCacheBytesWritten.load()/(1024.f*1024.f)));
                 ypos += y_inc;
 
                 addText(xpos, ypos, llformat("%.3f/%.3f MB Mesh Skins/Decompositions Memory", LLMeshRepository::sCacheBytesSkins / (1024.f*1024.f), LLMeshRepository::sCacheBytesDecomps / (1024.f*1024.f)));
@@ -799,6 +810,7 @@ public:
 
 			LLVertexBuffer::sBindCount = LLImageGL::sBindCount = 
 				LLVertexBuffer::sSetCount = LLImageGL::sUniqueCount = 
+				LLVertexBuffer::sDrawCount = LLVertexBuffer::sMergedDrawCount = 
 				gPipeline.mNumVisibleNodes = LLPipeline::sVisibleLightCount = 0;
 		}
 		if (gSavedSettings.getbool("DebugShowAvatarRenderInfo"))
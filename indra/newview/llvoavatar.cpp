@@ -43,6 +43,7 @@
 #include "llagentcamera.h"
 #include "llagentwearables.h"
 #include "llanimationstates.h"
+#include "llavataranimationupdater.h"
 #include "llavatarnamecache.h"
 #include "llavatarpropertiesprocessor.h"
 #include "llavatarrendernotifier.h"
@@ -696,6 +697,7 @@ LLVOAvatar::LLVOAvatar(const LLUUID& id,
 	mVisible(false),
 	mLastImpostorUpdateFrameTime(0.f),
 	mLastImpostorUpdateReason(0),
+	mImpostorOffscreenFrames(0),
 	mWindFreq(0.f),
 	mRipplePhase( 0.f ),
 	mBelowWater(false),
@@ -721,6 +723,12 @@ LLVOAvatar::LLVOAvatar(const LLUUID& id,
 	mCulled(false),
 	mVisibilityRank(0),
 	mNeedsSkin(false),
+	mPendingMotionUpdate(LLCharacter::NORMAL_UPDATE),
+	mPendingEvaluate(false),
+	mPendingVisible(false),
+	mPendingSitGroundConstrained(false),
+	mAnimatingCharacter(false),
+	mPendingVisualParamsUpdate(false),
 	mLastSkinTime(0.f),
 	mUpdatePeriod(1),
 	mOverallAppearance(AOA_INVISIBLE),
@@ -881,6 +889,8 @@ LLVOAvatar::~LLVOAvatar()
 	// </FS:ND>
 	LL_DEBUGS("Avatar") << "LLVOAvatar Destructor (0x" << this << ") id:" << mID << LL_ENDL;
 
+	releaseImpostor();
+
 	//
 	//	if we have a pending avatar properties request
 	//	then clear it down
@@ -913,6 +923,7 @@ void LLVOAvatar::markDead()
 	}
 	mVoiceVisualizer->markDead();
 	LLLoadedCallbackEntry::cleanUpCallbackList(&mCallbackTextureList) ;
+	releaseImpostor();
 	LLViewerObject::markDead();
 }
 
@@ -1165,10 +1176,24 @@ void LLVOAvatar::resetImpostors()
 		 iter != LLCharacter::sInstances.end(); ++iter)
 	{
 		LLVOAvatar* avatar = (LLVOAvatar*) *iter;
-		avatar->mImpostor.release();
+		avatar->mImpostorSlot = LLAvatarImpostorAtlas::Slot();
 		avatar->mNeedsImpostorUpdate = true;
 		avatar->mLastImpostorUpdateReason = 1;
 	}
+
+	if (LLAvatarImpostorAtlas::instanceExists())
+	{
+		LLAvatarImpostorAtlas::getInstance()->release();
+	}
+}
+
+void LLVOAvatar::releaseImpostor()
+{
+	if (LLAvatarImpostorAtlas::instanceExists())
+	{
+		LLAvatarImpostorAtlas::getInstance()->free(mImpostorSlot);
+	}
+	mImpostorSlot = LLAvatarImpostorAtlas::Slot();
 }
 
 // static
@@ -2726,8 +2751,32 @@ void LLVOAvatar::idleUpdate(LLAgent &agent, const F64 &time)
 	// animate the character
 	// store off last frame's root position to be consistent with camera position
 	mLastRootPos = mRoot->getWorldPosition();
+
+	if (canAnimateInParallel())
+	{
+		if (prepareCharacterUpdate(agent))
+		{
+			// LLAvatarAnimationUpdater animates it with the others and finishes
+			// the idle update afterwards
+			LLAvatarAnimationUpdater::getInstance()->add(this);
+		}
+		else
+		{
+			idleUpdateAfterAnimation(false);
+		}
+		return;
+	}
+
 	bool detailed_update = updateCharacter(agent);
+	idleUpdateAfterAnimation(detailed_update);
+}
 
+//------------------------------------------------------------------------
+// idleUpdateAfterAnimation()
+// everything in idleUpdate() that wants this frame's joint positions
+//------------------------------------------------------------------------
+void LLVOAvatar::idleUpdateAfterAnimation(bool detailed_update)
+{
 	static LLUICachedControl<bool> visualizers_in_calls("ShowVoiceVisualizersInCalls", false);
 	bool voice_enabled = (visualizers_in_calls || LLVoiceClient::getInstance()->inProximalChannel()) &&
 						 LLVoiceClient::getInstance()->getVoiceEnabled(mID);
@@ -4740,6 +4789,34 @@ bool LLVOAvatar::computeNeedsUpdate()
 //
 //------------------------------------------------------------------------
 bool LLVOAvatar::updateCharacter(LLAgent &agent)
+{
+	if (!prepareCharacterUpdate(agent))
+	{
+		return false;
+	}
+
+	animateCharacter();
+
+	return finishCharacterUpdate();
+}
+
+//------------------------------------------------------------------------
+// canAnimateInParallel()
+// Self and animated objects are few and have their own update ordering
+// (camera, attachment positions), so they stay serial.
+//------------------------------------------------------------------------
+bool LLVOAvatar::canAnimateInParallel() const
+{
+	return LLAvatarAnimationUpdater::isEnabled() &&
+		!isSelf() && !isControlAvatar() && !isUIAvatar() &&
+		mSpecialRenderMode == 0;
+}
+
+//------------------------------------------------------------------------
+// prepareCharacterUpdate()
+// main thread: everything updateCharacter() does before evaluating motions
+//------------------------------------------------------------------------
+bool LLVOAvatar::prepareCharacterUpdate(LLAgent &agent)
 {	
 	updateDebugText();
 	
@@ -4844,20 +4921,55 @@ bool LLVOAvatar::updateCharacter(LLAgent &agent)
 	// update animations
 	if (!visible)
 	{
-		updateMotions(LLCharacter::HIDDEN_UPDATE);
+		mPendingMotionUpdate = LLCharacter::HIDDEN_UPDATE;
 	}
 	else if (mSpecialRenderMode == 1) // Animation Preview
 	{
-		updateMotions(LLCharacter::FORCE_UPDATE);
+		mPendingMotionUpdate = LLCharacter::FORCE_UPDATE;
 	}
 	else
 	{
 		// Might be better to do HIDDEN_UPDATE if cloud
-		updateMotions(LLCharacter::NORMAL_UPDATE);
+		mPendingMotionUpdate = LLCharacter::NORMAL_UPDATE;
+	}
+
+	// motion loading, purging and timing stay here, evaluation may not
+	mPendingEvaluate = beginMotionUpdate(mPendingMotionUpdate);
+	mPendingVisible = visible;
+	mPendingSitGroundConstrained = was_sit_ground_constrained;
+
+	return true;
+}
+
+//------------------------------------------------------------------------
+// animateCharacter()
+// any thread: evaluate and blend motions, then bring the joints' world
+// matrices up to date
+//------------------------------------------------------------------------
+void LLVOAvatar::animateCharacter()
+{
+	if (mPendingEvaluate)
+	{
+		mAnimatingCharacter = true;
+		evaluateMotions(mPendingMotionUpdate);
+		mAnimatingCharacter = false;
+		mPendingEvaluate = false;
 	}
 
+	mJointUpdateList.updateWorldMatrices(mRoot);
+}
+
+//------------------------------------------------------------------------
+// finishCharacterUpdate()
+// main thread: what updateCharacter() does after the motions, returns
+// whether the avatar is visible
+//------------------------------------------------------------------------
+bool LLVOAvatar::finishCharacterUpdate()
+{
+	bool visible = mPendingVisible;
+
 	// Special handling for sitting on ground.
-	if (!getParent() && (isSitting() || was_sit_ground_constrained))
+	if (!getParent() && (isSitting() || mPendingSitGroundConstrained))
 	{
 		
 		F32 off_z = LLVector3d(getHoverOffset()).mdV[VZ];
@@ -4871,14 +4983,22 @@ bool LLVOAvatar::updateCharacter(LLAgent &agent)
 		}
 	}
 
+	// visual params the motions changed, see mAnimatingCharacter
+	if (mPendingVisualParamsUpdate)
+	{
+		mPendingVisualParamsUpdate = false;
+		updateVisualParams();
+	}
+
 	// update head position
 	updateHeadOffset();
 
 	// Generate footstep sounds when feet hit the ground
     updateFootstepSounds();
 
-	// Update child joints as needed.
-	mRoot->updateWorldMatrixChildren();
+	// Update child joints as needed.  Only the sit offset and the visual
+	// params above can have dirtied them since animateCharacter().
+	mJointUpdateList.updateWorldMatrices(mRoot);
 
     if (visible)
     {
@@ -5424,7 +5544,8 @@ U32 LLVOAvatar::renderRigid()
 
 U32 LLVOAvatar::renderImpostor(LLColor4U color, S32 diffuse_channel)
 {
-	if (!mImpostor.isComplete())
+	LLAvatarImpostorAtlas* atlas = LLAvatarImpostorAtlas::getInstance();
+	if (!hasImpostor() || !atlas->getTarget().isComplete())
 	{
 		return 0;
 	}
@@ -5471,16 +5592,19 @@ U32 LLVOAvatar::renderImpostor(LLColor4U color, S32 diffuse_channel)
 	LLGLEnable test(GL_ALPHA_TEST);
     gGL.flush();
 
+	LLVector2 tc_min, tc_max;
+	atlas->getTexCoords(mImpostorSlot, tc_min, tc_max);
+
 	gGL.color4ubv(color.mV);
-	gGL.getTexUnit(diffuse_channel)->bind(&mImpostor);
+	gGL.getTexUnit(diffuse_channel)->bind(&atlas->getTarget());
 	gGL.begin(LLRender::QUADS);
-	gGL.texCoord2f(0,0);
+	gGL.texCoord2f(tc_min.mV[0], tc_min.mV[1]);
 	gGL.vertex3fv((pos+left-up).mV);
-	gGL.texCoord2f(1,0);
+	gGL.texCoord2f(tc_max.mV[0], tc_min.mV[1]);
 	gGL.vertex3fv((pos-left-up).mV);
-	gGL.texCoord2f(1,1);
+	gGL.texCoord2f(tc_max.mV[0], tc_max.mV[1]);
 	gGL.vertex3fv((pos-left+up).mV);
-	gGL.texCoord2f(0,1);
+	gGL.texCoord2f(tc_min.mV[0], tc_max.mV[1]);
 	gGL.vertex3fv((pos+left+up).mV);
 	gGL.end();
 	gGL.flush();
@@ -7239,6 +7363,12 @@ void LLVOAvatar::initAttachmentPoints(bool ignore_hud_joints)
 //-----------------------------------------------------------------------------
 void LLVOAvatar::updateVisualParams()
 {
+	if (mAnimatingCharacter)
+	{ //possibly on an animation worker, finishCharacterUpdate() does it
+		mPendingVisualParamsUpdate = true;
+		return;
+	}
+
 	ESex avatar_sex = (getVisualParamWeight("male") > 0.5f) ? SEX_MALE : SEX_FEMALE;
 	if (getSex() != avatar_sex)
 	{
@@ -10602,6 +10732,12 @@ void LLVOAvatar::updateRiggingInfo()
 			{
 				const LLUUID& mesh_id = vol->getVolume()->getParams().getSculptID();
 				S32 max_lod = llmax(vol->getLOD(), vol->mLastRiggingInfoLOD);
+				// pick up boxes another wearer of the mesh cached at a higher LOD
+				const LLMeshSkinInfo* skin = vol->getSkinInfo();
+				if (skin)
+				{
+					max_lod = llmax(max_lod, skin->mRiggingInfoLOD);
+				}
 				curr_rigging_info_key[mesh_id] = max_lod;
 			}
 		}
@@ -10651,24 +10787,99 @@ U32 LLVOAvatar::getPartitionType() const
 	return mIsControlAvatar ? LLViewerRegion::PARTITION_CONTROL_AV : LLViewerRegion::PARTITION_AVATAR;
 }
 
+// impostors out of view this many frames give their atlas slot back
+static const U32 IMPOSTOR_OFFSCREEN_RELEASE_FRAMES = 120;
+
 //static
 void LLVOAvatar::updateImpostors()
 {
 	LLViewerCamera::sCurCameraID = LLViewerCamera::CAMERA_WORLD;
 
+	static LLCachedControl<U32> update_budget(gSavedSettings, "RenderAvatarImpostorUpdateBudget", 4);
+
+	LLAvatarImpostorAtlas* atlas = LLAvatarImpostorAtlas::getInstance();
+
     std::vector<LLCharacter*> instances_copy = LLCharacter::sInstances;
+	std::vector<LLVOAvatar*> impostors;
+	U32 offscreen_slots = 0;
 	for (std::vector<LLCharacter*>::iterator iter = instances_copy.begin();
 		iter != instances_copy.end(); ++iter)
 	{
 		LLVOAvatar* avatar = (LLVOAvatar*) *iter;
-		if (!avatar->isDead()
-			&& avatar->isVisible()
-			&& avatar->isImpostor()
-			&& avatar->needsImpostorUpdate())
+		if (avatar->isDead())
 		{
-            avatar->calcMutedAVColor();
-			gPipeline.generateImpostor(avatar);
+			continue;
+		}
+		if (!avatar->isImpostor())
+		{
+			avatar->releaseImpostor();
 		}
+		else if (avatar->isVisible())
+		{
+			avatar->mImpostorOffscreenFrames = 0;
+			impostors.push_back(avatar);
+		}
+		else if (avatar->hasImpostor())
+		{
+			// keep the slot for a quick look around, but not for good
+			if (++avatar->mImpostorOffscreenFrames > IMPOSTOR_OFFSCREEN_RELEASE_FRAMES)
+			{
+				avatar->releaseImpostor();
+				avatar->mNeedsImpostorUpdate = true;
+				avatar->mLastImpostorUpdateReason = 14;
+			}
+			else
+			{
+				++offscreen_slots;
+			}
+		}
+	}
+
+	// give every impostor holding or wanting a slot room in the atlas at
+	// once, bigger ones are rendered again at the smaller size
+	atlas->setNumImpostors((U32) impostors.size() + offscreen_slots);
+
+	struct Candidate
+	{
+		LLVOAvatar* mAvatar;
+		bool		mHasImpostor;
+		F32			mPriority;
+	};
+	std::vector<Candidate> candidates;
+	for (LLVOAvatar* avatar : impostors)
+	{
+		if (avatar->hasImpostor() && avatar->mImpostorSlot.mSize > atlas->getMaxSlotSize())
+		{
+			avatar->mNeedsImpostorUpdate = true;
+			avatar->mLastImpostorUpdateReason = 13;
+		}
+
+		if (avatar->needsImpostorUpdate())
+		{
+			F32 waited = (F32)(gFrameTimeSeconds - avatar->mLastImpostorUpdateFrameTime);
+			Candidate candidate = { avatar, avatar->hasImpostor(), avatar->mImpostorPixelArea * (1.f + waited) };
+			candidates.push_back(candidate);
+		}
+	}
+
+	// avatars with nothing to show come first, then the largest on screen
+	// weighted by how long they have been waiting
+	std::sort(candidates.begin(), candidates.end(),
+		[](const Candidate& lhs, const Candidate& rhs)
+		{
+			if (lhs.mHasImpostor != rhs.mHasImpostor)
+			{
+				return !lhs.mHasImpostor;
+			}
+			return lhs.mPriority > rhs.mPriority;
+		});
+
+	U32 count = llmin((U32) candidates.size(), llmax((U32) update_budget, (U32) 1));
+	for (U32 i = 0; i < count; ++i)
+	{
+		LLVOAvatar* avatar = candidates[i].mAvatar;
+		avatar->calcMutedAVColor();
+		gPipeline.generateImpostor(avatar);
 	}
 
 	LLCharacter::sAllowInstancesChange = true;
@@ -43,7 +43,7 @@
 #include "llcontrol.h"
 #include "llviewerjointmesh.h"
 #include "llviewerjointattachment.h"
-#include "llrendertarget.h"
+#include "llavatarimpostoratlas.h"
 #include "llavatarappearancedefines.h"
 #include "lltexglobalcolor.h"
 #include "lldriverparam.h"
@@ -270,6 +270,15 @@ public:
 	virtual void	updateDebugText();
 	virtual bool 	computeNeedsUpdate();
 	virtual bool 	updateCharacter(LLAgent &agent);
+
+	// updateCharacter() in three steps so LLAvatarAnimationUpdater can run the
+	// middle one for many avatars at once.  prepareCharacterUpdate() and
+	// finishCharacterUpdate() run on the main thread; animateCharacter() only
+	// touches this avatar's motions and joints and may run on a worker.
+	bool			prepareCharacterUpdate(LLAgent &agent); // false if there is nothing to animate
+	void			animateCharacter();
+	bool			finishCharacterUpdate();
+	bool			canAnimateInParallel() const;
     void			updateFootstepSounds();
     void			computeUpdatePeriod();
     void			updateOrientation(LLAgent &agent, F32 speed, F32 delta_time);
@@ -277,6 +286,7 @@ public:
     void			updateRootPositionAndRotation(LLAgent &agent, F32 speed, bool was_sit_ground_constrained);
     
 	void            idleUpdateVoiceVisualizer(bool voice_enabled, const LLVector3 &position);
+	void			idleUpdateAfterAnimation(bool detailed_update);
 	void 			idleUpdateMisc(bool detailed_update);
 	virtual void	idleUpdateAppearanceAnimation();
 	void 			idleUpdateLipSync(bool voice_enabled);
@@ -503,6 +513,18 @@ private:
 	bool		shouldAlphaMask();
 
 	bool 		mNeedsSkin; // avatar has been animated and verts have not been updated
+
+	// carried from prepareCharacterUpdate() to animateCharacter() and finishCharacterUpdate()
+	LLCharacter::e_update_t mPendingMotionUpdate;
+	bool		mPendingEvaluate;
+	bool		mPendingVisible;
+	bool		mPendingSitGroundConstrained;
+	// set while animateCharacter() runs: updateVisualParams() starts and stops
+	// motions and touches the mesh, so motions asking for it then (avatar
+	// physics) get it from finishCharacterUpdate() on the main thread
+	bool		mAnimatingCharacter;
+	bool		mPendingVisualParamsUpdate;
+	LLJointUpdateList mJointUpdateList;
 	F32			mLastSkinTime; //value of gFrameTimeSeconds at last skin update
 
 	S32	 		mUpdatePeriod;
@@ -574,10 +596,13 @@ public:
 	void 		setImpostorDim(const LLVector2& dim);
 	static void	resetImpostors();
 	static void updateImpostors();
-	LLRenderTarget mImpostor;
+	bool		hasImpostor() const { return mImpostorSlot.isValid(); }
+	void		releaseImpostor();
+	LLAvatarImpostorAtlas::Slot mImpostorSlot;
 	bool		mNeedsImpostorUpdate;
 	S32			mLastImpostorUpdateReason;
 	F32SecondsImplicit mLastImpostorUpdateFrameTime;
+	U32			mImpostorOffscreenFrames; // frames out of view while holding a slot
     const LLVector3*  getLastAnimExtents() const { return mLastAnimExtents; }
 	void		setNeedsExtentUpdate(bool val) { mNeedsExtentUpdate = val; }
 
@@ -44,8 +44,9 @@ F32 LLVOCacheEntry::sFrontPixelThreshold = 1.0f;
 F32 LLVOCacheEntry::sRearPixelThreshold = 1.0f;
 bool LLVOCachePartition::sNeedsOcclusionCheck = false;
 
-const S32 ENTRY_HEADER_SIZE = 6 * sizeof(S32);
 const S32 MAX_ENTRY_BODY_SIZE = 10000;
+const U32 REGION_FILE_MAGIC = 0x434f564c; // "LVOC"
+const U32 REGION_FILE_FORMAT_VERSION = 2;
 
 bool check_read(LLAPRFile* apr_file, void* src, S32 n_bytes) 
 {
@@ -74,7 +75,9 @@ LLVOCacheEntry::LLVOCacheEntry(U32 local_id, U32 crc, LLDataPackerBinaryBuffer &
 	mSceneContrib(0.f),
 	mValid(true),
 	mParentID(0),
-	mBSphereRadius(-1.0f)
+	mBSphereRadius(-1.0f),
+	mBodyOffset(0),
+	mBodySize(0)
 {
 	mBuffer = new U8[dp.getBufferSize()];
 	mDP.assignBuffer(mBuffer, dp.getBufferSize());
@@ -94,74 +97,34 @@ LLVOCacheEntry::LLVOCacheEntry()
 	mSceneContrib(0.f),
 	mValid(true),
 	mParentID(0),
-	mBSphereRadius(-1.0f)
+	mBSphereRadius(-1.0f),
+	mBodyOffset(0),
+	mBodySize(0)
 {
 	mDP.assignBuffer(mBuffer, 0);
 }
 
-LLVOCacheEntry::LLVOCacheEntry(LLAPRFile* apr_file)
-:	LLViewerOctreeEntryData(LLViewerOctreeEntry::LLVOCACHEENTRY), 
-	mBuffer(NULL),
+LLVOCacheEntry::LLVOCacheEntry(U32 local_id, U32 crc, S32 hit_count, S32 dupe_count, S32 crc_change_count,
+							   LLVOCacheRegionFile* region_file, U32 body_offset, S32 body_size)
+:	LLViewerOctreeEntryData(LLViewerOctreeEntry::LLVOCACHEENTRY),
+	mLocalID(local_id),
+	mCRC(crc),
 	mUpdateFlags(-1),
+	mHitCount(hit_count),
+	mDupeCount(dupe_count),
+	mCRCChangeCount(crc_change_count),
+	mBuffer(NULL),
+	mRegionFile(region_file),
+	mBodyOffset(body_offset),
+	mBodySize(body_size),
 	mState(INACTIVE),
 	mSceneContrib(0.f),
-	mValid(false),
+	mValid(true),
 	mParentID(0),
 	mBSphereRadius(-1.0f)
 {
-	S32 size = -1;
-	bool success;
-    static U8 data_buffer[ENTRY_HEADER_SIZE];
-
+	// the body stays in the region file until getDP() asks for it
 	mDP.assignBuffer(mBuffer, 0);
-
-    success = check_read(apr_file, (void *)data_buffer, ENTRY_HEADER_SIZE);
-    if (success)
-    {
-        memcpy(&mLocalID, data_buffer, sizeof(U32));
-        memcpy(&mCRC, data_buffer + sizeof(U32), sizeof(U32));
-        memcpy(&mHitCount, data_buffer + (2 * sizeof(U32)), sizeof(S32));
-        memcpy(&mDupeCount, data_buffer + (3 * sizeof(U32)), sizeof(S32));
-        memcpy(&mCRCChangeCount, data_buffer + (4 * sizeof(U32)), sizeof(S32));
-        memcpy(&size, data_buffer + (5 * sizeof(U32)), sizeof(S32));
-
-		// Corruption in the cache entries
-		if ((size > MAX_ENTRY_BODY_SIZE) || (size < 1))
-		{
-			// We've got a bogus size, skip reading it.
-			// We won't bother seeking, because the rest of this file
-			// is likely bogus, and will be tossed anyway.
-			LL_WARNS() << "Bogus cache entry, size " << size << ", aborting!" << LL_ENDL;
-			success = false;
-		}
-	}
-	if(success && size > 0)
-	{
-		mBuffer = new U8[size];
-		success = check_read(apr_file, mBuffer, size);
-
-		if(success)
-		{
-			mDP.assignBuffer(mBuffer, size);
-		}
-		else
-		{
-			delete[] mBuffer ;
-			mBuffer = NULL ;
-		}
-	}
-
-	if(!success)
-	{
-		mLocalID = 0;
-		mCRC = 0;
-		mHitCount = 0;
-		mDupeCount = 0;
-		mCRCChangeCount = 0;
-		mBuffer = NULL;
-		mEntry = NULL;
-		mState = INACTIVE;
-	}
 }
 
 LLVOCacheEntry::~LLVOCacheEntry()
@@ -178,6 +141,8 @@ void LLVOCacheEntry::updateEntry(U32 crc, LLDataPackerBinaryBuffer &dp)
 	}
 
 	mDP.freeBuffer();
+	mRegionFile = NULL;
+	mBodySize = 0;
 
 	llassert_always(dp.getBufferSize() > 0);
 	mBuffer = new U8[dp.getBufferSize()];
@@ -213,11 +178,9 @@ void LLVOCacheEntry::removeAllChildren()
 //virtual 
 void LLVOCacheEntry::setOctreeEntry(LLViewerOctreeEntry* entry)
 {
-	if(!entry && mDP.getBufferSize() > 0)
+	LLUUID fullid;
+	if(!entry && getFullID(fullid))
 	{
-		LLUUID fullid;
-		LLViewerObject::unpackUUID(&mDP, fullid, "ID");
-		
 		LLViewerObject* obj = gObjectList.findObject(fullid);
 		if(obj && obj->mDrawable)
 		{
@@ -310,6 +273,19 @@ LLVOCacheEntry* LLVOCacheEntry::getChild()
 
 LLDataPackerBinaryBuffer *LLVOCacheEntry::getDP()
 {
+	if (mRegionFile.notNull())
+	{
+		// first use since the region was loaded, copy the body out of the mapping
+		if (mRegionFile->isOpen())
+		{
+			mBuffer = new U8[mBodySize];
+			memcpy(mBuffer, mRegionFile->getData() + mBodyOffset, mBodySize);
+			mDP.assignBuffer(mBuffer, mBodySize);
+		}
+		mRegionFile = NULL;
+		mBodySize = 0;
+	}
+
 	if (mDP.getBufferSize() == 0)
 	{
 		//LL_INFOS() << "Not getting cache entry, invalid!" << LL_ENDL;
@@ -322,6 +298,11 @@ LLDataPackerBinaryBuffer *LLVOCacheEntry::getDP()
 // [SL:KB] - Patch: World-Derender | Checked: 2014-08-10 (Catznip-3.7)
 const U8* LLVOCacheEntry::getDPBuffer() const
 {
+	if (mRegionFile.notNull())
+	{
+		// read straight from the mapping rather than loading the body
+		return mRegionFile->isOpen() ? mRegionFile->getData() + mBodyOffset : NULL;
+	}
 	if (mDP.getBufferSize() == 0)
 		return NULL;
 	return mDP.getBuffer();
@@ -344,25 +325,43 @@ void LLVOCacheEntry::dump() const
 		<< LL_ENDL;
 }
 
+S32 LLVOCacheEntry::getBodySize() const
+{
+	if (mRegionFile.notNull())
+	{
+		return mRegionFile->isOpen() ? mBodySize : 0;
+	}
+	return mDP.getBufferSize();
+}
+
+bool LLVOCacheEntry::getFullID(LLUUID& id) const
+{
+	// the id leads the body, see LLViewerObject::initObjectDataMap()
+	const U8* buffer = getDPBuffer();
+	if (!buffer || getBodySize() < UUID_BYTES)
+	{
+		return false;
+	}
+	memcpy(id.mData, buffer, UUID_BYTES);
+	return true;
+}
+
 S32 LLVOCacheEntry::writeToBuffer(U8 *data_buffer) const
 {
-    S32 size = mDP.getBufferSize();
-
-    if (size > MAX_ENTRY_BODY_SIZE)
-    {
-        LL_WARNS() << "Failed to write entry with size above allowed limit: " << size << LL_ENDL;
-        return 0;
-    }
-
-    memcpy(data_buffer, &mLocalID, sizeof(U32));
-    memcpy(data_buffer + sizeof(U32), &mCRC, sizeof(U32));
-    memcpy(data_buffer + (2 * sizeof(U32)), &mHitCount, sizeof(S32));
-    memcpy(data_buffer + (3 * sizeof(U32)), &mDupeCount, sizeof(S32));
-    memcpy(data_buffer + (4 * sizeof(U32)), &mCRCChangeCount, sizeof(S32));
-    memcpy(data_buffer + (5 * sizeof(U32)), &size, sizeof(S32));
-    memcpy(data_buffer + ENTRY_HEADER_SIZE, (void*)mBuffer, size);
-
-    return ENTRY_HEADER_SIZE + size;
+	S32 size = getBodySize();
+
+	if (size > MAX_ENTRY_BODY_SIZE)
+	{
+		LL_WARNS() << "Failed to write entry with size above allowed limit: " << size << LL_ENDL;
+		return 0;
+	}
+
+	if (size > 0)
+	{
+		memcpy(data_buffer, getDPBuffer(), size);
+	}
+
+	return size;
 }
 
 //static 
@@ -1137,10 +1136,10 @@ void LLVOCache::removeCache(ELLPath location, bool started)
 	std::string mask = "*";
 	std::string cache_dir = gDirUtilp->getExpandedFilename(location, object_cache_dirname);
 	LL_INFOS() << "Removing cache at " << cache_dir << LL_ENDL;
+	clearCacheInMemory(); //unmaps the region files first
 	gDirUtilp->deleteFilesInDir(cache_dir, mask); //delete all files
 	LLFile::rmdir(cache_dir);
 
-	clearCacheInMemory();
 	mInitialized = false;
 }
 
@@ -1160,9 +1159,9 @@ void LLVOCache::removeCache()
 
 	std::string mask = "*";
 	LL_INFOS() << "Removing object cache at " << mObjectCacheDirName << LL_ENDL;
+	clearCacheInMemory() ; //unmaps the region files first
 	gDirUtilp->deleteFilesInDir(mObjectCacheDirName, mask); 
 
-	clearCacheInMemory() ;
 	writeCacheHeader();
 }
 
@@ -1203,6 +1202,12 @@ void LLVOCache::removeEntry(U64 handle)
 
 void LLVOCache::clearCacheInMemory()
 {
+	for(region_file_map_t::iterator iter = mRegionFiles.begin(); iter != mRegionFiles.end(); ++iter)
+	{
+		iter->second->close();
+	}
+	mRegionFiles.clear();
+
 	if(!mHeaderEntryQueue.empty()) 
 	{
 		for(header_entry_queue_t::iterator iter = mHeaderEntryQueue.begin(); iter != mHeaderEntryQueue.end(); ++iter)
@@ -1235,6 +1240,11 @@ void LLVOCache::removeFromCache(HeaderEntryInfo* entry)
 		return ;
 	}
 
+	// The region may still be live (bad TE data in LLVOVolume drops its
+	// cache), so leave the mapping to the entries that have yet to load
+	// their body; the file can be deleted while it is mapped.
+	releaseRegionFile(entry->mHandle);
+
 	std::string filename;
 	getObjectCacheFilename(entry->mHandle, filename);
 	LLAPRFile::remove(filename, mLocalAPRFilePoolp);
@@ -1403,46 +1413,84 @@ void LLVOCache::readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::voca
 		return ;
 	}
 
-	bool success = true ;
+	// Only the index is parsed here.  Bodies stay in the mapped file until
+	// LLVOCacheEntry::getDP() is first called on them.  A mapping still
+	// tracked for this handle belongs to an earlier region that has gone
+	// away; unmap it rather than leave it pinning the file.
+	closeRegionFile(handle);
+
+	std::string filename;
+	getObjectCacheFilename(handle, filename);
+
+	LLVOCacheEntry::vocache_entry_map_t loaded_entries;
+	LLPointer<LLVOCacheRegionFile> region_file = new LLVOCacheRegionFile();
+	bool success = region_file->open(filename);
+	if(success)
 	{
-		std::string filename;
-		LLUUID cache_id;
-		getObjectCacheFilename(handle, filename);
-		LLAPRFile apr_file(filename, APR_READ|APR_BINARY, mLocalAPRFilePoolp);
-	
-		success = check_read(&apr_file, cache_id.mData, UUID_BYTES);
-	
+		const U8* data = region_file->getData();
+		const size_t file_size = region_file->getSize();
+
+		RegionFileHeader header;
+		success = file_size >= sizeof(RegionFileHeader);
+		if(success)
+		{
+			memcpy(&header, data, sizeof(RegionFileHeader));
+			success = header.mMagic == REGION_FILE_MAGIC && header.mFormatVersion == REGION_FILE_FORMAT_VERSION;
+			if(!success)
+			{
+				LL_WARNS() << "Unknown object cache format in " << filename << ", discarding" << LL_ENDL;
+			}
+		}
+
 		if(success)
-		{		
+		{
+			LLUUID cache_id;
+			memcpy(cache_id.mData, header.mRegionID, UUID_BYTES);
 			if(cache_id != id)
 			{
 				LL_INFOS() << "Cache ID doesn't match for this region, discarding"<< LL_ENDL;
 				success = false ;
 			}
+		}
 
-			if(success)
+		if(success)
+		{
+			const size_t index_end = sizeof(RegionFileHeader) + (size_t)llmax(header.mNumEntries, 0) * sizeof(RegionIndexRecord);
+			success = header.mNumEntries >= 0 && index_end <= file_size;
+
+			const U8* record_data = data + sizeof(RegionFileHeader);
+			for (S32 i = 0; success && i < header.mNumEntries; i++, record_data += sizeof(RegionIndexRecord))
 			{
-				S32 num_entries;  // if removal was enabled during write num_entries might be wrong
-				success = check_read(&apr_file, &num_entries, sizeof(S32)) ;
-	
-				if(success)
+				RegionIndexRecord record;
+				memcpy(&record, record_data, sizeof(RegionIndexRecord));
+
+				// Corruption in the cache entries
+				if (!record.mLocalID || record.mBodySize < 1 || record.mBodySize > MAX_ENTRY_BODY_SIZE
+					|| record.mBodyOffset < index_end || (size_t)record.mBodyOffset + record.mBodySize > file_size)
 				{
-					for (S32 i = 0; i < num_entries && apr_file.eof() != APR_EOF; i++)
-					{
-						LLPointer<LLVOCacheEntry> entry = new LLVOCacheEntry(&apr_file);
-						if (!entry->getLocalID())
-						{
-							LL_WARNS() << "Aborting cache file load for " << filename << ", cache file corruption!" << LL_ENDL;
-							success = false ;
-							break ;
-						}
-						cache_entry_map[entry->getLocalID()] = entry;
-					}
+					LL_WARNS() << "Aborting cache file load for " << filename << ", cache file corruption!" << LL_ENDL;
+					success = false;
+					break;
 				}
+
+				loaded_entries[record.mLocalID] = new LLVOCacheEntry(record.mLocalID, record.mCRC, record.mHitCount,
+					record.mDupeCount, record.mCRCChangeCount, region_file, record.mBodyOffset, record.mBodySize);
 			}
-		}		
+		}
+
+		if(success)
+		{
+			mRegionFiles[handle] = region_file;
+			cache_entry_map.insert(loaded_entries.begin(), loaded_entries.end());
+		}
+		else
+		{
+			// entries read before the corruption are dropped along with the file
+			loaded_entries.clear();
+			region_file->close();
+		}
 	}
-	
+
 	if(!success)
 	{
 		if(cache_entry_map.empty())
@@ -1454,6 +1502,21 @@ void LLVOCache::readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::voca
 	return ;
 }
 	
+void LLVOCache::closeRegionFile(U64 handle)
+{
+	region_file_map_t::iterator iter = mRegionFiles.find(handle);
+	if(iter != mRegionFiles.end())
+	{
+		iter->second->close();
+		mRegionFiles.erase(iter);
+	}
+}
+
+void LLVOCache::releaseRegionFile(U64 handle)
+{
+	mRegionFiles.erase(handle);
+}
+
 void LLVOCache::purgeEntries(U32 size)
 {
 	while(mHeaderEntryQueue.size() > size)
@@ -1484,107 +1547,154 @@ void LLVOCache::writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry:
 	}	
 
 	HeaderEntryInfo* entry;
-	handle_entry_map_t::iterator iter = mHandleEntryMap.find(handle) ;
-	if(iter == mHandleEntryMap.end()) //new entry
-	{				
-		if(mNumEntries >= mCacheSize - 1)
-		{
-			purgeEntries(mCacheSize - 1) ;
-		}
+	bool success = true ;
+	std::string filename;
+	getObjectCacheFilename(handle, filename);
+	// Write next to the old file and swap it in afterwards; the old one may
+	// still be mapped by the entries we are saving.
+	std::string temp_filename = filename + ".tmp";
 
-		entry = new HeaderEntryInfo();
-		entry->mHandle = handle ;
-		entry->mTime = time(NULL) ;
-		entry->mIndex = mNumEntries++;
-		mHeaderEntryQueue.insert(entry) ;
-		mHandleEntryMap[handle] = entry ;
-	}
-	else
 	{
-		// Update access time.
-		entry = iter->second ;		
+		// The region is going away: whichever way this block is left, the
+		// old file is unmapped before it is replaced or removed below, which
+		// Windows refuses to do to a mapped file.
+		ScopedRegionFileClose close_region_file(*this, handle);
+
+		handle_entry_map_t::iterator iter = mHandleEntryMap.find(handle) ;
+		if(iter == mHandleEntryMap.end()) //new entry
+		{				
+			if(mNumEntries >= mCacheSize - 1)
+			{
+				purgeEntries(mCacheSize - 1) ;
+			}
+
+			entry = new HeaderEntryInfo();
+			entry->mHandle = handle ;
+			entry->mTime = time(NULL) ;
+			entry->mIndex = mNumEntries++;
+			mHeaderEntryQueue.insert(entry) ;
+			mHandleEntryMap[handle] = entry ;
+		}
+		else
+		{
+			// Update access time.
+			entry = iter->second ;		
 
-		//resort
-		mHeaderEntryQueue.erase(entry) ;
+			//resort
+			mHeaderEntryQueue.erase(entry) ;
 		
-		entry->mTime = time(NULL) ;
-		mHeaderEntryQueue.insert(entry) ;
-	}
+			entry->mTime = time(NULL) ;
+			mHeaderEntryQueue.insert(entry) ;
+		}
 
-	//update cache header
-	if(!updateEntry(entry))
-	{
-		LL_WARNS() << "Failed to update cache header index " << entry->mIndex << ". handle = " << handle << LL_ENDL;
-		return ; //update failed.
-	}
+		//update cache header
+		if(!updateEntry(entry))
+		{
+			LL_WARNS() << "Failed to update cache header index " << entry->mIndex << ". handle = " << handle << LL_ENDL;
+			return ; //update failed.
+		}
 
-	if(!dirty_cache)
-	{
-		LL_WARNS() << "Skipping write to cache for handle " << handle << ": cache not dirty" << LL_ENDL;
-		return ; //nothing changed, no need to update.
-	}
+		if(!dirty_cache)
+		{
+			LL_WARNS() << "Skipping write to cache for handle " << handle << ": cache not dirty" << LL_ENDL;
+			return ; //nothing changed, no need to update.
+		}
+
+		//collect the index first, the bodies follow it in the same order
+		std::vector<RegionIndexRecord> records;
+		std::vector<const LLVOCacheEntry*> entries;
+		records.reserve(cache_entry_map.size());
+		entries.reserve(cache_entry_map.size());
+
+		U32 body_offset = sizeof(RegionFileHeader);
+		for (LLVOCacheEntry::vocache_entry_map_t::const_iterator iter = cache_entry_map.begin(); iter != cache_entry_map.end(); ++iter)
+		{
+			const LLVOCacheEntry* cache_entry = iter->second;
+			if (removal_enabled && !cache_entry->isValid())
+			{
+				continue;
+			}
+
+			RegionIndexRecord record;
+			record.mLocalID = cache_entry->getLocalID();
+			record.mCRC = cache_entry->getCRC();
+			record.mHitCount = cache_entry->getHitCount();
+			record.mDupeCount = cache_entry->getDupeCount();
+			record.mCRCChangeCount = cache_entry->getCRCChangeCount();
+			record.mBodyOffset = 0;
+			record.mBodySize = cache_entry->getBodySize();
+			if (record.mBodySize < 1 || record.mBodySize > MAX_ENTRY_BODY_SIZE) // body is minimum of 1
+			{
+				LL_WARNS() << "Failed to write entry " << record.mLocalID << " with size " << record.mBodySize << LL_ENDL;
+				success = false;
+				break;
+			}
+			records.push_back(record);
+			entries.push_back(cache_entry);
+		}
 
-	//write to cache file
-	bool success = true ;
-	{
-		std::string filename;
-		getObjectCacheFilename(handle, filename);
-		// <FS> Fix bogus cache entry size warning
-		//LLAPRFile apr_file(filename, APR_CREATE|APR_WRITE|APR_BINARY|APR_TRUNCATE, mLocalAPRFilePoolp);
-		LLAPRFile apr_file(filename, APR_FOPEN_CREATE|APR_FOPEN_WRITE|APR_FOPEN_BINARY|APR_FOPEN_TRUNCATE, mLocalAPRFilePoolp);
-	
-		success = check_write(&apr_file, (void*)id.mData, UUID_BYTES);
-	
 		if(success)
 		{
-			S32 num_entries = cache_entry_map.size(); // if removal is enabled num_entries might be wrong
-			success = check_write(&apr_file, &num_entries, sizeof(S32));
-            if (success)
-            {
-                const S32 buffer_size = 32768; //should be large enough for couple MAX_ENTRY_BODY_SIZE
-                U8 data_buffer[buffer_size]; // generaly entries are fairly small, so collect them and drop onto disk in one go
-                S32 size_in_buffer = 0;
-
-                // This can have a lot of entries, so might be better to dump them into buffer first and write in one go.
-                for (LLVOCacheEntry::vocache_entry_map_t::const_iterator iter = cache_entry_map.begin(); success && iter != cache_entry_map.end(); ++iter)
-                {
-                    if (!removal_enabled || iter->second->isValid())
-                    {
-                        S32 size = iter->second->writeToBuffer(data_buffer + size_in_buffer);
-
-                        if (size > ENTRY_HEADER_SIZE) // body is minimum of 1
-                        {
-                            size_in_buffer += size;
-                        }
-                        else
-                        {
-                            success = false;
-                            break;
-                        }
-
-                        // Make sure we have space in buffer for next element
-                        if (buffer_size - size_in_buffer < MAX_ENTRY_BODY_SIZE + ENTRY_HEADER_SIZE)
-                        {
-                            success = check_write(&apr_file, (void*)data_buffer, size_in_buffer);
-                            size_in_buffer = 0;
-                            if (!success)
-                            {
-                                break;
-                            }
-                        }
-                    }
-                }
-
-                if (success && size_in_buffer > 0)
-                {
-                    // final write
-                    success = check_write(&apr_file, (void*)data_buffer, size_in_buffer);
-                    size_in_buffer = 0;
-                }
-            }
+			body_offset += records.size() * sizeof(RegionIndexRecord);
+			for (RegionIndexRecord& record : records)
+			{
+				record.mBodyOffset = body_offset;
+				body_offset += record.mBodySize;
+			}
+
+			RegionFileHeader header;
+			header.mMagic = REGION_FILE_MAGIC;
+			header.mFormatVersion = REGION_FILE_FORMAT_VERSION;
+			memcpy(header.mRegionID, id.mData, UUID_BYTES);
+			header.mNumEntries = records.size();
+
+			LLAPRFile apr_file(temp_filename, APR_FOPEN_CREATE|APR_FOPEN_WRITE|APR_FOPEN_BINARY|APR_FOPEN_TRUNCATE, mLocalAPRFilePoolp);
+			success = check_write(&apr_file, &header, sizeof(RegionFileHeader));
+			if (success && !records.empty())
+			{
+				success = check_write(&apr_file, &records[0], records.size() * sizeof(RegionIndexRecord));
+			}
+
+			if (success)
+			{
+				const S32 buffer_size = 32768; //should be large enough for couple MAX_ENTRY_BODY_SIZE
+				U8 data_buffer[buffer_size]; // generaly entries are fairly small, so collect them and drop onto disk in one go
+				S32 size_in_buffer = 0;
+
+				for (size_t i = 0; success && i < entries.size(); ++i)
+				{
+					// Make sure we have space in buffer for next element
+					if (buffer_size - size_in_buffer < MAX_ENTRY_BODY_SIZE)
+					{
+						success = check_write(&apr_file, (void*)data_buffer, size_in_buffer);
+						size_in_buffer = 0;
+					}
+
+					if (success)
+					{
+						size_in_buffer += entries[i]->writeToBuffer(data_buffer + size_in_buffer);
+					}
+				}
+
+				if (success && size_in_buffer > 0)
+				{
+					// final write
+					success = check_write(&apr_file, (void*)data_buffer, size_in_buffer);
+				}
+			}
 		}
 	}
 
+	if(success)
+	{
+		LLFile::remove(filename, ENOENT);
+		success = LLFile::rename(temp_filename, filename) == 0;
+	}
+	else
+	{
+		LLFile::remove(temp_filename, ENOENT);
+	}
+
 	if(!success)
 	{
 		removeEntry(entry) ;
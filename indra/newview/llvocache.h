@@ -32,6 +32,28 @@
 #include "lldir.h"
 #include "llvieweroctree.h"
 #include "llapr.h"
+#include "llmappedfile.h"
+
+//---------------------------------------------------------------------------
+// Read-only mapping of one region's object cache file.  Entries read from the
+// file keep a reference to it and only copy their body out when first needed,
+// so the mapping lives on until the last of them loads its body or goes away,
+// even once LLVOCache deleted the file itself.
+class LLVOCacheRegionFile : public LLRefCount
+{
+public:
+	bool open(const std::string& filename) { return mMappedFile.open(filename); }
+	// Entries that have not loaded their body yet lose it, only for regions
+	// that are going away.
+	void close()                           { mMappedFile.close(); }
+	bool isOpen() const                    { return mMappedFile.isOpen(); }
+
+	const U8* getData() const              { return mMappedFile.getData(); }
+	size_t getSize() const                 { return mMappedFile.getSize(); }
+
+private:
+	LLMappedFile mMappedFile;
+};
 
 //---------------------------------------------------------------------------
 // Cache entries
@@ -83,7 +105,8 @@ protected:
 	~LLVOCacheEntry();
 public:
 	LLVOCacheEntry(U32 local_id, U32 crc, LLDataPackerBinaryBuffer &dp);
-	LLVOCacheEntry(LLAPRFile* apr_file);
+	LLVOCacheEntry(U32 local_id, U32 crc, S32 hit_count, S32 dupe_count, S32 crc_change_count,
+				   LLVOCacheRegionFile* region_file, U32 body_offset, S32 body_size);
 	LLVOCacheEntry();	
 
 	void updateEntry(U32 crc, LLDataPackerBinaryBuffer &dp);
@@ -98,6 +121,7 @@ public:
 
 	U32 getLocalID() const			{ return mLocalID; }
 	U32 getCRC() const				{ return mCRC; }
+	S32 getDupeCount() const		{ return mDupeCount; }
 	S32 getHitCount() const			{ return mHitCount; }
 	S32 getCRCChangeCount() const	{ return mCRCChangeCount; }
 	
@@ -106,7 +130,12 @@ public:
 	F32 getSceneContribution() const             { return mSceneContrib;}
 
 	void dump() const;
+	S32 getBodySize() const;
+	// reads the object id without loading the body
+	bool getFullID(LLUUID& id) const;
+	// copies the body only, the caller writes the index record
 	S32 writeToBuffer(U8 *data_buffer) const;
+	// loads the body from the region file on first use
 	LLDataPackerBinaryBuffer *getDP();
 // [SL:KB] - Patch: World-Derender | Checked: 2014-08-10 (Catznip-3.7)
 	const U8* getDPBuffer() const;
@@ -164,6 +193,11 @@ protected:
 	LLDataPackerBinaryBuffer	mDP;
 	U8							*mBuffer;
 
+	// body not loaded yet, still lives in the region file
+	LLPointer<LLVOCacheRegionFile> mRegionFile;
+	U32							mBodyOffset;
+	S32							mBodySize;
+
 	F32                         mSceneContrib; //projected scene contributuion of this object.
 	U32                         mState; //high 16 bits reserved for special use.
 	vocache_entry_set_t         mChildrenList; //children entries in a linked set.
@@ -266,6 +300,28 @@ private:
 	};
 	typedef std::set<HeaderEntryInfo*, header_entry_less> header_entry_queue_t;
 	typedef std::map<U64, HeaderEntryInfo*> handle_entry_map_t;
+	typedef std::map<U64, LLPointer<LLVOCacheRegionFile> > region_file_map_t;
+
+	// Region file layout: RegionFileHeader, mNumEntries RegionIndexRecords
+	// sorted by local id, then the entry bodies.
+	struct RegionFileHeader
+	{
+		U32 mMagic;
+		U32 mFormatVersion;
+		U8  mRegionID[UUID_BYTES];
+		S32 mNumEntries;
+	};
+
+	struct RegionIndexRecord
+	{
+		U32 mLocalID;
+		U32 mCRC;
+		S32 mHitCount;
+		S32 mDupeCount;
+		S32 mCRCChangeCount;
+		U32 mBodyOffset; // from the start of the file
+		S32 mBodySize;
+	};
 
 public:
 	// We need this init to be separate from constructor, since we might construct cache, purge it, then init.
@@ -290,6 +346,22 @@ private:
 	void removeCache() ;
 	void removeEntry(HeaderEntryInfo* entry) ;
 	void purgeEntries(U32 size);
+	// unmap, entries of the region that did not load their body lose it
+	void closeRegionFile(U64 handle);
+	// stop tracking the mapping, entries still holding it keep it alive
+	void releaseRegionFile(U64 handle);
+
+	// closeRegionFile() on scope exit, so a file being rewritten or removed
+	// is never left mapped on any way out
+	class ScopedRegionFileClose
+	{
+	public:
+		ScopedRegionFileClose(LLVOCache& cache, U64 handle) : mCache(cache), mHandle(handle) {}
+		~ScopedRegionFileClose() { mCache.closeRegionFile(mHandle); }
+	private:
+		LLVOCache&	mCache;
+		U64			mHandle;
+	};
 	bool updateEntry(const HeaderEntryInfo* entry);
 	
 private:
@@ -304,6 +376,7 @@ private:
 	LLVolatileAPRPool*   mLocalAPRFilePoolp ; 	
 	header_entry_queue_t mHeaderEntryQueue;
 	handle_entry_map_t   mHandleEntryMap;	
+	region_file_map_t    mRegionFiles; // mapped region files that entries may still read from
 };
 
 #endif
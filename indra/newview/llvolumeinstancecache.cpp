@@ -0,0 +1,300 @@
+/**
+ * @file llvolumeinstancecache.cpp
+ * @brief Vertex buffers shared by identical static prim faces
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llvolumeinstancecache.h"
+
+#include "lldrawable.h"
+#include "lldrawpool.h"
+#include "llface.h"
+#include "lltextureentry.h"
+#include "llvertexbuffer.h"
+#include "llviewercontrol.h"
+#include "llvolume.h"
+#include "llvovolume.h"
+#include "pipeline.h"
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+static LLTrace::BlockTimerStatHandle FTM_SHARE_VOLUME_GEOMETRY("Share Volume Geometry");
+
+bool LLVolumeInstanceCache::Key::operator<(const Key& rhs) const
+{
+	return std::tie(mVolume, mTE, mMask, mColor, mPoolType, mShiny, mGlow, mDeferred,
+					mScale.mV[VX], mScale.mV[VY], mScale.mV[VZ],
+					mOffsetS, mOffsetT, mScaleS, mScaleT, mRotation, mMaterialID) <
+		std::tie(rhs.mVolume, rhs.mTE, rhs.mMask, rhs.mColor, rhs.mPoolType, rhs.mShiny, rhs.mGlow, rhs.mDeferred,
+				 rhs.mScale.mV[VX], rhs.mScale.mV[VY], rhs.mScale.mV[VZ],
+				 rhs.mOffsetS, rhs.mOffsetT, rhs.mScaleS, rhs.mScaleT, rhs.mRotation, rhs.mMaterialID);
+}
+
+LLVolumeInstanceCache::LLVolumeInstanceCache()
+:	mBytes(0)
+{
+}
+
+LLVolumeInstanceCache::~LLVolumeInstanceCache()
+{
+	clear();
+}
+
+//static
+bool LLVolumeInstanceCache::isEnabled()
+{
+	return LLPipeline::RenderVolumeInstancing && instanceExists();
+}
+
+//static
+bool LLVolumeInstanceCache::canShare(LLFace* facep)
+{
+	LLDrawable* drawablep = facep->getDrawable();
+	LLVOVolume* vobj = drawablep ? drawablep->getVOVolume() : nullptr;
+	const LLTextureEntry* te = facep->getTextureEntry();
+
+	if (!vobj || !te || !vobj->getVolume() || facep->getGeomCount() <= 0)
+	{
+		return false;
+	}
+
+	return !drawablep->isActive() &&
+		!drawablep->isState(LLDrawable::ANIMATED_CHILD) &&
+		!facep->isState(LLFace::RIGGED | LLFace::TEXTURE_ANIM | LLFace::HUD_RENDER) &&
+		!vobj->isSelected() && //selection outlines draw face buffers in region space
+		!vobj->isHUDAttachment() &&
+		!vobj->mTextureAnimp &&
+		!vobj->getVolume()->isUnique() && //flexi
+		!te->getBumpmap() && //emboss offsets follow the sun
+		te->getTexGen() == LLTextureEntry::TEX_GEN_DEFAULT && //planar mapping depends on placement
+		facep->getPoolType() != LLDrawPool::POOL_ALPHA;
+}
+
+//static
+void LLVolumeInstanceCache::makeKey(LLFace* facep, U32 mask, Key& key)
+{
+	LLVOVolume* vobj = facep->getDrawable()->getVOVolume();
+	const LLTextureEntry* te = facep->getTextureEntry();
+
+	// everything LLFace::getGeometryVolume() reads for a static face
+	key.mVolume = vobj->getVolume();
+	key.mTE = facep->getTEOffset();
+	key.mMask = mask;
+	key.mScale = vobj->getScale();
+	key.mColor = LLColor4U(te->getColor()).asRGBA();
+	key.mPoolType = facep->getPoolType();
+	key.mShiny = te->getShiny();
+	key.mGlow = (U8) llclamp((S32) (te->getGlow()*255), 0, 255);
+	key.mDeferred = LLPipeline::sRenderDeferred;
+	key.mOffsetS = te->mOffsetS;
+	key.mOffsetT = te->mOffsetT;
+	key.mScaleS = te->mScaleS;
+	key.mScaleT = te->mScaleT;
+	key.mRotation = te->getRotation();
+	key.mMaterialID = te->getMaterialID();
+}
+
+U32 LLVolumeInstanceCache::assignSharedGeometry(LLFace** faces, U32 face_count, U32 mask)
+{
+	LL_RECORD_BLOCK_TIME(FTM_SHARE_VOLUME_GEOMETRY);
+
+	static LLCachedControl<U32> min_instances(gSavedSettings, "RenderVolumeInstanceMin", 4);
+
+	std::vector<Key> keys(face_count);
+	std::vector<bool> shareable(face_count);
+	std::map<Key, U32> counts;
+
+	for (U32 i = 0; i < face_count; ++i)
+	{
+		shareable[i] = canShare(faces[i]);
+		if (shareable[i])
+		{
+			makeKey(faces[i], mask, keys[i]);
+			counts[keys[i]]++;
+		}
+	}
+
+	bool any_shared = false;
+
+	for (U32 i = 0; i < face_count; ++i)
+	{
+		if (!shareable[i])
+		{
+			continue;
+		}
+
+		// a face that appears once in this group still shares geometry already
+		// built for another group
+		if (counts[keys[i]] < min_instances && mEntries.find(keys[i]) == mEntries.end())
+		{
+			continue;
+		}
+
+		LLFace* facep = faces[i];
+		Entry* entry = getEntry(keys[i], facep);
+		if (entry)
+		{
+			// the index setters drop the vertex buffer when they change
+			facep->setGeomIndex(0);
+			facep->setIndicesIndex(0);
+			facep->setTextureIndex(0);
+			facep->setVertexBuffer(entry->mBuffer);
+			facep->setState(LLFace::INSTANCED);
+			entry->mUsers++;
+			facep->getDrawable()->getVOVolume()->updateInstanceXform();
+			any_shared = true;
+		}
+	}
+
+	if (!any_shared)
+	{
+		return face_count;
+	}
+
+	LLFace** shared_begin = std::stable_partition(faces, faces + face_count,
+		[](LLFace* facep)
+		{
+			return !facep->isState(LLFace::INSTANCED);
+		});
+
+	return (U32)(shared_begin - faces);
+}
+
+LLVolumeInstanceCache::Entry* LLVolumeInstanceCache::getEntry(const Key& key, LLFace* facep)
+{
+	entry_map_t::iterator iter = mEntries.find(key);
+	if (iter != mEntries.end())
+	{
+		return &iter->second;
+	}
+
+	LLVolume* volume = key.mVolume;
+
+	LLPointer<LLVertexBuffer> buffer = new LLVertexBuffer(key.mMask, GL_STATIC_DRAW_ARB);
+	if (!buffer->allocateBuffer(facep->getGeomCount(), facep->getIndicesCount(), true))
+	{
+		LL_WARNS() << "Failed to allocate shared Vertex Buffer to "
+			<< facep->getGeomCount() << " vertices and "
+			<< facep->getIndicesCount() << " indices" << LL_ENDL;
+		return nullptr;
+	}
+
+	facep->setGeomIndex(0);
+	facep->setIndicesIndex(0);
+	facep->setTextureIndex(0);
+	facep->setVertexBuffer(buffer);
+
+	// object space with the scale applied, the instance transform does the rest
+	LLMatrix4 mat_vert;
+	mat_vert.initScale(key.mScale);
+
+	LLMatrix3 mat_normal;
+	mat_normal.setRows(LLVector3(1.0, 0.0, 0.0) / key.mScale.mV[VX],
+					   LLVector3(0.0, 1.0, 0.0) / key.mScale.mV[VY],
+					   LLVector3(0.0, 0.0, 1.0) / key.mScale.mV[VZ]);
+
+	if (!facep->getGeometryVolume(*volume, key.mTE, mat_vert, mat_normal, 0, true))
+	{
+		LL_WARNS() << "Failed to get geometry for shared face!" << LL_ENDL;
+		facep->setVertexBuffer(nullptr);
+		return nullptr;
+	}
+	buffer->flush();
+
+	iter = mEntries.insert(std::make_pair(key, Entry())).first;
+	Entry& entry = iter->second;
+	entry.mVolume = volume;
+	entry.mBuffer = buffer;
+	mBuffers[buffer] = iter;
+	mBytes += buffer->getSize() + buffer->getIndicesSize();
+
+	return &entry;
+}
+
+void LLVolumeInstanceCache::removeUser(const LLVertexBuffer* buffer)
+{
+	buffer_map_t::iterator iter = mBuffers.find(buffer);
+	if (iter == mBuffers.end())
+	{ //purged while the face still drew from it
+		return;
+	}
+
+	Entry& entry = iter->second->second;
+	llassert(entry.mUsers > 0);
+	if (entry.mUsers > 0 && --entry.mUsers == 0)
+	{ //keep it until the end of the frame, a rebuilding group takes it straight back
+		mUnused.push_back(buffer);
+	}
+}
+
+void LLVolumeInstanceCache::releaseUnused()
+{
+	for (const LLVertexBuffer* buffer : mUnused)
+	{
+		buffer_map_t::iterator iter = mBuffers.find(buffer);
+		if (iter != mBuffers.end() && iter->second->second.mUsers == 0)
+		{
+			erase(iter->second);
+		}
+	}
+	mUnused.clear();
+}
+
+void LLVolumeInstanceCache::erase(entry_map_t::iterator iter)
+{
+	// draw infos still holding the buffer keep it alive until their group
+	// rebuilds, the volume goes now
+	LLVertexBuffer* buffer = iter->second.mBuffer;
+	mBytes -= buffer->getSize() + buffer->getIndicesSize();
+	mBuffers.erase(buffer);
+	mEntries.erase(iter);
+}
+
+void LLVolumeInstanceCache::purgeVolume(const LLVolume* volume)
+{
+	// faces still holding a purged buffer keep it alive and draw it with the
+	// counts it was built with until their group rebuilds
+	for (entry_map_t::iterator iter = mEntries.begin(); iter != mEntries.end(); )
+	{
+		if (iter->first.mVolume == volume)
+		{
+			erase(iter++);
+		}
+		else
+		{
+			++iter;
+		}
+	}
+}
+
+void LLVolumeInstanceCache::clear()
+{
+	mEntries.clear();
+	mBuffers.clear();
+	mUnused.clear();
+	mBytes = 0;
+}
@@ -0,0 +1,138 @@
+/**
+ * @file llvolumeinstancecache.h
+ * @brief Vertex buffers shared by identical static prim faces
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLVOLUMEINSTANCECACHE_H
+#define LL_LLVOLUMEINSTANCECACHE_H
+
+#include "llsingleton.h"
+#include "llpointer.h"
+#include "llmaterialid.h"
+#include "v3math.h"
+
+#include <map>
+#include <vector>
+
+class LLFace;
+class LLVolume;
+class LLVertexBuffer;
+
+// LLVolumeMgr already shares one LLVolume between every prim with the same
+// parameters and LOD, but each face still writes its own transformed copy of
+// that geometry into its spatial group's vertex buffers.  For static faces
+// whose vertex data only depends on the volume, the scale and the texture
+// entry, LLVolumeInstanceCache keeps one buffer per distinct face, built in
+// object space, and LLVolumeGeometryManager::genDrawInfo() points every face
+// that matches it at that buffer instead.  Those faces are flagged
+// LLFace::INSTANCED and drawn with LLVOVolume::getInstanceXform() as their
+// model matrix; the batch sort in LLPipeline::postSort() keeps draws of the
+// same buffer together so only the matrix changes between them.
+//
+// This only deduplicates geometry memory: every shared face is still its
+// own draw call, there is no instanced draw path, and faces drawn from a
+// shared buffer no longer merge into their group's batches.  That usually
+// costs more than the memory saves, so "RenderVolumeInstancing" is off by
+// default.
+//
+// Each entry counts the faces drawing from it.  LLFace drops its use when
+// its vertex buffer is replaced or it is destroyed, and entries left with
+// no users are released once per frame, along with the volume they pin.
+class LLVolumeInstanceCache : public LLSimpleton<LLVolumeInstanceCache>
+{
+	LOG_CLASS(LLVolumeInstanceCache);
+public:
+	LLVolumeInstanceCache();
+	~LLVolumeInstanceCache();
+
+	// follows gSavedSettings "RenderVolumeInstancing"
+	static bool isEnabled();
+
+	// main thread: move the faces that draw from shared geometry to the end of
+	// faces and return how many are left for the group's own buffers
+	U32 assignSharedGeometry(LLFace** faces, U32 face_count, U32 mask);
+
+	// main thread: a face stopped drawing from buffer
+	void removeUser(const LLVertexBuffer* buffer);
+
+	// main thread, once per frame: drop the entries no face uses any more
+	void releaseUnused();
+
+	// main thread: drop the buffers built from volume, call before its
+	// geometry changes in place (sculpt map or mesh asset arriving)
+	void purgeVolume(const LLVolume* volume);
+
+	// drop every buffer, they die with the GL context
+	void clear();
+
+	U32 getNumBuffers() const { return (U32)mEntries.size(); }
+	U32 getBytes() const { return mBytes; }
+
+private:
+	struct Key
+	{
+		bool operator<(const Key& rhs) const;
+
+		LLVolume*		mVolume;
+		S32				mTE;
+		U32				mMask;
+		LLVector3		mScale;
+		U32				mColor;
+		U32				mPoolType;
+		U8				mShiny;
+		U8				mGlow;
+		bool			mDeferred;
+		F32				mOffsetS;
+		F32				mOffsetT;
+		F32				mScaleS;
+		F32				mScaleT;
+		F32				mRotation;
+		LLMaterialID	mMaterialID;
+	};
+
+	struct Entry
+	{
+		Entry() : mUsers(0) {}
+
+		LLPointer<LLVolume>			mVolume; // keeps Key::mVolume from being reused
+		LLPointer<LLVertexBuffer>	mBuffer;
+		U32							mUsers;	 // faces drawing from mBuffer
+	};
+
+	typedef std::map<Key, Entry> entry_map_t;
+	typedef std::map<const LLVertexBuffer*, entry_map_t::iterator> buffer_map_t;
+
+	static bool canShare(LLFace* facep);
+	static void makeKey(LLFace* facep, U32 mask, Key& key);
+
+	Entry* getEntry(const Key& key, LLFace* facep);
+	void erase(entry_map_t::iterator iter);
+
+	entry_map_t mEntries;
+	buffer_map_t mBuffers;
+	std::vector<const LLVertexBuffer*> mUnused; // lost their last user this frame
+	U32 mBytes;
+};
+
+#endif // LL_LLVOLUMEINSTANCECACHE_H
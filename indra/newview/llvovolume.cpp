@@ -88,6 +88,8 @@
 #include "llcallstack.h"
 #include "llsculptidsize.h"
 #include "llavatarappearancedefines.h"
+#include "llgeometryrebuilder.h"
+#include "llvolumeinstancecache.h"
 
 const F32 FORCE_SIMPLE_RENDER_AREA = 512.f;
 const F32 FORCE_CULL_AREA = 8.f;
@@ -1364,6 +1366,10 @@ void LLVOVolume::sculpt()
 				mSculptTexture->updateBindStatsForTester() ;
 			}
 		}
+		if (LLVolumeInstanceCache::instanceExists())
+		{ //shared buffers built from the old sculpt no longer match it
+			LLVolumeInstanceCache::getInstance()->purgeVolume(getVolume());
+		}
 		getVolume()->sculpt(sculpt_width, sculpt_height, sculpt_components, sculpt_data, discard_level, mSculptTexture->isMissingAsset());
 
 		//notify rebuild any other VOVolumes that reference this sculpty volume
@@ -1781,7 +1787,8 @@ bool LLVOVolume::genBBoxes(bool force_global, bool should_update_octree_bounds)
         // updates needed, set REBUILD_RIGGED accordingly.
 
         // Without the flag, this will remove unused rigged volumes, which we are not currently very aggressive about.
-        updateRiggedVolume(false);
+        // Only the face extents are needed here, picking and selection skin the vertices themselves.
+        updateRiggedVolume(false, LLRiggedVolume::UPDATE_ALL_FACE_EXTENTS);
     }
 
     LLVolume* volume = mRiggedVolume;
@@ -2002,6 +2009,27 @@ void LLVOVolume::updateRelativeXform(bool force_identity)
 	}
 }
 
+void LLVOVolume::updateInstanceXform()
+{ //same placement as the static branch of updateRelativeXform(), but the scale
+  //is baked into the shared geometry and the region offset applied here
+	LLVector3 pos = getPosition();
+	LLQuaternion rot = getRotation();
+
+	if (mParent)
+	{
+		pos *= mParent->getRotation();
+		pos += mParent->getPosition();
+		rot *= mParent->getRotation();
+	}
+
+	pos += getRegion()->getOriginAgent();
+
+	mInstanceXform.initRows(LLVector4(LLVector3::x_axis * rot, 0.f),
+							LLVector4(LLVector3::y_axis * rot, 0.f),
+							LLVector4(LLVector3::z_axis * rot, 0.f),
+							LLVector4(pos, 1.f));
+}
+
 bool LLVOVolume::lodOrSculptChanged(LLDrawable *drawable, S32 &compiled, S32 &should_update_octree_bounds)
 {
 	bool regen_faces = false;
@@ -2072,7 +2100,7 @@ bool LLVOVolume::updateGeometry(LLDrawable *drawable)
 {	
 	if (mDrawable->isState(LLDrawable::REBUILD_RIGGED))
 	{
-        updateRiggedVolume(false);
+        updateRiggedVolume(false, LLRiggedVolume::UPDATE_ALL_FACE_EXTENTS);
 		genBBoxes(false);
 		mDrawable->clearState(LLDrawable::REBUILD_RIGGED);
 	}
@@ -2135,7 +2163,7 @@ bool LLVOVolume::updateGeometry(LLDrawable *drawable)
 		
 		if(drawable->isState(LLDrawable::REBUILD_RIGGED | LLDrawable::RIGGED)) 
 		{
-			updateRiggedVolume(false);
+			updateRiggedVolume(false, LLRiggedVolume::UPDATE_ALL_FACE_EXTENTS);
 		}
 	}
 	// it has its own drawable (it's moved) or it has changed UVs or it has changed xforms from global<->local
@@ -3846,21 +3874,21 @@ void LLVOVolume::updateRiggingInfo()
         if (skin && avatar && volume)
         {
             LL_DEBUGS("RigSpammish") << "starting, vovol " << this << " lod " << getLOD() << " last " << mLastRiggingInfoLOD << LL_ENDL;
-            if (getLOD()>mLastRiggingInfoLOD || getLOD()==3)
+            // The skin info caches the boxes of the highest LOD any object
+            // wearing this mesh has loaded, which may be better than ours.
+            if (getLOD()>mLastRiggingInfoLOD || getLOD()==3 || skin->mRiggingInfoLOD>mLastRiggingInfoLOD)
             {
                 // Rigging info may need update
                 mJointRiggingInfoTab.clear();
-                for (S32 f = 0; f < volume->getNumVolumeFaces(); ++f)
+                LLSkinningUtil::updateRiggingInfo(skin, avatar, volume, getLOD(), mJointRiggingInfoTab);
+                if (mJointRiggingInfoTab.size()==0)
                 {
-                    LLVolumeFace& vol_face = volume->getVolumeFace(f);
-                    LLSkinningUtil::updateRiggingInfo(skin, avatar, vol_face);
-                    if (vol_face.mJointRiggingInfoTab.size()>0)
-                    {
-                        mJointRiggingInfoTab.merge(vol_face.mJointRiggingInfoTab);
-                    }
+                    // no weights loaded yet
+                    return;
                 }
-                // Keep the highest LOD info available.
-                mLastRiggingInfoLOD = getLOD();
+                // The LOD the boxes actually came from, which is below ours
+                // while our LOD's weights have not loaded yet.
+                mLastRiggingInfoLOD = skin->mRiggingInfoLOD;
                 LL_DEBUGS("RigSpammish") << "updated rigging info for LLVOVolume " 
                                          << this << " lod " << mLastRiggingInfoLOD 
                                          << LL_ENDL;
@@ -4959,11 +4987,14 @@ void LLRiggedVolume::update(const LLMeshSkinInfo* skin, LLVOAvatar* avatar, cons
 	LLMatrix4a mat[kMaxJoints];
 	U32 maxJoints = LLSkinningUtil::getMeshJointCount(skin);
     LLSkinningUtil::initSkinningMatrixPalette(mat, maxJoints, skin, avatar);
-    const LLMatrix4a bind_shape_matrix = skin->mBindShapeMatrix;
+    LLSkinningUtil::applyBindShapeMatrix(mat, maxJoints, skin);
 
     S32 rigged_vert_count = 0;
     S32 rigged_face_count = 0;
     LLVector4a box_min, box_max;
+    box_min.clear();
+    box_max.clear();
+    bool extents_only = false;
     S32 face_begin;
     S32 face_end;
     if (face_index == DO_NOT_UPDATE_FACES)
@@ -4971,10 +5002,11 @@ void LLRiggedVolume::update(const LLMeshSkinInfo* skin, LLVOAvatar* avatar, cons
         face_begin = 0;
         face_end = 0;
     }
-    else if (face_index == UPDATE_ALL_FACES)
+    else if (face_index == UPDATE_ALL_FACES || face_index == UPDATE_ALL_FACE_EXTENTS)
     {
         face_begin = 0;
         face_end = volume->getNumVolumeFaces();
+        extents_only = (face_index == UPDATE_ALL_FACE_EXTENTS);
     }
     else
     {
@@ -4993,86 +5025,59 @@ void LLRiggedVolume::update(const LLMeshSkinInfo* skin, LLVOAvatar* avatar, cons
 		{
             LLSkinningUtil::checkSkinWeights(weight, dst_face.mNumVertices, skin);
 
+            // unpacked once per face and joint count, then reused every update
+            vol_face.packSkinWeights(maxJoints);
+
 			LLVector4a* pos = dst_face.mPositions;
 
-			if (pos && dst_face.mExtents)
+			if (pos && dst_face.mExtents && vol_face.mJointIndices)
 			{
-                U32 max_joints = LLSkinningUtil::getMaxJointCount();
                 rigged_vert_count += dst_face.mNumVertices;
-                rigged_face_count++;
 
-            #if USE_SEPARATE_JOINT_INDICES_AND_WEIGHTS
-                if (vol_face.mJointIndices) // fast path with preconditioned joint indices
+				//update bounding box
+				// VFExtents change
+                if (extents_only)
                 {
-                    LLMatrix4a src[4];
-                    U8* joint_indices_cursor = vol_face.mJointIndices;
-                    LLVector4a* just_weights = vol_face.mJustWeights;
-                    for (U32 j = 0; j < dst_face.mNumVertices; ++j)
-				    {
-					    LLMatrix4a final_mat;
-                        F32* w = just_weights[j].getF32ptr();
-                        LLSkinningUtil::getPerVertexSkinMatrixWithIndices(w, joint_indices_cursor, mat, final_mat, src);
-                        joint_indices_cursor += 4;
-
-					    LLVector4a& v = vol_face.mPositions[j];
-					    LLVector4a t;
-					    LLVector4a dst;
-					    bind_shape_matrix.affineTransform(v, t);
-					    final_mat.affineTransform(t, dst);
-					    pos[j] = dst;
-				    }
+                    LLSkinningUtil::skinExtents(vol_face, mat, dst_face.mExtents);
                 }
                 else
-            #endif
                 {
-				    for (U32 j = 0; j < dst_face.mNumVertices; ++j)
-				    {
-					    LLMatrix4a final_mat;
-                        LLSkinningUtil::getPerVertexSkinMatrix(weight[j].getF32ptr(), mat, false, final_mat, max_joints);
-				
-					    LLVector4a& v = vol_face.mPositions[j];
-					    LLVector4a t;
-					    LLVector4a dst;
-					    bind_shape_matrix.affineTransform(v, t);
-					    final_mat.affineTransform(t, dst);
-					    pos[j] = dst;
-				    }
+                    LLSkinningUtil::skinPositions(vol_face, mat, pos, dst_face.mExtents);
                 }
 
-				//update bounding box
-				// VFExtents change
-				LLVector4a& min = dst_face.mExtents[0];
-				LLVector4a& max = dst_face.mExtents[1];
-
-				min = pos[0];
-				max = pos[1];
-                if (i==0)
+                if (rigged_face_count++ == 0)
                 {
-                    box_min = min;
-                    box_max = max;
+                    box_min = dst_face.mExtents[0];
+                    box_max = dst_face.mExtents[1];
+                }
+                else
+                {
+                    box_min.setMin(box_min, dst_face.mExtents[0]);
+                    box_max.setMax(box_max, dst_face.mExtents[1]);
                 }
-
-				for (U32 j = 1; j < dst_face.mNumVertices; ++j)
-				{
-					min.setMin(min, pos[j]);
-					max.setMax(max, pos[j]);
-				}
-
-                box_min.setMin(min,box_min);
-                box_max.setMax(max,box_max);
 
 				dst_face.mCenter->setAdd(dst_face.mExtents[0], dst_face.mExtents[1]);
 				dst_face.mCenter->mul(0.5f);
 
 			}
 
-            if (rebuild_face_octrees)
+            // positions did not move in extents_only mode, the octree still fits them
+            if (rebuild_face_octrees && !extents_only)
 			{
                 dst_face.destroyOctree();
                 dst_face.createOctree();
 			}
 		}
 	}
+    if (face_index == UPDATE_ALL_FACES)
+    {
+        mPositionsSkinned = true;
+    }
+    else if (extents_only)
+    {
+        mPositionsSkinned = false;
+    }
+
     mExtraDebugText = llformat("rigged %d/%d - box (%f %f %f) (%f %f %f)",
                                rigged_face_count, rigged_vert_count,
                                box_min[0], box_min[1], box_min[2],
@@ -5292,6 +5297,10 @@ void LLVolumeGeometryManager::registerFace(LLSpatialGroup* group, LLFace* facep,
 	{
 		model_mat = &drawable->getWorldMatrix();
 	}
+	else if (facep->isState(LLFace::INSTANCED))
+	{ //shared geometry is in object space
+		model_mat = &drawable->getVOVolume()->getInstanceXform();
+	}
 	else if (drawable->isActive())
 	{
 		model_mat = &drawable->getRenderMatrix();
@@ -5770,6 +5779,7 @@ void LLVolumeGeometryManager::rebuildGeom(LLSpatialGroup* group)
 				//ALWAYS null out vertex buffer on rebuild -- if the face lands in a render
 				// batch, it will recover its vertex buffer reference from the spatial group
 				facep->setVertexBuffer(nullptr);
+				facep->clearState(LLFace::INSTANCED);
 			
 				//sum up face verts and indices
 				drawablep->updateFaceSize(i);
@@ -6025,6 +6035,7 @@ void LLVolumeGeometryManager::rebuildGeom(LLSpatialGroup* group)
 	}
 
 	group->mGeometryBytes = 0;
+	group->clearState(LLSpatialGroup::HAS_INSTANCES);
 
 	U32 geometryBytes = 0;
 
@@ -6047,6 +6058,11 @@ void LLVolumeGeometryManager::rebuildGeom(LLSpatialGroup* group)
         rigged = true;
     }
 
+	if (LLGeometryRebuilder::isEnabled())
+	{ //write the faces genDrawInfo queued and upload their buffers
+		LLGeometryRebuilder::getInstance()->finish();
+	}
+
 	group->mGeometryBytes = geometryBytes;
 
 	if (!LLPipeline::sDelayVBUpdate)
@@ -6120,7 +6136,12 @@ void LLVolumeGeometryManager::rebuildMesh(LLSpatialGroup* group)
 					for (S32 i = 0; i < drawablep->getNumFaces(); ++i)
 					{
 						LLFace* face = drawablep->getFace(i);
-						if (face)
+						if (face && face->isState(LLFace::INSTANCED))
+						{ //other faces draw from this buffer, let rebuildGeom() pick the right one
+							group->dirtyGeom();
+							gPipeline.markRebuild(group, true);
+						}
+						else if (face)
 						{
 							LLVertexBuffer* buff = face->getVertexBuffer();
 							if (buff)
@@ -6259,6 +6280,9 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 	
 	static LLCachedControl<bool> use_transform_feedback(gSavedSettings, "RenderUseTransformFeedback", false);
 
+	//write face geometry from worker threads, see rebuildGeom()
+	bool threaded_rebuild = LLGeometryRebuilder::isEnabled() && !LLPipeline::sDelayVBUpdate;
+
 	if (use_transform_feedback &&
 		gTransformPositionProgram.mProgramObject && //transform shaders are loaded
 		buffer_usage == GL_DYNAMIC_DRAW_ARB && //target buffer is in VRAM
@@ -6305,8 +6329,22 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 	}
 				
 	bool hud_group = group->isHUDGroup() ;
+
+	//faces that draw from geometry shared with identical prims go last, one
+	//render batch each
+	U32 batched_count = face_count;
+	if (LLVolumeInstanceCache::isEnabled() && !rigged && !distance_sort && !hud_group && !LLPipeline::sDelayVBUpdate)
+	{
+		batched_count = LLVolumeInstanceCache::getInstance()->assignSharedGeometry(faces, face_count, mask);
+		if (batched_count < face_count)
+		{
+			group->setState(LLSpatialGroup::HAS_INSTANCES);
+		}
+	}
+
 	LLFace** face_iter = faces;
 	LLFace** end_faces = faces+face_count;
+	LLFace** end_batched = faces+batched_count;
 	
 	LLSpatialGroup::buffer_map_t buffer_map;
 
@@ -6367,6 +6405,9 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 		
 		U32 texture_count = 0;
 
+		bool shared = facep->isState(LLFace::INSTANCED);
+
+		if (!shared)
 		{
 			if (batch_textures)
 			{
@@ -6380,7 +6421,7 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 				if (can_batch_texture(facep))
 				{ //populate texture_list with any textures that can be batched
 				  //move i to the next unbatchable face
-					while (i != end_faces)
+					while (i != end_batched)
 					{
 						facep = *i;
 						
@@ -6453,7 +6494,7 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 			}
 			else
 			{
-				while (i != end_faces && 
+				while (i != end_batched && 
 					(LLPipeline::sTextureBindTest || 
 						(distance_sort || 
 							((*i)->getTexture() == tex))))
@@ -6492,6 +6533,11 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 		//create vertex buffer
 		LLPointer<LLVertexBuffer> buffer;
 
+		if (shared)
+		{ //already written by LLVolumeInstanceCache
+			buffer = facep->getVertexBuffer();
+		}
+		else
 		{
 			buffer = createVertexBuffer(mask, buffer_usage);
 			if(!buffer->allocateBuffer(geom_count, index_count, true))
@@ -6503,10 +6549,18 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 			}
 		}
 
-		if (buffer)
+		//transform feedback packs the buffer with GL, keep it on this thread
+		bool threaded_buffer = threaded_rebuild && buffer_usage != GL_DYNAMIC_COPY_ARB;
+
+		if (buffer && !shared)
 		{
 			geometryBytes += buffer->getSize() + buffer->getIndicesSize();
 			buffer_map[mask][*face_iter].push_back(buffer);
+
+			if (threaded_buffer)
+			{
+				LLGeometryRebuilder::getInstance()->addBuffer(buffer);
+			}
 		}
 
 		//add face geometry
@@ -6526,47 +6580,60 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 				++face_iter;
 				continue;
 			}
-			facep->setIndicesIndex(indices_index);
-			facep->setGeomIndex(index_offset);
-			facep->setVertexBuffer(buffer);	
-			
-			if (batch_textures && facep->getTextureIndex() == FACE_DO_NOT_BATCH_TEXTURES)
+
+			if (shared)
 			{
-				LL_ERRS() << "Invalid texture index." << LL_ENDL;
+				facep->updateRebuildFlags();
 			}
-			
+			else
 			{
-				//for debugging, set last time face was updated vs moved
-				facep->updateRebuildFlags();
+				facep->setIndicesIndex(indices_index);
+				facep->setGeomIndex(index_offset);
+				facep->setVertexBuffer(buffer);	
+			
+				if (batch_textures && facep->getTextureIndex() == FACE_DO_NOT_BATCH_TEXTURES)
+				{
+					LL_ERRS() << "Invalid texture index." << LL_ENDL;
+				}
+			
+				{
+					//for debugging, set last time face was updated vs moved
+					facep->updateRebuildFlags();
 
-				if (!LLPipeline::sDelayVBUpdate)
-				{ //copy face geometry into vertex buffer
-					LLDrawable* drawablep = facep->getDrawable();
-					LLVOVolume* vobj = drawablep->getVOVolume();
-					LLVolume* volume = vobj->getVolume();
+					if (!LLPipeline::sDelayVBUpdate)
+					{ //copy face geometry into vertex buffer
+						LLDrawable* drawablep = facep->getDrawable();
+						LLVOVolume* vobj = drawablep->getVOVolume();
+						LLVolume* volume = vobj->getVolume();
 
-					if (drawablep->isState(LLDrawable::ANIMATED_CHILD))
-					{
-						vobj->updateRelativeXform(true);
-					}
+						if (drawablep->isState(LLDrawable::ANIMATED_CHILD))
+						{
+							vobj->updateRelativeXform(true);
+						}
 
-					U32 te_idx = facep->getTEOffset();
+						U32 te_idx = facep->getTEOffset();
 
-					if (!facep->getGeometryVolume(*volume, te_idx, 
-						vobj->getRelativeXform(), vobj->getRelativeXformInvTrans(), index_offset,true))
-					{
-						LL_WARNS() << "Failed to get geometry for face!" << LL_ENDL;
-					}
+						if (threaded_buffer)
+						{
+							LLGeometryRebuilder::getInstance()->addFace(facep, volume, te_idx,
+								vobj->getRelativeXform(), vobj->getRelativeXformInvTrans(), index_offset);
+						}
+						else if (!facep->getGeometryVolume(*volume, te_idx, 
+							vobj->getRelativeXform(), vobj->getRelativeXformInvTrans(), index_offset,true))
+						{
+							LL_WARNS() << "Failed to get geometry for face!" << LL_ENDL;
+						}
 
-					if (drawablep->isState(LLDrawable::ANIMATED_CHILD))
-					{
-						vobj->updateRelativeXform(false);
+						if (drawablep->isState(LLDrawable::ANIMATED_CHILD))
+						{
+							vobj->updateRelativeXform(false);
+						}
 					}
 				}
-			}
 
-			index_offset += facep->getGeomCount();
-			indices_index += facep->getIndicesCount();
+				index_offset += facep->getGeomCount();
+				indices_index += facep->getIndicesCount();
+			}
 
 			//append face to appropriate render batch
 
@@ -6857,7 +6924,7 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 			++face_iter;
 		}
 
-		if (buffer)
+		if (buffer && !threaded_buffer && !shared)
 		{
 			buffer->flush();
 		}
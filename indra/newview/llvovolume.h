@@ -61,16 +61,26 @@ class LLRiggedVolume : public LLVolume
 {
 public:
 	LLRiggedVolume(const LLVolumeParams& params)
-		: LLVolume(params, 0.f)
+		: LLVolume(params, 0.f),
+		  mPositionsSkinned(false)
 	{
 	}
 
     using FaceIndex = S32;
     static const FaceIndex UPDATE_ALL_FACES = -1;
     static const FaceIndex DO_NOT_UPDATE_FACES = -2;
+    // every face's extents from per-joint bounds, vertices are left as they are
+    static const FaceIndex UPDATE_ALL_FACE_EXTENTS = -3;
     void update(const LLMeshSkinInfo* skin, LLVOAvatar* avatar, const LLVolume* src_volume, FaceIndex face_index = UPDATE_ALL_FACES, bool rebuild_face_octrees = true);
 
+    // false once an UPDATE_ALL_FACE_EXTENTS update has left the vertices
+    // behind the current pose, until the next UPDATE_ALL_FACES update
+    bool hasSkinnedPositions() const { return mPositionsSkinned; }
+
     std::string mExtraDebugText;
+
+private:
+    bool mPositionsSkinned;
 };
 
 // Base class for implementations of the volume - Primitive, Flexible Object, etc.
@@ -140,6 +150,9 @@ public:
 	const LLVector3		getPivotPositionAgent() const;
 	const LLMatrix4&	getRelativeXform() const				{ return mRelativeXform; }
 	const LLMatrix3&	getRelativeXformInvTrans() const		{ return mRelativeXformInvTrans; }
+				// rotation and agent space position without scale, the model matrix of faces drawn from shared geometry
+				void	updateInstanceXform();
+	const LLMatrix4&	getInstanceXform() const				{ return mInstanceXform; }
 	/*virtual*/	const LLMatrix4	getRenderMatrix() const;
 				typedef std::map<LLUUID, S32> texture_cost_t;
 				U32 	getRenderCost(texture_cost_t &textures) const;
@@ -430,6 +443,7 @@ private:
 	F32			mSpotLightPriority;
 	LLMatrix4	mRelativeXform;
 	LLMatrix3	mRelativeXformInvTrans;
+	LLMatrix4	mInstanceXform;
 	bool		mVolumeChanged;
 	F32			mVObjRadius;
 	LLVolumeInterface *mVolumeImpl;
@@ -37,6 +37,7 @@
 #include "lldrawpool.h"
 #include "llglheaders.h"
 #include "llhttpnode.h"
+#include "llobjectupdatedecoder.h"
 #include "llregionhandle.h"
 #include "llsky.h"
 #include "llsurface.h"
@@ -673,6 +674,13 @@ void LLWorld::removeRegion(const LLHost &host)
 		LL_WARNS() << "Trying to remove region that doesn't exist!" << LL_ENDL;
 		return;
 	}
+
+	// let anything still in flight reach the object cache before it is saved,
+	// both below and in the region's destructor
+	if (LLObjectUpdateDecoder::instanceExists())
+	{
+		LLObjectUpdateDecoder::getInstance()->flushRegion(regionp->getHandle());
+	}
 	
 	if (regionp == gAgent.getRegion())
 	{
@@ -43,6 +43,7 @@
 // other Linden headers
 #include "llerror.h"
 #include "lleventcoro.h"
+#include "llcorehttputil.h"
 #include "stringize.h"
 #include "llxmlrpctransaction.h"
 #include "llsecapi.h"
@@ -367,6 +368,9 @@ public:
             data["status"] = status_string;
         }
 
+        // so an offline replay can log in, see LLXMLRPCListener::process()
+        LLCoreHttpUtil::HttpRecording::record(mMethod, mUri, data);
+
         // whether successful or not, send reply on requested LLEventPump
         replyPump.post(data);
         // need to wake up the loginCoro now
@@ -544,6 +548,25 @@ private:
 
 bool LLXMLRPCListener::process(const LLSD& command)
 {
+    // Replaying a recorded session: answer with the recorded reply
+    LLSD data;
+    if (LLCoreHttpUtil::HttpRecording::replay(command["method"].asString(), command["uri"].asString(), data))
+    {
+        if (! data.has("status"))
+        {
+            // nothing recorded for this request, fail it the way a
+            // transaction that never connected would
+            data = LLSD::emptyMap();
+            data["status"] = sStatusMapper.lookup(LLXMLRPCTransaction::StatusOtherError);
+            data["errorcode"] = sCURLcodeMapper.lookup(CURLE_COULDNT_CONNECT);
+            data["error"] = "Not in the session recording";
+            data["transfer_rate"] = 0.0;
+        }
+        LLReqID(command).stamp(data);
+        LLEventPumps::instance().obtain(command["reply"].asString()).post(data);
+        return false;
+    }
+
     // Allocate a new heap Poller, but do not save a pointer to it. Poller
     // will check its own status and free itself on completion of the request.
     (new Poller(command));
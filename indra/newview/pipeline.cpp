@@ -91,6 +91,8 @@
 #include "llvowlsky.h"
 #include "llvotree.h"
 #include "llvovolume.h"
+#include "llvolumeinstancecache.h"
+#include "llavatarimpostoratlas.h"
 #include "llvosurfacepatch.h"
 #include "llvowater.h"
 #include "llvotree.h"
@@ -110,6 +112,7 @@
 #include "llfloaterpathfindingcharacters.h"
 #include "llfloatertools.h"
 #include "llpanelface.h"
+#include "llparallelcull.h"
 #include "llpathfindingpathtool.h"
 #include "llscenemonitor.h"
 #include "llprogressview.h"
@@ -216,6 +219,9 @@ bool LLPipeline::CameraOffset;
 F32 LLPipeline::CameraMaxCoF;
 F32 LLPipeline::CameraDoFResScale;
 F32 LLPipeline::RenderAutoHideSurfaceAreaLimit;
+bool LLPipeline::RenderBatchSort;
+bool LLPipeline::RenderBatchMerge;
+bool LLPipeline::RenderVolumeInstancing;
 LLTrace::EventStatHandle<S64> LLPipeline::sStatBatchSize("renderbatchsize");
 
 const F32 BACKLIGHT_DAY_MAGNITUDE_OBJECT = 0.1f;
@@ -444,6 +450,7 @@ void LLPipeline::init()
 	LLVertexBuffer::sUseStreamDraw = gSavedSettings.getbool("RenderUseStreamVBO");
 	LLVertexBuffer::sUseVAO = gSavedSettings.getbool("RenderUseVAO");
 	LLVertexBuffer::sPreferStreamDraw = gSavedSettings.getbool("RenderPreferStreamDraw");
+	LLVertexBuffer::sStreamRingMode = gSavedSettings.getU32("RenderStreamRing");
 	sRenderAttachedLights = gSavedSettings.getbool("RenderAttachedLights");
 	sRenderAttachedParticles = gSavedSettings.getbool("RenderAttachedParticles");
 
@@ -611,6 +618,9 @@ void LLPipeline::init()
 	connectRefreshCachedSettingsSafe("CameraDoFResScale");
 	connectRefreshCachedSettingsSafe("RenderAutoHideSurfaceAreaLimit");
 	gSavedSettings.getControl("RenderAutoHideSurfaceAreaLimit")->getCommitSignal()->connect(boost::bind(&LLPipeline::refreshCachedSettings));
+	connectRefreshCachedSettingsSafe("RenderBatchSort");
+	connectRefreshCachedSettingsSafe("RenderBatchMerge");
+	connectRefreshCachedSettingsSafe("RenderVolumeInstancing");
 
 }
 
@@ -707,6 +717,11 @@ void LLPipeline::destroyGL()
 
 	resetVertexBuffers();
 
+	if (LLVolumeInstanceCache::instanceExists())
+	{
+		LLVolumeInstanceCache::getInstance()->clear();
+	}
+
 	releaseGLBuffers();
 
 	if (LLVertexBuffer::sEnableVBOs)
@@ -1140,6 +1155,9 @@ void LLPipeline::refreshCachedSettings()
 	CameraMaxCoF = gSavedSettings.getF32("CameraMaxCoF");
 	CameraDoFResScale = gSavedSettings.getF32("CameraDoFResScale");
 	RenderAutoHideSurfaceAreaLimit = gSavedSettings.getF32("RenderAutoHideSurfaceAreaLimit");
+	RenderBatchSort = gSavedSettings.getbool("RenderBatchSort");
+	RenderBatchMerge = gSavedSettings.getbool("RenderBatchMerge");
+	RenderVolumeInstancing = gSavedSettings.getbool("RenderVolumeInstancing");
 	RenderSpotLight = nullptr;
 	updateRenderDeferred();
 
@@ -2416,12 +2434,33 @@ void LLPipeline::updateCull(LLCamera& camera, LLCullResult& result, LLPlane* pla
 		mCubeVB->setBuffer(LLVertexBuffer::MAP_VERTEX);
 	}
 	
+	bool parallel_cull = LLParallelCull::isEnabled();
+	if (parallel_cull)
+	{ //cull the spatial partitions of every region on the Cull thread pool
+		std::vector<LLSpatialPartition*> parts;
+		for (LLWorld::region_list_t::const_iterator iter = LLWorld::getInstance()->getRegionList().begin(); 
+				iter != LLWorld::getInstance()->getRegionList().end(); ++iter)
+		{
+			LLViewerRegion* region = *iter;
+
+			for (U32 i = 0; i < LLViewerRegion::NUM_PARTITIONS; i++)
+			{
+				LLSpatialPartition* part = region->getSpatialPartition(i);
+				if (part && hasRenderType(part->mDrawableType))
+				{
+					parts.push_back(part);
+				}
+			}
+		}
+		LLParallelCull::getInstance()->cull(parts, camera);
+	}
+
 	for (LLWorld::region_list_t::const_iterator iter = LLWorld::getInstance()->getRegionList().begin(); 
 			iter != LLWorld::getInstance()->getRegionList().end(); ++iter)
 	{
 		LLViewerRegion* region = *iter;
 
-		for (U32 i = 0; i < LLViewerRegion::NUM_PARTITIONS; i++)
+		for (U32 i = 0; i < LLViewerRegion::NUM_PARTITIONS && !parallel_cull; i++)
 		{
 			LLSpatialPartition* part = region->getSpatialPartition(i);
 			if (part)
@@ -2433,7 +2472,8 @@ void LLPipeline::updateCull(LLCamera& camera, LLCullResult& result, LLPlane* pla
 			}
 		}
 
-		//scan the VO Cache tree
+		//scan the VO Cache tree, after the spatial partitions as it rewrites
+		//the camera's region frustum planes
 		LLVOCachePartition* vo_part = region->getVOCachePartition();
 		if(vo_part)
 		{
@@ -2535,6 +2575,34 @@ void LLPipeline::markNotCulled(LLSpatialGroup* group, LLCamera& camera)
 	mNumVisibleNodes++;
 }
 
+void LLPipeline::markNotCulled(LLCullFragment& fragment, LLCamera& camera)
+{
+	assertInitialized();
+
+	//the worker already called setVisible(), distances can mark groups for rebuild
+	bool update_distance = LLViewerCamera::sCurCameraID == LLViewerCamera::CAMERA_WORLD;
+
+	for (LLCullResult::sg_iterator iter = fragment.mResult.beginDrawableGroups(); iter != fragment.mResult.endDrawableGroups(); ++iter)
+	{
+		if (update_distance)
+		{
+			(*iter)->updateDistance(camera);
+		}
+		sCull->pushDrawableGroup(*iter);
+	}
+
+	for (LLCullResult::sg_iterator iter = fragment.mResult.beginVisibleGroups(); iter != fragment.mResult.endVisibleGroups(); ++iter)
+	{
+		if (update_distance)
+		{
+			(*iter)->updateDistance(camera);
+		}
+		sCull->pushVisibleGroup(*iter);
+	}
+
+	mNumVisibleNodes += fragment.mResult.getDrawableGroupsSize() + fragment.mResult.getVisibleGroupsSize();
+}
+
 void LLPipeline::markOccluder(LLSpatialGroup* group)
 {
 	if (sUseOcclusion > 1 && group && !group->isOcclusionState(LLSpatialGroup::ACTIVE_OCCLUSION))
@@ -2731,6 +2799,10 @@ void LLPipeline::updateGL()
 	{ //seed VBO Pools
 		LLVertexBuffer::seedPools();
 	}
+
+	{ //give this frame's immediate mode geometry its own part of the stream ring
+		LLVertexBuffer::nextStreamFrame();
+	}
 }
 
 void LLPipeline::clearRebuildGroups()
@@ -2876,6 +2948,11 @@ void LLPipeline::rebuildGroups()
 	S32 min_count = llclamp((S32) ((F32) (size * size)/4096*0.25f), 1, size);
 			
 	S32 count = 0;
+
+	//after a teleport min_count can be most of the queue, spread it over frames
+	static LLCachedControl<F32> rebuild_budget_ms(gSavedSettings, "RenderGeometryRebuildBudgetMs", 8.f);
+	F32 max_time = rebuild_budget_ms * 0.001f;
+	LLTimer update_timer;
 	
 	std::sort(mGroupQ2.begin(), mGroupQ2.end(), LLSpatialGroup::CompareUpdateUrgency());
 
@@ -2885,6 +2962,11 @@ void LLPipeline::rebuildGroups()
 	for (iter = mGroupQ2.begin();
 		 iter != mGroupQ2.end() && count <= min_count; ++iter)
 	{
+		if (iter != mGroupQ2.begin() && max_time > 0.f && update_timer.getElapsedTimeF32() > max_time)
+		{
+			break;
+		}
+
 		LLSpatialGroup* group = *iter;
 		last_iter = iter;
 
@@ -2921,6 +3003,12 @@ void LLPipeline::updateGeom(F32 max_dtime)
 	// for now, only LLVOVolume does this to throttle LOD changes
 	LLVOVolume::preUpdateGeom();
 
+	// shared face geometry nothing drew from since last frame
+	if (LLVolumeInstanceCache::instanceExists())
+	{
+		LLVolumeInstanceCache::getInstance()->releaseUnused();
+	}
+
 	// Iterate through all drawables on the priority build queue,
 	for (LLDrawable::drawable_list_t::iterator iter = mBuildQ1.begin();
 		 iter != mBuildQ1.end();)
@@ -3756,6 +3844,44 @@ void LLPipeline::touchTextures(LLDrawInfo* info)
     touchTexture(info->mNormalMap, info->mVSize);
 }
 
+// passes whose draw infos may be drawn in any order, each immediately followed by its _RIGGED variant
+static const U32 sSortableBatchPasses[] =
+{
+	LLRenderPass::PASS_SIMPLE,
+	LLRenderPass::PASS_FULLBRIGHT,
+	LLRenderPass::PASS_INVISIBLE,
+	LLRenderPass::PASS_FULLBRIGHT_SHINY,
+	LLRenderPass::PASS_SHINY,
+	LLRenderPass::PASS_BUMP,
+	LLRenderPass::PASS_MATERIAL,
+	LLRenderPass::PASS_MATERIAL_ALPHA_MASK,
+	LLRenderPass::PASS_MATERIAL_ALPHA_EMISSIVE,
+	LLRenderPass::PASS_SPECMAP,
+	LLRenderPass::PASS_SPECMAP_MASK,
+	LLRenderPass::PASS_SPECMAP_EMISSIVE,
+	LLRenderPass::PASS_NORMMAP,
+	LLRenderPass::PASS_NORMMAP_MASK,
+	LLRenderPass::PASS_NORMMAP_EMISSIVE,
+	LLRenderPass::PASS_NORMSPEC,
+	LLRenderPass::PASS_NORMSPEC_MASK,
+	LLRenderPass::PASS_NORMSPEC_EMISSIVE,
+	LLRenderPass::PASS_ALPHA_MASK,
+	LLRenderPass::PASS_FULLBRIGHT_ALPHA_MASK,
+};
+
+void LLPipeline::sortBatches()
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_PIPELINE;
+
+	std::sort(sCull->beginRenderMap(LLRenderPass::PASS_GRASS), sCull->endRenderMap(LLRenderPass::PASS_GRASS), LLDrawInfo::CompareBatchState());
+
+	for (U32 pass : sSortableBatchPasses)
+	{
+		std::sort(sCull->beginRenderMap(pass), sCull->endRenderMap(pass), LLDrawInfo::CompareBatchState());
+		std::sort(sCull->beginRenderMap(pass + 1), sCull->endRenderMap(pass + 1), LLDrawInfo::CompareBatchState());
+	}
+}
+
 void LLPipeline::postSort(LLCamera& camera)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_PIPELINE;
@@ -3904,6 +4030,11 @@ void LLPipeline::postSort(LLCamera& camera)
         std::sort(sCull->beginRiggedAlphaGroups(), sCull->endRiggedAlphaGroups(), LLSpatialGroup::CompareRenderOrder());
 	}
 
+	if (RenderBatchSort)
+	{
+		sortBatches();
+	}
+
 	LL_PUSH_CALLSTACKS();
 	// only render if the flag is set. The flag is only set if we are in edit mode or the toggle is set in the menus
 	if (LLFloaterReg::instanceVisible("beacons") && !sShadowRender)
@@ -7292,6 +7423,11 @@ void LLPipeline::doResetVertexBuffers(bool forced)
 	LLVOPartGroup::destroyGL();
     gGL.resetVertexBuffer();
 
+	if (LLVolumeInstanceCache::instanceExists())
+	{
+		LLVolumeInstanceCache::getInstance()->clear();
+	}
+
 	SUBSYSTEM_CLEANUP(LLVertexBuffer);
 	
 	if (LLVertexBuffer::sGLCount != 0)
@@ -7309,6 +7445,7 @@ void LLPipeline::doResetVertexBuffers(bool forced)
 	LLVertexBuffer::sUseStreamDraw = gSavedSettings.getbool("RenderUseStreamVBO");
 	LLVertexBuffer::sUseVAO = gSavedSettings.getbool("RenderUseVAO");
 	LLVertexBuffer::sPreferStreamDraw = gSavedSettings.getbool("RenderPreferStreamDraw");
+	LLVertexBuffer::sStreamRingMode = gSavedSettings.getU32("RenderStreamRing");
 	LLVertexBuffer::sEnableVBOs = gSavedSettings.getbool("RenderVBOEnable");
 	LLVertexBuffer::sDisableVBOMapping = LLVertexBuffer::sEnableVBOs && gSavedSettings.getbool("RenderVBOMappingDisable") ;
 	sBakeSunlight = gSavedSettings.getbool("RenderBakeSunlight");
@@ -10864,6 +11001,62 @@ void LLPipeline::generateImpostor(LLVOAvatar* avatar, bool preview_avatar)
 
 	assertInitialized();
 
+	LLViewerCamera* viewer_camera = LLViewerCamera::getInstance();
+	LLAvatarImpostorAtlas* atlas = LLAvatarImpostorAtlas::getInstance();
+
+	LLCamera camera = *viewer_camera;
+	LLVector2 tdim;
+	U32 resY = 0;
+	U32 resX = 0;
+	F32 fov = 0.f;
+	F32 aspect = 1.f;
+
+	if (!preview_avatar)
+	{
+		const LLVector4a* ext = avatar->mDrawable->getSpatialExtents();
+		LLVector3 pos(avatar->getRenderPosition()+avatar->getImpostorOffset());
+
+		camera.lookAt(viewer_camera->getOrigin(), pos, viewer_camera->getUpAxis());
+	
+		LLVector4a half_height;
+		half_height.setSub(ext[1], ext[0]);
+		half_height.mul(0.5f);
+
+		LLVector4a left;
+		left.load3(camera.getLeftAxis().mV);
+		left.mul(left);
+		llassert(left.dot3(left).getF32() > F_APPROXIMATELY_ZERO);
+		left.normalize3fast();
+
+		LLVector4a up;
+		up.load3(camera.getUpAxis().mV);
+		up.mul(up);
+		llassert(up.dot3(up).getF32() > F_APPROXIMATELY_ZERO);
+		up.normalize3fast();
+
+		tdim.mV[0] = fabsf(half_height.dot3(left).getF32());
+		tdim.mV[1] = fabsf(half_height.dot3(up).getF32());
+
+		F32 distance = (pos-camera.getOrigin()).length();
+		fov = atanf(tdim.mV[1]/distance)*2.f*RAD_TO_DEG;
+		aspect = tdim.mV[0]/tdim.mV[1];
+
+		// get the number of pixels per angle
+		F32 pa = gViewerWindow->getWindowHeightRaw() / (RAD_TO_DEG * viewer_camera->getView());
+
+		//get resolution based on angle width and height of impostor (double desired resolution to prevent aliasing)
+		resY = llmin(nhpo2((U32) (fov*pa)), (U32) 512);
+		resX = llmin(nhpo2((U32) (atanf(tdim.mV[0]/distance)*2.f*RAD_TO_DEG*pa)), (U32) 512);
+
+		if (!atlas->assign(avatar->mImpostorSlot, resX, resY))
+		{ //atlas is full, try again next frame
+			LL_DEBUGS("AvatarRenderPipeline") << "No room in impostor atlas for avatar " << avatar->getID() << LL_ENDL;
+			return;
+		}
+		resX = avatar->mImpostorSlot.mWidth;
+		resY = avatar->mImpostorSlot.mHeight;
+	}
+
     // previews can't be muted or impostered
 	bool visually_muted = !preview_avatar && avatar->isVisuallyMuted();
     LL_DEBUGS_ONCE("AvatarRenderPipeline") << "Avatar " << avatar->getID()
@@ -10913,8 +11106,6 @@ void LLPipeline::generateImpostor(LLVOAvatar* avatar, bool preview_avatar)
 	sShadowRender = true;
 	sImpostorRender = true;
 
-	LLViewerCamera* viewer_camera = LLViewerCamera::getInstance();
-
 	{
 		markVisible(avatar->mDrawable, *viewer_camera);
 
@@ -10982,44 +11173,15 @@ void LLPipeline::generateImpostor(LLVOAvatar* avatar, bool preview_avatar)
 	}
 
 	stateSort(*LLViewerCamera::getInstance(), result);
-	
-	LLCamera camera = *viewer_camera;
-	LLVector2 tdim;
-	U32 resY = 0;
-	U32 resX = 0;
+
+	LLRenderTarget& target = atlas->getTarget();
+	const LLAvatarImpostorAtlas::Slot& slot = avatar->mImpostorSlot;
 
     if (!preview_avatar)
 	{
-		const LLVector4a* ext = avatar->mDrawable->getSpatialExtents();
-		LLVector3 pos(avatar->getRenderPosition()+avatar->getImpostorOffset());
-
-		camera.lookAt(viewer_camera->getOrigin(), pos, viewer_camera->getUpAxis());
-	
-		LLVector4a half_height;
-		half_height.setSub(ext[1], ext[0]);
-		half_height.mul(0.5f);
-
-		LLVector4a left;
-		left.load3(camera.getLeftAxis().mV);
-		left.mul(left);
-		llassert(left.dot3(left).getF32() > F_APPROXIMATELY_ZERO);
-		left.normalize3fast();
-
-		LLVector4a up;
-		up.load3(camera.getUpAxis().mV);
-		up.mul(up);
-		llassert(up.dot3(up).getF32() > F_APPROXIMATELY_ZERO);
-		up.normalize3fast();
-
-		tdim.mV[0] = fabsf(half_height.dot3(left).getF32());
-		tdim.mV[1] = fabsf(half_height.dot3(up).getF32());
-
 		gGL.matrixMode(LLRender::MM_PROJECTION);
 		gGL.pushMatrix();
 	
-		F32 distance = (pos-camera.getOrigin()).length();
-		F32 fov = atanf(tdim.mV[1]/distance)*2.f*RAD_TO_DEG;
-		F32 aspect = tdim.mV[0]/tdim.mV[1];
 		glh::matrix4f persp = gl_perspective(fov, aspect, 1.f, 256.f);
 		set_current_projection(persp);
 		gGL.loadMatrix(persp.m);
@@ -11036,33 +11198,25 @@ void LLPipeline::generateImpostor(LLVOAvatar* avatar, bool preview_avatar)
 
 		glClearColor(0.0f,0.0f,0.0f,0.0f);
 		gGL.setColorMask(true, true);
-	
-		// get the number of pixels per angle
-		F32 pa = gViewerWindow->getWindowHeightRaw() / (RAD_TO_DEG * viewer_camera->getView());
 
-		//get resolution based on angle width and height of impostor (double desired resolution to prevent aliasing)
-		resY = llmin(nhpo2((U32) (fov*pa)), (U32) 512);
-		resX = llmin(nhpo2((U32) (atanf(tdim.mV[0]/distance)*2.f*RAD_TO_DEG*pa)), (U32) 512);
-
-		if (!avatar->mImpostor.isComplete())
+		if (!target.isComplete())
 		{
-            avatar->mImpostor.allocate(resX, resY, GL_RGBA, true, false);
+			target.allocate(atlas->getSize(), atlas->getSize(), GL_RGBA, true, false);
 
 			if (LLPipeline::sRenderDeferred)
 			{
-				addDeferredAttachments(avatar->mImpostor, true);
+				addDeferredAttachments(target, true);
 			}
 		
-			gGL.getTexUnit(0)->bind(&avatar->mImpostor);
+			gGL.getTexUnit(0)->bind(&target);
 			gGL.getTexUnit(0)->setTextureFilteringOption(LLTexUnit::TFO_POINT);
 			gGL.getTexUnit(0)->unbind(LLTexUnit::TT_TEXTURE);
 		}
-		else if(resX != avatar->mImpostor.getWidth() || resY != avatar->mImpostor.getHeight())
-		{
-			avatar->mImpostor.resize(resX,resY);
-		}
 
-		avatar->mImpostor.bindTarget();
+		target.bindTarget();
+
+		// draw into this avatar's part of the atlas only
+		glViewport(slot.mX, slot.mY, resX, resY);
 	}
 
 	F32 old_alpha = LLDrawPoolAvatar::sMinimumAlpha;
@@ -11087,7 +11241,11 @@ void LLPipeline::generateImpostor(LLVOAvatar* avatar, bool preview_avatar)
     }
     else if (LLPipeline::sRenderDeferred)
 	{
-		avatar->mImpostor.clear();
+		{
+			LLGLEnable scissor(GL_SCISSOR_TEST);
+			glScissor(slot.mX, slot.mY, resX, resY);
+			target.clear();
+		}
 		renderGeomDeferred(camera);
 
 		renderGeomPostDeferred(camera);		
@@ -11110,8 +11268,8 @@ void LLPipeline::generateImpostor(LLVOAvatar* avatar, bool preview_avatar)
 	else
 	{
 		LLGLEnable scissor(GL_SCISSOR_TEST);
-		glScissor(0, 0, resX, resY);
-		avatar->mImpostor.clear();
+		glScissor(slot.mX, slot.mY, resX, resY);
+		target.clear();
 		renderGeom(camera);
 
 		// Shameless hack time: render it all again,
@@ -11189,7 +11347,7 @@ void LLPipeline::generateImpostor(LLVOAvatar* avatar, bool preview_avatar)
 
     if (!preview_avatar)
     {
-        avatar->mImpostor.flush();
+        target.flush();
         avatar->setImpostorDim(tdim);
     }
 
@@ -46,6 +46,7 @@ class LLFace;
 class LLViewerObject;
 class LLTextureEntry;
 class LLCullResult;
+class LLCullFragment;
 class LLVOAvatar;
 class LLVOPartGroup;
 class LLGLSLShader;
@@ -174,6 +175,7 @@ public:
 	void		doOcclusion(LLCamera& camera, LLRenderTarget& source, LLRenderTarget& dest, LLRenderTarget* scratch_space = nullptr);
 	void		doOcclusion(LLCamera& camera);
 	void		markNotCulled(LLSpatialGroup* group, LLCamera &camera);
+	void		markNotCulled(LLCullFragment& fragment, LLCamera& camera); // groups culled on a worker thread, see LLParallelCull
 	void        markMoved(LLDrawable *drawablep, bool damped_motion = false);
 	void        markShift(LLDrawable *drawablep);
 	void        markTextured(LLDrawable *drawablep);
@@ -260,6 +262,9 @@ public:
 	void stateSort(LLSpatialBridge* bridge, LLCamera& camera, bool fov_changed = false);
 	void stateSort(LLDrawable* drawablep, LLCamera& camera);
 	void postSort(LLCamera& camera);
+
+	//order the draw infos of passes that don't depend on draw order by shared GL state
+	void sortBatches();
     
     //update stats for textures in given DrawInfo
     void touchTextures(LLDrawInfo* info);
@@ -982,6 +987,9 @@ public:
 	static F32 CameraMaxCoF;
 	static F32 CameraDoFResScale;
 	static F32 RenderAutoHideSurfaceAreaLimit;
+	static bool RenderBatchSort;
+	static bool RenderBatchMerge;
+	static bool RenderVolumeInstancing;
 };
 
 void render_bbox(const LLVector3 &min, const LLVector3 &max);
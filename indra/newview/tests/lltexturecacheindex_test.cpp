@@ -0,0 +1,267 @@
+/**
+ * @file lltexturecacheindex_test.cpp
+ * @brief LLTextureCacheIndex test cases, including a concurrent request benchmark.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+// Precompiled header: almost always required for newview cpp files
+#include "../llviewerprecompiledheaders.h"
+// Class to test
+#include "../lltexturecacheindex.h"
+// Dependencies
+#include "lltimer.h"
+
+#include <boost/filesystem.hpp>
+#include <thread>
+
+// Tut header
+#include "../test/lltut.h"
+
+namespace tut
+{
+	struct texturecacheindex_test
+	{
+		texturecacheindex_test()
+		{
+			mJournal = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+		}
+
+		~texturecacheindex_test()
+		{
+			LLFile::remove(mJournal, ENOENT);
+			LLFile::remove(mJournal + ".tmp", ENOENT);
+		}
+
+		void open(LLTextureCacheIndex& index, U32 max_entries)
+		{
+			LLTextureCacheIndex::entry_list_t dropped;
+			index.setReadOnly(false);
+			if (!index.load(mJournal, "test", max_entries, dropped))
+			{
+				index.clear();
+			}
+		}
+
+		S32 add(LLTextureCacheIndex& index, const LLUUID& id, S32 body_size)
+		{
+			LLTextureCacheIndex::Entry entry, evicted;
+			S32 idx = index.allocate(id, entry, evicted);
+			if (idx >= 0)
+			{
+				index.update(entry, body_size + 1000, body_size);
+			}
+			return idx;
+		}
+
+		std::string mJournal;
+	};
+
+	typedef test_group<texturecacheindex_test> texturecacheindex_t;
+	typedef texturecacheindex_t::object texturecacheindex_object_t;
+	tut::texturecacheindex_t tut_texturecacheindex("LLTextureCacheIndex");
+
+	template<> template<>
+	void texturecacheindex_object_t::test<1>()
+	{
+		set_test_name("entries are found in their slots");
+
+		LLTextureCacheIndex index;
+		open(index, 2);
+
+		LLUUID a, b;
+		a.generate();
+		b.generate();
+		S32 idx_a = add(index, a, 100);
+		S32 idx_b = add(index, b, 200);
+		ensure("distinct slots", idx_a >= 0 && idx_b >= 0 && idx_a != idx_b);
+
+		LLTextureCacheIndex::Entry entry;
+		ensure_equals("found in its slot", index.find(b, entry, true), idx_b);
+		ensure_equals("body size", entry.mBodySize, 200);
+		ensure_equals("body total", index.getBodySizeTotal(), (S64)300);
+
+		LLTextureCacheIndex::Entry removed;
+		ensure("removed", index.remove(a, removed));
+		ensure("gone", !index.contains(a));
+		ensure_equals("freed slot reused", add(index, LLUUID::generateNewID(), 50), idx_a);
+	}
+
+	template<> template<>
+	void texturecacheindex_object_t::test<2>()
+	{
+		set_test_name("a full index evicts the least recently used entry");
+
+		LLTextureCacheIndex index;
+		open(index, 4);
+
+		std::vector<LLUUID> ids(4);
+		for (S32 i = 0; i < 4; ++i)
+		{
+			ids[i].generate();
+			add(index, ids[i], 10);
+		}
+
+		LLTextureCacheIndex::Entry entry, evicted;
+		S32 idx = index.allocate(LLUUID::generateNewID(), entry, evicted);
+		ensure("slot handed out", idx >= 0);
+		ensure_equals("evicted slot reused", evicted.mIndex, idx);
+		ensure_equals("one entry evicted", index.getEntryCount(), (U32)3);
+		ensure("evicted entry gone", !index.contains(evicted.mID));
+	}
+
+	template<> template<>
+	void texturecacheindex_object_t::test<3>()
+	{
+		set_test_name("the journal survives a restart and compaction");
+
+		LLUUID a, b, c;
+		a.generate();
+		b.generate();
+		c.generate();
+		S32 idx_b;
+		{
+			LLTextureCacheIndex index;
+			open(index, 16);
+			add(index, a, 100);
+			idx_b = add(index, b, 200);
+			add(index, c, 300);
+			LLTextureCacheIndex::Entry removed;
+			index.remove(a, removed);
+		}
+		{
+			LLTextureCacheIndex index;
+			open(index, 16);
+			LLTextureCacheIndex::Entry entry;
+			ensure("removed entry stays removed", !index.contains(a));
+			ensure_equals("slot kept", index.find(b, entry, false), idx_b);
+			ensure_equals("body total", index.getBodySizeTotal(), (S64)500);
+			index.compact();
+		}
+		{
+			LLTextureCacheIndex index;
+			open(index, 16);
+			LLTextureCacheIndex::Entry entry;
+			ensure_equals("compacted slot kept", index.find(b, entry, false), idx_b);
+			ensure_equals("compacted entries", index.getEntryCount(), (U32)2);
+		}
+		{
+			LLTextureCacheIndex index;
+			LLTextureCacheIndex::entry_list_t dropped;
+			index.setReadOnly(false);
+			ensure("other format rejected", !index.load(mJournal, "other", 16, dropped));
+		}
+	}
+
+	template<> template<>
+	void texturecacheindex_object_t::test<4>()
+	{
+		set_test_name("10k concurrent requests");
+
+		const S32 THREADS = 8;
+		const S32 REQUESTS = 10000;
+		const U32 MAX_ENTRIES = 2048;
+
+		LLTextureCacheIndex index;
+		open(index, MAX_ENTRIES);
+
+		// A shared working set larger than the cache, so lookups, creations,
+		// evictions and removals all race each other.
+		std::vector<LLUUID> ids(MAX_ENTRIES * 2);
+		for (size_t i = 0; i < ids.size(); ++i)
+		{
+			ids[i].generate();
+		}
+
+		LLTimer timer;
+		std::vector<std::thread> threads;
+		for (S32 t = 0; t < THREADS; ++t)
+		{
+			threads.emplace_back([&index, &ids, t]()
+				{
+					LLTextureCacheIndex::Entry entry, evicted;
+					for (S32 i = t; i < REQUESTS; i += THREADS)
+					{
+						const LLUUID& id = ids[(i * 7919) % ids.size()];
+						switch (i % 8)
+						{
+						case 0:
+							index.remove(id, entry);
+							break;
+						case 1:
+						case 2:
+							if (index.find(id, entry, true) < 0 && index.allocate(id, entry, evicted) >= 0)
+							{
+								index.update(entry, 2000, 1000);
+							}
+							break;
+						default:
+							index.find(id, entry, true);
+							break;
+						}
+					}
+				});
+		}
+		for (S32 t = 0; t < THREADS; ++t)
+		{
+			threads[t].join();
+		}
+		index.flush();
+		F32 elapsed = timer.getElapsedTimeF32();
+		LL_INFOS() << REQUESTS << " requests on " << THREADS << " threads took " << elapsed * 1000.f << " ms" << LL_ENDL;
+
+		LLTextureCacheIndex::entry_list_t entries;
+		index.getEntries(entries);
+		std::set<S32> slots;
+		S64 body_size = 0;
+		for (size_t i = 0; i < entries.size(); ++i)
+		{
+			ensure("slot in range", entries[i].mIndex >= 0 && entries[i].mIndex < (S32)MAX_ENTRIES);
+			ensure("slot used once", slots.insert(entries[i].mIndex).second);
+			body_size += entries[i].mBodySize;
+		}
+		ensure_equals("entry count", index.getEntryCount(), (U32)entries.size());
+		ensure_equals("body total", index.getBodySizeTotal(), body_size);
+
+		// the journal as written by the racing threads replays to the same index
+		{
+			LLTextureCacheIndex replayed;
+			LLTextureCacheIndex::entry_list_t dropped;
+			ensure("journal replayed", replayed.load(mJournal, "test", MAX_ENTRIES, dropped));
+			ensure("nothing dropped", dropped.empty());
+			ensure_equals("replayed entry count", replayed.getEntryCount(), (U32)entries.size());
+			for (size_t i = 0; i < entries.size(); ++i)
+			{
+				LLTextureCacheIndex::Entry entry;
+				ensure_equals("replayed slot", replayed.find(entries[i].mID, entry, false), entries[i].mIndex);
+			}
+		}
+
+		// and so does the compacted one
+		ensure("compaction claimed", index.startCompaction());
+		ensure("only once", !index.startCompaction());
+		index.compact();
+		LLTextureCacheIndex reloaded;
+		open(reloaded, MAX_ENTRIES);
+		ensure_equals("reloaded entry count", reloaded.getEntryCount(), (U32)entries.size());
+	}
+}